@@ -68,6 +68,30 @@ class Genode::Cancelable_lock
 
 		Applicant _owner;
 
+	public:
+
+		/**
+		 * Contention statistics
+		 */
+		struct Contention
+		{
+			unsigned contended = 0; /* acquisitions that found the lock taken */
+			unsigned spun      = 0; /* contended acquisitions without blocking */
+			unsigned blocked   = 0; /* contended acquisitions that blocked */
+		};
+
+	private:
+
+		Contention _contention { };
+
+		/*
+		 * Number of rounds with exponentially increasing backoff a contending
+		 * thread spins before blocking. It is adapted to the success of
+		 * spinning at this lock, which becomes futile if lock holders are
+		 * not running in parallel, e.g., on a single CPU.
+		 */
+		unsigned char _spin_rounds = 4;
+
 	public:
 
 		enum State { LOCKED, UNLOCKED };
@@ -89,6 +113,11 @@ class Genode::Cancelable_lock
 		 */
 		void unlock();
 
+		/**
+		 * Return contention statistics
+		 */
+		Contention contention() const { return _contention; }
+
 		/**
 		 * Lock guard
 		 */
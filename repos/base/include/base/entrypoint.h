@@ -57,9 +57,10 @@ class Genode::Entrypoint : Noncopyable
 		{
 			enum { STACK_SIZE = 2*1024*sizeof(long) };
 			Entrypoint &ep;
-			Signal_proxy_thread(Env &env, Entrypoint &ep)
+			Signal_proxy_thread(Env &env, Entrypoint &ep, Location location,
+			                    Cpu_session &cpu)
 			:
-				Thread(env, "signal_proxy", STACK_SIZE),
+				Thread(env, "signal_proxy", STACK_SIZE, location, Weight(), cpu),
 				ep(ep)
 			{ start(); }
 
@@ -138,6 +139,15 @@ class Genode::Entrypoint : Noncopyable
 
 		Entrypoint(Env &env, size_t stack_size, char const *name);
 
+		/**
+		 * Constructor
+		 *
+		 * \param location  CPU affinity of the entrypoint thread and its
+		 *                  signal-proxy thread
+		 */
+		Entrypoint(Env &env, size_t stack_size, char const *name,
+		           Affinity::Location location);
+
 		~Entrypoint()
 		{
 			_rpc_ep->dissolve(&_signal_proxy);
@@ -0,0 +1,484 @@
+/*
+ * \brief  Pool of entrypoints, one per CPU
+ * \author Genode Labs
+ * \date   2018-04-06
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__BASE__ENTRYPOINT_POOL_H_
+#define _INCLUDE__BASE__ENTRYPOINT_POOL_H_
+
+#include <base/allocator.h>
+#include <base/entrypoint.h>
+#include <base/env.h>
+#include <base/lock.h>
+#include <cpu_session/cpu_session.h>
+#include <util/fifo.h>
+#include <util/string.h>
+
+namespace Genode { class Entrypoint_pool; }
+
+
+/**
+ * Pool of entrypoints, one per CPU of the component's affinity space
+ *
+ * A server that hands out many sessions can use the pool to serve its
+ * sessions by all CPUs available to it. Each session is bound to one
+ * entrypoint of the pool, selected according to the 'Placement' policy
+ * when the session is created (see 'Root_component').
+ *
+ * Thread-safety contract: The RPC functions of a session are executed by
+ * the session's entrypoint only and are thereby serialized. However,
+ * sessions bound to different entrypoints execute in parallel with each
+ * other and with the component's initial entrypoint, which serves the root
+ * interfaces and the signal handlers registered there. State shared between
+ * sessions, e.g., a registry of all sessions, must therefore be protected
+ * by a lock. Signal handlers of a session should be registered at the
+ * session's entrypoint, which serializes them with the session's RPC
+ * functions. In contrast, a pool 'Signal_handler' is executed by any idle
+ * entrypoint of the pool and thereby concurrently with the RPC functions
+ * of the session. The session state accessed by such a handler must be
+ * protected by a lock.
+ *
+ * Work that does not need to be served by a specific entrypoint can be
+ * submitted to the pool as 'Job'. Jobs are queued at an entrypoint but
+ * executed by any entrypoint of the pool that is idle, i.e., an idle
+ * entrypoint steals jobs from the queues of busy ones. The pool
+ * 'Signal_handler' turns the handling of a signal into such a job.
+ */
+class Genode::Entrypoint_pool
+{
+	public:
+
+		/**
+		 * Policy for binding new sessions to entrypoints
+		 */
+		enum Placement {
+
+			/* entrypoint serving the least number of sessions */
+			LEAST_LOADED,
+
+			/* entrypoints in turn */
+			ROUND_ROBIN,
+
+			/* entrypoint at the CPU of the session's affinity */
+			SESSION_AFFINITY
+		};
+
+		class Worker;
+
+		/**
+		 * Unit of work executed by any entrypoint of the pool
+		 *
+		 * A job is never executed concurrently with itself. Submitting a job
+		 * that is already queued has no effect. Submitting a job while it is
+		 * executed lets it execute once more afterwards.
+		 */
+		class Job : Interface, private Fifo<Job>::Element
+		{
+			private:
+
+				friend class Fifo<Job>;
+				friend class Entrypoint_pool;
+
+				enum State { IDLE, QUEUED, RUNNING, RUNNING_SUBMITTED };
+
+				State _state = IDLE;
+
+			public:
+
+				virtual void execute() = 0;
+		};
+
+		template <typename T> class Signal_handler;
+
+		class Worker : Noncopyable
+		{
+			private:
+
+				friend class Entrypoint_pool;
+
+				Entrypoint_pool &_pool;
+				Entrypoint       _ep;
+
+				/* members protected by the pool's lock */
+				Fifo<Job> _jobs     { };
+				unsigned  _num_jobs = 0;
+				unsigned  _sessions = 0;
+
+				/* worker executes jobs or was woken up to do so */
+				bool      _busy     = false;
+
+				Genode::Signal_handler<Worker> _job_handler {
+					_ep, *this, &Worker::_handle_jobs };
+
+				void _handle_jobs() { _pool._execute_jobs(*this); }
+
+				void _wake_up() { Signal_transmitter(_job_handler).submit(); }
+
+			public:
+
+				Worker(Entrypoint_pool &pool, Env &env, size_t stack_size,
+				       char const *name, Affinity::Location location)
+				:
+					_pool(pool), _ep(env, stack_size, name, location)
+				{ }
+
+				Entrypoint &ep() { return _ep; }
+		};
+
+	private:
+
+		Allocator &_alloc;
+		Placement  _placement;
+		unsigned   _num_workers;
+		unsigned   _next = 0;
+		Lock       _lock { };
+		Worker   **_workers;
+
+		typedef String<32> Name;
+
+		size_t _workers_size() const { return _num_workers*sizeof(Worker *); }
+
+		/*
+		 * Noncopyable
+		 */
+		Entrypoint_pool(Entrypoint_pool const &);
+		Entrypoint_pool &operator = (Entrypoint_pool const &);
+
+		static unsigned _num_workers_for(Env &env, unsigned max_entrypoints)
+		{
+			unsigned const cpus = env.cpu().affinity_space().total();
+			return max(1U, min(cpus, max_entrypoints));
+		}
+
+		Worker &_worker(Entrypoint &ep)
+		{
+			for (unsigned i = 0; i < _num_workers; i++)
+				if (&_workers[i]->ep() == &ep)
+					return *_workers[i];
+
+			/* entrypoint outside of the pool */
+			throw Invalid_entrypoint();
+		}
+
+		/**
+		 * Dequeue job from 'worker' or steal one from the busiest other
+		 * worker, called with '_lock' held
+		 */
+		Job *_dequeue_or_steal(Worker &worker)
+		{
+			Worker *victim = &worker;
+			if (!worker._num_jobs)
+				for (unsigned i = 0; i < _num_workers; i++)
+					if (_workers[i]->_num_jobs > victim->_num_jobs)
+						victim = _workers[i];
+
+			Job *job = victim->_jobs.dequeue();
+			if (!job)
+				return nullptr;
+
+			victim->_num_jobs--;
+			job->_state = Job::RUNNING;
+			return job;
+		}
+
+		/**
+		 * Return whether jobs are queued at any worker, called with '_lock'
+		 * held
+		 */
+		bool _jobs_queued() const
+		{
+			for (unsigned i = 0; i < _num_workers; i++)
+				if (_workers[i]->_num_jobs)
+					return true;
+
+			return false;
+		}
+
+		/**
+		 * Mark an idle worker other than 'worker' as busy, called with
+		 * '_lock' held
+		 *
+		 * \return  worker to wake up, or nullptr if all workers are busy
+		 */
+		Worker *_claim_idle_worker(Worker &worker)
+		{
+			for (unsigned i = 0; i < _num_workers; i++) {
+				Worker &idle = *_workers[i];
+				if (&idle != &worker && !idle._busy) {
+					idle._busy = true;
+					return &idle;
+				}
+			}
+			return nullptr;
+		}
+
+		/**
+		 * Enqueue job at 'worker', called with '_lock' held
+		 *
+		 * \return  worker to wake up, or nullptr
+		 */
+		Worker *_enqueue(Job &job, Worker &worker)
+		{
+			switch (job._state) {
+			case Job::QUEUED:
+			case Job::RUNNING_SUBMITTED:
+				return nullptr;
+
+			case Job::RUNNING:
+				job._state = Job::RUNNING_SUBMITTED;
+				return nullptr;
+
+			case Job::IDLE:
+				break;
+			}
+
+			job._state = Job::QUEUED;
+			worker._jobs.enqueue(&job);
+			worker._num_jobs++;
+
+			/*
+			 * Let an idle worker steal the job if 'worker' is occupied, i.e.,
+			 * it executes jobs, has jobs queued already, serves the RPC
+			 * functions of sessions, or is the caller itself as in the case
+			 * of a pool 'Signal_handler'.
+			 */
+			bool const occupied = worker._busy || worker._num_jobs > 1
+			                   || worker._sessions
+			                   || worker._ep.rpc_ep().is_myself();
+
+			if (occupied)
+				if (Worker *idle = _claim_idle_worker(worker))
+					return idle;
+
+			worker._busy = true;
+			return &worker;
+		}
+
+		void _execute_jobs(Worker &worker)
+		{
+			for (;;) {
+				Job    *job    = nullptr;
+				Worker *helper = nullptr;
+				{
+					Lock::Guard guard(_lock);
+
+					job = _dequeue_or_steal(worker);
+					worker._busy = (job != nullptr);
+
+					/* let another idle worker help with the remaining jobs */
+					if (job && _jobs_queued())
+						helper = _claim_idle_worker(worker);
+				}
+
+				if (!job)
+					return;
+
+				if (helper)
+					helper->_wake_up();
+
+				job->execute();
+
+				Worker *wake_up = nullptr;
+				{
+					Lock::Guard guard(_lock);
+
+					bool const resubmitted = (job->_state == Job::RUNNING_SUBMITTED);
+					job->_state = Job::IDLE;
+					if (resubmitted)
+						wake_up = _enqueue(*job, worker);
+				}
+
+				if (wake_up && wake_up != &worker)
+					wake_up->_wake_up();
+			}
+		}
+
+	public:
+
+		class Invalid_entrypoint : Exception { };
+
+		/**
+		 * Constructor
+		 *
+		 * \param stack_size       stack size of each entrypoint
+		 * \param name             name of the entrypoints, suffixed by the
+		 *                         index of the entrypoint
+		 * \param placement        policy for binding sessions to entrypoints
+		 * \param max_entrypoints  limit of the number of entrypoints, by
+		 *                         default one per CPU
+		 */
+		Entrypoint_pool(Env &env, Allocator &alloc, size_t stack_size,
+		                char const *name, Placement placement = LEAST_LOADED,
+		                unsigned max_entrypoints = ~0U)
+		:
+			_alloc(alloc), _placement(placement),
+			_num_workers(_num_workers_for(env, max_entrypoints)),
+			_workers((Worker **)alloc.alloc(_workers_size()))
+		{
+			Affinity::Space space = env.cpu().affinity_space();
+
+			for (unsigned i = 0; i < _num_workers; i++)
+				_workers[i] = new (alloc)
+					Worker(*this, env, stack_size, Name(name, "_", i).string(),
+					       space.total() ? space.location_of_index(i)
+					                     : Affinity::Location());
+		}
+
+		~Entrypoint_pool()
+		{
+			for (unsigned i = 0; i < _num_workers; i++)
+				destroy(_alloc, _workers[i]);
+
+			_alloc.free(_workers, _workers_size());
+		}
+
+		/**
+		 * Return number of entrypoints
+		 */
+		unsigned count() const { return _num_workers; }
+
+		/**
+		 * Return entrypoint at index
+		 */
+		Entrypoint &entrypoint(unsigned i) { return _workers[i % _num_workers]->ep(); }
+
+		/**
+		 * Call 'fn' for each entrypoint of the pool
+		 */
+		template <typename FN>
+		void for_each_entrypoint(FN const &fn)
+		{
+			for (unsigned i = 0; i < _num_workers; i++)
+				fn(_workers[i]->ep());
+		}
+
+		/**
+		 * Select entrypoint for a new session according to the placement
+		 * policy
+		 *
+		 * Each call must be paired with a call of 'release' once the session
+		 * is closed.
+		 */
+		Entrypoint &acquire(Affinity const &affinity)
+		{
+			Lock::Guard guard(_lock);
+
+			Worker *worker = nullptr;
+			switch (_placement) {
+
+			case ROUND_ROBIN:
+				worker = _workers[_next++ % _num_workers];
+				break;
+
+			case SESSION_AFFINITY:
+				{
+					Affinity::Location const location =
+						affinity.scale_to(Affinity::Space(_num_workers));
+
+					if (location.valid()) {
+						worker = _workers[location.xpos() % _num_workers];
+						break;
+					}
+				}
+				/* fall back to the least loaded entrypoint */
+
+			case LEAST_LOADED:
+				worker = _workers[0];
+				for (unsigned i = 1; i < _num_workers; i++)
+					if (_workers[i]->_sessions < worker->_sessions)
+						worker = _workers[i];
+				break;
+			}
+
+			worker->_sessions++;
+			return worker->ep();
+		}
+
+		/**
+		 * Account the closing of a session served by 'ep'
+		 *
+		 * \throw Invalid_entrypoint
+		 */
+		void release(Entrypoint &ep)
+		{
+			Lock::Guard guard(_lock);
+
+			Worker &worker = _worker(ep);
+			if (worker._sessions)
+				worker._sessions--;
+		}
+
+		/**
+		 * Submit job to be executed by the pool
+		 *
+		 * \param ep  entrypoint that queues the job, which is usually the
+		 *            entrypoint of the session the job belongs to
+		 *
+		 * \throw Invalid_entrypoint
+		 */
+		void submit(Job &job, Entrypoint &ep)
+		{
+			Worker *wake_up = nullptr;
+			{
+				Lock::Guard guard(_lock);
+				wake_up = _enqueue(job, _worker(ep));
+			}
+
+			if (wake_up)
+				wake_up->_wake_up();
+		}
+};
+
+
+/**
+ * Signal handler that is executed as job of the entrypoint pool
+ *
+ * The signal is received by the given entrypoint of the pool. The handler
+ * method, however, is executed by whichever entrypoint of the pool is idle
+ * first, possibly in parallel with the RPC functions served by the given
+ * entrypoint.
+ */
+template <typename T>
+class Genode::Entrypoint_pool::Signal_handler : private Entrypoint_pool::Job
+{
+	private:
+
+		Entrypoint_pool &_pool;
+		Entrypoint      &_ep;
+		T               &_obj;
+		void (T::*_member) ();
+
+		Genode::Signal_handler<Signal_handler> _handler;
+
+		void _handle() { _pool.submit(*this, _ep); }
+
+		void execute() override { (_obj.*_member)(); }
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param ep      entrypoint of the pool that receives the signal
+		 * \param obj     object to call the handler method on
+		 * \param member  handler method
+		 */
+		Signal_handler(Entrypoint_pool &pool, Entrypoint &ep, T &obj,
+		               void (T::*member)())
+		:
+			_pool(pool), _ep(ep), _obj(obj), _member(member),
+			_handler(ep, *this, &Signal_handler::_handle)
+		{ }
+
+		operator Signal_context_capability() const { return _handler; }
+};
+
+#endif /* _INCLUDE__BASE__ENTRYPOINT_POOL_H_ */
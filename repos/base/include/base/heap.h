@@ -15,6 +15,7 @@
 #define _INCLUDE__BASE__HEAP_H_
 
 #include <util/list.h>
+#include <util/avl_tree.h>
 #include <util/reconstructible.h>
 #include <base/ram_allocator.h>
 #include <region_map/region_map.h>
@@ -34,12 +35,46 @@ namespace Genode {
  * The heap class provides an allocator that uses a list of dataspaces of a RAM
  * allocator as backing store. One dataspace may be used for holding multiple
  * blocks.
+ *
+ * By default, the backing store is kept until the heap is destructed. If
+ * enabled via 'return_unused_dataspaces', the heap returns dataspaces that
+ * became completely unused to the RAM allocator.
  */
 class Genode::Heap : public Allocator
 {
+	public:
+
+		struct Stats
+		{
+			/* size of all dataspaces used as backing store */
+			size_t backing;
+
+			/* bytes of outstanding allocations */
+			size_t allocated;
+
+			/* slab pages used for small allocations */
+			size_t slab;
+
+			unsigned long dataspaces;
+
+			/* number of dataspaces returned to the RAM allocator so far */
+			unsigned long returned;
+
+			/**
+			 * Return fragmentation in percent
+			 *
+			 * This is the portion of the backing store not occupied by
+			 * allocations.
+			 */
+			unsigned fragmentation() const {
+				return backing > allocated
+				       ? (unsigned)(100 - (allocated*100)/backing) : 0; }
+		};
+
 	private:
 
-		class Dataspace : public List<Dataspace>::Element
+		class Dataspace : public List<Dataspace>::Element,
+		                  public Avl_node<Dataspace>
 		{
 			private:
 
@@ -55,8 +90,35 @@ class Genode::Heap : public Allocator
 				void  *local_addr;
 				size_t size;
 
+				/*
+				 * The following members are only maintained if unused
+				 * dataspaces are returned
+				 */
+				bool     chunk      = false; /* managed by the local allocator */
+				size_t   used       = 0;     /* bytes allocated within chunk   */
+				uint64_t slab_pages = 0;     /* bitmap of pages used as slabs  */
+
 				Dataspace(Ram_dataspace_capability c, void *local_addr, size_t size)
 				: cap(c), local_addr(local_addr), size(size) { }
+
+				/**
+				 * Avl_node interface
+				 */
+				bool higher(Dataspace *ds) {
+					return (addr_t)ds->local_addr > (addr_t)local_addr; }
+
+				/**
+				 * Return dataspace of subtree that contains 'addr'
+				 */
+				Dataspace *find_by_addr(addr_t addr)
+				{
+					addr_t const base = (addr_t)local_addr;
+					if (addr >= base && addr - base < size)
+						return this;
+
+					Dataspace *ds = child(addr > base);
+					return ds ? ds->find_by_addr(addr) : nullptr;
+				}
 		};
 
 		/*
@@ -89,6 +151,16 @@ class Genode::Heap : public Allocator
 					ram_alloc = ram, region_map = rm; }
 		};
 
+		struct Slab_page;
+
+		enum { SLAB_CLASSES = 8 };
+
+		/*
+		 * Noncopyable
+		 */
+		Heap(Heap const &);
+		Heap &operator = (Heap const &);
+
 		Lock                           _lock { };
 		Reconstructible<Allocator_avl> _alloc;        /* local allocator    */
 		Dataspace_pool                 _ds_pool;      /* list of dataspaces */
@@ -96,6 +168,24 @@ class Genode::Heap : public Allocator
 		size_t                         _quota_used  { 0 };
 		size_t                         _chunk_size  { 0 };
 
+		/*
+		 * State of the mode that returns unused dataspaces
+		 *
+		 * In this mode, the 'Dataspace' objects and the meta data of the
+		 * local allocator reside at the separate '_meta' heap so that each
+		 * chunk contains nothing but allocations. Small allocations are
+		 * grouped at per-size-class slab pages.
+		 */
+		Heap                    *_meta         { nullptr };
+		Ram_dataspace_capability _meta_ds      { };
+		Avl_tree<Dataspace>      _ds_tree      { };
+		size_t                   _reserve      { 0 };
+		size_t                   _unused_bytes { 0 };
+		size_t                   _slab_bytes   { 0 };
+		size_t                   _slab_used    { 0 };
+		unsigned long            _returned     { 0 };
+		Slab_page               *_slab_partial[SLAB_CLASSES] { };
+
 		/**
 		 * Allocate a new dataspace of the specified size
 		 *
@@ -116,13 +206,35 @@ class Genode::Heap : public Allocator
 		 * This method is a utility used by '_unsynchronized_alloc' to
 		 * avoid code duplication.
 		 */
-		bool _try_local_alloc(size_t size, void **out_addr);
+		bool _try_local_alloc(size_t size, void **out_addr, int align);
+
+		/**
+		 * Allocate block at the local allocator, expanding the backing store
+		 * if needed
+		 */
+		bool _local_alloc(size_t size, void **out_addr, int align);
 
 		/**
 		 * Unsynchronized implementation of 'alloc'
 		 */
 		bool _unsynchronized_alloc(size_t size, void **out_addr);
 
+		/**
+		 * Return dataspace that contains 'addr', or nullptr
+		 */
+		Dataspace *_ds_at(addr_t addr) {
+			return _ds_tree.first() ? _ds_tree.first()->find_by_addr(addr) : nullptr; }
+
+		/**
+		 * Account freed bytes of chunk and return the chunk if it is unused
+		 */
+		void _chunk_freed(Dataspace &ds, size_t size);
+
+		void _return_chunk(Dataspace &ds);
+
+		bool _slab_alloc_small(size_t size, void **out_addr);
+		void _slab_free(Dataspace &ds, void *addr);
+
 	public:
 
 		enum { UNLIMITED = ~0 };
@@ -145,11 +257,33 @@ class Genode::Heap : public Allocator
 		 */
 		int quota_limit(size_t new_quota_limit);
 
+		/**
+		 * Return dataspaces that became unused to the RAM allocator
+		 *
+		 * \param reserve  number of bytes of unused backing store that is
+		 *                 kept for subsequent allocations
+		 *
+		 * \return false if the mode cannot be enabled because the heap is
+		 *         already in use
+		 *
+		 * The mode must be enabled before the first allocation. Calling the
+		 * method again just updates the 'reserve' value.
+		 */
+		bool return_unused_dataspaces(size_t reserve = 256*1024);
+
+		/**
+		 * Return statistics about the backing store
+		 */
+		Stats stats();
+
 		/**
 		 * Re-assign RAM allocator and region map
 		 */
-		void reassign_resources(Ram_allocator *ram, Region_map *rm) {
-			_ds_pool.reassign_resources(ram, rm); }
+		void reassign_resources(Ram_allocator *ram, Region_map *rm)
+		{
+			_ds_pool.reassign_resources(ram, rm);
+			if (_meta) _meta->reassign_resources(ram, rm);
+		}
 
 
 		/*************************
@@ -20,6 +20,7 @@
 #include <util/noncopyable.h>
 #include <base/capability.h>
 #include <base/weak_ptr.h>
+#include <base/rw_lock.h>
 
 namespace Genode { template <typename> class Object_pool; }
 
@@ -95,13 +96,18 @@ class Genode::Object_pool : Interface, Noncopyable
 	private:
 
 		Avl_tree<Entry> _tree { };
-		Lock            _lock { };
+
+		/*
+		 * Look-ups by the entrypoint are far more frequent than insertions
+		 * and removals and may proceed in parallel
+		 */
+		Rw_lock         _lock { };
 
 	protected:
 
 		bool empty()
 		{
-			Lock::Guard lock_guard(_lock);
+			Rw_lock::Read_guard lock_guard(_lock);
 			return _tree.first() == nullptr;
 		}
 
@@ -109,13 +115,13 @@ class Genode::Object_pool : Interface, Noncopyable
 
 		void insert(OBJ_TYPE *obj)
 		{
-			Lock::Guard lock_guard(_lock);
+			Rw_lock::Write_guard lock_guard(_lock);
 			_tree.insert(obj);
 		}
 
 		void remove(OBJ_TYPE *obj)
 		{
-			Lock::Guard lock_guard(_lock);
+			Rw_lock::Write_guard lock_guard(_lock);
 			_tree.remove(obj);
 		}
 
@@ -131,7 +137,7 @@ class Genode::Object_pool : Interface, Noncopyable
 			Weak_ptr ptr;
 
 			{
-				Lock::Guard lock_guard(_lock);
+				Rw_lock::Read_guard lock_guard(_lock);
 
 				Entry * entry = _tree.first() ?
 					_tree.first()->find_by_obj_id(capid) : nullptr;
@@ -164,7 +170,7 @@ class Genode::Object_pool : Interface, Noncopyable
 				OBJ_TYPE * obj;
 
 				{
-					Lock::Guard lock_guard(_lock);
+					Rw_lock::Write_guard lock_guard(_lock);
 
 					if (!((obj = (OBJ_TYPE*) _tree.first()))) return;
 
@@ -0,0 +1,137 @@
+/*
+ * \brief  Reader-writer lock
+ * \author Genode Labs
+ * \date   2018-04-05
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__BASE__RW_LOCK_H_
+#define _INCLUDE__BASE__RW_LOCK_H_
+
+#include <base/lock.h>
+#include <cpu/atomic.h>
+#include <cpu/memory_barrier.h>
+#include <util/noncopyable.h>
+
+namespace Genode { class Rw_lock; }
+
+
+/**
+ * Lock that admits multiple readers or a single writer
+ *
+ * Readers enter and leave with a single atomic operation as long as no
+ * writer is present. A writer announces itself by setting the 'WRITER' bit
+ * of the state, which keeps new readers out, and blocks until the readers
+ * inside have left. Hence, writers cannot be starved by a steady stream of
+ * readers. Readers must not acquire the lock recursively because a writer
+ * that arrives in between would deadlock with them.
+ */
+class Genode::Rw_lock : Noncopyable
+{
+	private:
+
+		enum { WRITER = 1 << 30 };
+
+		/* number of readers inside, 'WRITER' bit set while writer present */
+		volatile int _state = 0;
+
+		/* serializes writers, held during write access */
+		Lock _writer { };
+
+		/* released by the last reader leaving while a writer waits */
+		Lock _drained { Lock::LOCKED };
+
+	public:
+
+		void read_lock()
+		{
+			for (;;) {
+				int const state = _state;
+
+				if (!(state & WRITER)) {
+					if (cmpxchg(&_state, state, state + 1))
+						return;
+					continue;
+				}
+
+				/* wait for the writer to finish */
+				Lock::Guard guard(_writer);
+			}
+		}
+
+		void read_unlock()
+		{
+			for (;;) {
+				int const state = _state;
+
+				if (!cmpxchg(&_state, state, state - 1))
+					continue;
+
+				/* wake up the waiting writer if we were the last reader */
+				if (state - 1 == WRITER)
+					_drained.unlock();
+
+				return;
+			}
+		}
+
+		void write_lock()
+		{
+			_writer.lock();
+
+			int state;
+			do { state = _state; } while (!cmpxchg(&_state, state, state | WRITER));
+
+			/* wait until the readers inside have left */
+			if (state)
+				_drained.lock();
+		}
+
+		void write_unlock()
+		{
+			/* make the writes of the critical section visible to readers */
+			memory_barrier();
+			_state = 0;
+			_writer.unlock();
+		}
+
+		/**
+		 * Lock guard for read access
+		 */
+		class Read_guard : Noncopyable
+		{
+			private:
+
+				Rw_lock &_lock;
+
+			public:
+
+				explicit Read_guard(Rw_lock &lock) : _lock(lock) { _lock.read_lock(); }
+
+				~Read_guard() { _lock.read_unlock(); }
+		};
+
+		/**
+		 * Lock guard for write access
+		 */
+		class Write_guard : Noncopyable
+		{
+			private:
+
+				Rw_lock &_lock;
+
+			public:
+
+				explicit Write_guard(Rw_lock &lock) : _lock(lock) { _lock.write_lock(); }
+
+				~Write_guard() { _lock.write_unlock(); }
+		};
+};
+
+#endif /* _INCLUDE__BASE__RW_LOCK_H_ */
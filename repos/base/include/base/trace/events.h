@@ -25,6 +25,7 @@ namespace Genode { namespace Trace {
 	struct Rpc_reply;
 	struct Signal_submit;
 	struct Signal_received;
+	struct Lock_contention;
 } }
 
 
@@ -121,4 +122,21 @@ struct Genode::Trace::Signal_received
 };
 
 
+struct Genode::Trace::Lock_contention
+{
+	void const    *lock;
+	unsigned const spin_rounds;
+
+	Lock_contention(void const *lock, unsigned spin_rounds)
+	:
+		lock(lock), spin_rounds(spin_rounds)
+	{
+		Thread::trace(this);
+	}
+
+	size_t generate(Policy_module &policy, char *dst) const {
+		return policy.lock_contention(dst, lock, spin_rounds); }
+};
+
+
 #endif /* _INCLUDE__BASE__TRACE__EVENTS_H_ */
@@ -21,8 +21,10 @@
 #include <base/allocator.h>
 #include <base/rpc_server.h>
 #include <base/entrypoint.h>
+#include <base/entrypoint_pool.h>
 #include <base/service.h>
 #include <util/arg_string.h>
+#include <util/list.h>
 #include <base/log.h>
 
 namespace Genode {
@@ -107,6 +109,56 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 		 */
 		Rpc_entrypoint *_ep;
 
+		/*
+		 * Entrypoint that serves the root component, not defined when
+		 * using the deprecated constructor
+		 */
+		Entrypoint *_entrypoint = nullptr;
+
+		/*
+		 * Pool of entrypoints that serve the sessions, or nullptr if the
+		 * sessions are served by '_ep'
+		 */
+		Entrypoint_pool *_ep_pool = nullptr;
+
+		/*
+		 * Entrypoint of the pool selected for the session under construction
+		 */
+		Entrypoint *_session_ep = nullptr;
+
+		/*
+		 * Entrypoint of the pool selected for a session
+		 *
+		 * The binding is recorded independently from the entrypoint that
+		 * manages the session object, which differs if the session object
+		 * calls 'manage' by itself, to release the selection at the pool
+		 * when the session is closed.
+		 */
+		struct Pool_binding : List<Pool_binding>::Element
+		{
+			SESSION_TYPE *session = nullptr;
+			Entrypoint   &ep;
+
+			Pool_binding(Entrypoint &ep) : ep(ep) { }
+
+			/*
+			 * Noncopyable
+			 */
+			Pool_binding(Pool_binding const &);
+			Pool_binding &operator = (Pool_binding const &);
+		};
+
+		/*
+		 * Bindings of the sessions created via the pool, only accessed by
+		 * the entrypoint of the root component
+		 */
+		List<Pool_binding> _pool_bindings { };
+
+		/*
+		 * Binding of the session under construction
+		 */
+		Pool_binding *_session_binding = nullptr;
+
 		/*
 		 * Allocator for allocating session objects.
 		 * This allocator must be used by the derived
@@ -131,9 +183,23 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 				bool ack = false;
 				Root_component &root;
 				Guard(Root_component &root) : root(root) { }
-				~Guard() { if (!ack) root.release(); }
+				~Guard()
+				{
+					if (!ack) {
+						root.release();
+						if (root._session_binding)
+							Genode::destroy(root.md_alloc(), root._session_binding);
+						if (root._session_ep)
+							root._ep_pool->release(*root._session_ep);
+					}
+					root._session_ep      = nullptr;
+					root._session_binding = nullptr;
+				}
 			} aquire_guard { *this };
 
+			if (_ep_pool)
+				_session_ep = &_ep_pool->acquire(affinity);
+
 			/*
 			 * We need to decrease 'ram_quota' by
 			 * the size of the session object.
@@ -142,6 +208,10 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 
 			size_t needed = sizeof(SESSION_TYPE) + md_alloc()->overhead(sizeof(SESSION_TYPE));
 
+			/* account for the binding of the session to the pool */
+			if (_ep_pool)
+				needed += sizeof(Pool_binding) + md_alloc()->overhead(sizeof(Pool_binding));
+
 			if (needed > ram_quota.value)
 				throw Insufficient_ram_quota();
 
@@ -165,6 +235,12 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 
 			Cap_quota const remaining_cap_quota { cap_quota.value - 1 };
 
+			if (_ep_pool) {
+				try { _session_binding = new (md_alloc()) Pool_binding(*_session_ep); }
+				catch (Out_of_ram)  { throw Insufficient_ram_quota(); }
+				catch (Out_of_caps) { throw Insufficient_cap_quota(); }
+			}
+
 			/*
 			 * Deduce ram quota needed for allocating the session object from the
 			 * donated ram quota.
@@ -197,12 +273,62 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 			 * called 'manage'.
 			 */
 			if (!s->cap().valid())
-				_ep->manage(s);
+				(_session_ep ? &_session_ep->rpc_ep() : _ep)->manage(s);
+
+			if (_session_binding) {
+				_session_binding->session = s;
+				_pool_bindings.insert(_session_binding);
+			}
 
 			aquire_guard.ack = true;
 			return *s;
 		}
 
+		/*
+		 * Apply 'fn' to the session and the entrypoint of the pool that
+		 * serves it, the latter being nullptr if the session is served
+		 * by '_ep'
+		 */
+		template <typename FN>
+		void _apply(Session_capability cap, FN const &fn)
+		{
+			unsigned const num_pool_eps = _ep_pool ? _ep_pool->count() : 0;
+
+			for (unsigned i = 0; i <= num_pool_eps; i++) {
+
+				Entrypoint *pool_ep = (i < num_pool_eps)
+				                    ? &_ep_pool->entrypoint(i) : nullptr;
+
+				bool found = false;
+				(pool_ep ? &pool_ep->rpc_ep() : _ep)->apply(cap,
+					[&] (SESSION_TYPE *s) {
+						if (!s) return;
+
+						found = true;
+						fn(pool_ep, *s);
+					});
+
+				if (found)
+					return;
+			}
+		}
+
+		/*
+		 * Release the entrypoint of the pool selected for 'session'
+		 */
+		void _release_pool_binding(SESSION_TYPE const *session)
+		{
+			for (Pool_binding *b = _pool_bindings.first(); b; b = b->next()) {
+				if (b->session != session)
+					continue;
+
+				_pool_bindings.remove(b);
+				_ep_pool->release(b->ep);
+				Genode::destroy(md_alloc(), b);
+				return;
+			}
+		}
+
 		/*
 		 * Noncopyable
 		 */
@@ -278,6 +404,17 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 		 */
 		Rpc_entrypoint *ep() { return _ep; }
 
+		/**
+		 * Return entrypoint that serves the session under construction
+		 *
+		 * This method is meant to be called by '_create_session', e.g., for
+		 * registering the signal handlers of the new session at the
+		 * entrypoint that serves the session. A session object that calls
+		 * 'manage' by itself must do so at this entrypoint. The method is
+		 * not available when using the deprecated constructor.
+		 */
+		Entrypoint &session_ep() { return _session_ep ? *_session_ep : *_entrypoint; }
+
 	public:
 
 		/**
@@ -290,7 +427,27 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 		 */
 		Root_component(Entrypoint &ep, Allocator &md_alloc)
 		:
-			_ep(&ep.rpc_ep()), _md_alloc(&md_alloc)
+			_ep(&ep.rpc_ep()), _entrypoint(&ep), _md_alloc(&md_alloc)
+		{ }
+
+		/**
+		 * Constructor for serving the sessions by a pool of entrypoints
+		 *
+		 * \param ep_pool   entrypoints that serve the sessions, one of which
+		 *                  is selected for each new session according to
+		 *                  the placement policy of the pool
+		 * \param ep        entry point that serves the root interface
+		 * \param md_alloc  meta-data allocator providing the backing store
+		 *                  for session objects
+		 *
+		 * The sessions are executed concurrently. See 'Entrypoint_pool' for
+		 * the implications on the session implementation.
+		 */
+		Root_component(Entrypoint_pool &ep_pool, Entrypoint &ep,
+		               Allocator &md_alloc)
+		:
+			_ep(&ep.rpc_ep()), _entrypoint(&ep), _ep_pool(&ep_pool),
+			_md_alloc(&md_alloc)
 		{ }
 
 		/**
@@ -346,26 +503,25 @@ class Genode::Root_component : public Rpc_object<Typed_root<SESSION_TYPE> >,
 		{
 			if (!args.valid_string()) throw Service_denied();
 
-			_ep->apply(session, [&] (SESSION_TYPE *s) {
-				if (!s) return;
-
-				_upgrade_session(s, args.string());
-			});
+			_apply(session, [&] (Entrypoint *, SESSION_TYPE &s) {
+				_upgrade_session(&s, args.string()); });
 		}
 
 		void close(Session_capability session_cap) override
 		{
-			SESSION_TYPE * session;
+			SESSION_TYPE *session = nullptr;
 
-			_ep->apply(session_cap, [&] (SESSION_TYPE *s) {
-				session = s;
+			_apply(session_cap, [&] (Entrypoint *pool_ep, SESSION_TYPE &s) {
+				session = &s;
 
 				/* let the entry point forget the session object */
-				if (session) _ep->dissolve(session);
+				(pool_ep ? &pool_ep->rpc_ep() : _ep)->dissolve(session);
 			});
 
 			if (!session) return;
 
+			_release_pool_binding(session);
+
 			_destroy_session(session);
 
 			POLICY::release();
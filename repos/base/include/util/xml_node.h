@@ -15,11 +15,13 @@
 #define _INCLUDE__UTIL__XML_NODE_H_
 
 #include <util/token.h>
+#include <base/allocator.h>
 #include <base/exception.h>
 
 namespace Genode {
 	class Xml_attribute;
 	class Xml_node;
+	class Xml_node_index;
 }
 
 
@@ -58,6 +60,8 @@ class Genode::Xml_attribute
 		 */
 		friend class Tag;
 
+		friend class Xml_node_index;
+
 		/**
 		 * Constructor
 		 *
@@ -181,6 +185,208 @@ class Genode::Xml_attribute
 };
 
 
+/**
+ * Index of the nodes and attributes of an XML document
+ *
+ * The index is built in a single pass over the XML data. It records the
+ * location of each node, the sub nodes of each node, and the name of each
+ * attribute. Nodes obtained via 'xml()' and all nodes reached from them
+ * navigate the document by means of the index instead of re-tokenizing the
+ * XML data. They otherwise behave like ordinary 'Xml_node' objects.
+ *
+ * The index refers to the XML data, which must stay unmodified during the
+ * lifetime of the index. Nodes obtained from the index must not be used
+ * after the index is destructed.
+ *
+ * If the XML data contains syntax errors, the index stays empty and 'xml()'
+ * returns an ordinary node.
+ */
+class Genode::Xml_node_index
+{
+	private:
+
+		friend class Xml_node;
+
+		enum { NONE = ~0U, INITIAL_CAPACITY = 64 };
+
+		struct Node
+		{
+			size_t   start;          /* offset of start tag        */
+			size_t   end;            /* offset of end tag          */
+			unsigned name_len;
+			unsigned parent;
+			unsigned pos;            /* position in '_sub_nodes'   */
+			unsigned sub_nodes;      /* position of first sub node */
+			unsigned num_sub_nodes;
+			unsigned attrs;          /* index of first attribute   */
+			unsigned num_attrs;
+		};
+
+		struct Attr
+		{
+			size_t   name;           /* offset of attribute name   */
+			unsigned name_len;
+		};
+
+		Allocator  &_alloc;
+		char const *_addr;
+		size_t      _max_len;
+
+		Node       *_nodes         = nullptr;
+		unsigned    _num_nodes     = 0;
+		unsigned    _nodes_cap     = 0;
+		Attr       *_attrs         = nullptr;
+		unsigned    _num_attrs     = 0;
+		unsigned    _attrs_cap     = 0;
+		unsigned   *_sub_nodes     = nullptr;
+		bool        _valid         = false;
+
+		/*
+		 * Noncopyable
+		 */
+		Xml_node_index(Xml_node_index const &);
+		Xml_node_index &operator = (Xml_node_index const &);
+
+		/**
+		 * Enlarge 'array' to hold at least 'needed' elements
+		 */
+		template <typename T>
+		void _grow(T *&array, unsigned &capacity, unsigned needed)
+		{
+			if (needed <= capacity)
+				return;
+
+			unsigned const new_capacity = max(capacity*2, (unsigned)INITIAL_CAPACITY);
+
+			T *const new_array = (T *)_alloc.alloc(new_capacity*sizeof(T));
+			if (array) {
+				memcpy((void *)new_array, (void *)array, capacity*sizeof(T));
+				_alloc.free(array, capacity*sizeof(T));
+			}
+			array    = new_array;
+			capacity = new_capacity;
+		}
+
+		template <typename T>
+		void _free(T *&array, unsigned capacity)
+		{
+			if (array)
+				_alloc.free(array, capacity*sizeof(T));
+			array = nullptr;
+		}
+
+		inline bool _build();
+
+		/**
+		 * Fill sub-node table with the nodes grouped by their parents
+		 */
+		void _link_sub_nodes()
+		{
+			if (_num_nodes > 1)
+				_sub_nodes = (unsigned *)_alloc.alloc((_num_nodes - 1)*sizeof(unsigned));
+
+			unsigned pos = 0;
+			for (unsigned i = 0; i < _num_nodes; i++) {
+				_nodes[i].sub_nodes = pos;
+				pos += _nodes[i].num_sub_nodes;
+				_nodes[i].num_sub_nodes = 0;
+			}
+
+			/* nodes are recorded in document order */
+			for (unsigned i = 1; i < _num_nodes; i++) {
+				Node &parent = _nodes[_nodes[i].parent];
+				_nodes[i].pos = parent.sub_nodes + parent.num_sub_nodes;
+				_sub_nodes[_nodes[i].pos] = i;
+				parent.num_sub_nodes++;
+			}
+		}
+
+		bool _has_type(unsigned node, char const *type) const
+		{
+			Node const &n = _nodes[node];
+			return strlen(type) == n.name_len
+			    && !strcmp(type, _addr + n.start + 1, n.name_len);
+		}
+
+		bool _has_name(Attr const &attr, char const *name) const
+		{
+			return strlen(name) == attr.name_len
+			    && !strcmp(name, _addr + attr.name, attr.name_len);
+		}
+
+		/**
+		 * Return node following 'node' within its parent or 'NONE'
+		 */
+		unsigned _next(unsigned node) const
+		{
+			if (node == 0)
+				return NONE;
+
+			Node const &parent = _nodes[_nodes[node].parent];
+			unsigned const pos = _nodes[node].pos + 1;
+
+			return pos < parent.sub_nodes + parent.num_sub_nodes
+			       ? _sub_nodes[pos] : NONE;
+		}
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param alloc    backing store for the index
+		 * \param addr     XML data
+		 * \param max_len  size of XML data
+		 *
+		 * \throw Out_of_ram
+		 * \throw Out_of_caps
+		 */
+		Xml_node_index(Allocator &alloc, char const *addr, size_t max_len = ~0UL)
+		:
+			_alloc(alloc), _addr(addr), _max_len(max_len)
+		{
+			try { _valid = _build(); }
+			catch (...) {
+				_free(_nodes, _nodes_cap);
+				_free(_attrs, _attrs_cap);
+				throw;
+			}
+
+			if (!_valid) {
+				_free(_nodes, _nodes_cap);
+				_free(_attrs, _attrs_cap);
+				_num_nodes = _num_attrs = 0;
+			}
+		}
+
+		~Xml_node_index()
+		{
+			if (_sub_nodes)
+				_alloc.free(_sub_nodes, (_num_nodes - 1)*sizeof(unsigned));
+
+			_free(_nodes, _nodes_cap);
+			_free(_attrs, _attrs_cap);
+		}
+
+		/**
+		 * Return true if the XML data is indexed
+		 */
+		bool valid() const { return _valid; }
+
+		/**
+		 * Return number of indexed nodes
+		 */
+		unsigned num_nodes() const { return _num_nodes; }
+
+		/**
+		 * Return top-level node of the XML data
+		 *
+		 * \throw Xml_node::Invalid_syntax
+		 */
+		inline Xml_node xml() const;
+};
+
+
 /**
  * Representation of an XML node
  */
@@ -195,6 +401,8 @@ class Genode::Xml_node
 		 */
 		class Tag;
 
+		friend class Xml_node_index;
+
 	public:
 
 		/*********************
@@ -449,6 +657,9 @@ class Genode::Xml_node
 		Tag         _start_tag;
 		Tag         _end_tag;
 
+		Xml_node_index const *_index = nullptr;  /* index of the document */
+		unsigned              _node  = 0;        /* node within the index */
+
 		/**
 		 * Search for end tag of XML node and initialize '_num_sub_nodes'
 		 *
@@ -565,6 +776,44 @@ class Genode::Xml_node
 			return Xml_node(at, _max_len - (at - addr()));
 		}
 
+		/**
+		 * Return end tag of indexed node without searching the XML data
+		 */
+		static Tag _indexed_end_tag(Xml_node_index const &index, unsigned node,
+		                            Tag const &start_tag)
+		{
+			if (start_tag.type() != Tag::START)
+				return start_tag;
+
+			size_t const end = index._nodes[node].end;
+			return Tag(Token(index._addr + end, index._max_len - end));
+		}
+
+		/**
+		 * Constructor used for nodes of an index
+		 */
+		Xml_node(Xml_node_index const &index, unsigned node)
+		:
+			_addr(index._addr + index._nodes[node].start),
+			_max_len(index._max_len - index._nodes[node].start),
+			_num_sub_nodes(index._nodes[node].num_sub_nodes),
+			_start_tag(Token(_addr, _max_len)),
+			_end_tag(_indexed_end_tag(index, node, _start_tag)),
+			_index(&index), _node(node)
+		{ }
+
+		Xml_attribute _indexed_attribute(Xml_node_index::Attr const &attr) const
+		{
+			return Xml_attribute(Token(_index->_addr + attr.name,
+			                           _index->_max_len - attr.name));
+		}
+
+		Xml_node _indexed_sub_node(unsigned idx) const
+		{
+			Xml_node_index::Node const &n = _index->_nodes[_node];
+			return Xml_node(*_index, _index->_sub_nodes[n.sub_nodes + idx]);
+		}
+
 	public:
 
 		/**
@@ -720,6 +969,14 @@ class Genode::Xml_node
 		 */
 		Xml_node next() const
 		{
+			if (_index && _node) {
+				unsigned const next = _index->_next(_node);
+				if (next == Xml_node_index::NONE)
+					throw Nonexistent_sub_node();
+
+				return Xml_node(*_index, next);
+			}
+
 			Token after_node = _end_tag.next_token();
 			after_node = skip_non_tag_characters(after_node);
 			try { return _sub_node(after_node.start()); }
@@ -757,6 +1014,13 @@ class Genode::Xml_node
 		 */
 		Xml_node sub_node(unsigned idx = 0U) const
 		{
+			if (_index) {
+				if (idx >= (unsigned)_num_sub_nodes)
+					throw Nonexistent_sub_node();
+
+				return _indexed_sub_node(idx);
+			}
+
 			if (_num_sub_nodes > 0) {
 
 				/* look up node at specified index */
@@ -778,6 +1042,15 @@ class Genode::Xml_node
 		 */
 		Xml_node sub_node(const char *type) const
 		{
+			if (_index) {
+				Xml_node_index::Node const &n = _index->_nodes[_node];
+				for (int i = 0; i < _num_sub_nodes; i++)
+					if (_index->_has_type(_index->_sub_nodes[n.sub_nodes + i], type))
+						return _indexed_sub_node(i);
+
+				throw Nonexistent_sub_node();
+			}
+
 			if (_num_sub_nodes > 0) {
 
 				/* search for sub node of specified type */
@@ -801,6 +1074,18 @@ class Genode::Xml_node
 			if (_num_sub_nodes == 0)
 				return;
 
+			if (_index) {
+				Xml_node_index::Node const &n = _index->_nodes[_node];
+				for (int i = 0; i < _num_sub_nodes; i++) {
+					if (type && !_index->_has_type(_index->_sub_nodes[n.sub_nodes + i], type))
+						continue;
+
+					Xml_node node = _indexed_sub_node(i);
+					fn(node);
+				}
+				return;
+			}
+
 			Xml_node node = sub_node();
 			for (int i = 0; ; node = node.next()) {
 
@@ -831,6 +1116,14 @@ class Genode::Xml_node
 		 */
 		Xml_attribute attribute(unsigned idx) const
 		{
+			if (_index) {
+				Xml_node_index::Node const &n = _index->_nodes[_node];
+				if (idx >= n.num_attrs)
+					throw Nonexistent_attribute();
+
+				return _indexed_attribute(_index->_attrs[n.attrs + idx]);
+			}
+
 			/* get first attribute of the node */
 			Xml_attribute a = _start_tag.attribute();
 
@@ -850,6 +1143,15 @@ class Genode::Xml_node
 		 */
 		Xml_attribute attribute(const char *type) const
 		{
+			if (_index) {
+				Xml_node_index::Node const &n = _index->_nodes[_node];
+				for (unsigned i = 0; i < n.num_attrs; i++)
+					if (_index->_has_name(_index->_attrs[n.attrs + i], type))
+						return _indexed_attribute(_index->_attrs[n.attrs + i]);
+
+				throw Nonexistent_attribute();
+			}
+
 			/* iterate, beginning with the first attribute of the node */
 			for (Xml_attribute a = _start_tag.attribute(); ; a = a.next())
 				if (a.has_type(type))
@@ -903,4 +1205,112 @@ class Genode::Xml_node
 			output.out_string(addr(), size()); }
 };
 
+
+/**
+ * Record all nodes and attributes of the XML data
+ *
+ * The tokens are visited in the same order as by 'Xml_node::_init_end_tag'
+ * so that the index matches the structure seen by ordinary nodes.
+ *
+ * \return  false if the XML data has syntax errors
+ */
+bool Genode::Xml_node_index::_build()
+{
+	typedef Xml_node::Token   Token;
+	typedef Xml_node::Tag     Tag;
+	typedef Xml_node::Comment Comment;
+
+	auto add_node = [&] (Tag const &tag, unsigned parent)
+	{
+		_grow(_nodes, _nodes_cap, _num_nodes + 1);
+
+		Node &node = _nodes[_num_nodes];
+		node.start         = tag.token().start() - _addr;
+		node.end           = node.start;
+		node.name_len      = tag.name().len();
+		node.parent        = parent;
+		node.pos           = 0;
+		node.sub_nodes     = 0;
+		node.num_sub_nodes = 0;
+		node.attrs         = _num_attrs;
+		node.num_attrs     = 0;
+
+		try {
+			for (Xml_attribute a = tag.attribute(); ; a = a._next()) {
+				_grow(_attrs, _attrs_cap, _num_attrs + 1);
+				_attrs[_num_attrs++] = Attr { (size_t)(a._name.start() - _addr),
+				                              (unsigned)a._name.len() };
+				_nodes[_num_nodes].num_attrs++;
+			}
+		} catch (Xml_attribute::Nonexistent_attribute) { }
+
+		if (parent != NONE)
+			_nodes[parent].num_sub_nodes++;
+
+		return _num_nodes++;
+	};
+
+	try {
+		Tag const root(Xml_node::skip_non_tag_characters(Token(_addr, _max_len)));
+		if (!root.node())
+			return false;
+
+		unsigned open = add_node(root, NONE);
+		if (root.type() == Tag::EMPTY) {
+			_link_sub_nodes();
+			return true;
+		}
+
+		for (Token t = root.next_token(); t.type() != Token::END; ) {
+
+			Comment const comment(t);
+			if (comment.valid()) {
+				t = comment.next_token();
+				continue;
+			}
+
+			Tag const tag(t);
+			if (tag.type() == Tag::INVALID) {
+				t = t.next();
+				continue;
+			}
+
+			t = tag.next_token();
+
+			if (tag.node()) {
+				unsigned const node = add_node(tag, open);
+				if (tag.type() == Tag::START)
+					open = node;
+				continue;
+			}
+
+			/* end tag must match the innermost open node */
+			Node &node = _nodes[open];
+			if (tag.name().len() != node.name_len
+			 || strcmp(tag.name().start(), _addr + node.start + 1, node.name_len))
+				return false;
+
+			node.end = tag.token().start() - _addr;
+
+			if (open == 0) {
+				_link_sub_nodes();
+				return true;
+			}
+
+			open = node.parent;
+		}
+	} catch (Xml_node::Invalid_syntax) { }
+
+	return false;
+}
+
+
+Genode::Xml_node Genode::Xml_node_index::xml() const
+{
+	if (_valid)
+		return Xml_node(*this, 0);
+
+	return Xml_node(_addr, _max_len);
+}
+
 #endif /* _INCLUDE__UTIL__XML_NODE_H_ */
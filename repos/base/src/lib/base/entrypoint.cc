@@ -331,10 +331,18 @@ Entrypoint::Entrypoint(Env &env)
 
 
 Entrypoint::Entrypoint(Env &env, size_t stack_size, char const *name)
+:
+	Entrypoint(env, stack_size, name, Affinity::Location())
+{ }
+
+
+Entrypoint::Entrypoint(Env &env, size_t stack_size, char const *name,
+                       Affinity::Location location)
 :
 	_env(env),
-	_rpc_ep(&env.pd(), stack_size, name), _signalling_initialized(true)
+	_rpc_ep(&env.pd(), stack_size, name, true, location),
+	_signalling_initialized(true)
 {
-	_signal_proxy_thread.construct(env, *this);
+	_signal_proxy_thread.construct(env, *this, location, env.cpu());
 }
 
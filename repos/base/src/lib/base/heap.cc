@@ -31,11 +31,115 @@ namespace {
 		 * to smaller allocations, this memory is released to
 		 * the RAM session when 'free()' is called.
 		 */
-		BIG_ALLOCATION_THRESHOLD = 64*1024 /* in bytes */
+		BIG_ALLOCATION_THRESHOLD = 64*1024, /* in bytes */
+
+		/*
+		 * Chunks of heaps that return unused dataspaces have a fixed size.
+		 * The end of each chunk is excluded from the local allocator to
+		 * prevent the merging of adjacent chunks into one block.
+		 */
+		RETURNABLE_CHUNK_SIZE = 256*1024, /* in bytes */
+		CHUNK_GUARD           = 16,
+
+		/*
+		 * Small allocations of heaps that return unused dataspaces are
+		 * served from slab pages. The first bytes of each page hold the
+		 * 'Slab_page' header.
+		 */
+		SLAB_PAGE_SIZE_LOG2 = 12,
+		SLAB_PAGE_SIZE      = 1 << SLAB_PAGE_SIZE_LOG2,
+		SLAB_HEADER_SIZE    = 64,
+		SLAB_MAX_SIZE       = 256,
 	};
+
+	size_t const slab_sizes[] = { 16, 32, 48, 64, 96, 128, 192, SLAB_MAX_SIZE };
+
+	unsigned slab_class(size_t size)
+	{
+		unsigned c = 0;
+		while (slab_sizes[c] < size) c++;
+		return c;
+	}
+
+	/**
+	 * Return bit of the chunk's slab-page bitmap that corresponds to 'addr'
+	 */
+	uint64_t slab_page_bit(void const *chunk_base, void const *addr)
+	{
+		return (uint64_t)1 << (((addr_t)addr - (addr_t)chunk_base) >> SLAB_PAGE_SIZE_LOG2);
+	}
+
+	size_t meta_ds_size() { return align_addr(sizeof(Heap) + 8*1024, 12); }
 }
 
 
+struct Heap::Slab_page
+{
+	struct Entry { Entry *next; };
+
+	/*
+	 * Noncopyable
+	 */
+	Slab_page(Slab_page const &);
+	Slab_page &operator = (Slab_page const &);
+
+	Slab_page *prev      = nullptr; /* within list of partially used pages */
+	Slab_page *next      = nullptr;
+	Entry     *free_list = nullptr;
+	unsigned const cls;
+	unsigned       used  = 0;
+
+	Slab_page(unsigned cls) : cls(cls)
+	{
+		static_assert(sizeof(Slab_page) <= SLAB_HEADER_SIZE,
+		              "slab-page header exceeds reserved space");
+
+		size_t const size = slab_sizes[cls];
+		addr_t const base = (addr_t)this + SLAB_HEADER_SIZE;
+
+		for (size_t i = (SLAB_PAGE_SIZE - SLAB_HEADER_SIZE)/size; i--; ) {
+			Entry * const e = (Entry *)(base + i*size);
+			e->next   = free_list;
+			free_list = e;
+		}
+	}
+
+	bool full() const { return !free_list; }
+
+	void *alloc()
+	{
+		Entry * const e = free_list;
+		free_list = e->next;
+		used++;
+		return e;
+	}
+
+	void free(void *addr)
+	{
+		Entry * const e = (Entry *)addr;
+		e->next   = free_list;
+		free_list = e;
+		used--;
+	}
+
+	void link(Slab_page *&head)
+	{
+		prev = nullptr;
+		next = head;
+		if (head) head->prev = this;
+		head = this;
+	}
+
+	void unlink(Slab_page *&head)
+	{
+		if (prev) prev->next = next;
+		else      head       = next;
+		if (next) next->prev = prev;
+		prev = next = nullptr;
+	}
+};
+
+
 void Heap::Dataspace_pool::remove_and_free(Dataspace &ds)
 {
 	/*
@@ -104,7 +208,22 @@ Heap::Dataspace *Heap::_allocate_dataspace(size_t size, bool enforce_separate_me
 		return nullptr;
 	}
 
-	if (enforce_separate_metadata) {
+	if (_meta) {
+
+		/* keep the Dataspace structure apart from the chunk */
+		if (!_meta->alloc(sizeof(Heap::Dataspace), &ds_meta_data_addr)) {
+			warning("could not allocate dataspace meta data");
+			_ds_pool.region_map->detach(ds_addr);
+			_ds_pool.ram_alloc->free(new_ds_cap);
+			return nullptr;
+		}
+
+		if (!enforce_separate_metadata) {
+			_alloc->add_range((addr_t)ds_addr, size - CHUNK_GUARD);
+			_unused_bytes += size;
+		}
+
+	} else if (enforce_separate_metadata) {
 
 		/* allocate the Dataspace structure */
 		if (!_unsynchronized_alloc(sizeof(Heap::Dataspace), &ds_meta_data_addr)) {
@@ -126,57 +245,51 @@ Heap::Dataspace *Heap::_allocate_dataspace(size_t size, bool enforce_separate_me
 	}
 
 	ds = construct_at<Dataspace>(ds_meta_data_addr, new_ds_cap, ds_addr, size);
+	ds->chunk = !enforce_separate_metadata;
 
 	_ds_pool.insert(ds);
 
+	if (_meta)
+		_ds_tree.insert(ds);
+
 	return ds;
 }
 
 
-bool Heap::_try_local_alloc(size_t size, void **out_addr)
+bool Heap::_try_local_alloc(size_t size, void **out_addr, int align)
 {
-	if (_alloc->alloc_aligned(size, out_addr, log2(16)).error())
+	if (_alloc->alloc_aligned(size, out_addr, align).error())
 		return false;
 
+	if (_meta) {
+		if (Dataspace *ds = _ds_at((addr_t)*out_addr)) {
+			if (!ds->used)
+				_unused_bytes -= ds->size;
+			ds->used += size;
+		}
+	}
+
 	_quota_used += size;
 	return true;
 }
 
 
-bool Heap::_unsynchronized_alloc(size_t size, void **out_addr)
+bool Heap::_local_alloc(size_t size, void **out_addr, int align)
 {
 	size_t dataspace_size;
 
-	if (size >= BIG_ALLOCATION_THRESHOLD) {
-
-		/*
-		 * big allocation
-		 *
-		 * in this case, we allocate one dataspace without any meta data in it
-		 * and return its local address without going through the allocator.
-		 */
-
-		/* align to 4K page */
-		dataspace_size = align_addr(size, 12);
-
-		Heap::Dataspace *ds = _allocate_dataspace(dataspace_size, true);
+	/* try allocation at our local allocator */
+	if (_try_local_alloc(size, out_addr, align))
+		return true;
 
-		if (!ds) {
-			warning("could not allocate dataspace");
+	/* the fixed chunk size covers all allocations below the big threshold */
+	if (_meta) {
+		if (!_allocate_dataspace(RETURNABLE_CHUNK_SIZE, false))
 			return false;
-		}
-
-		_quota_used += ds->size;
 
-		*out_addr = ds->local_addr;
-
-		return true;
+		return _try_local_alloc(size, out_addr, align);
 	}
 
-	/* try allocation at our local allocator */
-	if (_try_local_alloc(size, out_addr))
-		return true;
-
 	/*
 	 * Calculate block size of needed backing store. The block must hold the
 	 * requested 'size' and we add some space for meta data
@@ -209,7 +322,126 @@ bool Heap::_unsynchronized_alloc(size_t size, void **out_addr)
 	}
 
 	/* allocate originally requested block */
-	return _try_local_alloc(size, out_addr);
+	return _try_local_alloc(size, out_addr, align);
+}
+
+
+bool Heap::_slab_alloc_small(size_t size, void **out_addr)
+{
+	unsigned const cls = slab_class(size);
+
+	Slab_page *page = _slab_partial[cls];
+	if (!page) {
+		void *addr = nullptr;
+		if (!_local_alloc(SLAB_PAGE_SIZE, &addr, SLAB_PAGE_SIZE_LOG2))
+			return false;
+
+		Dataspace &ds = *_ds_at((addr_t)addr);
+		ds.slab_pages |= slab_page_bit(ds.local_addr, addr);
+
+		page = construct_at<Slab_page>(addr, cls);
+		page->link(_slab_partial[cls]);
+		_slab_bytes += SLAB_PAGE_SIZE;
+	}
+
+	*out_addr = page->alloc();
+	if (page->full())
+		page->unlink(_slab_partial[cls]);
+
+	_slab_used += slab_sizes[cls];
+	return true;
+}
+
+
+void Heap::_slab_free(Dataspace &ds, void *addr)
+{
+	Slab_page &page = *(Slab_page *)((addr_t)addr & ~((addr_t)SLAB_PAGE_SIZE - 1));
+	unsigned const cls = page.cls;
+
+	if (page.full())
+		page.link(_slab_partial[cls]);
+
+	page.free(addr);
+	_slab_used -= slab_sizes[cls];
+
+	/* keep the last partially used page of the size class */
+	if (page.used || (!page.prev && !page.next))
+		return;
+
+	page.unlink(_slab_partial[cls]);
+	ds.slab_pages &= ~slab_page_bit(ds.local_addr, &page);
+	_slab_bytes -= SLAB_PAGE_SIZE;
+
+	_alloc->free(&page);
+	_quota_used -= SLAB_PAGE_SIZE;
+	_chunk_freed(ds, SLAB_PAGE_SIZE);
+}
+
+
+void Heap::_chunk_freed(Dataspace &ds, size_t size)
+{
+	ds.used -= size;
+	if (ds.used)
+		return;
+
+	_unused_bytes += ds.size;
+
+	/* retain up to '_reserve' bytes of unused chunks as hysteresis */
+	if (_unused_bytes > _reserve)
+		_return_chunk(ds);
+}
+
+
+void Heap::_return_chunk(Dataspace &ds)
+{
+	if (_alloc->remove_range((addr_t)ds.local_addr, ds.size - CHUNK_GUARD)) {
+		warning("heap: could not remove unused chunk from local allocator");
+		return;
+	}
+
+	_unused_bytes -= ds.size;
+	_returned++;
+
+	_ds_tree.remove(&ds);
+	_ds_pool.remove_and_free(ds);
+	_meta->free(&ds, sizeof(Dataspace));
+}
+
+
+bool Heap::_unsynchronized_alloc(size_t size, void **out_addr)
+{
+	size_t dataspace_size;
+
+	if (size >= BIG_ALLOCATION_THRESHOLD) {
+
+		/*
+		 * big allocation
+		 *
+		 * in this case, we allocate one dataspace without any meta data in it
+		 * and return its local address without going through the allocator.
+		 */
+
+		/* align to 4K page */
+		dataspace_size = align_addr(size, 12);
+
+		Heap::Dataspace *ds = _allocate_dataspace(dataspace_size, true);
+
+		if (!ds) {
+			warning("could not allocate dataspace");
+			return false;
+		}
+
+		_quota_used += ds->size;
+
+		*out_addr = ds->local_addr;
+
+		return true;
+	}
+
+	if (_meta && size <= SLAB_MAX_SIZE)
+		return _slab_alloc_small(size, out_addr);
+
+	return _local_alloc(size, out_addr, log2(16));
 }
 
 
@@ -231,6 +463,41 @@ void Heap::free(void *addr, size_t)
 	/* serialize access of heap functions */
 	Lock::Guard lock_guard(_lock);
 
+	if (_meta) {
+
+		Heap::Dataspace *ds = _ds_at((addr_t)addr);
+		if (!ds) {
+			warning("heap could not free memory block");
+			return;
+		}
+
+		/* big allocation */
+		if (!ds->chunk) {
+			size_t const size = ds->size;
+			_ds_tree.remove(ds);
+			_ds_pool.remove_and_free(*ds);
+			_meta->free(ds, sizeof(Dataspace));
+			_quota_used -= size;
+			return;
+		}
+
+		if (ds->slab_pages & slab_page_bit(ds->local_addr, addr)) {
+			_slab_free(*ds, addr);
+			return;
+		}
+
+		size_t const size = _alloc->size_at(addr);
+		if (!size) {
+			warning("heap could not free memory block");
+			return;
+		}
+
+		_alloc->free(addr, size);
+		_quota_used -= size;
+		_chunk_freed(*ds, size);
+		return;
+	}
+
 	/* try to find the size in our local allocator */
 	size_t const size = _alloc->size_at(addr);
 
@@ -281,8 +548,110 @@ Heap::Heap(Ram_allocator *ram_alloc,
 }
 
 
+bool Heap::return_unused_dataspaces(size_t reserve)
+{
+	Lock::Guard lock_guard(_lock);
+
+	if (_meta) {
+		_reserve = reserve;
+		return true;
+	}
+
+	/* the meta data can only be separated as long as the heap is empty */
+	if (_ds_pool.first() || _alloc->avail())
+		return false;
+
+	/*
+	 * The meta heap is placed at the beginning of its own dataspace, the
+	 * remainder serves as its initial backing store.
+	 */
+	size_t const size = meta_ds_size();
+
+	Ram_dataspace_capability ds_cap;
+	void *ds_addr = nullptr;
+	try {
+		ds_cap  = _ds_pool.ram_alloc->alloc(size);
+		ds_addr = _ds_pool.region_map->attach(ds_cap);
+	}
+	catch (Out_of_ram) {
+		return false;
+	}
+	catch (Region_map::Invalid_dataspace) {
+		_ds_pool.ram_alloc->free(ds_cap);
+		return false;
+	}
+	catch (Region_map::Region_conflict) {
+		_ds_pool.ram_alloc->free(ds_cap);
+		return false;
+	}
+
+	addr_t const static_addr = align_addr((addr_t)ds_addr + sizeof(Heap), 4);
+
+	_meta = construct_at<Heap>(ds_addr, _ds_pool.ram_alloc, _ds_pool.region_map,
+	                           (size_t)UNLIMITED, (void *)static_addr,
+	                           (addr_t)ds_addr + size - static_addr);
+	_meta_ds = ds_cap;
+	_reserve = reserve;
+
+	/* let the local allocator obtain its meta data from the meta heap */
+	_alloc.construct(_meta);
+	return true;
+}
+
+
+Heap::Stats Heap::stats()
+{
+	Lock::Guard lock_guard(_lock);
+
+	Stats stats { 0, _quota_used - _slab_bytes + _slab_used, _slab_bytes,
+	              0, _returned };
+
+	for (Heap::Dataspace *ds = _ds_pool.first(); ds; ds = ds->next()) {
+		stats.backing += ds->size;
+		stats.dataspaces++;
+	}
+
+	if (_meta) {
+		Stats const meta = _meta->stats();
+		stats.backing    += meta.backing + meta_ds_size();
+		stats.dataspaces += meta.dataspaces + 1;
+	}
+
+	return stats;
+}
+
+
 Heap::~Heap()
 {
+	/*
+	 * If unused dataspaces are returned, the meta data of the local allocator
+	 * and the 'Dataspace' objects reside at the meta heap, which is
+	 * destructed last.
+	 */
+	if (_meta) {
+
+		/* release slab pages kept for subsequent allocations */
+		for (unsigned i = 0; i < SLAB_CLASSES; i++)
+			for (Slab_page *page; (page = _slab_partial[i]); ) {
+				page->unlink(_slab_partial[i]);
+				if (!page->used)
+					_alloc->free(page);
+			}
+
+		_alloc.destruct();
+
+		for (Heap::Dataspace *ds; (ds = _ds_pool.first()); ) {
+			_ds_pool.remove_and_free(*ds);
+			_meta->free(ds, sizeof(Dataspace));
+		}
+
+		Region_map &rm = *_ds_pool.region_map;
+		_meta->~Heap();
+		rm.detach(_meta);
+		_ds_pool.ram_alloc->free(_meta_ds);
+		return;
+	}
+
 	/*
 	 * Revert allocations of heap-internal 'Dataspace' objects. Otherwise, the
 	 * subsequent destruction of the 'Allocator_avl' would detect those blocks
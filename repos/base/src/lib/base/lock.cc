@@ -13,6 +13,7 @@
 
 /* Genode includes */
 #include <base/cancelable_lock.h>
+#include <base/trace/events.h>
 #include <cpu/memory_barrier.h>
 
 /* base-internal includes */
@@ -60,15 +61,76 @@ void Cancelable_lock::Applicant::wake_up()
  ** Cancelable lock **
  *********************/
 
+enum { MAX_SPIN_ROUNDS = 10 };
+
+
 void Cancelable_lock::lock()
 {
 	Applicant myself(Thread::myself());
 
 	spinlock_lock(&_spinlock_state);
 
+	/*
+	 * If the lock is taken, spin with exponential backoff before blocking.
+	 * Critical sections are often much shorter than the block-and-wake-up
+	 * path through the kernel. Spinning is skipped if other applicants are
+	 * already blocked, which are served first on 'unlock' anyway.
+	 */
+	for (unsigned round = 0;; round++) {
+
+		if (cmpxchg(&_state, UNLOCKED, LOCKED)) {
+
+			/* we got the lock */
+			_owner          =  myself;
+			_last_applicant = &_owner;
+
+			if (round) {
+				_contention.spun++;
+				if (_spin_rounds < MAX_SPIN_ROUNDS)
+					_spin_rounds++;
+			}
+			spinlock_unlock(&_spinlock_state);
+			return;
+		}
+
+		if (!round)
+			_contention.contended++;
+
+		if (round >= _spin_rounds || _owner == myself
+		 || _owner.applicant_to_wake_up())
+			break;
+
+		spinlock_unlock(&_spinlock_state);
+
+		/* poll the lock state without holding the spinlock */
+		for (unsigned i = 0; i < (1U << round) && _state == LOCKED; i++)
+			memory_barrier();
+
+		spinlock_lock(&_spinlock_state);
+	}
+
+	/* spinning was futile, spin less next time but keep probing */
+	if (_spin_rounds > 1)
+		_spin_rounds--;
+
+	_contention.blocked++;
+
+	unsigned const spin_rounds = _spin_rounds;
+	spinlock_unlock(&_spinlock_state);
+
+	/*
+	 * Emit trace event before entering the applicants list because the
+	 * tracing back end may acquire locks itself.
+	 */
+	{
+		Trace::Lock_contention trace_event(this, spin_rounds);
+	}
+
+	spinlock_lock(&_spinlock_state);
+
 	if (cmpxchg(&_state, UNLOCKED, LOCKED)) {
 
-		/* we got the lock */
+		/* the lock got released in the meantime */
 		_owner          =  myself;
 		_last_applicant = &_owner;
 		spinlock_unlock(&_spinlock_state);
@@ -17,6 +17,7 @@
 #include <base/signal.h>
 #include <base/thread.h>
 #include <base/sleep.h>
+#include <base/rw_lock.h>
 #include <base/trace/events.h>
 #include <util/reconstructible.h>
 
@@ -135,26 +136,26 @@ namespace Genode {
 			 * scalability problem, we might introduce a more sophisticated
 			 * associative data structure.
 			 */
-			Lock mutable                        _lock { };
+			Rw_lock mutable                     _lock { };
 			List<List_element<Signal_context> > _list { };
 
 		public:
 
 			void insert(List_element<Signal_context> *le)
 			{
-				Lock::Guard guard(_lock);
+				Rw_lock::Write_guard guard(_lock);
 				_list.insert(le);
 			}
 
 			void remove(List_element<Signal_context> *le)
 			{
-				Lock::Guard guard(_lock);
+				Rw_lock::Write_guard guard(_lock);
 				_list.remove(le);
 			}
 
 			bool test_and_lock(Signal_context *context) const
 			{
-				Lock::Guard guard(_lock);
+				Rw_lock::Read_guard guard(_lock);
 
 				/* search list for context */
 				List_element<Signal_context> const *le = _list.first();
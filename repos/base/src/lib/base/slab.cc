@@ -407,10 +407,13 @@ void Slab::_free(void *addr)
 	 * Release completely free slab blocks if the total number of free slab
 	 * entries exceeds the capacity of two slab blocks. This way we keep
 	 * a modest amount of available entries around so that thrashing effects
-	 * are mitigated.
+	 * are mitigated. While the backing store is temporarily disabled, e.g.,
+	 * during 'Allocator_avl_tpl::add_range', blocks are kept because they
+	 * could not be handed back.
 	 */
 	_curr_sb = &block;
-	while (_total_avail > 2*_entries_per_block
+	while (_backing_store
+	 && _total_avail > 2*_entries_per_block
 	 && _num_blocks > 1
 	 && _curr_sb->avail() == _entries_per_block) {
 		_free_curr_sb();
@@ -35,6 +35,9 @@ Linker::Dependency::Dependency(Env &env, Allocator &md_alloc,
 
 Linker::Dependency::~Dependency()
 {
+	/* cached look-ups may refer to this dependency or its object */
+	flush_symbol_cache();
+
 	if (!_obj.unload())
 		return;
 
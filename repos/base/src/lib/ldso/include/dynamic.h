@@ -20,6 +20,8 @@
 
 namespace Linker {
 	struct Hash_table;
+	struct Gnu_hash_table;
+	struct Symbol_hash;
 	struct Dynamic;
 }
 
@@ -53,6 +55,102 @@ struct Linker::Hash_table
 };
 
 
+/**
+ * GNU hash table and hash function
+ *
+ * In contrast to the SysV hash table, the chains refer to consecutive
+ * entries of the symbol table, which is sorted by bucket. Each chain entry
+ * holds the hash value of the symbol with the lowest bit marking the end of
+ * the chain. A bloom filter in front of the buckets rejects most look-ups of
+ * symbols not defined by the object without touching the chains at all.
+ */
+struct Linker::Gnu_hash_table
+{
+	enum { BLOOM_BITS = sizeof(Elf::Addr) * 8 };
+
+	Elf::Hashelt nbuckets()    const { return ((Elf::Hashelt const *)this)[0]; }
+	Elf::Hashelt symoffset()   const { return ((Elf::Hashelt const *)this)[1]; }
+	Elf::Hashelt bloom_size()  const { return ((Elf::Hashelt const *)this)[2]; }
+	Elf::Hashelt bloom_shift() const { return ((Elf::Hashelt const *)this)[3]; }
+
+	Elf::Addr const *bloom() const {
+		return (Elf::Addr const *)((Elf::Hashelt const *)this + 4); }
+
+	Elf::Hashelt const *buckets() const {
+		return (Elf::Hashelt const *)(bloom() + bloom_size()); }
+
+	/**
+	 * Return chain entry of symbol, valid for indices from 'symoffset' on
+	 */
+	Elf::Hashelt chain(unsigned long sym_index) const {
+		return (buckets() + nbuckets())[sym_index - symoffset()]; }
+
+	/**
+	 * Check bloom filter, false means the symbol is not defined
+	 */
+	bool may_contain(Elf::Hashelt hash) const
+	{
+		if (!bloom_size())
+			return false;
+
+		Elf::Addr const word = bloom()[(hash / BLOOM_BITS) % bloom_size()];
+		Elf::Addr const mask = ((Elf::Addr)1 << (hash % BLOOM_BITS))
+		                     | ((Elf::Addr)1 << ((hash >> bloom_shift()) % BLOOM_BITS));
+
+		return (word & mask) == mask;
+	}
+
+	/**
+	 * Return number of entries of the symbol table
+	 *
+	 * The symbol table size is not part of the table, so it is derived from
+	 * the end of the chain of the last non-empty bucket.
+	 */
+	unsigned long num_symbols() const SELF_RELOC
+	{
+		unsigned long last = 0;
+		for (unsigned long i = 0; i < nbuckets(); i++)
+			if (buckets()[i] > last)
+				last = buckets()[i];
+
+		if (last < symoffset())
+			return symoffset();
+
+		while (!(chain(last) & 1))
+			last++;
+
+		return last + 1;
+	}
+
+	/**
+	 * Hash function of the GNU toolchain (Bernstein)
+	 */
+	static Elf::Hashelt hash(char const *name)
+	{
+		unsigned const char *p = (unsigned char const *)name;
+		Elf::Hashelt         h = 5381;
+
+		while (*p)
+			h = (h << 5) + h + *p++;
+
+		return h;
+	}
+};
+
+
+/**
+ * Hash values of a symbol name for both kinds of hash tables
+ */
+struct Linker::Symbol_hash
+{
+	unsigned long sysv;
+	Elf::Hashelt  gnu;
+
+	Symbol_hash(char const *name)
+	: sysv(Hash_table::hash(name)), gnu(Gnu_hash_table::hash(name)) { }
+};
+
+
 /**
  * .dynamic section entries
  */
@@ -94,6 +192,8 @@ class Linker::Dynamic
 		Allocator           *_md_alloc      = nullptr;
 
 		Hash_table          *_hash_table    = nullptr;
+		Gnu_hash_table      *_gnu_hash_table = nullptr;
+		unsigned long        _num_symbols   = 0;
 
 		Elf::Rela           *_reloca        = nullptr;
 		unsigned long        _reloca_size   = 0;
@@ -158,6 +258,7 @@ class Linker::Dynamic
 				case DT_PLTRELSZ: _pltrel_size = d->un.val;                             break;
 				case DT_PLTGOT  : _section<typeof(_pltgot)>(&_pltgot, d);               break;
 				case DT_HASH    : _section<typeof(_hash_table)>(&_hash_table, d);       break;
+				case DT_GNU_HASH: _section<typeof(_gnu_hash_table)>(&_gnu_hash_table, d); break;
 				case DT_RELA    : _section<typeof(_reloca)>(&_reloca, d);               break;
 				case DT_RELASZ  : _reloca_size = d->un.val;                             break;
 				case DT_SYMTAB  : _section<typeof(_symtab)>(&_symtab, d);               break;
@@ -173,6 +274,77 @@ class Linker::Dynamic
 					break;
 				}
 			}
+
+			_num_symbols = _hash_table     ? _hash_table->nchains()
+			             : _gnu_hash_table ? _gnu_hash_table->num_symbols() : 0;
+		}
+
+		bool _matches(Elf::Sym const *sym, char const *name) const
+		{
+			/* this omitts everything but 'NOTYPE', 'OBJECT', and 'FUNC' */
+			if (sym->type() > STT_FUNC)
+				return false;
+
+			if (sym->st_value == 0)
+				return false;
+
+			/* check for symbol name */
+			char const *sym_name = symbol_name(*sym);
+			return name[0] == sym_name[0] && !strcmp(name, sym_name);
+		}
+
+		Elf::Sym const *_lookup_gnu(char const *name, Elf::Hashelt hash) const
+		{
+			Gnu_hash_table const &h = *_gnu_hash_table;
+
+			if (!h.nbuckets() || !h.may_contain(hash))
+				return nullptr;
+
+			unsigned long sym_index = h.buckets()[hash % h.nbuckets()];
+
+			/* empty bucket */
+			if (sym_index < h.symoffset())
+				return nullptr;
+
+			/* traverse hash chain */
+			for (;; sym_index++) {
+
+				/* bad object */
+				if (sym_index >= _num_symbols)
+					return nullptr;
+
+				Elf::Hashelt const chain_hash = h.chain(sym_index);
+
+				/* compare the hash values, ignoring the end-of-chain bit */
+				if ((chain_hash | 1) == (hash | 1) && _matches(_symtab + sym_index, name))
+					return _symtab + sym_index;
+
+				if (chain_hash & 1)
+					return nullptr;
+			}
+		}
+
+		Elf::Sym const *_lookup_sysv(char const *name, unsigned long hash) const
+		{
+			Hash_table *h = _hash_table;
+
+			if (!h->buckets())
+				return nullptr;
+
+			unsigned long sym_index = h->buckets()[hash % h->nbuckets()];
+
+			/* traverse hash chain */
+			for (; sym_index != STN_UNDEF; sym_index = h->chains()[sym_index])
+			{
+				/* bad object */
+				if (sym_index > h->nchains())
+					return nullptr;
+
+				if (_matches(_symtab + sym_index, name))
+					return _symtab + sym_index;
+			}
+
+			return nullptr;
 		}
 
 	public:
@@ -216,7 +388,7 @@ class Linker::Dynamic
 
 		Elf::Sym const *symbol(unsigned sym_index) const
 		{
-			if (sym_index > _hash_table->nchains())
+			if (sym_index > _num_symbols)
 				return nullptr;
 
 			return _symtab + sym_index;
@@ -233,47 +405,37 @@ class Linker::Dynamic
 
 		Dependency const &dep() const { return *_dep; }
 
+		/**
+		 * Return number of entries of the symbol table
+		 */
+		unsigned long num_symbols() const { return _num_symbols; }
+
 		/*
-		 * Use DT_HASH table address for linker, assuming that it will always be at
-		 * the beginning of the file
+		 * Use the address of the first hash table for linker, assuming that it
+		 * will always be at the beginning of the file
 		 */
-		Elf::Addr link_map_addr() const { return trunc_page((Elf::Addr)_hash_table); }
+		Elf::Addr link_map_addr() const
+		{
+			Elf::Addr const sysv = (Elf::Addr)_hash_table;
+			Elf::Addr const gnu  = (Elf::Addr)_gnu_hash_table;
+
+			return trunc_page((sysv && (!gnu || sysv < gnu)) ? sysv : gnu);
+		}
 
 		/**
 		 * Lookup symbol name in this ELF
+		 *
+		 * The GNU hash table is preferred if present because its bloom
+		 * filter avoids traversing hash chains for most symbols that are
+		 * not defined by this object.
 		 */
-		Elf::Sym const *lookup_symbol(char const *name, unsigned long hash) const
+		Elf::Sym const *lookup_symbol(char const *name, Symbol_hash const &hash) const
 		{
-			Hash_table *h = _hash_table;
-
-			if (!h->buckets())
-				return nullptr;
-
-			unsigned long sym_index = h->buckets()[hash % h->nbuckets()];
-
-			/* traverse hash chain */
-			for (; sym_index != STN_UNDEF; sym_index = h->chains()[sym_index])
-			{
-				/* bad object */
-				if (sym_index > h->nchains())
-					return nullptr;
-
-				Elf::Sym const *sym      = symbol(sym_index);
-				char const     *sym_name = symbol_name(*sym);
+			if (_gnu_hash_table)
+				return _lookup_gnu(name, hash.gnu);
 
-				/* this omitts everything but 'NOTYPE', 'OBJECT', and 'FUNC' */
-				if (sym->type() > STT_FUNC)
-					continue;
-
-				if (sym->st_value == 0)
-					continue;
-
-				/* check for symbol name */
-				if (name[0] != sym_name[0] || strcmp(name, sym_name))
-					continue;
-
-				return sym;
-			}
+			if (_hash_table)
+				return _lookup_sysv(name, hash.sysv);
 
 			return nullptr;
 		}
@@ -285,7 +447,7 @@ class Linker::Dynamic
 		{
 			addr_t const reloc_base = _obj.reloc_base();
 
-			for (unsigned long i = 0; i < _hash_table->nchains(); i++)
+			for (unsigned long i = 0; i < _num_symbols; i++)
 			{
 				Elf::Sym const *sym = symbol(i);
 				if (!sym)
@@ -82,6 +82,13 @@ namespace Linker {
 	Elf::Sym const *lookup_symbol(char const *name, Dependency const &dep, Elf::Addr *base,
 	                              bool undef = false, bool other = false);
 
+	/**
+	 * Invalidate the cached results of 'lookup_symbol'
+	 *
+	 * Must be called whenever a dependency is destroyed.
+	 */
+	void flush_symbol_cache();
+
 	/**
 	 * Load an ELF (setup segments and map program header)
 	 *
@@ -40,9 +40,11 @@ namespace Linker {
 	struct Link_map;
 	struct Debug;
 	struct Config;
+	struct Symbol_cache;
 };
 
-static    Binary *binary_ptr = nullptr;
+static    Binary       *binary_ptr       = nullptr;
+static    Symbol_cache *symbol_cache_ptr = nullptr;
 bool      Linker::verbose  = false;
 Link_map *Link_map::first;
 
@@ -174,7 +176,7 @@ class Linker::Elf_object : public Object, private Fifo<Elf_object>::Element
 			return _dyn.symbol_name(sym);
 		}
 
-		Elf::Sym const *lookup_symbol(char const *name, unsigned long hash) const
+		Elf::Sym const *lookup_symbol(char const *name, Symbol_hash const &hash) const
 		{
 			return _dyn.lookup_symbol(name, hash);
 		}
@@ -338,6 +340,115 @@ static int exit_status;
 static void exit_on_suspended() { genode_exit(exit_status); }
 
 
+/**
+ * Cache of symbol look-ups by name
+ *
+ * Most symbols are referenced by several objects, e.g., 'memcpy' or the
+ * type information of the base library, and each of those references would
+ * otherwise search the dependency list from its beginning. The cache is
+ * direct mapped and remembers the last look-up per slot. An entry is valid
+ * for the dependency list it was resolved in and as long as no dependency is
+ * destroyed.
+ */
+class Linker::Symbol_cache
+{
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		Symbol_cache(Symbol_cache const &);
+		Symbol_cache &operator = (Symbol_cache const &);
+
+		enum { MIN_ENTRIES = 64, MAX_ENTRIES = 4096 };
+
+		struct Entry
+		{
+			Dependency const *first;
+			Elf_object const *elf;
+			Elf::Sym   const *sym;
+			Elf::Hashelt      hash;
+			bool              undef;
+		};
+
+		Allocator     &_alloc;
+		unsigned long  _num_entries;
+		Entry         *_entries;
+		Lock           _lock { };
+
+		static unsigned long _num_entries_for(unsigned long num_symbols)
+		{
+			unsigned long n = MIN_ENTRIES;
+			while (n < MAX_ENTRIES && n < num_symbols / 4)
+				n <<= 1;
+			return n;
+		}
+
+		Entry &_entry(Elf::Hashelt hash) { return _entries[hash & (_num_entries - 1)]; }
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param num_symbols  number of symbols of the loaded objects,
+		 *                     used to dimension the cache
+		 */
+		Symbol_cache(Allocator &alloc, unsigned long num_symbols)
+		:
+			_alloc(alloc), _num_entries(_num_entries_for(num_symbols)),
+			_entries((Entry *)alloc.alloc(_num_entries*sizeof(Entry)))
+		{
+			flush();
+		}
+
+		~Symbol_cache() { _alloc.free(_entries, _num_entries*sizeof(Entry)); }
+
+		/**
+		 * Look up cached symbol
+		 *
+		 * \return  symbol or nullptr on cache miss
+		 */
+		Elf::Sym const *lookup(char const *name, Symbol_hash const &hash,
+		                       Dependency const &first, bool undef, Elf::Addr *base)
+		{
+			Lock::Guard guard(_lock);
+
+			Entry const &e = _entry(hash.gnu);
+			if (!e.sym || e.hash != hash.gnu || e.first != &first || e.undef != undef)
+				return nullptr;
+
+			if (strcmp(name, e.elf->symbol_name(*e.sym)))
+				return nullptr;
+
+			*base = e.elf->reloc_base();
+			return e.sym;
+		}
+
+		void insert(Symbol_hash const &hash, Dependency const &first, bool undef,
+		            Elf_object const &elf, Elf::Sym const &sym)
+		{
+			Lock::Guard guard(_lock);
+
+			_entry(hash.gnu) = Entry { &first, &elf, &sym, hash.gnu, undef };
+		}
+
+		void flush()
+		{
+			Lock::Guard guard(_lock);
+
+			memset(_entries, 0, _num_entries*sizeof(Entry));
+		}
+};
+
+
+void Linker::flush_symbol_cache()
+{
+	if (symbol_cache_ptr)
+		symbol_cache_ptr->flush();
+}
+
+
 /**
  * The dynamic binary to load
  */
@@ -367,6 +478,13 @@ struct Linker::Binary : private Root_object, public Elf_object
 		/* load dependencies */
 		binary->load_needed(env, md_alloc, deps(), DONT_KEEP);
 
+		/* dimension symbol cache according to the symbols of the program */
+		unsigned long num_symbols = 0;
+		for (Dependency const *d = deps().head(); d; d = d->next())
+			num_symbols += d->obj().dynamic().num_symbols();
+
+		symbol_cache_ptr = new (md_alloc) Symbol_cache(md_alloc, num_symbols);
+
 		/* relocate and call constructors */
 		Init::list()->initialize(bind, STAGE_BINARY);
 	}
@@ -529,11 +647,20 @@ Elf::Sym const *Linker::lookup_symbol(char const *name, Dependency const &dep,
                                       Elf::Addr *base, bool undef, bool other)
 {
 	Dependency const *curr        = &dep.first();
-	unsigned long     hash        = Hash_table::hash(name);
+	Symbol_hash const hash(name);
 	Elf::Sym   const *weak_symbol = 0;
-	Elf::Addr        weak_base    = 0;
+	Elf_object const *weak_elf    = 0;
 	Elf::Sym   const *symbol      = 0;
 
+	/*
+	 * The result depends on the dependency list only, except when skipping
+	 * the requesting object for copy relocations
+	 */
+	bool const cached = symbol_cache_ptr && !other;
+	if (cached)
+		if (Elf::Sym const *sym = symbol_cache_ptr->lookup(name, hash, *curr, undef, base))
+			return sym;
+
 	//TODO: handle vertab and search in object list
 	for (;curr; curr = curr->next()) {
 
@@ -553,13 +680,16 @@ Elf::Sym const *Linker::lookup_symbol(char const *name, Dependency const &dep,
 				continue;
 
 			if (!symbol->weak() && symbol->st_shndx != SHN_UNDEF) {
+				if (cached)
+					symbol_cache_ptr->insert(hash, dep.first(), undef, elf, *symbol);
+
 				*base = elf.reloc_base();
 				return symbol;
 			}
 
 			if (!weak_symbol) {
 				weak_symbol = symbol;
-				weak_base   = elf.reloc_base();
+				weak_elf    = &elf;
 			}
 		}
 	}
@@ -579,7 +709,10 @@ Elf::Sym const *Linker::lookup_symbol(char const *name, Dependency const &dep,
 	if (!weak_symbol)
 		throw Not_found(name);
 
-	*base = weak_base;
+	if (cached)
+		symbol_cache_ptr->insert(hash, dep.first(), undef, *weak_elf, *weak_symbol);
+
+	*base = weak_elf->reloc_base();
 	return weak_symbol;
 }
 
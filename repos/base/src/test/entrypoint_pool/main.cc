@@ -0,0 +1,193 @@
+/*
+ * \brief  Test for the pool of per-CPU entrypoints
+ * \author Genode Labs
+ * \date   2018-04-06
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/entrypoint_pool.h>
+#include <base/heap.h>
+#include <base/log.h>
+
+namespace Test {
+
+	using namespace Genode;
+
+	struct Counter;
+	struct Job;
+	struct Main;
+}
+
+
+struct Test::Counter
+{
+	Entrypoint_pool &pool;
+
+	Lock     lock     { };
+	Lock     blockade { Lock::LOCKED };
+	unsigned value    = 0;
+	unsigned target;
+
+	/* bit mask of the entrypoints that incremented the counter */
+	unsigned long eps = 0;
+
+	Counter(Entrypoint_pool &pool, unsigned target)
+	: pool(pool), target(target) { }
+
+	/**
+	 * Increment counter, called by an entrypoint of the pool
+	 */
+	void increment()
+	{
+		Lock::Guard guard(lock);
+
+		for (unsigned i = 0; i < pool.count(); i++)
+			if (pool.entrypoint(i).rpc_ep().is_myself())
+				eps |= 1UL << i;
+
+		if (++value == target)
+			blockade.unlock();
+	}
+
+	void wait() { blockade.lock(); }
+
+	unsigned num_eps() const
+	{
+		unsigned n = 0;
+		for (unsigned long m = eps; m; m >>= 1)
+			n += m & 1;
+		return n;
+	}
+};
+
+
+struct Test::Job : Entrypoint_pool::Job
+{
+	Counter &counter;
+
+	Job(Counter &counter) : counter(counter) { }
+
+	void execute() override
+	{
+		/* keep the entrypoint busy to give the others a chance to steal */
+		for (unsigned volatile i = 0; i < 100000; i++);
+
+		counter.increment();
+	}
+};
+
+
+struct Test::Main
+{
+	enum { NUM_JOBS = 64, MAX_EPS = 16, STACK_SIZE = 2*1024*sizeof(long) };
+
+	Env &env;
+
+	Heap heap { env.ram(), env.rm() };
+
+	Entrypoint_pool pool { env, heap, STACK_SIZE, "pool_ep",
+	                       Entrypoint_pool::LEAST_LOADED, MAX_EPS };
+
+	void test_placement()
+	{
+		enum { SESSIONS_PER_EP = 3 };
+
+		unsigned const count = pool.count();
+		unsigned sessions[MAX_EPS] { };
+
+		for (unsigned i = 0; i < count*SESSIONS_PER_EP; i++) {
+			Entrypoint &ep = pool.acquire(Affinity());
+			for (unsigned j = 0; j < count; j++)
+				if (&pool.entrypoint(j) == &ep)
+					sessions[j]++;
+		}
+
+		for (unsigned i = 0; i < count; i++) {
+			if (sessions[i] != SESSIONS_PER_EP) {
+				error("entrypoint ", i, " serves ", sessions[i], " sessions");
+				throw Exception();
+			}
+			for (unsigned j = 0; j < SESSIONS_PER_EP; j++)
+				pool.release(pool.entrypoint(i));
+		}
+		log("sessions evenly placed");
+	}
+
+	void test_jobs()
+	{
+		Counter counter { pool, NUM_JOBS };
+
+		Constructible<Test::Job> jobs[NUM_JOBS];
+		for (unsigned i = 0; i < NUM_JOBS; i++)
+			jobs[i].construct(counter);
+
+		/* queue all jobs at the first entrypoint */
+		for (unsigned i = 0; i < NUM_JOBS; i++)
+			pool.submit(*jobs[i], pool.entrypoint(0));
+
+		counter.wait();
+		log("executed ", counter.value, " jobs by ", counter.num_eps(),
+		    " entrypoint(s)");
+
+		if (pool.count() > 1 && counter.num_eps() < 2) {
+			error("jobs were not stolen by idle entrypoints");
+			throw Exception();
+		}
+	}
+
+	enum { NUM_SIGNALS = 10 };
+
+	Counter signals { pool, 1 };
+
+	void _handle_signal() { signals.increment(); }
+
+	Entrypoint_pool::Signal_handler<Main> signal_handler {
+		pool, pool.entrypoint(0), *this, &Main::_handle_signal };
+
+	void test_signal()
+	{
+		/*
+		 * The signal is received by the first entrypoint, which submits the
+		 * handler as job. An idle entrypoint is expected to execute it.
+		 */
+		for (unsigned i = 0; i < NUM_SIGNALS; i++) {
+			{
+				Lock::Guard guard(signals.lock);
+				signals.target = i + 1;
+			}
+			Signal_transmitter(signal_handler).submit();
+
+			/* signals are not counted, wait for each one to be handled */
+			signals.wait();
+		}
+		log("handled ", signals.value, " signals");
+
+		if (pool.count() > 1 && !(signals.eps & ~1UL)) {
+			error("signals were handled by the receiving entrypoint only");
+			throw Exception();
+		}
+	}
+
+	Main(Env &env) : env(env)
+	{
+		log("--- test-entrypoint_pool started ---");
+		log("pool of ", pool.count(), " entrypoint(s)");
+
+		test_placement();
+		test_jobs();
+		test_signal();
+
+		log("done");
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
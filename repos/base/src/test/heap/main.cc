@@ -0,0 +1,259 @@
+/*
+ * \brief  Test for the heap's statistics and the return of unused dataspaces
+ * \author Genode Labs
+ * \date   2018-04-20
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#include <base/component.h>
+#include <base/heap.h>
+#include <base/log.h>
+
+using namespace Genode;
+
+
+struct Test_failed : Exception { };
+
+
+static void check(bool condition, char const *what)
+{
+	if (condition)
+		return;
+
+	error("check failed: ", what);
+	throw Test_failed();
+}
+
+
+static void print_stats(char const *label, Heap::Stats const &s)
+{
+	log(label, ": backing=", s.backing, " allocated=", s.allocated,
+	    " slab=", s.slab, " dataspaces=", s.dataspaces,
+	    " returned=", s.returned, " fragmentation=", s.fragmentation(), "%");
+}
+
+
+struct Main
+{
+	Env &_env;
+
+	enum { KB = 1024, CHUNK = 256*KB };
+
+	/**
+	 * Array of blocks of equal size allocated from one heap
+	 */
+	struct Blocks
+	{
+		enum { MAX = 2048 };
+
+		Heap  &heap;
+		size_t size;
+		void  *blocks[MAX] { };
+		unsigned count = 0;
+
+		/*
+		 * Noncopyable
+		 */
+		Blocks(Blocks const &);
+		Blocks &operator = (Blocks const &);
+
+		Blocks(Heap &heap, size_t size, unsigned count)
+		: heap(heap), size(size)
+		{
+			for (; this->count < count && this->count < MAX; this->count++)
+				check(heap.alloc(size, &blocks[this->count]), "alloc");
+		}
+
+		~Blocks() { release(); }
+
+		void release()
+		{
+			for (; count; count--)
+				heap.free(blocks[count - 1], size);
+		}
+	};
+
+	void _test_stats_default()
+	{
+		log("--- statistics of default heap ---");
+
+		Heap heap(_env.ram(), _env.rm());
+
+		{
+			Blocks blocks(heap, 100, 1000);
+
+			Heap::Stats const s = heap.stats();
+			print_stats("default", s);
+
+			check(s.allocated >= 100*1000, "allocated bytes");
+			check(s.backing   >= s.allocated, "backing covers allocations");
+			check(s.slab == 0 && s.returned == 0, "no slabs, nothing returned");
+		}
+
+		/* the default heap keeps its backing store */
+		check(heap.stats().backing > 0, "backing kept");
+	}
+
+	void _test_chunk_return()
+	{
+		log("--- chunk return with hysteresis ---");
+
+		enum { RESERVE = 2*CHUNK };
+
+		Heap heap(_env.ram(), _env.rm());
+		check(heap.return_unused_dataspaces(RESERVE), "enable mode");
+
+		Heap::Stats const initial = heap.stats();
+
+		size_t const ram_before = _env.pd().used_ram().value;
+
+		Blocks blocks(heap, 2*KB, 1200);
+
+		Heap::Stats const full = heap.stats();
+		print_stats("allocated", full);
+
+		check(full.dataspaces >= initial.dataspaces + 8, "chunks allocated");
+
+		blocks.release();
+
+		Heap::Stats const freed = heap.stats();
+		print_stats("freed", freed);
+
+		check(freed.returned > 0, "chunks returned");
+		check(freed.backing + (full.dataspaces - freed.dataspaces)*CHUNK
+		      <= full.backing, "backing shrinks by returned chunks");
+		check(_env.pd().used_ram().value < ram_before + full.backing - initial.backing,
+		      "RAM given back");
+
+		/* the reserve retains unused chunks up to its size */
+		check(freed.backing <= full.backing - (full.dataspaces - initial.dataspaces)*CHUNK
+		                       + RESERVE + CHUNK, "reserve respected");
+
+		/* allocations within the reserve do not cause dataspace churn */
+		for (unsigned i = 0; i < 100; i++) {
+			void *addr = nullptr;
+			check(heap.alloc(2*KB, &addr), "alloc within reserve");
+			heap.free(addr, 2*KB);
+		}
+
+		Heap::Stats const churn = heap.stats();
+		check(churn.returned   == freed.returned,   "no returned chunks");
+		check(churn.dataspaces == freed.dataspaces, "no new chunks");
+
+		/* without reserve, an unused chunk is returned right away */
+		check(heap.return_unused_dataspaces(0), "update reserve");
+
+		void *addr = nullptr;
+		check(heap.alloc(2*KB, &addr), "alloc without reserve");
+		heap.free(addr, 2*KB);
+
+		check(heap.stats().returned > churn.returned, "chunk returned without reserve");
+
+		/* the mode cannot be enabled for a heap in use */
+		Heap used(_env.ram(), _env.rm());
+		check(used.alloc(16, &addr), "alloc at default heap");
+		check(!used.return_unused_dataspaces(), "mode refused for used heap");
+		used.free(addr, 16);
+	}
+
+	void _test_slab_pages()
+	{
+		log("--- slab pages ---");
+
+		enum { PAGE = 4*KB, OBJECTS = 2000, SIZE = 40, CLASS_SIZE = 48 };
+
+		Heap heap(_env.ram(), _env.rm());
+		check(heap.return_unused_dataspaces(), "enable mode");
+
+		Heap::Stats const initial = heap.stats();
+
+		{
+			Blocks blocks(heap, SIZE, OBJECTS);
+
+			Heap::Stats const s = heap.stats();
+			print_stats("small objects", s);
+
+			check(s.slab >= OBJECTS*CLASS_SIZE, "slab pages in use");
+			check(s.slab <  OBJECTS*CLASS_SIZE + OBJECTS*CLASS_SIZE/8 + PAGE,
+			      "slab pages densely used");
+			check(s.allocated >= initial.allocated + OBJECTS*SIZE, "allocated bytes");
+		}
+
+		/* only the last partially used page of the class is kept */
+		Heap::Stats const s = heap.stats();
+		print_stats("freed small objects", s);
+		check(s.slab <= PAGE, "slab pages released");
+		check(s.allocated <= initial.allocated + PAGE, "allocated bytes after free");
+	}
+
+	void _test_big_allocations(bool returning)
+	{
+		log("--- big allocations (", returning ? "returning" : "default", " heap) ---");
+
+		enum { SIZE = 1024*KB };
+
+		Heap heap(_env.ram(), _env.rm());
+		if (returning)
+			check(heap.return_unused_dataspaces(), "enable mode");
+
+		Heap::Stats const before = heap.stats();
+
+		void *addr = nullptr;
+		check(heap.alloc(SIZE, &addr), "big alloc");
+		memset(addr, 0x55, SIZE);
+
+		Heap::Stats const during = heap.stats();
+		check(during.dataspaces == before.dataspaces + 1, "dedicated dataspace");
+		check(during.backing   >= before.backing + SIZE, "backing of big block");
+		check(during.allocated >= before.allocated + SIZE, "allocated big block");
+
+		heap.free(addr, SIZE);
+
+		Heap::Stats const after = heap.stats();
+		check(after.dataspaces == before.dataspaces, "dataspace released");
+		check(after.backing    == before.backing,    "backing after free");
+	}
+
+	void _test_fragmentation()
+	{
+		log("--- fragmentation ---");
+
+		Heap::Stats const empty { 0, 0, 0, 0, 0 };
+		check(empty.fragmentation() == 0, "empty heap");
+
+		Heap::Stats const half { 8*KB, 4*KB, 0, 1, 0 };
+		check(half.fragmentation() == 50, "half used");
+
+		/* allocations may exceed the backing store, e.g., of static memory */
+		Heap::Stats const over { 4*KB, 8*KB, 0, 1, 0 };
+		check(over.fragmentation() == 0, "allocated exceeds backing");
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		try {
+			_test_stats_default();
+			_test_chunk_return();
+			_test_slab_pages();
+			_test_big_allocations(false);
+			_test_big_allocations(true);
+			_test_fragmentation();
+		}
+		catch (...) {
+			_env.parent().exit(-1);
+			return;
+		}
+
+		log("--- heap test finished ---");
+		_env.parent().exit(0);
+	}
+};
+
+
+void Component::construct(Env &env) { static Main main(env); }
@@ -0,0 +1,3 @@
+TARGET = test-heap
+SRC_CC = main.cc
+LIBS   = base
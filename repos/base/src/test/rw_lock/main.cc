@@ -0,0 +1,303 @@
+/*
+ * \brief  Test for the reader-writer lock
+ * \author Genode Labs
+ * \date   2018-04-20
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#include <base/component.h>
+#include <base/log.h>
+#include <base/rw_lock.h>
+#include <base/semaphore.h>
+#include <base/thread.h>
+
+using namespace Genode;
+
+
+struct Test_failed : Exception { };
+
+
+static void check(bool condition, char const *what)
+{
+	if (condition)
+		return;
+
+	error("check failed: ", what);
+	throw Test_failed();
+}
+
+
+static int atomic_add(volatile int *value, int inc)
+{
+	for (;;) {
+		int const old = *value;
+		if (cmpxchg(value, old, old + inc))
+			return old + inc;
+	}
+}
+
+
+/**
+ * Give other threads the chance to run into the lock
+ */
+static void spin(unsigned rounds = 8000000)
+{
+	for (unsigned volatile i = 0; i < rounds; ++i) memory_barrier();
+}
+
+
+/**
+ * State shared by all threads of a test
+ */
+struct Shared
+{
+	Rw_lock lock { };
+
+	volatile int readers_inside = 0;
+	volatile int writers_inside = 0;
+	volatile int violations     = 0;
+	volatile int sequence       = 0;
+};
+
+
+enum { STACK_SIZE = 0x2000 };
+
+
+/**
+ * Reader that keeps the lock until released
+ */
+struct Holding_reader : Thread
+{
+	Shared    &shared;
+	Semaphore &entered;
+	Semaphore &release;
+
+	Holding_reader(Env &env, char const *name, Shared &shared,
+	               Semaphore &entered, Semaphore &release)
+	:
+		Thread(env, name, STACK_SIZE),
+		shared(shared), entered(entered), release(release)
+	{ }
+
+	void entry() override
+	{
+		Rw_lock::Read_guard guard(shared.lock);
+
+		atomic_add(&shared.readers_inside, 1);
+		entered.up();
+		release.down();
+		atomic_add(&shared.readers_inside, -1);
+	}
+};
+
+
+/**
+ * Thread that records the order in which it entered the lock
+ */
+struct Ordered_thread : Thread
+{
+	Shared    &shared;
+	bool const writer;
+
+	int volatile order = 0;
+
+	Ordered_thread(Env &env, char const *name, Shared &shared, bool writer)
+	:
+		Thread(env, name, STACK_SIZE), shared(shared), writer(writer)
+	{ }
+
+	void entry() override
+	{
+		if (writer) {
+			Rw_lock::Write_guard guard(shared.lock);
+			order = atomic_add(&shared.sequence, 1);
+		} else {
+			Rw_lock::Read_guard guard(shared.lock);
+			order = atomic_add(&shared.sequence, 1);
+		}
+	}
+};
+
+
+/**
+ * Thread that repeatedly enters the lock and checks for exclusion
+ */
+struct Stress_thread : Thread
+{
+	enum { ROUNDS = 20000 };
+
+	Shared    &shared;
+	bool const writer;
+
+	Stress_thread(Env &env, char const *name, Shared &shared, bool writer)
+	:
+		Thread(env, name, STACK_SIZE), shared(shared), writer(writer)
+	{ }
+
+	void _write()
+	{
+		Rw_lock::Write_guard guard(shared.lock);
+
+		if (atomic_add(&shared.writers_inside, 1) != 1 || shared.readers_inside)
+			atomic_add(&shared.violations, 1);
+
+		spin(100);
+		atomic_add(&shared.writers_inside, -1);
+	}
+
+	void _read()
+	{
+		Rw_lock::Read_guard guard(shared.lock);
+
+		atomic_add(&shared.readers_inside, 1);
+		if (shared.writers_inside)
+			atomic_add(&shared.violations, 1);
+
+		spin(100);
+		atomic_add(&shared.readers_inside, -1);
+	}
+
+	void entry() override
+	{
+		for (unsigned i = 0; i < ROUNDS; i++)
+			writer ? _write() : _read();
+	}
+};
+
+
+struct Main
+{
+	Env &_env;
+
+	enum { NUM_READERS = 4 };
+
+	void _test_concurrent_readers()
+	{
+		Shared    shared  { };
+		Semaphore entered { 0 };
+		Semaphore release { 0 };
+
+		Holding_reader r0(_env, "reader_0", shared, entered, release);
+		Holding_reader r1(_env, "reader_1", shared, entered, release);
+		Holding_reader r2(_env, "reader_2", shared, entered, release);
+		Holding_reader r3(_env, "reader_3", shared, entered, release);
+
+		r0.start(); r1.start(); r2.start(); r3.start();
+
+		/* all readers enter without any of them leaving */
+		for (unsigned i = 0; i < NUM_READERS; i++)
+			entered.down();
+
+		int const inside = shared.readers_inside;
+
+		for (unsigned i = 0; i < NUM_READERS; i++)
+			release.up();
+
+		r0.join(); r1.join(); r2.join(); r3.join();
+
+		check(inside == NUM_READERS, "readers inside at the same time");
+		log("concurrent readers passed");
+	}
+
+	void _test_writer_exclusion()
+	{
+		{
+			Shared    shared  { };
+			Semaphore entered { 0 };
+			Semaphore release { 0 };
+
+			Holding_reader reader(_env, "reader", shared, entered, release);
+			reader.start();
+			entered.down();
+
+			/* the writer must wait for the reader to leave */
+			Ordered_thread writer(_env, "writer", shared, true);
+			writer.start();
+			spin();
+
+			bool const writer_excluded = (writer.order == 0);
+
+			release.up();
+			reader.join();
+			writer.join();
+
+			check(writer_excluded, "writer excluded while reader inside");
+			check(writer.order == 1, "writer entered after reader left");
+		}
+
+		{
+			Shared shared { };
+
+			Stress_thread w0(_env, "writer_0", shared, true);
+			Stress_thread w1(_env, "writer_1", shared, true);
+			Stress_thread r0(_env, "reader_0", shared, false);
+			Stress_thread r1(_env, "reader_1", shared, false);
+
+			w0.start(); w1.start(); r0.start(); r1.start();
+			w0.join();  w1.join();  r0.join();  r1.join();
+
+			check(shared.violations == 0, "no reader or writer beside writer");
+		}
+		log("writer exclusion passed");
+	}
+
+	void _test_writer_preference()
+	{
+		Shared    shared  { };
+		Semaphore entered { 0 };
+		Semaphore release { 0 };
+
+		Holding_reader reader(_env, "reader", shared, entered, release);
+		reader.start();
+		entered.down();
+
+		/* writer waits for the reader inside */
+		Ordered_thread writer(_env, "writer", shared, true);
+		writer.start();
+		spin();
+
+		/* a reader arriving after the writer must not overtake it */
+		Ordered_thread late_reader(_env, "late_reader", shared, false);
+		late_reader.start();
+		spin();
+
+		bool const both_waiting = (writer.order == 0 && late_reader.order == 0);
+
+		release.up();
+		reader.join();
+		writer.join();
+		late_reader.join();
+
+		check(both_waiting, "writer and late reader wait for reader inside");
+		check(writer.order == 1 && late_reader.order == 2,
+		      "writer entered before late reader");
+		log("writer preference passed");
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- reader-writer lock test started ---");
+
+		try {
+			_test_concurrent_readers();
+			_test_writer_exclusion();
+			_test_writer_preference();
+		}
+		catch (...) {
+			_env.parent().exit(-1);
+			return;
+		}
+
+		log("--- reader-writer lock test finished ---");
+		_env.parent().exit(0);
+	}
+};
+
+
+void Component::construct(Env &env) { static Main main(env); }
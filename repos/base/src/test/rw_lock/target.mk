@@ -0,0 +1,3 @@
+TARGET = test-rw_lock
+SRC_CC = main.cc
+LIBS   = base
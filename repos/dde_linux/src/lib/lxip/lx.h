@@ -38,6 +38,28 @@ namespace Lx {
 	void timer_update_jiffies();
 
 	void lxcc_emul_init(Lx_kit::Env &env);
+
+	/**
+	 * Serialize the execution of the Linux code
+	 *
+	 * If the stack runs on a dedicated entrypoint, the Linux code is entered
+	 * by this entrypoint as well as by the users of the VFS. Otherwise, the
+	 * guard has no effect.
+	 */
+	struct Stack_guard
+	{
+		Stack_guard();
+		~Stack_guard();
+	};
+
+	/**
+	 * Enable the serialization by 'Stack_guard'
+	 *
+	 * Must be called before the stack is initialized.
+	 */
+	void stack_thread_enable();
+
+	bool stack_thread_enabled();
 }
 
 extern "C" void lxip_init();
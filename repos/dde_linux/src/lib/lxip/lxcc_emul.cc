@@ -15,7 +15,9 @@
 
 /* Genode includes */
 #include <base/allocator_avl.h>
+#include <base/lock.h>
 #include <base/object_pool.h>
+#include <base/semaphore.h>
 #include <base/sleep.h>
 #include <base/snprintf.h>
 #include <dataspace/client.h>
@@ -305,6 +307,60 @@ void *memmove(void *d, const void *s, size_t n)
  ** linux/sched.h **
  *******************/
 
+static bool              _stack_thread = false;
+static Genode::Lock      _stack_lock;
+static Genode::Lock      _stack_progress_lock;
+static unsigned          _stack_progress_waiters = 0;
+static Genode::Semaphore _stack_progress;
+
+
+void Lx::stack_thread_enable() { _stack_thread = true; }
+
+
+bool Lx::stack_thread_enabled() { return _stack_thread; }
+
+
+Lx::Stack_guard::Stack_guard()
+{
+	if (_stack_thread)
+		_stack_lock.lock();
+}
+
+
+Lx::Stack_guard::~Stack_guard()
+{
+	if (!_stack_thread)
+		return;
+
+	_stack_lock.unlock();
+
+	/* leaving the Linux code may have changed the state a waiter depends on */
+	Genode::Lock::Guard guard(_stack_progress_lock);
+	for (; _stack_progress_waiters; _stack_progress_waiters--)
+		_stack_progress.up();
+}
+
+
+/**
+ * Block the caller, which holds the stack guard, until the stack progressed
+ *
+ * The caller is a user of the VFS because the Linux code never blocks when
+ * entered by the dedicated entrypoint, which runs softirq and timer context
+ * only.
+ */
+static void wait_for_stack_progress()
+{
+	{
+		Genode::Lock::Guard guard(_stack_progress_lock);
+		_stack_progress_waiters++;
+	}
+
+	_stack_lock.unlock();
+	_stack_progress.down();
+	_stack_lock.lock();
+}
+
+
 struct Timeout : Genode::Io_signal_handler<Timeout>
 {
 	Genode::Entrypoint &ep;
@@ -313,7 +369,10 @@ struct Timeout : Genode::Io_signal_handler<Timeout>
 
 	void handle()
 	{
-		update_jiffies();
+		{
+			Lx::Stack_guard guard;
+			update_jiffies();
+		}
 
 		/* tick the higher layer of the component */
 		tick();
@@ -334,7 +393,10 @@ struct Timeout : Genode::Io_signal_handler<Timeout>
 
 	void wait()
 	{
-		ep.wait_and_dispatch_one_io_signal();
+		if (Lx::stack_thread_enabled())
+			wait_for_stack_progress();
+		else
+			ep.wait_and_dispatch_one_io_signal();
 	}
 };
 
@@ -46,6 +46,8 @@ class Nic_client
 
 		void _link_state()
 		{
+			Lx::Stack_guard guard;
+
 			bool const link_state = _nic.link_state();
 			ic_link_state = link_state;
 
@@ -63,20 +65,24 @@ class Nic_client
 		 */
 		void _packet_avail()
 		{
-			Lx::timer_update_jiffies();
+			{
+				Lx::Stack_guard guard;
 
-			/* process a batch of only MAX_PACKETS in one run */
-			enum { MAX_PACKETS = 20 };
+				Lx::timer_update_jiffies();
 
-			int count = 0;
-			while (_nic.rx()->packet_avail() &&
-			       _nic.rx()->ready_to_ack() &&
-			       count++ < MAX_PACKETS)
-			{
-				Nic::Packet_descriptor p = _nic.rx()->get_packet();
-				net_driver_rx(_nic.rx()->packet_content(p), p.size());
+				/* process a batch of only MAX_PACKETS in one run */
+				enum { MAX_PACKETS = 20 };
+
+				int count = 0;
+				while (_nic.rx()->packet_avail() &&
+				       _nic.rx()->ready_to_ack() &&
+				       count++ < MAX_PACKETS)
+				{
+					Nic::Packet_descriptor p = _nic.rx()->get_packet();
+					net_driver_rx(_nic.rx()->packet_content(p), p.size());
 
-				_nic.rx()->acknowledge_packet(p);
+					_nic.rx()->acknowledge_packet(p);
+				}
 			}
 
 			/* schedule next batch if there are still packets available */
@@ -100,6 +106,9 @@ class Nic_client
 		 */
 		void _ack_avail()
 		{
+			/* the packet allocator is shared with 'net_tx' */
+			Lx::Stack_guard guard;
+
 			while (_nic.tx()->ack_avail()) {
 				Nic::Packet_descriptor p = _nic.tx()->get_acked_packet();
 				_nic.tx()->release_packet(p);
@@ -157,17 +157,21 @@ class Lx::Timer
 		 */
 		void _handle()
 		{
-			update_jiffies();
+			{
+				Lx::Stack_guard guard;
 
-			while (Lx::Timer::Context *ctx = _list.first()) {
-				if (ctx->timeout > jiffies)
-					break;
+				update_jiffies();
 
-				ctx->pending = false;
-				ctx->function();
+				while (Lx::Timer::Context *ctx = _list.first()) {
+					if (ctx->timeout > jiffies)
+						break;
 
-				if (!ctx->pending)
-					del(ctx->timer);
+					ctx->pending = false;
+					ctx->function();
+
+					if (!ctx->pending)
+						del(ctx->timer);
+				}
 			}
 
 			/* tick the higher layer of the component */
@@ -17,11 +17,13 @@
 #include <base/log.h>
 #include <base/snprintf.h>
 #include <net/ipv4.h>
+#include <util/reconstructible.h>
 #include <util/string.h>
 #include <util/xml_node.h>
 #include <vfs/directory_service.h>
 #include <vfs/file_io_service.h>
 #include <vfs/file_system_factory.h>
+#include <vfs/socket_datagram.h>
 #include <vfs/vfs_handle.h>
 
 /* Lxip includes */
@@ -122,6 +124,7 @@ namespace Vfs {
 
 	class Lxip_file;
 	class Lxip_data_file;
+	class Lxip_datagrams_file;
 	class Lxip_bind_file;
 	class Lxip_accept_file;
 	class Lxip_connect_file;
@@ -277,8 +280,12 @@ struct Vfs::Lxip_vfs_file_handle final : Vfs::Lxip_vfs_handle
 
 	Vfs::File *file;
 
-	List_element<Lxip_vfs_file_handle> file_le    { this };
-	List_element<Lxip_vfs_file_handle> polling_le { this };
+	List_element<Lxip_vfs_file_handle> file_le        { this };
+	List_element<Lxip_vfs_file_handle> polling_le     { this };
+	List_element<Lxip_vfs_file_handle> io_response_le { this };
+
+	/* I/O response to deliver after leaving the stack guard */
+	Vfs::Io_response_handler *io_response_handler = nullptr;
 
 	char content_buffer[Lxip::MAX_DATA_LEN];
 
@@ -361,16 +368,101 @@ struct Vfs::Lxip_vfs_dir_handle final : Vfs::Lxip_vfs_handle
  */
 static Vfs::Lxip_vfs_file_handles _polling_handles;
 
+
+/**
+ * List of handles with a deferred I/O response
+ *
+ * If the stack runs on a dedicated entrypoint, I/O responses are queued by
+ * this entrypoint and delivered by the entrypoint of the VFS users, which
+ * is the context the response handler expects. The delivery happens after
+ * leaving the stack guard because the response handler may enter the VFS
+ * again, e.g., to check the read readiness of other handles.
+ */
+static Vfs::Lxip_vfs_file_handles _io_response_handles;
+
+/* signal to the VFS users' entrypoint to deliver the queued I/O responses */
+static Genode::Signal_context_capability _io_response_sigh;
+
+/* response handler of the I/O response triggered by the current poll */
+static Vfs::Io_response_handler *_deferred_io_response_handler;
+
+
+static void remove_io_response(Vfs::Lxip_vfs_file_handle &handle)
+{
+	if (!handle.io_response_handler)
+		return;
+
+	_io_response_handles.remove(&handle.io_response_le);
+	handle.io_response_handler = nullptr;
+}
+
+
 static void poll_all()
 {
 	using namespace Linux;
 
-	for (Genode::List_element<Vfs::Lxip_vfs_file_handle> *le = _polling_handles.first();
-	     le; le = le->next())
+	if (!Lx::stack_thread_enabled()) {
+		for (Genode::List_element<Vfs::Lxip_vfs_file_handle> *le = _polling_handles.first();
+		     le; le = le->next())
+		{
+			Vfs::Lxip_vfs_file_handle *handle = le->object();
+			if (handle->file)
+				handle->file->poll(true, handle->context);
+		}
+		return;
+	}
+
 	{
-		Vfs::Lxip_vfs_file_handle *handle = le->object();
-		if (handle->file)
+		Lx::Stack_guard guard;
+
+		for (Genode::List_element<Vfs::Lxip_vfs_file_handle> *le = _polling_handles.first();
+		     le; le = le->next())
+		{
+			Vfs::Lxip_vfs_file_handle *handle = le->object();
+			if (!handle->file || handle->io_response_handler)
+				continue;
+
+			_deferred_io_response_handler = nullptr;
 			handle->file->poll(true, handle->context);
+
+			if (_deferred_io_response_handler) {
+				handle->io_response_handler = _deferred_io_response_handler;
+				_io_response_handles.insert(&handle->io_response_le);
+			}
+		}
+
+		if (!_io_response_handles.first())
+			return;
+	}
+
+	Genode::Signal_transmitter(_io_response_sigh).submit();
+}
+
+
+/**
+ * Deliver the queued I/O responses, executed by the VFS users' entrypoint
+ */
+static void deliver_io_responses()
+{
+	using namespace Linux;
+
+	/* deliver one response at a time as handles may get closed meanwhile */
+	for (;;) {
+		Vfs::Io_response_handler *handler = nullptr;
+		Vfs::Vfs_handle::Context *context = nullptr;
+		{
+			Lx::Stack_guard guard;
+
+			Genode::List_element<Vfs::Lxip_vfs_file_handle> *le =
+				_io_response_handles.first();
+			if (!le)
+				return;
+
+			handler = le->object()->io_response_handler;
+			context = le->object()->context;
+			remove_io_response(*le->object());
+		}
+		handler->handle_io_response(context);
 	}
 }
 
@@ -404,6 +496,7 @@ class Vfs::Lxip_file : public Vfs::File
 			while (le) {
 				Vfs::Lxip_vfs_file_handle *h = le->object();
 				_polling_handles.remove(&h->polling_le);
+				remove_io_response(*h);
 				handles.remove(&h->file_le);
 				h->file = nullptr;
 				le = handles.first();
@@ -474,6 +567,151 @@ class Vfs::Lxip_data_file : public Vfs::Lxip_file
 };
 
 
+/**
+ * Batched transfer of datagrams, see 'vfs/socket_datagram.h'
+ */
+class Vfs::Lxip_datagrams_file : public Vfs::Lxip_file
+{
+	private:
+
+		/**
+		 * Return size of the next received datagram or negative error
+		 */
+		Lxip::ssize_t _pending_length()
+		{
+			using namespace Linux;
+
+			iovec iov { nullptr, 0 };
+
+			msghdr msg = create_msghdr(nullptr, 0, 0, &iov);
+
+			return _sock.ops->recvmsg(&_sock, &msg, 0,
+			                          MSG_DONTWAIT|MSG_PEEK|MSG_TRUNC);
+		}
+
+	public:
+
+		Lxip_datagrams_file(Lxip::Socket_dir &p, Linux::socket &s)
+		: Lxip_file(p, s, "datagrams") { }
+
+		/********************
+		 ** File interface **
+		 ********************/
+
+		bool poll(bool trigger_io_response,
+		          Vfs::Vfs_handle::Context *context) override
+		{
+			using namespace Linux;
+
+			file f;
+			f.f_flags = 0;
+			if (_sock.ops->poll(&f, &_sock, nullptr) & (POLLIN_SET)) {
+				if (trigger_io_response)
+					_parent.trigger_io_response(context);
+				return true;
+			}
+			return false;
+		}
+
+		Lxip::ssize_t write(Lxip_vfs_file_handle &,
+		                    char const *src, Genode::size_t len,
+		                    file_size /* ignored */) override
+		{
+			using namespace Linux;
+
+			if (!_sock_valid()) return -1;
+
+			Genode::size_t sent = 0;
+			while (len - sent >= sizeof(Socket_datagram)) {
+
+				Socket_datagram const &dg = *(Socket_datagram const *)(src + sent);
+				if (dg.length > len - sent - sizeof(Socket_datagram))
+					break;
+
+				/* an unspecified address refers to the connected peer */
+				sockaddr_in addr;
+				addr.sin_family      = AF_INET;
+				addr.sin_port        = htons(dg.port);
+				addr.sin_addr.s_addr = (dg.addr[0]<<0)|(dg.addr[1]<<8)|
+				                       (dg.addr[2]<<16)|(dg.addr[3]<<24);
+				bool const connected = !addr.sin_addr.s_addr && !dg.port;
+
+				iovec iov { const_cast<char *>(dg.payload()), dg.length };
+
+				msghdr msg = create_msghdr(connected ? nullptr : &addr,
+				                           connected ? 0 : sizeof(addr),
+				                           dg.length, &iov);
+
+				Lxip::ssize_t const res = _sock.ops->sendmsg(&_sock, &msg, dg.length);
+				if (res < 0) {
+					if (sent) break;
+					if (res == -EAGAIN) throw Would_block();
+					return -1;
+				}
+
+				sent += Genode::min(Socket_datagram::record_size(dg.length),
+				                    len - sent);
+			}
+			return sent;
+		}
+
+		Lxip::ssize_t read(Lxip_vfs_file_handle &,
+		                   char *dst, Genode::size_t len,
+		                   file_size /* ignored */) override
+		{
+			using namespace Linux;
+
+			if (!_sock_valid() || len <= sizeof(Socket_datagram)) return -1;
+
+			Genode::size_t received = 0;
+			while (len - received > sizeof(Socket_datagram)) {
+
+				Lxip::ssize_t const pending = _pending_length();
+				if (pending < 0) {
+					if (received) break;
+					if (pending == -EAGAIN) throw Would_block();
+					return -1;
+				}
+
+				/* only the first datagram of a batch is truncated */
+				Genode::size_t const avail = len - received - sizeof(Socket_datagram);
+				if (received && (Genode::size_t)pending > avail)
+					break;
+
+				Socket_datagram &dg = *(Socket_datagram *)(dst + received);
+
+				sockaddr_storage addr_storage;
+				sockaddr_in *addr = (sockaddr_in *)&addr_storage;
+
+				Genode::size_t const count = Genode::min(avail, (Genode::size_t)pending);
+
+				iovec iov { dg.payload(), count };
+
+				msghdr msg = create_msghdr(addr, sizeof(addr_storage), count, &iov);
+
+				Lxip::ssize_t const res = _sock.ops->recvmsg(&_sock, &msg, count,
+				                                             MSG_DONTWAIT);
+				if (res < 0) {
+					if (received) break;
+					return -1;
+				}
+
+				unsigned char const *a = (unsigned char *)&addr->sin_addr.s_addr;
+				unsigned char const *p = (unsigned char *)&addr->sin_port;
+
+				dg.length = res;
+				dg.flags  = (Genode::size_t)pending > count ? Socket_datagram::TRUNCATED : 0;
+				dg.port   = (p[0]<<8)|(p[1]<<0);
+				Genode::memcpy(dg.addr, a, sizeof(dg.addr));
+
+				received += Genode::min(Socket_datagram::record_size(res),
+				                        len - received);
+			}
+			return received;
+		}
+};
+
+
 class Vfs::Lxip_bind_file : public Vfs::Lxip_file
 {
 	private:
@@ -870,7 +1108,7 @@ class Vfs::Lxip_socket_dir final : public Lxip::Socket_dir
 
 		enum {
 			ACCEPT_NODE, BIND_NODE, CONNECT_NODE,
-			DATA_NODE, LOCAL_NODE, LISTEN_NODE, REMOTE_NODE,
+			DATA_NODE, DATAGRAMS_NODE, LOCAL_NODE, LISTEN_NODE, REMOTE_NODE,
 			ACCEPT_SOCKET_NODE,
 			MAX_FILES
 		};
@@ -893,13 +1131,14 @@ class Vfs::Lxip_socket_dir final : public Lxip::Socket_dir
 			return num;
 		}
 
-		Lxip_accept_file  _accept_file  { *this, _sock };
-		Lxip_bind_file    _bind_file    { *this, _sock };
-		Lxip_connect_file _connect_file { *this, _sock };
-		Lxip_data_file    _data_file    { *this, _sock };
-		Lxip_listen_file  _listen_file  { *this, _sock };
-		Lxip_local_file   _local_file   { *this, _sock };
-		Lxip_remote_file  _remote_file  { *this, _sock };
+		Lxip_accept_file    _accept_file    { *this, _sock };
+		Lxip_bind_file      _bind_file      { *this, _sock };
+		Lxip_connect_file   _connect_file   { *this, _sock };
+		Lxip_data_file      _data_file      { *this, _sock };
+		Lxip_datagrams_file _datagrams_file { *this, _sock };
+		Lxip_listen_file    _listen_file    { *this, _sock };
+		Lxip_local_file     _local_file     { *this, _sock };
+		Lxip_remote_file    _remote_file    { *this, _sock };
 
 		struct Accept_socket_file : Vfs::File
 		{
@@ -937,6 +1176,9 @@ class Vfs::Lxip_socket_dir final : public Lxip::Socket_dir
 			_files[DATA_NODE]    = &_data_file;
 			_files[LOCAL_NODE]   = &_local_file;
 			_files[REMOTE_NODE]  = &_remote_file;
+
+			if (parent.type() == Lxip::Protocol_dir::TYPE_DGRAM)
+				_files[DATAGRAMS_NODE] = &_datagrams_file;
 		}
 
 		~Lxip_socket_dir()
@@ -945,6 +1187,7 @@ class Vfs::Lxip_socket_dir final : public Lxip::Socket_dir
 			_bind_file.dissolve_handles();
 			_connect_file.dissolve_handles();
 			_data_file.dissolve_handles();
+			_datagrams_file.dissolve_handles();
 			_listen_file.dissolve_handles();
 			_local_file.dissolve_handles();
 			_remote_file.dissolve_handles();
@@ -1021,6 +1264,10 @@ class Vfs::Lxip_socket_dir final : public Lxip::Socket_dir
 
 		void trigger_io_response(Vfs::Vfs_handle::Context *context) override
 		{
+			if (Lx::stack_thread_enabled()) {
+				_deferred_io_response_handler = &_io_response_handler;
+				return;
+			}
 			_io_response_handler.handle_io_response(context);
 		}
 
@@ -1593,6 +1840,8 @@ class Vfs::Lxip_file_system : public Vfs::File_system,
 
 		void apply_config(Genode::Xml_node const &config) override
 		{
+			Lx::Stack_guard guard;
+
 			typedef String<16> Addr;
 
 			unsigned const mtu = config.attribute_value("mtu", 0U);
@@ -1709,6 +1958,8 @@ class Vfs::Lxip_file_system : public Vfs::File_system,
 
 		Stat_result stat(char const *path, Stat &out) override
 		{
+			Lx::Stack_guard guard;
+
 			Vfs::Node *node = _lookup(path);
 			if (!node) return STAT_ERR_NO_ENTRY;
 
@@ -1735,6 +1986,8 @@ class Vfs::Lxip_file_system : public Vfs::File_system,
 
 		file_size num_dirent(char const *path) override
 		{
+			Lx::Stack_guard guard;
+
 			if (_is_root(path)) return num_dirent();
 
 			Vfs::Node *node = _lookup(path);
@@ -1748,6 +2001,8 @@ class Vfs::Lxip_file_system : public Vfs::File_system,
 
 		bool directory(char const *path) override
 		{
+			Lx::Stack_guard guard;
+
 			Vfs::Node *node = _lookup(path);
 			return node ? dynamic_cast<Vfs::Directory *>(node) : 0;
 		}
@@ -1762,6 +2017,8 @@ class Vfs::Lxip_file_system : public Vfs::File_system,
 		{
 			if (mode & OPEN_MODE_CREATE) return OPEN_ERR_NO_PERM;
 
+			Lx::Stack_guard guard;
+
 			try {
 				if (Genode::strcmp(path, "/tcp", 4) == 0)
 					return _tcp_dir.open(*this, _io_response_handler, alloc,
@@ -1790,6 +2047,8 @@ class Vfs::Lxip_file_system : public Vfs::File_system,
 		Opendir_result opendir(char const *path, bool create,
 		                       Vfs_handle **out_handle, Allocator &alloc) override
 		{
+			Lx::Stack_guard guard;
+
 			Vfs::Node *node = _lookup(path);
 
 			if (!node) return OPENDIR_ERR_LOOKUP_FAILED;
@@ -1808,20 +2067,26 @@ class Vfs::Lxip_file_system : public Vfs::File_system,
 
 		void close(Vfs_handle *vfs_handle) override
 		{
+			Lx::Stack_guard guard;
+
 			Lxip_vfs_handle *handle =
 				static_cast<Vfs::Lxip_vfs_handle*>(vfs_handle);
 
 			Lxip_vfs_file_handle *file_handle =
 				dynamic_cast<Vfs::Lxip_vfs_file_handle*>(handle);
 
-			if (file_handle)
+			if (file_handle) {
 				_polling_handles.remove(&file_handle->polling_le);
+				remove_io_response(*file_handle);
+			}
 
 			Genode::destroy(handle->alloc(), handle);
 		}
 
 		Unlink_result unlink(char const *path) override
 		{
+			Lx::Stack_guard guard;
+
 			if (*path == '/') path++;
 
 			if (Genode::strcmp(path, "tcp", 3) == 0)
@@ -1845,6 +2110,8 @@ class Vfs::Lxip_file_system : public Vfs::File_system,
 			Vfs::Lxip_vfs_handle *handle =
 				static_cast<Vfs::Lxip_vfs_handle*>(vfs_handle);
 
+			Lx::Stack_guard guard;
+
 			try { return handle->write(src, count, out_count); }
 			catch (File::Would_block) { return WRITE_ERR_WOULD_BLOCK; }
 
@@ -1854,6 +2121,8 @@ class Vfs::Lxip_file_system : public Vfs::File_system,
 		                          char *dst, file_size count,
 		                          file_size &out_count) override
 		{
+			Lx::Stack_guard guard;
+
 			try { return _read(vfs_handle, dst, count, out_count); }
 			catch (File::Would_block) { return READ_QUEUED; }
 		}
@@ -1869,6 +2138,8 @@ class Vfs::Lxip_file_system : public Vfs::File_system,
 			Lxip_vfs_file_handle *handle =
 				dynamic_cast<Vfs::Lxip_vfs_file_handle *>(vfs_handle);
 
+			Lx::Stack_guard guard;
+
 			if (handle && dynamic_cast<Lxip_file*>(handle->file)) {
 				_polling_handles.remove(&handle->polling_le);
 				_polling_handles.insert(&handle->polling_le);
@@ -1882,8 +2153,24 @@ class Vfs::Lxip_file_system : public Vfs::File_system,
 		{
 			Lxip_vfs_handle &handle =
 				*static_cast<Lxip_vfs_handle *>(vfs_handle);
+
+			Lx::Stack_guard guard;
 			return handle.read_ready();
 		}
+
+		void drop_io_response(Vfs_handle::Context &context) override
+		{
+			Lx::Stack_guard guard;
+
+			for (Genode::List_element<Vfs::Lxip_vfs_file_handle> *le =
+			     _io_response_handles.first(); le; le = le->next())
+			{
+				if (le->object()->context == &context) {
+					remove_io_response(*le->object());
+					return;
+				}
+			}
+		}
 };
 
 
@@ -1891,28 +2178,73 @@ struct Lxip_factory : Vfs::File_system_factory
 {
 	struct Init
 	{
+		enum { STACK_SIZE = 64 * 1024 * sizeof(long) };
+
 		char _config_buf[128];
 
 		char *_parse_config(Genode::Xml_node);
 
+		Genode::Constructible<Genode::Entrypoint> _stack_ep { };
+
+		struct Io_response_delivery
+		{
+			Genode::Io_signal_handler<Io_response_delivery> _handler;
+
+			void _handle() { deliver_io_responses(); }
+
+			Io_response_delivery(Genode::Entrypoint &ep)
+			: _handler(ep, *this, &Io_response_delivery::_handle)
+			{
+				_io_response_sigh = _handler;
+			}
+		};
+
+		Genode::Constructible<Io_response_delivery> _io_response_delivery { };
+
+		/**
+		 * Return entrypoint that executes rx processing and timers
+		 *
+		 * By default, the stack shares the entrypoint with the VFS users.
+		 * With the 'rx_thread' option, the stack runs on a dedicated
+		 * entrypoint, which queues I/O responses for the delivery by the
+		 * entrypoint of the VFS users.
+		 */
+		Genode::Entrypoint &_ep(Genode::Env &env, Genode::Xml_node config)
+		{
+			if (!config.attribute_value("rx_thread", false))
+				return env.ep();
+
+			Genode::log("Running network stack on dedicated thread.");
+
+			_io_response_delivery.construct(env.ep());
+
+			Lx::stack_thread_enable();
+			_stack_ep.construct(env, STACK_SIZE, "lxip_ep");
+			return *_stack_ep;
+		}
+
 		Init(Genode::Env       &env,
-		     Genode::Allocator &alloc)
+		     Genode::Allocator &alloc,
+		     Genode::Xml_node   config)
 		{
 			Lx_kit::Env &lx_env = Lx_kit::construct_env(env);
 
+			Genode::Entrypoint &ep = _ep(lx_env.env(), config);
+
 			Lx::lxcc_emul_init(lx_env);
 			Lx::malloc_init(env, lx_env.heap());
-			Lx::timer_init(env, lx_env.env().ep(), lx_env.heap(), &poll_all);
-			Lx::event_init(env, lx_env.env().ep(), &poll_all);
-			Lx::nic_client_init(env, lx_env.env().ep(), lx_env.heap(), &poll_all);
+			Lx::timer_init(env, ep, lx_env.heap(), &poll_all);
+			Lx::event_init(env, ep, &poll_all);
+			Lx::nic_client_init(env, ep, lx_env.heap(), &poll_all);
 
+			Lx::Stack_guard guard;
 			lxip_init();
 		}
 	};
 
 	Vfs::File_system *create(Vfs::Env &env, Genode::Xml_node config) override
 	{
-		static Init inst(env.env(), env.alloc());
+		static Init inst(env.env(), env.alloc(), config);
 		return new (env.alloc()) Vfs::Lxip_file_system(env, config);
 	}
 };
@@ -126,6 +126,7 @@ namespace Libc {
 			virtual int select(int nfds, fd_set *readfds, fd_set *writefds,
 			                   fd_set *exceptfds, struct timeval *timeout);
 			virtual ssize_t send(File_descriptor *, const void *buf, ::size_t len, int flags);
+			virtual ssize_t sendmsg(File_descriptor *, const struct msghdr *msg, int flags);
 			virtual ssize_t sendto(File_descriptor *, const void *buf,
 			                       ::size_t len, int flags,
 			                       const struct sockaddr *dest_addr,
@@ -0,0 +1,63 @@
+/*
+ * \brief  Statistics and thread hook of the libc malloc implementation
+ * \author Genode Labs
+ * \date   2018-03-22
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__LIBC__MALLOC_STATS_H_
+#define _INCLUDE__LIBC__MALLOC_STATS_H_
+
+/* Genode includes */
+#include <base/stdint.h>
+
+namespace Libc {
+
+	struct Malloc_stats
+	{
+		/* memory obtained from the backing store, including large blocks */
+		Genode::size_t held;
+
+		/* memory of outstanding allocations, rounded up to size classes */
+		Genode::size_t allocated;
+
+		/* free objects kept in per-thread caches */
+		Genode::size_t cached;
+
+		/* dedicated dataspaces of large allocations */
+		Genode::size_t large;
+		unsigned long  large_count;
+
+		/**
+		 * Return fragmentation in percent
+		 *
+		 * This is the portion of held memory not occupied by allocations.
+		 */
+		unsigned fragmentation() const {
+			return held > allocated ? (unsigned)(100 - (allocated*100)/held) : 0; }
+	};
+
+	/**
+	 * Return statistics of the malloc arena
+	 *
+	 * The statistics are only maintained if the arena allocator is enabled
+	 * via '<libc malloc="arena"/>'. Otherwise, all values are zero.
+	 */
+	Malloc_stats malloc_stats();
+
+	/**
+	 * Release the per-thread state of the malloc arena
+	 *
+	 * Called by a thread right before it exits, e.g., by 'pthread_exit'.
+	 * Memory allocated by the thread stays valid.
+	 */
+	void malloc_thread_exit();
+}
+
+#endif /* _INCLUDE__LIBC__MALLOC_STATS_H_ */
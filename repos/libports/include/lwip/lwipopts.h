@@ -69,6 +69,9 @@
 /* MEM_ALIGNMENT > 4 e.g. for x86_64 are not supported, see Genode issue #817 */
 #define MEM_ALIGNMENT               4
 
+/* let pbufs refer to packets of the nic-session rx buffer */
+#define LWIP_SUPPORT_CUSTOM_PBUF    1
+
 #define DEFAULT_ACCEPTMBOX_SIZE   128
 #define TCPIP_MBOX_SIZE           128
 
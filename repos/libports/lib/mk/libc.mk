@@ -16,7 +16,7 @@ SRC_CC = atexit.cc dummies.cc rlimit.cc sysctl.cc \
          plugin.cc plugin_registry.cc select.cc exit.cc environ.cc nanosleep.cc \
          pread_pwrite.cc readv_writev.cc poll.cc \
          libc_pdbg.cc vfs_plugin.cc rtc.cc dynamic_linker.cc signal.cc \
-         socket_operations.cc task.cc socket_fs_plugin.cc
+         socket_operations.cc task.cc socket_fs_plugin.cc kqueue.cc
 
 CC_OPT_sysctl += -Wno-write-strings
 
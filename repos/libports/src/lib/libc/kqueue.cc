@@ -0,0 +1,557 @@
+/*
+ * \brief  kqueue() and kevent() implementation
+ * \author Genode Labs
+ * \date   2018-03-30
+ *
+ * In contrast to select() and poll(), which scan all file descriptors on
+ * each wakeup, a kqueue keeps its registrations across calls. A registration
+ * for read events is attached as context to the VFS handle of the file
+ * descriptor. Hence, the I/O response of a VFS back end for a handle puts
+ * the registration onto the ready queue of its kqueue directly and kevent()
+ * only looks at the queued registrations.
+ *
+ * Write events are always reported because the VFS does not track write
+ * readiness, which corresponds to the behaviour of select().
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/lock.h>
+#include <base/log.h>
+#include <vfs/file_system.h>
+
+/* libc includes */
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#include <errno.h>
+#include <stdlib.h>
+
+/* libc plugin interface */
+#include <libc-plugin/fd_alloc.h>
+#include <libc-plugin/plugin.h>
+
+/* libc-internal includes */
+#include "libc_errno.h"
+#include "task.h"
+
+
+namespace Libc {
+
+	struct Kqueue;
+	struct Kqueue_plugin;
+	struct Kevent_registration;
+
+	Vfs::Vfs_handle *vfs_file_handle(File_descriptor *);
+	File_descriptor *socket_fs_read_file(File_descriptor *);
+
+	void kqueue_io_response(Vfs::Vfs_handle::Context *);
+	void kqueue_handle_closed(Vfs::Vfs_handle *);
+}
+
+
+/**
+ * Registration of a filter for a file descriptor
+ *
+ * Read registrations are attached as context to the VFS handle. Before a
+ * registration is detached from its handle, a pending I/O response for it
+ * is discarded at the file system that holds it.
+ */
+struct Libc::Kevent_registration : Vfs::Vfs_handle::Context
+{
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		Kevent_registration(Kevent_registration const &);
+		Kevent_registration &operator = (Kevent_registration const &);
+
+	public:
+
+		Kqueue &kqueue;
+
+		Kevent_registration *next_in_bucket = nullptr;
+		Kevent_registration *next_ready     = nullptr;
+
+		uintptr_t             ident   = 0;
+		short                 filter  = 0;
+		u_short               flags   = 0;
+		u_int                 fflags  = 0;
+		intptr_t              data    = 0;
+		void                 *udata   = nullptr;
+		Vfs::Vfs_handle      *handle  = nullptr;
+		Vfs::File_io_service *io      = nullptr;
+		bool                  enabled = false;
+		bool                  queued  = false;
+
+		/* tag of registrations among the contexts of VFS handles */
+		enum { TAG = 0x6b657674 /* "kevt" */ };
+
+		Kevent_registration(Kqueue &kqueue) : Context(TAG), kqueue(kqueue) { }
+
+		/**
+		 * Return registration the VFS handle context refers to, or nullptr
+		 */
+		static Kevent_registration *from_context(Vfs::Vfs_handle::Context *context)
+		{
+			if (!context || context->tag != TAG)
+				return nullptr;
+
+			return static_cast<Kevent_registration *>(context);
+		}
+
+		/**
+		 * Request an I/O response once the handle becomes readable
+		 *
+		 * \return  true if the handle is readable already
+		 */
+		bool arm()
+		{
+			if (!handle)
+				return true;
+
+			handle->fs().notify_read_ready(handle);
+			return handle->fs().read_ready(handle);
+		}
+};
+
+
+struct Libc::Kqueue : Libc::Plugin_context
+{
+	private:
+
+		enum { BUCKETS = 256 };
+
+		Genode::Lock _lock { };
+
+		Kevent_registration *_buckets[BUCKETS] { };
+		Kevent_registration *_unused     = nullptr;
+		Kevent_registration *_ready_head = nullptr;
+		Kevent_registration *_ready_tail = nullptr;
+
+		static unsigned _bucket(uintptr_t ident) { return ident % BUCKETS; }
+
+		Kevent_registration *_lookup(uintptr_t ident, short filter)
+		{
+			for (Kevent_registration *r = _buckets[_bucket(ident)]; r; r = r->next_in_bucket)
+				if (r->ident == ident && r->filter == filter)
+					return r;
+
+			return nullptr;
+		}
+
+		/*
+		 * Registrations are recycled instead of freed because a VFS back end
+		 * may be about to deliver an I/O response that it dequeued already.
+		 * Such a stale response results in a spurious readiness check only.
+		 */
+		Kevent_registration *_alloc()
+		{
+			if (_unused) {
+				Kevent_registration *r = _unused;
+				_unused = r->next_in_bucket;
+				return r;
+			}
+
+			void *mem = malloc(sizeof(Kevent_registration));
+			return mem ? new (mem) Kevent_registration(*this) : nullptr;
+		}
+
+		void _enqueue(Kevent_registration &r)
+		{
+			if (r.queued || !r.enabled)
+				return;
+
+			r.queued     = true;
+			r.next_ready = nullptr;
+
+			if (_ready_tail)
+				_ready_tail->next_ready = &r;
+			else
+				_ready_head = &r;
+
+			_ready_tail = &r;
+		}
+
+		Kevent_registration *_dequeue()
+		{
+			Kevent_registration *r = _ready_head;
+			if (!r)
+				return nullptr;
+
+			_ready_head = r->next_ready;
+			if (!_ready_head)
+				_ready_tail = nullptr;
+
+			r->queued = false;
+			return r;
+		}
+
+		void _remove(Kevent_registration &r)
+		{
+			/* unlink from bucket */
+			for (Kevent_registration **n = &_buckets[_bucket(r.ident)]; *n;
+			     n = &(*n)->next_in_bucket) {
+				if (*n == &r) {
+					*n = r.next_in_bucket;
+					break;
+				}
+			}
+
+			/* unlink from ready queue */
+			Kevent_registration *prev = nullptr;
+			for (Kevent_registration *q = _ready_head; q; prev = q, q = q->next_ready) {
+				if (q != &r)
+					continue;
+
+				if (prev) prev->next_ready = q->next_ready;
+				else      _ready_head      = q->next_ready;
+
+				if (_ready_tail == q)
+					_ready_tail = prev;
+				break;
+			}
+
+			if (r.handle && r.handle->context == &r)
+				r.handle->context = nullptr;
+
+			/* the registration must not stay in a list of pending responses */
+			if (r.io)
+				r.io->drop_io_response(r);
+
+			r.handle  = nullptr;
+			r.io      = nullptr;
+			r.enabled = false;
+			r.queued  = false;
+
+			r.next_in_bucket = _unused;
+			_unused = &r;
+		}
+
+		/**
+		 * Return VFS handle that signals read readiness of 'fd'
+		 */
+		static Vfs::Vfs_handle *_read_handle(File_descriptor *fd)
+		{
+			if (Vfs::Vfs_handle *handle = vfs_file_handle(fd))
+				return handle;
+
+			/* sockets are readable if their data or accept file is */
+			if (File_descriptor *file = socket_fs_read_file(fd))
+				return vfs_file_handle(file);
+
+			return nullptr;
+		}
+
+		int _add(struct kevent const &change)
+		{
+			File_descriptor *fd =
+				file_descriptor_allocator()->find_by_libc_fd(change.ident);
+			if (!fd)
+				return EBADF;
+
+			Kevent_registration *r = _lookup(change.ident, change.filter);
+			bool const added = !r;
+
+			if (added) {
+				Vfs::Vfs_handle *handle = nullptr;
+				if (change.filter == EVFILT_READ) {
+					handle = _read_handle(fd);
+					if (!handle)
+						return ENODEV;
+
+					/* a handle carries the registration of one kqueue only */
+					if (handle->context)
+						return EBUSY;
+				}
+
+				r = _alloc();
+				if (!r)
+					return ENOMEM;
+
+				r->ident  = change.ident;
+				r->filter = change.filter;
+				r->handle = handle;
+				r->io     = handle ? &handle->fs() : nullptr;
+
+				if (handle)
+					handle->context = r;
+
+				Kevent_registration *&bucket = _buckets[_bucket(r->ident)];
+				r->next_in_bucket = bucket;
+				bucket = r;
+			}
+
+			r->flags   = change.flags & (EV_ONESHOT | EV_CLEAR | EV_DISPATCH);
+			r->fflags  = change.fflags;
+			r->data    = change.data;
+			r->udata   = change.udata;
+			r->enabled = !(change.flags & EV_DISABLE);
+
+			if (r->enabled && r->arm())
+				_enqueue(*r);
+
+			return 0;
+		}
+
+		int _apply(struct kevent const &change)
+		{
+			if (change.filter != EVFILT_READ && change.filter != EVFILT_WRITE)
+				return EINVAL;
+
+			if (change.flags & EV_ADD)
+				return _add(change);
+
+			Kevent_registration *r = _lookup(change.ident, change.filter);
+			if (!r)
+				return ENOENT;
+
+			if (change.flags & EV_DELETE) {
+				_remove(*r);
+				return 0;
+			}
+
+			if (change.flags & EV_DISABLE)
+				r->enabled = false;
+
+			if (change.flags & EV_ENABLE) {
+				r->enabled = true;
+				if (r->arm())
+					_enqueue(*r);
+			}
+
+			return 0;
+		}
+
+		/**
+		 * Report the queued registrations that are still ready
+		 *
+		 * Each queued registration is looked at once per call. Level-
+		 * triggered registrations stay queued as long as they are ready.
+		 */
+		int _collect(struct kevent *eventlist, int nevents)
+		{
+			int count = 0;
+
+			Kevent_registration *last = _ready_tail;
+			while (count < nevents && _ready_head) {
+
+				bool const end = (_ready_head == last);
+
+				Kevent_registration &r = *_dequeue();
+
+				if (r.enabled && r.arm()) {
+
+					struct kevent &ev = eventlist[count++];
+					ev.ident  = r.ident;
+					ev.filter = r.filter;
+					ev.flags  = r.flags;
+					ev.fflags = 0;
+					ev.data   = 0;
+					ev.udata  = r.udata;
+
+					if (r.flags & EV_ONESHOT)
+						_remove(r);
+					else if (r.flags & EV_DISPATCH)
+						r.enabled = false;
+					else if (!(r.flags & EV_CLEAR))
+						_enqueue(r);
+				}
+
+				if (end)
+					break;
+			}
+			return count;
+		}
+
+	public:
+
+		~Kqueue()
+		{
+			/* removal discards the pending I/O responses of registrations */
+			for (Kevent_registration *&bucket : _buckets)
+				while (bucket)
+					_remove(*bucket);
+
+			while (_unused) {
+				Kevent_registration *r = _unused;
+				_unused = r->next_in_bucket;
+				r->~Kevent_registration();
+				free(r);
+			}
+		}
+
+		bool pending()
+		{
+			Genode::Lock::Guard guard(_lock);
+			return _ready_head != nullptr;
+		}
+
+		void ready(Kevent_registration &r)
+		{
+			Genode::Lock::Guard guard(_lock);
+			_enqueue(r);
+		}
+
+		void handle_closed(Kevent_registration &r)
+		{
+			Genode::Lock::Guard guard(_lock);
+			_remove(r);
+		}
+
+		/**
+		 * Apply changes and collect events as specified for 'kevent'
+		 *
+		 * \return  number of events or -1 if no event could be collected
+		 */
+		int process(struct kevent const *changelist, int nchanges,
+		            struct kevent *eventlist, int nevents,
+		            timespec const *timeout)
+		{
+			int count = 0;
+			{
+				Genode::Lock::Guard guard(_lock);
+
+				for (int i = 0; i < nchanges; i++) {
+
+					int const error = _apply(changelist[i]);
+					if (!error && !(changelist[i].flags & EV_RECEIPT))
+						continue;
+
+					/* report errors and receipts via the event list */
+					if (count == nevents) {
+						if (error)
+							return Errno(error);
+						continue;
+					}
+
+					struct kevent &ev = eventlist[count++];
+					ev       = changelist[i];
+					ev.flags = EV_ERROR;
+					ev.data  = error;
+				}
+
+				if (count)
+					return count;
+
+				count = _collect(eventlist, nevents);
+			}
+
+			if (count || !nevents)
+				return count;
+
+			unsigned long timeout_ms = 0;
+			if (timeout) {
+				timeout_ms = timeout->tv_sec*1000 + timeout->tv_nsec/1000000;
+
+				/* zero timeout means polling */
+				if (!timeout_ms) {
+					if (!timeout->tv_nsec)
+						return 0;
+					timeout_ms = 1;
+				}
+			}
+
+			struct Check : Suspend_functor
+			{
+				Kqueue &kqueue;
+
+				Check(Kqueue &kqueue) : kqueue(kqueue) { }
+
+				bool suspend() override { return !kqueue.pending(); }
+			} check { *this };
+
+			/* the ready queue may hold registrations that are not ready anymore */
+			for (;;) {
+				timeout_ms = suspend(check, timeout_ms);
+
+				{
+					Genode::Lock::Guard guard(_lock);
+					count = _collect(eventlist, nevents);
+				}
+
+				if (count || (timeout && !timeout_ms))
+					return count;
+			}
+		}
+};
+
+
+struct Libc::Kqueue_plugin : Libc::Plugin
+{
+	int close(File_descriptor *fd) override
+	{
+		Kqueue *kqueue = dynamic_cast<Kqueue *>(fd->context);
+		if (!kqueue) return Errno(EBADF);
+
+		kqueue->~Kqueue();
+		free(kqueue);
+
+		file_descriptor_allocator()->free(fd);
+		return 0;
+	}
+};
+
+
+static Libc::Kqueue_plugin &kqueue_plugin()
+{
+	static Libc::Kqueue_plugin inst;
+	return inst;
+}
+
+
+void Libc::kqueue_io_response(Vfs::Vfs_handle::Context *context)
+{
+	/* handle contexts of other types are not ours to report */
+	if (Kevent_registration *r = Kevent_registration::from_context(context))
+		r->kqueue.ready(*r);
+}
+
+
+void Libc::kqueue_handle_closed(Vfs::Vfs_handle *handle)
+{
+	if (Kevent_registration *r = Kevent_registration::from_context(handle->context))
+		r->kqueue.handle_closed(*r);
+}
+
+
+extern "C" int kqueue(void)
+{
+	void *mem = malloc(sizeof(Libc::Kqueue));
+	if (!mem) return Errno(ENOMEM);
+
+	Libc::Kqueue *kqueue = new (mem) Libc::Kqueue();
+
+	Libc::File_descriptor *fd =
+		Libc::file_descriptor_allocator()->alloc(&kqueue_plugin(), kqueue);
+	if (!fd) {
+		kqueue->~Kqueue();
+		free(mem);
+		return Errno(EMFILE);
+	}
+	return fd->libc_fd;
+}
+
+
+extern "C" int kevent(int kq, struct kevent const *changelist, int nchanges,
+                      struct kevent *eventlist, int nevents,
+                      struct timespec const *timeout)
+{
+	Libc::File_descriptor *fd = Libc::file_descriptor_allocator()->find_by_libc_fd(kq);
+	if (!fd || fd->plugin != &kqueue_plugin()) return Errno(EBADF);
+
+	Libc::Kqueue *kqueue = dynamic_cast<Libc::Kqueue *>(fd->context);
+	if (!kqueue) return Errno(EBADF);
+
+	if (nchanges < 0 || nevents < 0) return Errno(EINVAL);
+	if ((nchanges && !changelist) || (nevents && !eventlist)) return Errno(EFAULT);
+
+	return kqueue->process(changelist, nchanges, eventlist, nevents, timeout);
+}
@@ -44,6 +44,14 @@ namespace Libc {
 	 * Malloc allocator
          */
 	void init_malloc(Genode::Allocator &heap);
+
+	/**
+	 * Select malloc implementation according to the libc config
+	 *
+	 * With '<libc malloc="arena"/>', subsequent allocations are served by
+	 * the scalable arena allocator.
+	 */
+	void init_malloc_config(Genode::Env &env, Genode::Xml_node node);
 }
 
 #endif /* _LIBC_INIT_H_ */
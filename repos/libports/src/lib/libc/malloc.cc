@@ -16,9 +16,12 @@
 #include <base/env.h>
 #include <base/log.h>
 #include <base/slab.h>
+#include <base/thread.h>
+#include <cpu/memory_barrier.h>
 #include <util/construct_at.h>
 #include <util/string.h>
 #include <util/misc_math.h>
+#include <libc/malloc_stats.h>
 
 /* libc includes */
 extern "C" {
@@ -64,6 +67,71 @@ namespace Genode {
 }
 
 
+struct Metadata
+{
+	typedef Genode::size_t size_t;
+	typedef Genode::addr_t addr_t;
+
+	/* bit 63 arena flag, bits 62..5 size, and 4..0 offset */
+	unsigned long long value;
+
+	enum : unsigned long long { ARENA = 1ULL << 63 };
+
+	/**
+	 * Allocation metadata
+	 *
+	 * \param size    allocation size
+	 * \param offset  offset of pointer from allocation
+	 * \param arena   allocation belongs to the arena allocator
+	 */
+	Metadata(size_t size, unsigned offset, bool arena = false)
+	:
+		value(((unsigned long long)size << 5) | (offset & 0x1f)
+		      | (arena ? (unsigned long long)ARENA : 0ULL))
+	{ }
+
+	size_t   size()   const { return (value & ~ARENA) >> 5; }
+	unsigned offset() const { return value & 0x1f; }
+	bool     arena()  const { return value & ARENA; }
+
+	/**
+	 * Allocation overhead due to alignment and metadata storage
+	 *
+	 * We store the metadata of the allocation right before the pointer
+	 * returned to the caller and can then retrieve the information when
+	 * freeing the block. Therefore, we add room for metadata and 16-byte
+	 * alignment.
+	 *
+	 * Note, the worst case is an allocation that starts at
+	 * 16 byte - sizeof(Metadata) + 1 because it misses one byte of space
+	 * for the metadata and therefore increases the worst-case allocation
+	 * by 15 bytes additionally to the metadata space.
+	 */
+	static constexpr size_t room() { return sizeof(Metadata) + 15; }
+
+	static Metadata &of(void *ptr) { return *((Metadata *)ptr - 1); }
+
+	/**
+	 * Place metadata into allocated block and return pointer for the caller
+	 */
+	static void *prepare(void *alloc_addr, size_t real_size, bool arena)
+	{
+		/* correctly align the allocation address */
+		Metadata * const aligned_addr =
+			(Metadata *)(((addr_t)alloc_addr + room()) & ~15UL);
+
+		unsigned const offset = (addr_t)aligned_addr - (addr_t)alloc_addr;
+
+		*(aligned_addr - 1) = Metadata(real_size, offset, arena);
+
+		return aligned_addr;
+	}
+
+	static void *alloc_addr(void *ptr) {
+		return (void *)((addr_t)ptr - of(ptr).offset()); }
+};
+
+
 /**
  * Allocator that uses slabs for small objects sizes
  */
@@ -80,37 +148,7 @@ class Malloc
 			NUM_SLABS  = (SLAB_STOP - SLAB_START) + 1
 		};
 
-		struct Metadata
-		{
-			unsigned long long value; /* bits 63..5 size and 4..0 offset */
-
-			/**
-			 * Allocation metadata
-			 *
-			 * \param size    allocation size
-			 * \param offset  offset of pointer from allocation
-			 */
-			Metadata(size_t size, unsigned offset)
-			: value(((unsigned long long)size << 5) | (offset & 0x1f)) { }
-
-			size_t   size()   const { return value >> 5; }
-			unsigned offset() const { return value & 0x1f; }
-		};
-
-		/**
-		 * Allocation overhead due to alignment and metadata storage
-		 *
-		 * We store the metadata of the allocation right before the pointer
-		 * returned to the caller and can then retrieve the information when
-		 * freeing the block. Therefore, we add room for metadata and 16-byte
-		 * alignment.
-		 *
-		 * Note, the worst case is an allocation that starts at
-		 * 16 byte - sizeof(Metadata) + 1 because it misses one byte of space
-		 * for the metadata and therefore increases the worst-case allocation
-		 * by 15 bytes additionally to the metadata space.
-		 */
-		static constexpr size_t _room() { return sizeof(Metadata) + 15; }
+		static constexpr size_t _room() { return Metadata::room(); }
 
 		Genode::Allocator  &_backing_store;        /* back-end allocator */
 		Genode::Slab_alloc *_allocator[NUM_SLABS]; /* slab allocators */
@@ -164,66 +202,460 @@ class Malloc
 
 			if (!alloc_addr) return nullptr;
 
-			/* correctly align the allocation address */
-			Metadata * const aligned_addr =
-				(Metadata *)(((addr_t)alloc_addr + _room()) & ~15UL);
+			return Metadata::prepare(alloc_addr, real_size, false);
+		}
+
+		void free(void *ptr)
+		{
+			Genode::Lock::Guard lock_guard(_lock);
+
+			size_t   const  real_size  = Metadata::of(ptr).size();
+			unsigned const  msb        = _slab_log2(real_size);
+
+			void *alloc_addr = Metadata::alloc_addr(ptr);
+
+			if (msb > SLAB_STOP) {
+				_backing_store.free(alloc_addr, real_size);
+			} else {
+				_allocator[msb - SLAB_START]->free(alloc_addr);
+			}
+		}
+};
+
+
+/**
+ * Scalable allocator for multi-threaded programs
+ *
+ * Small allocations are served from fine-grained size classes. Each class
+ * is backed by a slab allocator with a lock of its own. In front of the
+ * slabs, each thread has a cache of free objects per size class (a
+ * magazine), which serves most allocations and deallocations without any
+ * lock. Objects freed by another thread than the allocating one simply end
+ * up in the magazine of the freeing thread. Only when a magazine runs empty
+ * or full, half of its capacity is exchanged with the slab. When a thread
+ * exits, its magazines are flushed to the slabs and its cache is freed.
+ *
+ * Medium allocations are served by the thread-safe backing store. Large
+ * allocations get a dedicated dataspace, which is handed back on free.
+ */
+class Arena
+{
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		Arena(Arena const &);
+		Arena &operator = (Arena const &);
+
+		typedef Genode::size_t size_t;
+		typedef Genode::addr_t addr_t;
+
+		enum {
+			NUM_CLASSES    = 40,        /* 16 linear plus 24 logarithmic */
+			MAX_CLASS_SIZE = 16*1024,
+			LARGE_SIZE     = 128*1024,  /* dedicated dataspaces from here */
+			MAGAZINE       = 32,
+			MAX_CACHES     = 64,
+		};
+
+		/**
+		 * Return size class for 'size' of up to 'MAX_CLASS_SIZE'
+		 *
+		 * Up to 256 bytes, classes are spaced by 16 bytes. Above, each
+		 * power of two is divided into four classes.
+		 */
+		static unsigned _class_index(size_t size)
+		{
+			if (size <= 256)
+				return (unsigned)((size + 15)/16) - 1;
+
+			unsigned const msb     = Genode::log2(size - 1);
+			size_t   const step    = 1UL << (msb - 2);
+			unsigned const quarter = (unsigned)((size - (1UL << msb) + step - 1)/step);
 
-			unsigned const offset = (addr_t)aligned_addr - (addr_t)alloc_addr;
+			return 16 + (msb - 8)*4 + quarter - 1;
+		}
 
-			*(aligned_addr - 1) = Metadata(real_size, offset);
+		static size_t _class_size(unsigned index)
+		{
+			if (index < 16)
+				return (index + 1)*16;
 
-			return aligned_addr;
+			index -= 16;
+			unsigned const msb = 8 + index/4;
+			return (1UL << msb) + (index%4 + 1)*(1UL << (msb - 2));
 		}
 
-		void *realloc(void *ptr, size_t size)
+		struct Size_class
+		{
+			Genode::Lock        lock        { };
+			Genode::Slab_alloc *slab        = nullptr;
+			unsigned long       outstanding = 0;  /* objects out of the slab */
+		};
+
+		struct Magazine
+		{
+			unsigned  count = 0;
+			void     *objects[MAGAZINE];
+		};
+
+		struct Thread_cache
+		{
+			Magazine magazines[NUM_CLASSES];
+		};
+
+		/*
+		 * Slot of the cache table
+		 *
+		 * The key is kept outside of the cache so that a thread looking up
+		 * its cache never touches the caches of other threads, which may
+		 * be freed concurrently.
+		 */
+		struct Cache_slot
 		{
-			size_t const real_size     = size + _room();
-			size_t const old_real_size = ((Metadata *)ptr - 1)->size();
+			void const   * volatile key   = nullptr;
+			Thread_cache * volatile cache = nullptr;
+		};
+
+		/*
+		 * Header of a large allocation at the start of its dataspace
+		 */
+		struct Large
+		{
+			Genode::Ram_dataspace_capability const cap;
+			size_t                           const size;
+
+			Large(Genode::Ram_dataspace_capability cap, size_t size)
+			: cap(cap), size(size) { }
+		};
+
+		Genode::Env       &_env;
+		Genode::Allocator &_backing_store;
+
+		Size_class _classes[NUM_CLASSES];
+
+		Cache_slot   _caches[MAX_CACHES];
+		Genode::Lock _caches_lock { };  /* protects registration and release */
 
-			/* do not reallocate if new size is less than the current size */
-			if (real_size <= old_real_size)
-				return ptr;
+		/* statistics of medium and large allocations */
+		Genode::Lock  _large_lock  { };
+		size_t        _medium      = 0;
+		size_t        _large       = 0;
+		unsigned long _large_count = 0;
 
-			/* allocate new block */
-			void *new_addr = alloc(size);
+		static void const *_key()
+		{
+			static char main_thread;
+
+			void const *key = Genode::Thread::myself();
+			return key ? key : &main_thread;
+		}
 
-			if (new_addr) {
-				/* copy content from old block into new block */
-				memcpy(new_addr, ptr, old_real_size - _room());
+		static unsigned _first_slot(void const *key) {
+			return (unsigned)(((addr_t)key >> 12) % MAX_CACHES); }
 
-				/* free old block */
-				free(ptr);
+		/**
+		 * Return cache of the calling thread
+		 *
+		 * The cache is identified by the thread object, which is unique
+		 * among all running threads. The cache of a thread that exits
+		 * without calling 'thread_exit' is inherited by the next thread
+		 * using the same thread object.
+		 *
+		 * \return  nullptr if the maximum number of caches is exhausted
+		 */
+		Thread_cache *_cache()
+		{
+			void const * const key   = _key();
+			unsigned     const start = _first_slot(key);
+
+			/*
+			 * Released caches leave holes, so the whole table is searched
+			 * before a new cache gets registered.
+			 */
+			for (unsigned i = 0; i < MAX_CACHES; i++) {
+				Cache_slot &slot = _caches[(start + i) % MAX_CACHES];
+				if (slot.key == key)
+					return slot.cache;
 			}
 
-			return new_addr;
+			/* register new cache at the first free slot */
+			Genode::Lock::Guard guard(_caches_lock);
+
+			for (unsigned i = 0; i < MAX_CACHES; i++) {
+
+				Cache_slot &slot = _caches[(start + i) % MAX_CACHES];
+				if (slot.key)
+					continue;
+
+				void *addr = nullptr;
+				if (!_backing_store.alloc(sizeof(Thread_cache), &addr))
+					return nullptr;
+
+				slot.cache = Genode::construct_at<Thread_cache>(addr);
+
+				/* publish the key not before the cache is initialized */
+				Genode::memory_barrier();
+				slot.key = key;
+				return slot.cache;
+			}
+			return nullptr;
 		}
 
-		void free(void *ptr)
+		void *_alloc_central(unsigned index)
 		{
-			Genode::Lock::Guard lock_guard(_lock);
+			Size_class &c = _classes[index];
+			Genode::Lock::Guard guard(c.lock);
 
-			Metadata *md = (Metadata *)ptr - 1;
+			void *obj = c.slab->alloc();
+			if (obj)
+				c.outstanding++;
+			return obj;
+		}
 
-			size_t   const  real_size  = md->size();
-			unsigned const  msb        = _slab_log2(real_size);
+		void _free_central(unsigned index, void *obj)
+		{
+			Size_class &c = _classes[index];
+			Genode::Lock::Guard guard(c.lock);
 
-			void *alloc_addr = (void *)((addr_t)ptr - md->offset());
+			c.slab->free(obj);
+			c.outstanding--;
+		}
 
-			if (msb > SLAB_STOP) {
+		void _refill(unsigned index, Magazine &m)
+		{
+			Size_class &c = _classes[index];
+			Genode::Lock::Guard guard(c.lock);
+
+			while (m.count < MAGAZINE/2) {
+				void *obj = c.slab->alloc();
+				if (!obj)
+					break;
+				m.objects[m.count++] = obj;
+				c.outstanding++;
+			}
+		}
+
+		void _flush(unsigned index, Magazine &m, unsigned count)
+		{
+			Size_class &c = _classes[index];
+			Genode::Lock::Guard guard(c.lock);
+
+			for (; count && m.count; count--) {
+				c.slab->free(m.objects[--m.count]);
+				c.outstanding--;
+			}
+		}
+
+		void *_alloc_large(size_t real_size)
+		{
+			void *alloc_addr = nullptr;
+
+			if (real_size <= LARGE_SIZE) {
+				if (!_backing_store.alloc(real_size, &alloc_addr))
+					return nullptr;
+
+				Genode::Lock::Guard guard(_large_lock);
+				_medium += real_size;
+
+			} else {
+
+				size_t const size = Genode::align_addr(real_size + sizeof(Large), 12);
+
+				Genode::Ram_dataspace_capability cap;
+				try { cap = _env.ram().alloc(size); }
+				catch (Genode::Out_of_ram)  { return nullptr; }
+				catch (Genode::Out_of_caps) { return nullptr; }
+
+				void *base = nullptr;
+				try { base = _env.rm().attach(cap); }
+				catch (...) {
+					_env.ram().free(cap);
+					return nullptr;
+				}
+
+				Genode::construct_at<Large>(base, cap, size);
+				alloc_addr = (Large *)base + 1;
+
+				Genode::Lock::Guard guard(_large_lock);
+				_large += size;
+				_large_count++;
+			}
+
+			return Metadata::prepare(alloc_addr, real_size, true);
+		}
+
+		void _free_large(void *alloc_addr, size_t real_size)
+		{
+			if (real_size <= LARGE_SIZE) {
 				_backing_store.free(alloc_addr, real_size);
+
+				Genode::Lock::Guard guard(_large_lock);
+				_medium -= real_size;
+				return;
+			}
+
+			Large *large = (Large *)alloc_addr - 1;
+
+			Genode::Ram_dataspace_capability const cap  = large->cap;
+			size_t                           const size = large->size;
+
+			large->~Large();
+			_env.rm().detach(large);
+			_env.ram().free(cap);
+
+			Genode::Lock::Guard guard(_large_lock);
+			_large -= size;
+			_large_count--;
+		}
+
+	public:
+
+		Arena(Genode::Env &env, Genode::Allocator &backing_store)
+		: _env(env), _backing_store(backing_store)
+		{
+			for (unsigned i = 0; i < NUM_CLASSES; i++)
+				_classes[i].slab = new (backing_store)
+					Genode::Slab_alloc(_class_size(i), &backing_store);
+
+		}
+
+		~Arena() { Genode::warning(__func__, " unexpectedly called"); }
+
+		/**
+		 * Return the cache of the calling thread to the slabs
+		 *
+		 * Called by a thread that is about to exit. The slot of the cache
+		 * becomes available to other threads.
+		 */
+		void thread_exit()
+		{
+			void const * const key   = _key();
+			unsigned     const start = _first_slot(key);
+
+			for (unsigned i = 0; i < MAX_CACHES; i++) {
+
+				Cache_slot &slot = _caches[(start + i) % MAX_CACHES];
+				if (slot.key != key)
+					continue;
+
+				Thread_cache *cache = slot.cache;
+
+				for (unsigned j = 0; j < NUM_CLASSES; j++)
+					_flush(j, cache->magazines[j], MAGAZINE);
+
+				Genode::Lock::Guard guard(_caches_lock);
+
+				slot.key   = nullptr;
+				slot.cache = nullptr;
+
+				cache->~Thread_cache();
+				_backing_store.free(cache, sizeof(Thread_cache));
+				return;
+			}
+		}
+
+		void *alloc(size_t size)
+		{
+			size_t const real_size = size + Metadata::room();
+
+			if (real_size > MAX_CLASS_SIZE)
+				return _alloc_large(real_size);
+
+			unsigned const index = _class_index(real_size);
+
+			void *obj = nullptr;
+
+			if (Thread_cache *cache = _cache()) {
+				Magazine &m = cache->magazines[index];
+
+				if (!m.count)
+					_refill(index, m);
+
+				if (m.count)
+					obj = m.objects[--m.count];
 			} else {
-				_allocator[msb - SLAB_START]->free(alloc_addr);
+				obj = _alloc_central(index);
 			}
+
+			if (!obj) return nullptr;
+
+			return Metadata::prepare(obj, real_size, true);
+		}
+
+		void free(void *ptr)
+		{
+			size_t const real_size  = Metadata::of(ptr).size();
+			void * const alloc_addr = Metadata::alloc_addr(ptr);
+
+			if (real_size > MAX_CLASS_SIZE) {
+				_free_large(alloc_addr, real_size);
+				return;
+			}
+
+			unsigned const index = _class_index(real_size);
+
+			if (Thread_cache *cache = _cache()) {
+				Magazine &m = cache->magazines[index];
+
+				if (m.count == MAGAZINE)
+					_flush(index, m, MAGAZINE/2);
+
+				m.objects[m.count++] = alloc_addr;
+			} else {
+				_free_central(index, alloc_addr);
+			}
+		}
+
+		Libc::Malloc_stats stats()
+		{
+			Libc::Malloc_stats s { 0, 0, 0, 0, 0 };
+
+			for (unsigned i = 0; i < NUM_CLASSES; i++) {
+				Size_class &c = _classes[i];
+				Genode::Lock::Guard guard(c.lock);
+
+				s.held      += c.slab->consumed();
+				s.allocated += c.outstanding*_class_size(i);
+			}
+
+			/* the magazine counts are read without synchronization */
+			{
+				Genode::Lock::Guard guard(_caches_lock);
+
+				for (unsigned i = 0; i < MAX_CACHES; i++) {
+					Thread_cache const *cache = _caches[i].key ? _caches[i].cache
+					                                           : nullptr;
+					if (!cache)
+						continue;
+
+					for (unsigned j = 0; j < NUM_CLASSES; j++)
+						s.cached += cache->magazines[j].count*_class_size(j);
+				}
+			}
+
+			s.allocated = s.allocated > s.cached ? s.allocated - s.cached : 0;
+
+			Genode::Lock::Guard guard(_large_lock);
+
+			s.held        += _medium + _large;
+			s.allocated   += _medium + _large;
+			s.large        = _large;
+			s.large_count  = _large_count;
+
+			return s;
 		}
 };
 
 
 static Malloc *mallocator;
+static Arena  *arena;
 
 
 extern "C" void *malloc(size_t size)
 {
-	return mallocator->alloc(size);
+	return arena ? arena->alloc(size) : mallocator->alloc(size);
 }
 
 
@@ -238,7 +670,13 @@ extern "C" void *calloc(size_t nmemb, size_t size)
 
 extern "C" void free(void *ptr)
 {
-	if (ptr) mallocator->free(ptr);
+	if (!ptr) return;
+
+	/* blocks allocated before enabling the arena stay with 'mallocator' */
+	if (Metadata::of(ptr).arena())
+		arena->free(ptr);
+	else
+		mallocator->free(ptr);
 }
 
 
@@ -251,11 +689,62 @@ extern "C" void *realloc(void *ptr, size_t size)
 		return nullptr;
 	}
 
-	return mallocator->realloc(ptr, size);
+	size_t const real_size     = size + Metadata::room();
+	size_t const old_real_size = Metadata::of(ptr).size();
+
+	/* do not reallocate if new size is less than the current size */
+	if (real_size <= old_real_size)
+		return ptr;
+
+	/* allocate new block */
+	void *new_addr = malloc(size);
+
+	if (new_addr) {
+		/* copy content from old block into new block */
+		memcpy(new_addr, ptr, old_real_size - Metadata::room());
+
+		/* free old block */
+		free(ptr);
+	}
+
+	return new_addr;
+}
+
+
+Libc::Malloc_stats Libc::malloc_stats()
+{
+	return arena ? arena->stats() : Malloc_stats { 0, 0, 0, 0, 0 };
 }
 
 
+void Libc::malloc_thread_exit()
+{
+	if (arena)
+		arena->thread_exit();
+}
+
+
+static Genode::Allocator *malloc_heap;
+
+
 void Libc::init_malloc(Genode::Allocator &heap)
 {
-	mallocator = unmanaged_singleton<Malloc>(heap);
+	malloc_heap = &heap;
+	mallocator  = unmanaged_singleton<Malloc>(heap);
+}
+
+
+void Libc::init_malloc_config(Genode::Env &env, Genode::Xml_node node)
+{
+	typedef Genode::String<16> Mode;
+	Mode const mode = node.attribute_value("malloc", Mode("simple"));
+
+	if (mode == "arena") {
+		if (!arena)
+			arena = unmanaged_singleton<Arena>(env, *malloc_heap);
+		return;
+	}
+
+	if (mode != "simple")
+		Genode::warning("unknown malloc mode '", mode, "'");
 }
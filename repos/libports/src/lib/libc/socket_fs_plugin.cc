@@ -17,6 +17,7 @@
 /* Genode includes */
 #include <base/env.h>
 #include <base/log.h>
+#include <vfs/socket_datagram.h>
 #include <vfs/types.h>
 #include <util/string.h>
 #include <libc/allocator.h>
@@ -29,6 +30,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <limits.h>
 #include <stdio.h>
 
 /* libc-internal includes */
@@ -41,6 +43,7 @@
 namespace Libc {
 	extern char const *config_socket();
 	bool read_ready(Libc::File_descriptor *);
+	Libc::File_descriptor *socket_fs_read_file(Libc::File_descriptor *);
 }
 
 
@@ -80,6 +83,8 @@ namespace Socket_fs {
 	struct Sockaddr_functor;
 	struct Remote_functor;
 	struct Local_functor;
+	struct Datagrams_functor;
+	struct Batch_buffer;
 
 	Plugin & plugin();
 
@@ -120,7 +125,7 @@ struct Socket_fs::Context : Libc::Plugin_context
 	private:
 
 		enum Fd : unsigned {
-			DATA, CONNECT, BIND, LISTEN, ACCEPT, LOCAL, REMOTE, MAX
+			DATA, DATAGRAMS, CONNECT, BIND, LISTEN, ACCEPT, LOCAL, REMOTE, MAX
 		};
 
 		struct
@@ -129,7 +134,7 @@ struct Socket_fs::Context : Libc::Plugin_context
 			int                    num;
 			Libc::File_descriptor *file;
 		} _fd[Fd::MAX] = {
-			{ "data",    -1, nullptr },
+			{ "data",    -1, nullptr }, { "datagrams", -1, nullptr },
 			{ "connect", -1, nullptr }, { "bind",   -1, nullptr },
 			{ "listen",  -1, nullptr }, { "accept", -1, nullptr },
 			{ "local",   -1, nullptr }, { "remote", -1, nullptr }
@@ -194,6 +199,7 @@ struct Socket_fs::Context : Libc::Plugin_context
 		}
 
 		int data_fd()    { return _fd_for_type(Fd::DATA,    O_RDWR); }
+		int datagrams_fd() { return _fd_for_type(Fd::DATAGRAMS, O_RDWR); }
 		int connect_fd() { return _fd_for_type(Fd::CONNECT, O_WRONLY); }
 		int bind_fd()    { return _fd_for_type(Fd::BIND,    O_WRONLY); }
 		int listen_fd()  { return _fd_for_type(Fd::LISTEN,  O_WRONLY); }
@@ -203,6 +209,7 @@ struct Socket_fs::Context : Libc::Plugin_context
 
 		/* request the appropriate fd to ensure the file is open */
 		bool data_read_ready()   { data_fd();   return _fd_read_ready(Fd::DATA); }
+		bool datagrams_read_ready() { datagrams_fd(); return _fd_read_ready(Fd::DATAGRAMS); }
 		bool accept_read_ready() { accept_fd(); return _fd_read_ready(Fd::ACCEPT); }
 		bool local_read_ready()  { local_fd();  return _fd_read_ready(Fd::LOCAL); }
 		bool remote_read_ready() { remote_fd(); return _fd_read_ready(Fd::REMOTE); }
@@ -213,6 +220,19 @@ struct Socket_fs::Context : Libc::Plugin_context
 		{
 			return _accept_only ? accept_read_ready() : data_read_ready();
 		}
+
+		/**
+		 * Return file that 'read_ready' refers to
+		 */
+		Libc::File_descriptor *read_file()
+		{
+			if (_accept_only) {
+				accept_fd();
+				return _fd[Fd::ACCEPT].file;
+			}
+			data_fd();
+			return _fd[Fd::DATA].file;
+		}
 };
 
 
@@ -248,6 +268,40 @@ struct Socket_fs::Local_functor : Socket_fs::Sockaddr_functor
 };
 
 
+struct Socket_fs::Datagrams_functor : Libc::Suspend_functor
+{
+	Socket_fs::Context &context;
+
+	Datagrams_functor(Socket_fs::Context &context) : context(context) { }
+
+	bool suspend() override { return !context.datagrams_read_ready(); }
+};
+
+
+/*
+ * Temporary buffer for gathering I/O vectors and batches of datagrams
+ */
+struct Socket_fs::Batch_buffer
+{
+	size_t const size;
+	char * const base;
+
+	Batch_buffer(size_t size) : size(size), base((char *)malloc(size)) { }
+
+	~Batch_buffer() { free(base); }
+
+	bool valid() const { return base != nullptr; }
+
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		Batch_buffer(Batch_buffer const &);
+		Batch_buffer &operator = (Batch_buffer const &);
+};
+
+
 struct Socket_fs::Plugin : Libc::Plugin
 {
 	bool supports_select(int, fd_set *, fd_set *, fd_set *, timeval *) override;
@@ -646,13 +700,6 @@ extern "C" ssize_t socket_fs_recv(int libc_fd, void *buf, ::size_t len, int flag
 }
 
 
-extern "C" ssize_t socket_fs_recvmsg(int libc_fd, msghdr *msg, int flags)
-{
-	Genode::warning("##########  TODO  ########## ", __func__);
-	return 0;
-}
-
-
 static ssize_t do_sendto(Libc::File_descriptor *fd,
                          void const *buf, ::size_t len, int flags,
                          sockaddr const *dest_addr, socklen_t dest_addrlen)
@@ -710,6 +757,377 @@ extern "C" ssize_t socket_fs_send(int libc_fd, void const *buf, ::size_t len, in
 }
 
 
+/***************************************
+ ** Scatter-gather and batched transfer **
+ ***************************************/
+
+typedef Vfs::Socket_datagram Socket_datagram;
+
+
+static size_t iov_size(msghdr const &msg)
+{
+	size_t size = 0;
+	for (int i = 0; i < msg.msg_iovlen; i++)
+		size += msg.msg_iov[i].iov_len;
+
+	return size;
+}
+
+
+/**
+ * Copy up to 'len' bytes from 'src' to the I/O vector of 'msg'
+ *
+ * \return  number of copied bytes
+ */
+static size_t scatter(msghdr const &msg, char const *src, size_t len)
+{
+	size_t copied = 0;
+	for (int i = 0; i < msg.msg_iovlen && copied < len; i++) {
+		size_t const n = Genode::min(msg.msg_iov[i].iov_len, len - copied);
+		memcpy(msg.msg_iov[i].iov_base, src + copied, n);
+		copied += n;
+	}
+	return copied;
+}
+
+
+/**
+ * Copy the I/O vector of 'msg' to 'dst'
+ *
+ * \return  number of copied bytes
+ */
+static size_t gather(msghdr const &msg, char *dst)
+{
+	size_t copied = 0;
+	for (int i = 0; i < msg.msg_iovlen; i++) {
+		memcpy(dst + copied, msg.msg_iov[i].iov_base, msg.msg_iov[i].iov_len);
+		copied += msg.msg_iov[i].iov_len;
+	}
+	return copied;
+}
+
+
+static void write_sockaddr_in(msghdr &msg, Socket_datagram const &dg)
+{
+	if (!msg.msg_name)
+		return;
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_len    = sizeof(addr);
+	addr.sin_family = AF_INET;
+	addr.sin_port   = htons(dg.port);
+	memcpy(&addr.sin_addr.s_addr, dg.addr, sizeof(dg.addr));
+
+	/* do not exceed the caller's buffer */
+	memcpy(msg.msg_name, &addr, Genode::min((size_t)msg.msg_namelen, sizeof(addr)));
+	msg.msg_namelen = sizeof(addr);
+}
+
+
+/**
+ * Wait until datagrams are available for reading
+ *
+ * \param timeout_ms  maximum time to wait, 0 for infinite wait
+ *
+ * \return  false if the socket is non-blocking or the timeout expired
+ *          before a datagram arrived
+ */
+static bool wait_for_datagrams(Socket_fs::Context &context, bool nonblocking,
+                               unsigned long timeout_ms)
+{
+	Datagrams_functor func(context);
+
+	if (nonblocking)
+		return !func.suspend();
+
+	while (func.suspend()) {
+		unsigned long const remaining = Libc::suspend(func, timeout_ms);
+
+		if (timeout_ms) {
+			if (!remaining)
+				return !func.suspend();
+
+			timeout_ms = remaining;
+		}
+	}
+	return true;
+}
+
+
+/**
+ * Receive a batch of datagrams by one read of the 'datagrams' file
+ *
+ * The read returns all datagrams available once the first one arrived,
+ * which corresponds to the semantics of 'MSG_WAITFORONE'. A datagram
+ * cannot be read without consuming it, so 'MSG_PEEK' is not supported.
+ *
+ * \param timeout_ms  maximum time to wait for the first datagram,
+ *                    0 for infinite wait
+ */
+static ssize_t do_recvmmsg_udp(Socket_fs::Context &context,
+                               mmsghdr *msgvec, unsigned vlen, int flags,
+                               unsigned long timeout_ms = 0)
+{
+	if (flags & MSG_PEEK) return Errno(EOPNOTSUPP);
+
+	bool const nonblocking = (flags & MSG_DONTWAIT)
+	                      || (context.fd_flags() & O_NONBLOCK);
+
+	try {
+		if (!wait_for_datagrams(context, nonblocking, timeout_ms))
+			return Errno(EAGAIN);
+	} catch (Socket_fs::Context::Inaccessible) {
+		return Errno(EINVAL);
+	}
+
+	size_t size = 0;
+	for (unsigned i = 0; i < vlen; i++)
+		size += Socket_datagram::record_size(iov_size(msgvec[i].msg_hdr));
+
+	Batch_buffer buffer(size);
+	if (!buffer.valid()) return Errno(ENOMEM);
+
+	ssize_t n = 0;
+	try {
+		lseek(context.datagrams_fd(), 0, 0);
+		n = read(context.datagrams_fd(), buffer.base, buffer.size);
+	} catch (Socket_fs::Context::Inaccessible) {
+		return Errno(EINVAL);
+	}
+	if (n <= 0) return n;
+
+	/* distribute the received records to the messages */
+	size_t   offset = 0;
+	unsigned count  = 0;
+	for (; count < vlen && offset + sizeof(Socket_datagram) <= (size_t)n; count++) {
+
+		Socket_datagram const &dg = *(Socket_datagram const *)(buffer.base + offset);
+		msghdr &msg = msgvec[count].msg_hdr;
+
+		size_t const len = Genode::min((size_t)dg.length,
+		                               n - offset - sizeof(Socket_datagram));
+		size_t const copied = scatter(msg, dg.payload(), len);
+
+		write_sockaddr_in(msg, dg);
+		msg.msg_controllen = 0;
+		msg.msg_flags      = (copied < dg.length || (dg.flags & Socket_datagram::TRUNCATED))
+		                   ? MSG_TRUNC : 0;
+
+		msgvec[count].msg_len = copied;
+
+		offset += Socket_datagram::record_size(dg.length);
+	}
+	return count;
+}
+
+
+/**
+ * Send a batch of datagrams by one write of the 'datagrams' file
+ */
+static ssize_t do_sendmmsg_udp(Socket_fs::Context &context,
+                               mmsghdr *msgvec, unsigned vlen)
+{
+	size_t size = 0;
+	for (unsigned i = 0; i < vlen; i++)
+		size += Socket_datagram::record_size(iov_size(msgvec[i].msg_hdr));
+
+	Batch_buffer buffer(size);
+	if (!buffer.valid()) return Errno(ENOMEM);
+
+	/* a record without address is sent to the connected peer */
+	size_t offset = 0;
+	for (unsigned i = 0; i < vlen; i++) {
+
+		Socket_datagram &dg = *(Socket_datagram *)(buffer.base + offset);
+		msghdr const &msg = msgvec[i].msg_hdr;
+
+		memset(&dg, 0, sizeof(dg));
+		if (msg.msg_name) {
+			if (msg.msg_namelen < sizeof(sockaddr_in)) return Errno(EINVAL);
+
+			sockaddr_in const &addr = *(sockaddr_in const *)msg.msg_name;
+			dg.port = ntohs(addr.sin_port);
+			memcpy(dg.addr, &addr.sin_addr.s_addr, sizeof(dg.addr));
+		}
+		dg.length = gather(msg, dg.payload());
+
+		offset += Socket_datagram::record_size(dg.length);
+	}
+
+	ssize_t n = 0;
+	try {
+		lseek(context.datagrams_fd(), 0, 0);
+		n = write(context.datagrams_fd(), buffer.base, offset);
+	} catch (Socket_fs::Context::Inaccessible) {
+		return Errno(EINVAL);
+	}
+	if (n == -1) return -1;
+	if (n == 0)  return Errno(ENETDOWN);
+
+	/* count the completely sent messages */
+	offset = 0;
+	unsigned count = 0;
+	for (; count < vlen; count++) {
+
+		Socket_datagram const &dg = *(Socket_datagram const *)(buffer.base + offset);
+		if (offset + sizeof(Socket_datagram) + dg.length > (size_t)n)
+			break;
+
+		msgvec[count].msg_len = dg.length;
+		offset += Socket_datagram::record_size(dg.length);
+	}
+	return count;
+}
+
+
+static ssize_t do_recvmsg(Libc::File_descriptor *fd, msghdr *msg, int flags)
+{
+	Socket_fs::Context *context = dynamic_cast<Socket_fs::Context *>(fd->context);
+	if (!context) return Errno(ENOTSOCK);
+	if (!msg)     return Errno(EFAULT);
+
+	if (context->proto() == Socket_fs::Context::Proto::UDP) {
+		mmsghdr mmsg { *msg, 0 };
+		ssize_t const res = do_recvmmsg_udp(*context, &mmsg, 1, flags);
+		if (res <= 0) return res;
+
+		*msg = mmsg.msg_hdr;
+		return mmsg.msg_len;
+	}
+
+	socklen_t * const namelen = msg->msg_name ? &msg->msg_namelen : nullptr;
+	msg->msg_controllen = 0;
+	msg->msg_flags      = 0;
+
+	/* receive into the only buffer directly */
+	if (msg->msg_iovlen == 1)
+		return do_recvfrom(fd, msg->msg_iov[0].iov_base, msg->msg_iov[0].iov_len,
+		                   flags, (sockaddr *)msg->msg_name, namelen);
+
+	Batch_buffer buffer(iov_size(*msg));
+	if (!buffer.valid()) return Errno(ENOMEM);
+
+	ssize_t const n = do_recvfrom(fd, buffer.base, buffer.size, flags,
+	                              (sockaddr *)msg->msg_name, namelen);
+	if (n <= 0) return n;
+
+	return scatter(*msg, buffer.base, n);
+}
+
+
+static ssize_t do_sendmsg(Libc::File_descriptor *fd, msghdr const *msg, int flags)
+{
+	Socket_fs::Context *context = dynamic_cast<Socket_fs::Context *>(fd->context);
+	if (!context) return Errno(ENOTSOCK);
+	if (!msg)     return Errno(EFAULT);
+
+	if (context->proto() == Socket_fs::Context::Proto::UDP) {
+		mmsghdr mmsg { *msg, 0 };
+		ssize_t const res = do_sendmmsg_udp(*context, &mmsg, 1);
+		if (res <= 0) return res;
+
+		return mmsg.msg_len;
+	}
+
+	/* send the only buffer directly */
+	if (msg->msg_iovlen == 1)
+		return do_sendto(fd, msg->msg_iov[0].iov_base, msg->msg_iov[0].iov_len,
+		                 flags, (sockaddr const *)msg->msg_name, msg->msg_namelen);
+
+	Batch_buffer buffer(iov_size(*msg));
+	if (!buffer.valid()) return Errno(ENOMEM);
+
+	gather(*msg, buffer.base);
+
+	return do_sendto(fd, buffer.base, buffer.size, flags,
+	                 (sockaddr const *)msg->msg_name, msg->msg_namelen);
+}
+
+
+extern "C" ssize_t socket_fs_recvmsg(int libc_fd, msghdr *msg, int flags)
+{
+	Libc::File_descriptor *fd = Libc::file_descriptor_allocator()->find_by_libc_fd(libc_fd);
+	if (!fd) return Errno(EBADF);
+
+	return do_recvmsg(fd, msg, flags);
+}
+
+
+extern "C" ssize_t socket_fs_sendmsg(int libc_fd, msghdr const *msg, int flags)
+{
+	Libc::File_descriptor *fd = Libc::file_descriptor_allocator()->find_by_libc_fd(libc_fd);
+	if (!fd) return Errno(EBADF);
+
+	return do_sendmsg(fd, msg, flags);
+}
+
+
+extern "C" ssize_t socket_fs_recvmmsg(int libc_fd, mmsghdr *msgvec, size_t vlen,
+                                      int flags, timespec const *timeout)
+{
+	Libc::File_descriptor *fd = Libc::file_descriptor_allocator()->find_by_libc_fd(libc_fd);
+	if (!fd) return Errno(EBADF);
+
+	Socket_fs::Context *context = dynamic_cast<Socket_fs::Context *>(fd->context);
+	if (!context) return Errno(ENOTSOCK);
+	if (!msgvec)  return Errno(EFAULT);
+	if (!vlen)    return 0;
+
+	vlen = Genode::min(vlen, (size_t)IOV_MAX);
+
+	if (context->proto() == Socket_fs::Context::Proto::UDP) {
+
+		if (!timeout)
+			return do_recvmmsg_udp(*context, msgvec, vlen, flags);
+
+		if (timeout->tv_sec < 0 || timeout->tv_nsec < 0 || timeout->tv_nsec >= 1000000000)
+			return Errno(EINVAL);
+
+		unsigned long const timeout_ms = timeout->tv_sec*1000
+		                               + (timeout->tv_nsec + 999999)/1000000;
+
+		/* a zero timeout polls for available datagrams */
+		return do_recvmmsg_udp(*context, msgvec, vlen,
+		                       timeout_ms ? flags : flags | MSG_DONTWAIT,
+		                       timeout_ms);
+	}
+
+	/* a stream is received as a whole into the first message */
+	ssize_t const n = do_recvmsg(fd, &msgvec[0].msg_hdr, flags);
+	if (n < 0) return n;
+
+	msgvec[0].msg_len = n;
+	return 1;
+}
+
+
+extern "C" ssize_t socket_fs_sendmmsg(int libc_fd, mmsghdr *msgvec, size_t vlen,
+                                      int flags)
+{
+	Libc::File_descriptor *fd = Libc::file_descriptor_allocator()->find_by_libc_fd(libc_fd);
+	if (!fd) return Errno(EBADF);
+
+	Socket_fs::Context *context = dynamic_cast<Socket_fs::Context *>(fd->context);
+	if (!context) return Errno(ENOTSOCK);
+	if (!msgvec)  return Errno(EFAULT);
+
+	vlen = Genode::min(vlen, (size_t)IOV_MAX);
+
+	if (context->proto() == Socket_fs::Context::Proto::UDP)
+		return do_sendmmsg_udp(*context, msgvec, vlen);
+
+	size_t count = 0;
+	for (; count < vlen; count++) {
+		ssize_t const n = do_sendmsg(fd, &msgvec[count].msg_hdr, flags);
+		if (n < 0) return count ? count : n;
+
+		msgvec[count].msg_len = n;
+	}
+	return count;
+}
+
+
 extern "C" int socket_fs_getsockopt(int libc_fd, int level, int optname,
                                     void *optval, socklen_t *optlen)
 {
@@ -946,6 +1364,19 @@ int Socket_fs::Plugin::select(int nfds,
 }
 
 
+Libc::File_descriptor *Libc::socket_fs_read_file(Libc::File_descriptor *fd)
+{
+	if (!fd || !dynamic_cast<Socket_fs::Plugin *>(fd->plugin))
+		return nullptr;
+
+	Socket_fs::Context *context = dynamic_cast<Socket_fs::Context *>(fd->context);
+	if (!context) return nullptr;
+
+	try { return context->read_file(); }
+	catch (Socket_fs::Context::Inaccessible) { return nullptr; }
+}
+
+
 int Socket_fs::Plugin::close(Libc::File_descriptor *fd)
 {
 	Socket_fs::Context *context = dynamic_cast<Socket_fs::Context *>(fd->context);
@@ -28,8 +28,11 @@ extern "C" int socket_fs_listen(int, int);
 extern "C" ssize_t socket_fs_recvfrom(int, void *, ::size_t, int, sockaddr *, socklen_t *);
 extern "C" ssize_t socket_fs_recv(int, void *, ::size_t, int);
 extern "C" ssize_t socket_fs_recvmsg(int, msghdr *, int);
+extern "C" ssize_t socket_fs_recvmmsg(int, mmsghdr *, ::size_t, int, timespec const *);
 extern "C" ssize_t socket_fs_sendto(int, void const *, ::size_t, int, sockaddr const *, socklen_t);
 extern "C" ssize_t socket_fs_send(int, void const *, ::size_t, int);
+extern "C" ssize_t socket_fs_sendmsg(int, msghdr const *, int);
+extern "C" ssize_t socket_fs_sendmmsg(int, mmsghdr *, ::size_t, int);
 extern "C" int socket_fs_getsockopt(int, int, int, void *, socklen_t *);
 extern "C" int socket_fs_setsockopt(int, int, int, void const *, socklen_t);
 extern "C" int socket_fs_shutdown(int, int);
@@ -171,6 +171,24 @@ extern "C" ssize_t recvmsg(int libc_fd, msghdr *msg, int flags)
 }
 
 
+extern "C" ssize_t recvmmsg(int libc_fd, mmsghdr *msgvec, ::size_t vlen, int flags,
+                            timespec const *timeout)
+{
+	if (*Libc::config_socket())
+		return socket_fs_recvmmsg(libc_fd, msgvec, vlen, flags, timeout);
+
+	/* receive one message per call of the plugin */
+	::size_t count = 0;
+	for (; count < vlen; count++) {
+		ssize_t const n = _recvmsg(libc_fd, &msgvec[count].msg_hdr, flags);
+		if (n < 0) return count ? count : n;
+
+		msgvec[count].msg_len = n;
+	}
+	return count;
+}
+
+
 extern "C" ssize_t _sendto(int libc_fd, void const *buf, ::size_t len, int flags,
                            sockaddr const *dest_addr, socklen_t dest_addrlen)
 {
@@ -197,6 +215,38 @@ extern "C" ssize_t send(int libc_fd, void const *buf, ::size_t len, int flags)
 }
 
 
+extern "C" ssize_t _sendmsg(int libc_fd, msghdr const *msg, int flags)
+{
+	if (*Libc::config_socket())
+		return socket_fs_sendmsg(libc_fd, msg, flags);
+
+	FD_FUNC_WRAPPER(sendmsg, libc_fd, msg, flags);
+}
+
+
+extern "C" ssize_t sendmsg(int libc_fd, msghdr const *msg, int flags)
+{
+	return _sendmsg(libc_fd, msg, flags);
+}
+
+
+extern "C" ssize_t sendmmsg(int libc_fd, mmsghdr *msgvec, ::size_t vlen, int flags)
+{
+	if (*Libc::config_socket())
+		return socket_fs_sendmmsg(libc_fd, msgvec, vlen, flags);
+
+	/* send one message per call of the plugin */
+	::size_t count = 0;
+	for (; count < vlen; count++) {
+		ssize_t const n = _sendmsg(libc_fd, &msgvec[count].msg_hdr, flags);
+		if (n < 0) return count ? count : n;
+
+		msgvec[count].msg_len = n;
+	}
+	return count;
+}
+
+
 extern "C" int _getsockopt(int libc_fd, int level, int optname,
                           void *optval, socklen_t *optlen)
 {
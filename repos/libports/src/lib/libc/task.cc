@@ -49,6 +49,8 @@ namespace Libc {
 	class Timeout_handler;
 	class Io_response_handler;
 
+	void kqueue_io_response(Vfs::Vfs_handle::Context *);
+
 	using Genode::Microseconds;
 }
 
@@ -388,8 +390,12 @@ extern void (*libc_select_notify)();
 
 struct Libc::Io_response_handler : Vfs::Io_response_handler
 {
-	void handle_io_response(Vfs::Vfs_handle::Context *) override
+	void handle_io_response(Vfs::Vfs_handle::Context *context) override
 	{
+		/* report readiness of the handle to the kqueue it is registered at */
+		if (context)
+			Libc::kqueue_io_response(context);
+
 		/* some contexts may have been deblocked from select() */
 		if (libc_select_notify)
 			libc_select_notify();
@@ -976,6 +982,7 @@ void Component::construct(Genode::Env &env)
 	kernel = unmanaged_singleton<Libc::Kernel>(env, heap);
 
 	Libc::libc_config_init(kernel->libc_env().libc_config());
+	Libc::init_malloc_config(env, kernel->libc_env().libc_config());
 
 	/*
 	 * XXX The following two steps leave us with the dilemma that we don't know
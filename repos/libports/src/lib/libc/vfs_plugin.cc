@@ -17,6 +17,8 @@
 #include <base/env.h>
 #include <base/log.h>
 #include <vfs/dir_file_system.h>
+#include <dataspace/client.h>
+#include <util/misc_math.h>
 
 /* libc includes */
 #include <errno.h>
@@ -154,6 +156,15 @@ namespace Libc {
 		return handle->fs().read_ready(handle);
 	}
 
+	Vfs::Vfs_handle *vfs_file_handle(Libc::File_descriptor *fd)
+	{
+		if (!fd || !dynamic_cast<Libc::Vfs_plugin *>(fd->plugin))
+			return nullptr;
+
+		return vfs_handle(fd);
+	}
+
+	void kqueue_handle_closed(Vfs::Vfs_handle *);
 }
 
 int Libc::Vfs_plugin::access(const char *path, int amode)
@@ -299,6 +310,7 @@ int Libc::Vfs_plugin::close(Libc::File_descriptor *fd)
 {
 	Vfs::Vfs_handle *handle = vfs_handle(fd);
 	_vfs_sync(handle);
+	Libc::kqueue_handle_closed(handle);
 	handle->close();
 	Libc::file_descriptor_allocator()->free(fd);
 	return 0;
@@ -1137,10 +1149,12 @@ void *Libc::Vfs_plugin::mmap(void *addr_in, ::size_t length, int prot, int flags
 		return (void *)-1;
 	}
 
-	/*
-	 * XXX attempt to obtain memory mapping via
-	 *     'Vfs::Directory_service::dataspace'.
-	 */
+	/* attach the file content in place if the VFS exposes it */
+	if (fd->fd_path && !(offset & ((1 << PAGE_SHIFT) - 1))) {
+		void *addr = _mmap_dataspace(fd->fd_path, length, offset);
+		if (addr)
+			return addr;
+	}
 
 	void *addr = Libc::mem_alloc()->alloc(length, PAGE_SHIFT);
 	if (addr == (void *)-1) {
@@ -1159,8 +1173,44 @@ void *Libc::Vfs_plugin::mmap(void *addr_in, ::size_t length, int prot, int flags
 }
 
 
+void *Libc::Vfs_plugin::_mmap_dataspace(char const *path, ::size_t length,
+                                        ::off_t offset)
+{
+	Genode::Dataspace_capability ds = _root_dir.dataspace(path);
+	if (!ds.valid())
+		return nullptr;
+
+	::size_t const size = Genode::align_addr(length, PAGE_SHIFT);
+
+	if ((::size_t)offset + size <= Genode::Dataspace_client(ds).size()) {
+		try {
+			void *addr = _rm.attach(ds, size, offset);
+			_mappings.insert(new (_alloc) Mapping(addr, ds, path));
+			return addr;
+		}
+		catch (Genode::Region_map::Region_conflict) { }
+		catch (Genode::Out_of_ram)                  { }
+		catch (Genode::Out_of_caps)                 { }
+	}
+
+	_root_dir.release(path, ds);
+	return nullptr;
+}
+
+
 int Libc::Vfs_plugin::munmap(void *addr, ::size_t)
 {
+	for (Mapping *m = _mappings.first(); m; m = m->next()) {
+		if (m->addr != addr)
+			continue;
+
+		_rm.detach(addr);
+		_root_dir.release(m->path.base(), m->ds);
+		_mappings.remove(m);
+		Genode::destroy(_alloc, m);
+		return 0;
+	}
+
 	Libc::mem_alloc()->free(addr);
 	return 0;
 }
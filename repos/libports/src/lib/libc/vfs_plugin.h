@@ -18,6 +18,7 @@
 
 /* Genode includes */
 #include <libc/component.h>
+#include <util/list.h>
 
 /* libc includes */
 #include <fcntl.h>
@@ -43,6 +44,26 @@ class Libc::Vfs_plugin : public Libc::Plugin
 
 		Vfs::File_system &_root_dir;
 
+		Genode::Region_map &_rm;
+
+		/**
+		 * File content attached directly via 'Vfs::Directory_service::dataspace'
+		 */
+		struct Mapping : Genode::List<Mapping>::Element
+		{
+			void                         * const addr;
+			Genode::Dataspace_capability   const ds;
+			Vfs::Absolute_path             const path;
+
+			Mapping(void *addr, Genode::Dataspace_capability ds,
+			        char const *path)
+			: addr(addr), ds(ds), path(path) { }
+		};
+
+		Genode::List<Mapping> _mappings { };
+
+		void *_mmap_dataspace(char const *path, ::size_t length, ::off_t offset);
+
 		void _open_stdio(Genode::Xml_node const &node, char const *attr,
 		                 int libc_fd, unsigned flags)
 		{
@@ -154,7 +175,7 @@ class Libc::Vfs_plugin : public Libc::Plugin
 
 		Vfs_plugin(Libc::Env &env, Genode::Allocator &alloc)
 		:
-			_alloc(alloc), _root_dir(env.vfs())
+			_alloc(alloc), _root_dir(env.vfs()), _rm(env.rm())
 		{
 			using Genode::Xml_node;
 
@@ -20,6 +20,7 @@ extern "C" {
 #include <lwip/sys.h>
 #include <lwip/stats.h>
 #include <lwip/snmp.h>
+#include <lwip/ip.h>
 #include <netif/etharp.h>
 #include <netif/ppp_oe.h>
 #include <nic.h>
@@ -49,23 +50,108 @@ class Nic_receiver_thread : public Genode::Thread_deprecated<8192>
 
 		typedef Nic::Packet_descriptor Packet_descriptor;
 
+		/*
+		 * Number of received packets that may be referenced by pbufs at a
+		 * time, the remaining part of the rx queue is kept available to the
+		 * nic server when lwIP holds on to received data for long, e.g., in
+		 * the receive buffers of sockets
+		 */
+		enum { MAX_RX_PBUFS = Nic::Session::QUEUE_SIZE / 2 };
+
+		/*
+		 * Pbuf that refers to the content of a packet in the rx bulk buffer
+		 *
+		 * The packet is acknowledged not before lwIP releases the pbuf.
+		 */
+		struct Rx_pbuf
+		{
+			struct pbuf_custom   custom; /* must be the first member */
+			Nic_receiver_thread *thread;
+			Packet_descriptor    packet;
+		};
+
 		Nic::Connection  *_nic;       /* nic-session */
 		Packet_descriptor _rx_packet; /* actual packet received */
 		struct netif     *_netif;     /* LwIP network interface structure */
 
+		/*
+		 * Pbufs are released by the tcpip thread or by the application
+		 * threads, which hand the packets over to the receiver thread for
+		 * the acknowledgement
+		 */
+		Genode::Lock      _rx_pbuf_lock;
+		Rx_pbuf           _rx_pbufs[MAX_RX_PBUFS];
+		Rx_pbuf          *_free_rx_pbufs[MAX_RX_PBUFS];
+		unsigned          _free_rx_pbuf_cnt;
+		Packet_descriptor _pending_acks[MAX_RX_PBUFS];
+		unsigned          _pending_ack_cnt;
+
 		Genode::Signal_receiver  _sig_rec;
 
 		Genode::Io_signal_dispatcher<Nic_receiver_thread> _link_state_dispatcher;
 		Genode::Io_signal_dispatcher<Nic_receiver_thread> _rx_packet_avail_dispatcher;
 		Genode::Io_signal_dispatcher<Nic_receiver_thread> _rx_ready_to_ack_dispatcher;
+		Genode::Io_signal_dispatcher<Nic_receiver_thread> _rx_pbuf_freed_dispatcher;
+
+		/*
+		 * Noncopyable
+		 */
+		Nic_receiver_thread(Nic_receiver_thread const &);
+		Nic_receiver_thread &operator = (Nic_receiver_thread const &);
+
+		static void _free_rx_pbuf(struct pbuf *p)
+		{
+			Rx_pbuf *rx_pbuf = reinterpret_cast<Rx_pbuf *>(p);
+			rx_pbuf->thread->_release_rx_pbuf(*rx_pbuf);
+		}
+
+		void _release_rx_pbuf(Rx_pbuf &rx_pbuf)
+		{
+			bool notify = false;
+			{
+				Genode::Lock::Guard guard(_rx_pbuf_lock);
+
+				notify = !_pending_ack_cnt;
+				_pending_acks[_pending_ack_cnt++]   = rx_pbuf.packet;
+				_free_rx_pbufs[_free_rx_pbuf_cnt++] = &rx_pbuf;
+			}
+
+			/* acknowledgements of the receiver thread are flushed anyway */
+			if (notify && Genode::Thread::myself() != this)
+				Genode::Signal_transmitter(_rx_pbuf_freed_dispatcher).submit();
+		}
+
+		/**
+		 * Acknowledge the packets of released pbufs as far as the ack
+		 * queue permits
+		 */
+		void _flush_acks()
+		{
+			Genode::Lock::Guard guard(_rx_pbuf_lock);
+
+			unsigned const cnt = Genode::min(_pending_ack_cnt,
+			                                 _nic->rx()->ack_slots_free());
+			if (!cnt)
+				return;
+
+			_nic->rx()->acknowledge_packets(_pending_acks, cnt);
+
+			for (unsigned i = cnt; i < _pending_ack_cnt; i++)
+				_pending_acks[i - cnt] = _pending_acks[i];
+
+			_pending_ack_cnt -= cnt;
+		}
 
 		void _handle_rx_packet_avail(unsigned)
 		{
+			_flush_acks();
+
 			while (_nic->rx()->packet_avail() && _nic->rx()->ready_to_ack()) {
 				_rx_packet = _nic->rx()->get_packet();
 				genode_netif_input(_netif);
-				_nic->rx()->acknowledge_packet(_rx_packet);
 			}
+
+			_flush_acks();
 		}
 
 		void _handle_rx_read_to_ack(unsigned) { _handle_rx_packet_avail(0); }
@@ -89,11 +175,18 @@ class Nic_receiver_thread : public Genode::Thread_deprecated<8192>
 
 		Nic_receiver_thread(Nic::Connection *nic, struct netif *netif)
 		:
-			Genode::Thread_deprecated<8192>("nic-recv"), _nic(nic), _netif(netif),
+			Genode::Thread_deprecated<8192>("nic-recv"), _nic(nic),
+			_rx_packet(), _netif(netif), _rx_pbuf_lock(), _rx_pbufs(),
+			_free_rx_pbufs(), _free_rx_pbuf_cnt(0), _pending_acks(),
+			_pending_ack_cnt(0), _sig_rec(),
 			_link_state_dispatcher(_sig_rec, *this, &Nic_receiver_thread::_handle_link_state),
 			_rx_packet_avail_dispatcher(_sig_rec, *this, &Nic_receiver_thread::_handle_rx_packet_avail),
-			_rx_ready_to_ack_dispatcher(_sig_rec, *this, &Nic_receiver_thread::_handle_rx_read_to_ack)
+			_rx_ready_to_ack_dispatcher(_sig_rec, *this, &Nic_receiver_thread::_handle_rx_read_to_ack),
+			_rx_pbuf_freed_dispatcher(_sig_rec, *this, &Nic_receiver_thread::_handle_rx_read_to_ack)
 		{
+			for (; _free_rx_pbuf_cnt < MAX_RX_PBUFS; _free_rx_pbuf_cnt++)
+				_free_rx_pbufs[_free_rx_pbuf_cnt] = &_rx_pbufs[_free_rx_pbuf_cnt];
+
 			_nic->link_state_sigh(_link_state_dispatcher);
 			_nic->rx_channel()->sigh_packet_avail(_rx_packet_avail_dispatcher);
 			_nic->rx_channel()->sigh_ready_to_ack(_rx_ready_to_ack_dispatcher);
@@ -103,6 +196,76 @@ class Nic_receiver_thread : public Genode::Thread_deprecated<8192>
 		Nic::Connection  *nic() { return _nic; };
 		Packet_descriptor rx_packet() { return _rx_packet; };
 
+		/**
+		 * Return whether the current rx packet is an unfragmented TCP
+		 * segment over IPv4
+		 *
+		 * lwIP refuses to grow the header of a pbuf that refers to
+		 * external memory. The TCP input path only ever hides headers,
+		 * whereas other paths, e.g., the ICMP port-unreachable reply to a
+		 * UDP datagram or the ICMP protocol-unreachable reply to an
+		 * unknown IP protocol, re-expose the IP header of the received
+		 * packet.
+		 */
+		bool _rx_packet_tcp_segment()
+		{
+			if (_rx_packet.size() < SIZEOF_ETH_HDR + IP_HLEN)
+				return false;
+
+			char const * const content = _nic->rx()->packet_content(_rx_packet);
+
+			struct eth_hdr const * const eth = (struct eth_hdr const *)content;
+			if (eth->type != PP_HTONS(ETHTYPE_IP))
+				return false;
+
+			struct ip_hdr const * const ip =
+				(struct ip_hdr const *)(content + SIZEOF_ETH_HDR);
+
+			return IPH_V(ip) == 4
+			    && IPH_PROTO(ip) == IP_PROTO_TCP
+			    && (IPH_OFFSET(ip) & PP_HTONS(IP_OFFMASK | IP_MF)) == 0;
+		}
+
+		/**
+		 * Return pbuf that refers to the content of the current rx packet
+		 *
+		 * Only TCP segments are referred to, all other packets are rare
+		 * enough to be copied into pbufs lwIP can freely adjust.
+		 *
+		 * \return  pbuf or 0 if the packet is no TCP segment or the limit
+		 *          of referenced packets is reached, in this case the
+		 *          caller copies the content and acknowledges the packet
+		 *          by calling 'ack_rx_packet'
+		 */
+		struct pbuf *rx_packet_pbuf()
+		{
+			if (ETH_PAD_SIZE || _rx_packet.size() > 0xffff)
+				return 0;
+
+			if (!_rx_packet_tcp_segment())
+				return 0;
+
+			Rx_pbuf *rx_pbuf = 0;
+			{
+				Genode::Lock::Guard guard(_rx_pbuf_lock);
+
+				if (!_free_rx_pbuf_cnt)
+					return 0;
+
+				rx_pbuf = _free_rx_pbufs[--_free_rx_pbuf_cnt];
+			}
+
+			rx_pbuf->thread                      = this;
+			rx_pbuf->packet                      = _rx_packet;
+			rx_pbuf->custom.custom_free_function = _free_rx_pbuf;
+
+			u16_t const len = _rx_packet.size();
+			return pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &rx_pbuf->custom,
+			                           _nic->rx()->packet_content(_rx_packet), len);
+		}
+
+		void ack_rx_packet() { _nic->rx()->acknowledge_packet(_rx_packet); }
+
 		Packet_descriptor alloc_tx_packet(Genode::size_t size)
 		{
 			while (true) {
@@ -184,6 +347,10 @@ extern "C" {
 	 * Should allocate a pbuf and transfer the bytes of the incoming
 	 * packet from the interface into the pbuf.
 	 *
+	 * Preferably, the pbuf refers to the packet in the rx bulk buffer
+	 * directly, which is acknowledged when the pbuf gets freed. Only if
+	 * too many packets are held by lwIP, the content is copied.
+	 *
 	 * @param netif the lwip network interface structure for this genode_netif
 	 * @return a pbuf filled with the received packet (including MAC header)
 	 *         NULL on memory error
@@ -194,6 +361,13 @@ extern "C" {
 		Nic_receiver_thread   *th         = reinterpret_cast<Nic_receiver_thread*>(netif->state);
 		Nic::Connection       *nic        = th->nic();
 		Nic::Packet_descriptor rx_packet  = th->rx_packet();
+
+		struct pbuf *p = th->rx_packet_pbuf();
+		if (p) {
+			LINK_STATS_INC(link.recv);
+			return p;
+		}
+
 		char                  *rx_content = nic->rx()->packet_content(rx_packet);
 		u16_t                  len        = rx_packet.size();
 
@@ -202,7 +376,7 @@ extern "C" {
 #endif
 
 		/* We allocate a pbuf chain of pbufs from the pool. */
-		struct pbuf *p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+		p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
 		if (p) {
 #if ETH_PAD_SIZE
 			pbuf_header(p, -ETH_PAD_SIZE); /* drop the padding word */
@@ -227,6 +401,7 @@ extern "C" {
 			LINK_STATS_INC(link.drop);
 		}
 
+		th->ack_rx_packet();
 		return p;
 	}
 
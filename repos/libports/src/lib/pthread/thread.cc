@@ -16,6 +16,7 @@
 #include <base/thread.h>
 #include <os/timed_semaphore.h>
 #include <util/list.h>
+#include <libc/malloc_stats.h>
 
 #include <errno.h>
 #include <pthread.h>
@@ -163,7 +164,23 @@ extern "C" {
 
 	void pthread_exit(void *value_ptr)
 	{
-		pthread_cancel(pthread_self());
+		/* cleanup threads which tried to self-destruct */
+		pthread_cleanup();
+
+		/* allocate beforehand, the thread must not use malloc afterwards */
+		thread_cleanup * const cleanup = new thread_cleanup(pthread_self());
+
+		/*
+		 * Return the thread's malloc cache before the thread is queued for
+		 * deletion. Otherwise, another thread could delete it while it holds
+		 * a lock of the allocator.
+		 */
+		Libc::malloc_thread_exit();
+
+		{
+			Lock_guard<Lock> lock_guard(pthread_cleanup_list_lock);
+			pthread_cleanup_list.insert(cleanup);
+		}
 
 		Lock lock;
 		while (true) lock.lock();
@@ -0,0 +1,239 @@
+/*
+ * \brief  Test kqueue() and kevent() in libc
+ * \author Genode Labs
+ * \date   2018-04-20
+ *
+ * The test writes to one end of a terminal crosslink and waits for read
+ * events of the other end. Afterwards, it echoes UDP datagrams received via
+ * a socket_fs socket.
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* libc includes */
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static void check(bool condition, char const *what)
+{
+	if (condition)
+		return;
+
+	printf("Error: %s (errno=%d)\n", what, errno);
+	exit(-1);
+}
+
+
+static timespec const poll_timeout { 0, 0 };
+static timespec const wait_timeout { 5, 0 };
+
+
+/**
+ * Apply one change to the kqueue
+ *
+ * \return  0 on success or the errno value of the failed change
+ */
+static int change(int kq, int fd, short filter, u_short flags)
+{
+	struct kevent ev;
+	EV_SET(&ev, fd, filter, flags, 0, 0, 0);
+
+	errno = 0;
+	return kevent(kq, &ev, 1, 0, 0, 0) == 0 ? 0 : errno;
+}
+
+
+/**
+ * Collect at most one event
+ *
+ * \return  number of events, the event is stored in 'ev'
+ */
+static int collect(int kq, struct kevent &ev, timespec const &timeout)
+{
+	memset(&ev, 0, sizeof(ev));
+	return kevent(kq, 0, 0, &ev, 1, &timeout);
+}
+
+
+static bool read_event(int kq, int fd, timespec const &timeout)
+{
+	struct kevent ev;
+	return collect(kq, ev, timeout) == 1
+	    && ev.ident == (uintptr_t)fd && ev.filter == EVFILT_READ;
+}
+
+
+static bool no_event(int kq)
+{
+	struct kevent ev;
+	return collect(kq, ev, poll_timeout) == 0;
+}
+
+
+static void drain(int fd, size_t count)
+{
+	char buf[16];
+	while (count) {
+		ssize_t const n = read(fd, buf, count < sizeof(buf) ? count : sizeof(buf));
+		check(n > 0, "read from terminal");
+		count -= n;
+	}
+}
+
+
+static void write_terminal(int fd, char const *msg)
+{
+	size_t const len = strlen(msg);
+	check(write(fd, msg, len) == (ssize_t)len, "write to terminal");
+}
+
+
+static void test_terminal(int tx, int rx)
+{
+	int kq = kqueue();
+	check(kq >= 0, "create kqueue");
+
+	/* level-triggered */
+	check(change(kq, rx, EVFILT_READ, EV_ADD) == 0, "register terminal");
+	check(no_event(kq), "no event without data");
+	write_terminal(tx, "a");
+	check(read_event(kq, rx, wait_timeout), "read event");
+	check(read_event(kq, rx, poll_timeout), "read event while data left");
+	drain(rx, 1);
+	check(no_event(kq), "no event after data was read");
+	check(change(kq, rx, EVFILT_READ, EV_DELETE) == 0, "delete registration");
+	check(change(kq, rx, EVFILT_READ, EV_DELETE) == ENOENT, "delete twice");
+	printf("level-triggered read events passed\n");
+
+	/* EV_ONESHOT removes the registration after the first event */
+	check(change(kq, rx, EVFILT_READ, EV_ADD | EV_ONESHOT) == 0, "register oneshot");
+	write_terminal(tx, "b");
+	check(read_event(kq, rx, wait_timeout), "oneshot event");
+	check(no_event(kq), "no second oneshot event");
+	check(change(kq, rx, EVFILT_READ, EV_DELETE) == ENOENT, "oneshot removed");
+	drain(rx, 1);
+	printf("EV_ONESHOT passed\n");
+
+	/* EV_DISPATCH disables the registration after the first event */
+	check(change(kq, rx, EVFILT_READ, EV_ADD | EV_DISPATCH) == 0, "register dispatch");
+	write_terminal(tx, "c");
+	check(read_event(kq, rx, wait_timeout), "dispatch event");
+	check(no_event(kq), "no event while disabled");
+	check(change(kq, rx, EVFILT_READ, EV_ENABLE) == 0, "enable dispatch");
+	check(read_event(kq, rx, poll_timeout), "event after enable");
+	drain(rx, 1);
+	check(change(kq, rx, EVFILT_READ, EV_DELETE) == 0, "delete dispatch");
+	printf("EV_DISPATCH passed\n");
+
+	/* EV_CLEAR reports new data only */
+	check(change(kq, rx, EVFILT_READ, EV_ADD | EV_CLEAR) == 0, "register clear");
+	write_terminal(tx, "d");
+	check(read_event(kq, rx, wait_timeout), "clear event");
+	check(no_event(kq), "no event for old data");
+	write_terminal(tx, "e");
+	check(read_event(kq, rx, wait_timeout), "clear event for new data");
+	drain(rx, 2);
+	check(change(kq, rx, EVFILT_READ, EV_DELETE) == 0, "delete clear");
+	printf("EV_CLEAR passed\n");
+
+	/* a handle can be registered at one kqueue only */
+	int kq2 = kqueue();
+	check(kq2 >= 0, "create second kqueue");
+	check(change(kq, rx, EVFILT_READ, EV_ADD) == 0, "register at first kqueue");
+	check(change(kq2, rx, EVFILT_READ, EV_ADD) == EBUSY, "register at second kqueue");
+
+	/* closing a kqueue releases its registrations */
+	check(close(kq) == 0, "close kqueue");
+	check(kevent(kq, 0, 0, 0, 0, 0) == -1 && errno == EBADF, "closed kqueue");
+	check(change(kq2, rx, EVFILT_READ, EV_ADD) == 0, "register after close");
+	write_terminal(tx, "f");
+	check(read_event(kq2, rx, wait_timeout), "event at second kqueue");
+	drain(rx, 1);
+	check(change(kq2, rx, EVFILT_READ, EV_DELETE) == 0, "delete at second kqueue");
+	printf("EBUSY and closing a kqueue passed\n");
+
+	/* closing a file descriptor removes its registration */
+	int fd = open("/dev/terminal_rx", O_RDONLY);
+	check(fd >= 0, "open terminal again");
+	check(change(kq2, fd, EVFILT_READ, EV_ADD) == 0, "register second handle");
+	check(close(fd) == 0, "close registered file descriptor");
+	check(change(kq2, fd, EVFILT_READ, EV_DELETE) == ENOENT, "registration removed");
+	check(change(kq2, fd, EVFILT_READ, EV_ADD) == EBADF, "register closed fd");
+	write_terminal(tx, "g");
+	check(no_event(kq2), "no event for closed file descriptor");
+	drain(rx, 1);
+
+	check(close(kq2) == 0, "close second kqueue");
+	printf("closing a registered file descriptor passed\n");
+}
+
+
+static void test_socket(unsigned port, unsigned count)
+{
+	int s = socket(AF_INET, SOCK_DGRAM, 0);
+	check(s >= 0, "create socket");
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family      = AF_INET;
+	addr.sin_port        = htons(port);
+	addr.sin_addr.s_addr = INADDR_ANY;
+	check(bind(s, (struct sockaddr *)&addr, sizeof(addr)) == 0, "bind socket");
+
+	int kq = kqueue();
+	check(kq >= 0, "create kqueue");
+	check(change(kq, s, EVFILT_READ, EV_ADD) == 0, "register socket");
+
+	/* echo datagrams once the socket is readable */
+	for (unsigned i = 0; i < count; i++) {
+
+		struct kevent ev;
+		timespec const timeout { 60, 0 };
+		check(collect(kq, ev, timeout) == 1 && ev.ident == (uintptr_t)s,
+		      "socket read event");
+
+		char buf[4096];
+		socklen_t addr_len = sizeof(addr);
+		ssize_t const n = recvfrom(s, buf, sizeof(buf), 0,
+		                           (struct sockaddr *)&addr, &addr_len);
+		check(n > 0, "receive datagram");
+		check(no_event(kq), "no event after datagram was received");
+		check(sendto(s, buf, n, 0, (struct sockaddr *)&addr, addr_len) == n,
+		      "send datagram");
+	}
+
+	/* the registration goes away with the socket */
+	check(close(s) == 0, "close registered socket");
+	check(change(kq, s, EVFILT_READ, EV_DELETE) == ENOENT, "socket registration removed");
+	check(close(kq) == 0, "close kqueue");
+	printf("socket read events passed\n");
+}
+
+
+int main(int, char **)
+{
+	int tx = open("/dev/terminal_tx", O_WRONLY);
+	int rx = open("/dev/terminal_rx", O_RDONLY);
+	check(tx >= 0 && rx >= 0, "open terminals");
+
+	test_terminal(tx, rx);
+	test_socket(1337, 5);
+
+	printf("--- test succeeded ---\n");
+	return 0;
+}
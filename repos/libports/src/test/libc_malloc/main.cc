@@ -0,0 +1,320 @@
+/*
+ * \brief  Test for the arena allocator of the libc malloc
+ * \author Genode Labs
+ * \date   2018-04-20
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <libc/malloc_stats.h>
+
+/* libc includes */
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static void check(bool condition, char const *what)
+{
+	if (condition)
+		return;
+
+	printf("check failed: %s\n", what);
+	exit(-1);
+}
+
+
+/* sizes of the linear and logarithmic size classes and medium blocks */
+static size_t const sizes[] = { 1, 24, 100, 256, 300, 1000, 4000, 16000, 60000 };
+
+enum { NUM_SIZES = sizeof(sizes)/sizeof(sizes[0]) };
+
+
+static void fill(void *ptr, size_t size, unsigned char pattern) {
+	memset(ptr, pattern, size); }
+
+
+static bool filled(void const *ptr, size_t size, unsigned char pattern)
+{
+	for (size_t i = 0; i < size; i++)
+		if (((unsigned char const *)ptr)[i] != pattern)
+			return false;
+	return true;
+}
+
+
+/**
+ * Allocate and free blocks of all sizes, checking their content
+ */
+static void *stress(void *arg)
+{
+	enum { ROUNDS = 2000, OBJECTS = 64 };
+
+	unsigned char const pattern = (unsigned char)(unsigned long)arg;
+
+	void   *objects[OBJECTS] { };
+	size_t  object_sizes[OBJECTS] { };
+
+	for (unsigned r = 0; r < ROUNDS; r++) {
+
+		unsigned const i = (r*7) % OBJECTS;
+
+		if (objects[i])
+			check(filled(objects[i], object_sizes[i], pattern), "block content");
+
+		free(objects[i]);
+
+		object_sizes[i] = sizes[r % NUM_SIZES];
+		objects[i]      = malloc(object_sizes[i]);
+		check(objects[i], "malloc");
+		fill(objects[i], object_sizes[i], pattern);
+	}
+
+	for (unsigned i = 0; i < OBJECTS; i++)
+		free(objects[i]);
+
+	return nullptr;
+}
+
+
+struct Worker
+{
+	pthread_t  thread;
+	sem_t      finished;
+	void     *(*fn)(void *);
+	void      *arg;
+};
+
+
+static void *worker_entry(void *arg)
+{
+	Worker &worker = *(Worker *)arg;
+	worker.fn(worker.arg);
+	sem_post(&worker.finished);
+	return nullptr;
+}
+
+
+/**
+ * Execute 'fn' concurrently in 'count' threads and wait for their completion
+ */
+static void run_threads(unsigned count, void *(*fn)(void *), void *arg = nullptr)
+{
+	enum { MAX_WORKERS = 16 };
+
+	static Worker workers[MAX_WORKERS];
+
+	/* the semaphores are reused as a finished thread may still post */
+	static bool initialized = false;
+	if (!initialized) {
+		for (unsigned i = 0; i < MAX_WORKERS; i++)
+			sem_init(&workers[i].finished, 0, 0);
+		initialized = true;
+	}
+
+	for (unsigned i = 0; i < count && i < MAX_WORKERS; i++) {
+		Worker &w = workers[i];
+		w.fn  = fn;
+		w.arg = arg ? arg : (void *)(unsigned long)(i + 1);
+		check(pthread_create(&w.thread, nullptr, worker_entry, &w) == 0,
+		      "pthread_create");
+	}
+
+	for (unsigned i = 0; i < count && i < MAX_WORKERS; i++)
+		sem_wait(&workers[i].finished);
+}
+
+
+/*
+ * Blocks allocated by one thread and freed by another
+ */
+
+enum { REMOTE_BLOCKS = 1000 };
+
+static void *remote_blocks[REMOTE_BLOCKS];
+
+
+static void *alloc_remote(void *)
+{
+	for (unsigned i = 0; i < REMOTE_BLOCKS; i++) {
+		remote_blocks[i] = malloc(sizes[i % NUM_SIZES]);
+		check(remote_blocks[i], "malloc of remote block");
+		fill(remote_blocks[i], sizes[i % NUM_SIZES], 0x5a);
+	}
+	return nullptr;
+}
+
+
+static void *free_remote(void *)
+{
+	for (unsigned i = 0; i < REMOTE_BLOCKS; i++) {
+		check(filled(remote_blocks[i], sizes[i % NUM_SIZES], 0x5a),
+		      "remote block content");
+		free(remote_blocks[i]);
+	}
+	return nullptr;
+}
+
+
+/**
+ * Leave objects in the cache of the calling thread
+ */
+static void *populate_cache(void *)
+{
+	enum { OBJECTS = 32 };
+
+	void *objects[OBJECTS];
+	for (unsigned i = 0; i < OBJECTS; i++)
+		objects[i] = malloc(64);
+
+	for (unsigned i = 0; i < OBJECTS; i++)
+		free(objects[i]);
+
+	return nullptr;
+}
+
+
+static void test_threads()
+{
+	printf("--- concurrent allocations ---\n");
+
+	run_threads(8, stress);
+
+	/* blocks migrate between threads */
+	run_threads(1, alloc_remote);
+	run_threads(1, free_remote);
+	run_threads(1, alloc_remote);
+	free_remote(nullptr);
+}
+
+
+static void test_thread_exit()
+{
+	printf("--- caches of exited threads ---\n");
+
+	/*
+	 * More threads than cache slots are started one after another, each
+	 * leaving objects in its cache. The caches must be released when the
+	 * threads exit.
+	 */
+	enum { THREADS = 256, MAX_CACHED = 32*1024 };
+
+	Libc::Malloc_stats const before = Libc::malloc_stats();
+
+	for (unsigned i = 0; i < THREADS; i++)
+		run_threads(1, populate_cache);
+
+	/* the last thread may not have exited yet */
+	Libc::Malloc_stats after = Libc::malloc_stats();
+	for (unsigned i = 0; i < 100 && after.cached > before.cached + MAX_CACHED; i++) {
+		usleep(10*1000);
+		after = Libc::malloc_stats();
+	}
+
+	printf("cached before: %zu after: %zu\n", before.cached, after.cached);
+	check(after.cached <= before.cached + MAX_CACHED, "released caches");
+}
+
+
+static void test_large()
+{
+	printf("--- large allocations ---\n");
+
+	enum { MB = 1024*1024 };
+
+	Libc::Malloc_stats const before = Libc::malloc_stats();
+
+	void *large = malloc(4*MB);
+	check(large, "large malloc");
+	fill(large, 4*MB, 0xa5);
+
+	Libc::Malloc_stats const during = Libc::malloc_stats();
+	check(during.large_count == before.large_count + 1, "large count");
+	check(during.large >= before.large + 4*MB, "large size");
+	check(during.held >= during.allocated, "held covers allocated");
+
+	free(large);
+
+	Libc::Malloc_stats const after = Libc::malloc_stats();
+	check(after.large_count == before.large_count, "large count after free");
+	check(after.large == before.large, "large size after free");
+}
+
+
+static void test_realloc()
+{
+	printf("--- realloc ---\n");
+
+	/* grow from a size class to a medium block to a dedicated dataspace */
+	size_t const steps[] = { 16, 200, 5000, 60000, 2*1024*1024 };
+
+	size_t  size = steps[0];
+	char   *ptr  = (char *)malloc(size);
+	check(ptr, "malloc");
+	fill(ptr, size, 0x11);
+
+	for (size_t new_size : steps) {
+		char *grown = (char *)realloc(ptr, new_size);
+		check(grown, "realloc");
+		check(filled(grown, size, 0x11), "content preserved by realloc");
+		fill(grown, new_size, 0x11);
+		ptr  = grown;
+		size = new_size;
+	}
+
+	/* shrinking keeps the block */
+	check(realloc(ptr, 10) == ptr, "shrinking realloc");
+	check(filled(ptr, 10, 0x11), "content after shrinking realloc");
+
+	free(ptr);
+}
+
+
+static void test_stats()
+{
+	printf("--- statistics ---\n");
+
+	Libc::Malloc_stats const before = Libc::malloc_stats();
+	check(before.held > 0, "arena in use");
+
+	enum { BLOCKS = 256, SIZE = 1000 };
+	static void *blocks[BLOCKS];
+
+	for (unsigned i = 0; i < BLOCKS; i++)
+		blocks[i] = malloc(SIZE);
+
+	Libc::Malloc_stats const during = Libc::malloc_stats();
+	check(during.allocated >= before.allocated + BLOCKS*SIZE, "allocated");
+	check(during.held >= during.allocated, "held");
+	check(during.fragmentation() <= 100, "fragmentation");
+
+	for (unsigned i = 0; i < BLOCKS; i++)
+		free(blocks[i]);
+
+	Libc::Malloc_stats const after = Libc::malloc_stats();
+	check(after.allocated < during.allocated, "allocated after free");
+}
+
+
+int main(int, char **)
+{
+	printf("--- libc malloc arena test ---\n");
+
+	test_stats();
+	test_large();
+	test_realloc();
+	test_threads();
+	test_thread_exit();
+
+	printf("--- libc malloc arena test finished ---\n");
+	return 0;
+}
@@ -64,9 +64,24 @@ void Libc::Component::construct(Libc::Env &env)
 		addr.sin_family = AF_INET;
 		addr.sin_addr.s_addr = inet_addr(serv_addr.string());
 
-		/* send test message */
 		enum { BUF_SZ = 1024 };
 		char buf[BUF_SZ];
+
+		/*
+		 * Send a message to a port the server does not listen to, which
+		 * lets the server's stack reply with an ICMP port unreachable
+		 * message, the server must keep working afterwards
+		 */
+		unsigned const closed_port =
+			config_node.attribute_value("closed_port", 0U);
+		if (closed_port) {
+			struct sockaddr_in closed_addr = addr;
+			closed_addr.sin_port = htons(closed_port);
+			::snprintf(buf, BUF_SZ, "closed port %u", closed_port);
+			sendto(s, buf, BUF_SZ, 0, (struct sockaddr*)&closed_addr,
+			       sizeof(closed_addr));
+		}
+		/* send test message */
 		::snprintf(buf, BUF_SZ, "UDP server at %s:%u", serv_addr.string(), port);
 		if (sendto(s, buf, BUF_SZ, 0, (struct sockaddr*)&addr, addr_sz) != BUF_SZ) {
 			continue;
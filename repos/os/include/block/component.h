@@ -20,18 +20,169 @@
 #include <base/allocator_avl.h>
 #include <base/heap.h>
 #include <root/component.h>
+#include <util/reconstructible.h>
 #include <block/driver.h>
 
 namespace Block {
 
 	using namespace Genode;
 
+	class Queue_component_base;
+	class Queue_component;
 	class Session_component_base;
 	class Session_component;
 	class Root;
 };
 
 
+/**
+ * Bulk buffer of an additional queue
+ *
+ * Analogously to 'Session_component_base', the buffer must outlive the
+ * packet stream of the queue.
+ */
+class Block::Queue_component_base
+{
+	protected:
+
+		Driver                  &_driver;
+		Ram_dataspace_capability _ds;
+
+		Queue_component_base(Driver &driver, size_t buf_size)
+		: _driver(driver), _ds(_driver.alloc_dma_buffer(buf_size)) { }
+
+		~Queue_component_base() { _driver.free_dma_buffer(_ds); }
+};
+
+
+/**
+ * Additional queue of a multi-queue session
+ *
+ * Each queue is served by an entrypoint of its own, which hands the
+ * requests to the 'process' method of the driver.
+ */
+class Block::Queue_component : Queue_component_base
+{
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		Queue_component(Queue_component const &);
+		Queue_component &operator = (Queue_component const &);
+
+		enum { STACK_SIZE = 4*1024*sizeof(long), BATCH = 32 };
+
+		typedef Packet_stream_tx::Rpc_object<Session::Tx> Tx_rpc_object;
+
+		Genode::Entrypoint                             _ep;
+		Constructible<Tx_rpc_object>                   _tx          { };
+		Constructible<Signal_handler<Queue_component>> _sink_ack    { };
+		Constructible<Signal_handler<Queue_component>> _sink_submit { };
+		bool const                                     _writeable;
+
+		/*
+		 * The packet stream and its signal handlers are dissolved by the
+		 * queue's entrypoint, see '~Queue_component'
+		 */
+		Lock                            _dissolved { Lock::LOCKED };
+		Signal_handler<Queue_component> _dissolve;
+
+		Packet_descriptor _batch[BATCH];
+
+		void _process(Packet_descriptor &packet)
+		{
+			packet.succeeded(false);
+
+			bool const write = packet.operation() == Packet_descriptor::WRITE;
+
+			/* ignore invalid packets */
+			if (!packet.size() || (write && !_writeable)
+			 || packet.block_number() + packet.block_count() > _driver.block_count()
+			 || packet.block_count() * _driver.block_size() > packet.size())
+				return;
+
+			char * const content = _tx->sink()->packet_content(packet);
+			if (!content)
+				return;
+
+			try {
+				_driver.process(packet.operation(), packet.block_number(),
+				                packet.block_count(), content);
+				packet.succeeded(true);
+			} catch (Driver::Io_error) { }
+		}
+
+		/**
+		 * Called whenever a signal from the packet-stream interface triggered
+		 */
+		void _signal()
+		{
+			Session::Tx::Sink &sink = *_tx->sink();
+
+			while (sink.packet_avail() && sink.ready_to_ack()) {
+
+				unsigned const max = min((unsigned)BATCH, sink.ack_slots_free());
+				unsigned const n   = sink.get_packets(_batch, max);
+
+				for (unsigned i = 0; i < n; i++)
+					_process(_batch[i]);
+
+				sink.acknowledge_packets(_batch, n);
+			}
+		}
+
+		void _handle_dissolve()
+		{
+			_sink_submit.destruct();
+			_sink_ack.destruct();
+			_tx.destruct();
+			_dissolved.unlock();
+		}
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param env       environment used for creating the entrypoint
+		 * \param driver    multi-queue capable driver
+		 * \param buf_size  size of packet-stream payload buffer
+		 */
+		Queue_component(Genode::Env &env, Driver &driver, size_t buf_size,
+		                bool writeable)
+		:
+			Queue_component_base(driver, buf_size),
+			_ep(env, STACK_SIZE, "block_queue"),
+			_writeable(writeable),
+			_dissolve(_ep, *this, &Queue_component::_handle_dissolve)
+		{
+			_tx.construct(_ds, env.rm(), _ep.rpc_ep());
+			_sink_ack.construct(_ep, *this, &Queue_component::_signal);
+			_sink_submit.construct(_ep, *this, &Queue_component::_signal);
+
+			_tx->sigh_ready_to_ack(*_sink_ack);
+			_tx->sigh_packet_avail(*_sink_submit);
+		}
+
+		/**
+		 * Destructor
+		 *
+		 * The queue's entrypoint may dispatch a signal or RPC of the queue
+		 * at any time. Hence, the packet stream and its signal handlers are
+		 * dissolved by this entrypoint, which cannot execute one of them at
+		 * the same time. The caller blocks until they are dissolved.
+		 */
+		~Queue_component()
+		{
+			Signal_transmitter(_dissolve).submit();
+			_dissolved.lock();
+		}
+
+		Capability<Session::Tx> cap() const { return _tx->cap(); }
+};
+
+
 /**
  * We have a hen and egg situation that makes this base class necessary.
  * The Block::Session_rpc_object construction depends on a dataspace for
@@ -78,6 +229,13 @@ class Block::Session_component : public Block::Session_component_base,
 		unsigned                          _p_in_fly;
 		bool                              _writeable;
 
+		/*
+		 * Additional queues of a multi-queue session, queue 0 is the
+		 * session's packet stream served by the session entrypoint
+		 */
+		Constructible<Queue_component>    _queues[Session::MAX_QUEUES - 1];
+		unsigned                          _num_queues = 1;
+
 		/**
 		 * Acknowledge a packet already handled
 		 */
@@ -200,7 +358,39 @@ class Block::Session_component : public Block::Session_component_base,
 			_driver.session(this);
 		}
 
-		~Session_component() { _driver.session(nullptr); }
+		/**
+		 * Constructor for a multi-queue session
+		 *
+		 * \param env     environment used for creating the entrypoints
+		 *                of the additional queues
+		 * \param queues  number of requested queues, it is limited to 1
+		 *                if the driver does not support multiple queues
+		 */
+		Session_component(Driver_factory &driver_factory,
+		                  Genode::Env    &env,
+		                  size_t          buf_size,
+		                  bool            writeable,
+		                  unsigned        queues)
+		: Session_component(driver_factory, env.ep(), env.rm(), buf_size,
+		                    writeable)
+		{
+			if (!_driver.multi_queue())
+				return;
+
+			queues = min(queues, (unsigned)Session::MAX_QUEUES);
+			for (; _num_queues < queues; _num_queues++)
+				_queues[_num_queues - 1].construct(env, _driver, buf_size,
+				                                   writeable);
+		}
+
+		~Session_component()
+		{
+			/* the queues are dissolved by the entrypoints serving them */
+			for (unsigned i = 1; i < _num_queues; i++)
+				_queues[i - 1].destruct();
+
+			_driver.session(nullptr);
+		}
 
 		/**
 		 * Acknowledges a packet processed by the driver to the client
@@ -255,6 +445,16 @@ class Block::Session_component : public Block::Session_component_base,
 		}
 
 		void sync() { _driver.sync(); }
+
+		unsigned queues() override { return _num_queues; }
+
+		Capability<Session::Tx> _queue_cap(unsigned idx) override
+		{
+			if (idx == 0)          return _tx.cap();
+			if (idx < _num_queues) return _queues[idx - 1]->cap();
+
+			return Capability<Session::Tx>();
+		}
 };
 
 
@@ -271,6 +471,9 @@ class Block::Root : public Genode::Root_component<Block::Session_component,
 		Genode::Region_map &_rm;
 		bool const          _writeable;
 
+		/* only defined if multi-queue sessions are supported */
+		Genode::Env        *_env = nullptr;
+
 	protected:
 
 		/**
@@ -282,6 +485,10 @@ class Block::Root : public Genode::Root_component<Block::Session_component,
 				Arg_string::find_arg(args, "ram_quota"  ).ulong_value(0);
 			size_t tx_buf_size =
 				Arg_string::find_arg(args, "tx_buf_size").ulong_value(0);
+			unsigned queues = _env
+				? Arg_string::find_arg(args, "queues").ulong_value(1) : 1;
+
+			queues = max(1U, min(queues, (unsigned)Session::MAX_QUEUES));
 
 			/* delete ram quota by the memory needed for the session */
 			size_t session_size = max((size_t)4096,
@@ -291,13 +498,13 @@ class Block::Root : public Genode::Root_component<Block::Session_component,
 				throw Insufficient_ram_quota();
 
 			/*
-			 * Check if donated ram quota suffices for both
+			 * Check if donated ram quota suffices for all
 			 * communication buffers. Also check both sizes separately
 			 * to handle a possible overflow of the sum of both sizes.
 			 */
-			if (tx_buf_size > ram_quota - session_size) {
+			if (tx_buf_size > (ram_quota - session_size) / queues) {
 				error("insufficient 'ram_quota', got ", ram_quota, ", need ",
-				     tx_buf_size + session_size);
+				     tx_buf_size*queues + session_size);
 				throw Insufficient_ram_quota();
 			}
 
@@ -305,6 +512,11 @@ class Block::Root : public Genode::Root_component<Block::Session_component,
 				? Arg_string::find_arg(args, "writeable").bool_value(true)
 				: false;
 
+			if (_env)
+				return new (md_alloc()) Session_component(_driver_factory,
+				                                          *_env, tx_buf_size,
+				                                          writeable, queues);
+
 			return new (md_alloc()) Session_component(_driver_factory,
 			                                          _ep, _rm, tx_buf_size,
 			                                          writeable);
@@ -329,6 +541,25 @@ class Block::Root : public Genode::Root_component<Block::Session_component,
 			Root_component(ep, md_alloc),
 			_driver_factory(driver_factory), _ep(ep), _rm(rm), _writeable(writeable)
 		{ }
+
+		/**
+		 * Constructor for a root component that supports multi-queue
+		 * sessions if provided by the driver
+		 *
+		 * \param env             environment used for creating the
+		 *                        entrypoints of additional queues
+		 * \param md_alloc        allocator to allocate session components
+		 * \param driver_factory  factory to create and destroy driver backend
+		 */
+		Root(Genode::Env    &env,
+		     Allocator      &md_alloc,
+		     Driver_factory &driver_factory,
+		     bool            writeable)
+		:
+			Root(env.ep(), md_alloc, env.rm(), driver_factory, writeable)
+		{
+			_env = &env;
+		}
 };
 
 #endif /* _INCLUDE__BLOCK__COMPONENT_H_ */
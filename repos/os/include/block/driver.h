@@ -199,6 +199,34 @@ class Block::Driver : Genode::Interface
 		                       Packet_descriptor & /* packet */) {
 			throw Io_error(); }
 
+		/**
+		 * Check if the driver is able to serve multiple queues
+		 *
+		 * A multi-queue capable driver implements 'process', which gets
+		 * called concurrently by the entrypoints of the additional queues
+		 * of a multi-queue session.
+		 */
+		virtual bool multi_queue() { return false; }
+
+		/**
+		 * Process request synchronously
+		 *
+		 * \param operation     requested operation
+		 * \param block_number  number of first block
+		 * \param block_count   number of blocks
+		 * \param buffer        payload of the request
+		 *
+		 * \throw Io_error
+		 *
+		 * Note: has to be overriden by multi-queue capable drivers and must
+		 *       be safe to be called concurrently with all other I/O methods
+		 */
+		virtual void process(Packet_descriptor::Opcode /* operation */,
+		                     sector_t                  /* block_number */,
+		                     Genode::size_t            /* block_count */,
+		                     char *                    /* buffer */) {
+			throw Io_error(); }
+
 		/**
 		 * Check if DMA is enabled for driver
 		 *
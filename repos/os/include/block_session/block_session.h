@@ -94,11 +94,24 @@ class Block::Packet_descriptor : public Genode::Packet_descriptor
  * class to enable the client-side use of the block interface via a pointer to
  * the abstract 'Session' class. This way, we can transparently co-locate the
  * packet-stream server with the client in same program.
+ *
+ * A client may ask for several independent queues by specifying the
+ * 'queues' session argument. Each queue is a packet stream of its own with a
+ * dedicated bulk buffer of 'tx_buf_size' bytes and dedicated data-flow
+ * signals. Queue 0 is the packet stream returned by 'tx_channel'. The
+ * server may grant fewer queues than requested. The queues operate
+ * independently from each other, in particular, the server gives no
+ * ordering guarantees between requests of different queues.
  */
 struct Block::Session : public Genode::Session
 {
 	enum { TX_QUEUE_SIZE = 256 };
 
+	/**
+	 * Maximum number of queues per session
+	 */
+	enum { MAX_QUEUES = 8 };
+
 
 	/**
 	 * This class represents supported operations on a block device
@@ -125,6 +138,14 @@ struct Block::Session : public Genode::Session
 	                                     TX_QUEUE_SIZE, TX_QUEUE_SIZE,
 	                                     char> Tx_policy;
 
+	/*
+	 * Policy for components that drive the packet stream from a single
+	 * thread only, see 'Genode::Lock_free_packet_stream_policy'
+	 */
+	typedef Genode::Lock_free_packet_stream_policy<Block::Packet_descriptor,
+	                                               TX_QUEUE_SIZE, TX_QUEUE_SIZE,
+	                                               char> Tx_lock_free_policy;
+
 	typedef Packet_stream_tx::Channel<Tx_policy> Tx;
 
 	/**
@@ -152,6 +173,11 @@ struct Block::Session : public Genode::Session
 	 */
 	virtual void sync() = 0;
 
+	/**
+	 * Return number of queues granted by the server
+	 */
+	virtual unsigned queues() = 0;
+
 	/**
 	 * Request packet-transmission channel
 	 */
@@ -171,7 +197,10 @@ struct Block::Session : public Genode::Session
 	           Genode::size_t *, Operations *);
 	GENODE_RPC(Rpc_tx_cap, Genode::Capability<Tx>, _tx_cap);
 	GENODE_RPC(Rpc_sync, void, sync);
-	GENODE_RPC_INTERFACE(Rpc_info, Rpc_tx_cap, Rpc_sync);
+	GENODE_RPC(Rpc_queues, unsigned, queues);
+	GENODE_RPC(Rpc_queue_cap, Genode::Capability<Tx>, _queue_cap, unsigned);
+	GENODE_RPC_INTERFACE(Rpc_info, Rpc_tx_cap, Rpc_sync, Rpc_queues,
+	                     Rpc_queue_cap);
 };
 
 #endif /* _INCLUDE__BLOCK_SESSION__BLOCK_SESSION_H_ */
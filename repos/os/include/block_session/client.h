@@ -18,17 +18,36 @@
 #include <block_session/capability.h>
 #include <packet_stream_tx/client.h>
 
-namespace Block { class Session_client; }
+namespace Block {
 
+	template <typename POLICY> class Session_client_tpl;
+	class Session_client;
 
-class Block::Session_client : public Genode::Rpc_client<Session>
+	/**
+	 * Client of an additional queue of a multi-queue session
+	 */
+	typedef Packet_stream_tx::Client<Session::Tx> Queue_client;
+}
+
+
+/**
+ * Client-side block session interface with a local packet-stream policy
+ *
+ * \param POLICY  packet-stream policy of the local tx source, e.g.,
+ *                'Session::Tx_lock_free_policy' for a client that drives
+ *                the stream from a single thread only
+ */
+template <typename POLICY>
+class Block::Session_client_tpl : public Genode::Rpc_client<Session>
 {
-	private:
+	protected:
 
-		Packet_stream_tx::Client<Tx> _tx;
+		Packet_stream_tx::Client<Tx, POLICY> _tx;
 
 	public:
 
+		typedef typename Packet_stream_tx::Channel<POLICY>::Source Tx_source;
+
 		/**
 		 * Constructor
 		 *
@@ -36,14 +55,16 @@ class Block::Session_client : public Genode::Rpc_client<Session>
 		 * \param tx_buffer_alloc  allocator used for managing the
 		 *                         transmission buffer
 		 */
-		Session_client(Session_capability       session,
-		               Genode::Range_allocator &tx_buffer_alloc,
-		               Genode::Region_map      &rm)
+		Session_client_tpl(Session_capability       session,
+		                   Genode::Range_allocator &tx_buffer_alloc,
+		                   Genode::Region_map      &rm)
 		:
 			Genode::Rpc_client<Session>(session),
 			_tx(call<Rpc_tx_cap>(), rm, tx_buffer_alloc)
 		{ }
 
+		Tx_source *tx_source() { return _tx.source(); }
+
 
 		/*****************************
 		 ** Block session interface **
@@ -55,17 +76,49 @@ class Block::Session_client : public Genode::Rpc_client<Session>
 			call<Rpc_info>(blk_count, blk_size, ops);
 		}
 
-		Tx *tx_channel() { return &_tx; }
-		Tx::Source *tx() { return _tx.source(); }
 		void sync() override { call<Rpc_sync>(); }
+		unsigned queues() override { return call<Rpc_queues>(); }
+
+		/**
+		 * Request packet-stream channel of queue 'idx'
+		 *
+		 * The returned capability is meant to be used with a
+		 * 'Block::Queue_client'. For queue 0, the channel is the one
+		 * already served by this session client via 'tx'.
+		 */
+		Genode::Capability<Tx> queue_cap(unsigned idx) {
+			return call<Rpc_queue_cap>(idx); }
 
 		/*
 		 * Wrapper for alloc_packet, allocates 2KB aligned packets
 		 */
 		Packet_descriptor dma_alloc_packet(Genode::size_t size)
 		{
-			return tx()->alloc_packet(size, 11);
+			return tx_source()->alloc_packet(size, 11);
 		}
 };
 
+
+class Block::Session_client : public Session_client_tpl<Session::Tx_policy>
+{
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param session          session capability
+		 * \param tx_buffer_alloc  allocator used for managing the
+		 *                         transmission buffer
+		 */
+		Session_client(Session_capability       session,
+		               Genode::Range_allocator &tx_buffer_alloc,
+		               Genode::Region_map      &rm)
+		:
+			Session_client_tpl<Session::Tx_policy>(session, tx_buffer_alloc, rm)
+		{ }
+
+		Tx *tx_channel() override { return &_tx; }
+		Tx::Source *tx() override { return _tx.source(); }
+};
+
 #endif /* _INCLUDE__BLOCK_SESSION__CLIENT_H_ */
@@ -18,9 +18,29 @@
 #include <base/connection.h>
 #include <base/allocator.h>
 
-namespace Block { struct Connection; }
+namespace Block {
 
-struct Block::Connection : Genode::Connection<Session>, Session_client
+	template <typename CLIENT> struct Connection_tpl;
+
+	typedef Connection_tpl<Session_client> Connection;
+
+	/**
+	 * Connection for a client that drives the packet stream from a single
+	 * thread only
+	 */
+	typedef Connection_tpl<Session_client_tpl<Session::Tx_lock_free_policy> >
+	        Lock_free_connection;
+}
+
+
+/**
+ * Connection to a block service
+ *
+ * \param CLIENT  session client, which determines the packet-stream policy
+ *                used at the client side
+ */
+template <typename CLIENT>
+struct Block::Connection_tpl : Genode::Connection<Session>, CLIENT
 {
 	/**
 	 * Issue session request
@@ -29,10 +49,18 @@ struct Block::Connection : Genode::Connection<Session>, Session_client
 	 */
 	Genode::Capability<Block::Session> _session(Genode::Parent &parent,
 	                                            char const *label,
-	                                            Genode::size_t tx_buf_size)
+	                                            Genode::size_t tx_buf_size,
+	                                            unsigned queues = 1)
 	{
-		return session(parent, "ram_quota=%ld, cap_quota=%ld, tx_buf_size=%ld, label=\"%s\"",
-		               14*1024 + tx_buf_size, CAP_QUOTA, tx_buf_size, label);
+		/*
+		 * Each additional queue consumes a bulk buffer, an entrypoint
+		 * at the server side, and its data-flow signal capabilities.
+		 */
+		queues = Genode::max(1U, Genode::min(queues, (unsigned)Session::MAX_QUEUES));
+		return session(parent, "ram_quota=%ld, cap_quota=%ld, tx_buf_size=%ld, "
+		                       "queues=%u, label=\"%s\"",
+		               (14*1024 + tx_buf_size)*queues,
+		               Session::CAP_QUOTA*queues, tx_buf_size, queues, label);
 	}
 
 	/**
@@ -42,13 +70,34 @@ struct Block::Connection : Genode::Connection<Session>, Session_client
 	 *                         transmission buffer
 	 * \param tx_buf_size      size of transmission buffer in bytes
 	 */
-	Connection(Genode::Env             &env,
-	           Genode::Range_allocator *tx_block_alloc,
-	           Genode::size_t           tx_buf_size = 128*1024,
-	           const char              *label = "")
+	Connection_tpl(Genode::Env             &env,
+	               Genode::Range_allocator *tx_block_alloc,
+	               Genode::size_t           tx_buf_size = 128*1024,
+	               const char              *label = "")
 	:
 		Genode::Connection<Session>(env, _session(env.parent(), label, tx_buf_size)),
-		Session_client(cap(), *tx_block_alloc, env.rm())
+		CLIENT(cap(), *tx_block_alloc, env.rm())
+	{ }
+
+	/**
+	 * Constructor for a multi-queue session
+	 *
+	 * \param tx_buffer_alloc  allocator used for managing the
+	 *                         transmission buffer of queue 0
+	 * \param tx_buf_size      size of transmission buffer of each queue
+	 * \param queues           number of requested queues
+	 *
+	 * The number of granted queues can be requested via 'queues()'.
+	 */
+	Connection_tpl(Genode::Env             &env,
+	               Genode::Range_allocator *tx_block_alloc,
+	               Genode::size_t           tx_buf_size,
+	               const char              *label,
+	               unsigned                 queues)
+	:
+		Genode::Connection<Session>(env, _session(env.parent(), label,
+		                                          tx_buf_size, queues)),
+		CLIENT(cap(), *tx_block_alloc, env.rm())
 	{ }
 
 	/**
@@ -58,12 +107,12 @@ struct Block::Connection : Genode::Connection<Session>, Session_client
 	 * \deprecated  Use the constructor with 'Env &' as first
 	 *              argument instead
 	 */
-	Connection(Genode::Range_allocator *tx_block_alloc,
-	           Genode::size_t           tx_buf_size = 128*1024,
-	           const char              *label = "") __attribute__((deprecated))
+	Connection_tpl(Genode::Range_allocator *tx_block_alloc,
+	               Genode::size_t           tx_buf_size = 128*1024,
+	               const char              *label = "") __attribute__((deprecated))
 	:
 		Genode::Connection<Session>(_session(*Genode::env_deprecated()->parent(), label, tx_buf_size)),
-		Session_client(cap(), *tx_block_alloc, *Genode::env_deprecated()->rm_session())
+		CLIENT(cap(), *tx_block_alloc, *Genode::env_deprecated()->rm_session())
 	{ }
 };
 
@@ -59,6 +59,21 @@ class Block::Session_rpc_object : public Genode::Rpc_object<Session, Session_rpc
 		 */
 		Genode::Capability<Tx> _tx_cap() { return _tx.cap(); }
 
+		/**
+		 * Return capability to packet-stream channel of queue 'idx'
+		 *
+		 * This method is called by the client via an RPC call at session
+		 * construction time. Servers that support multiple queues override
+		 * this method along with 'queues'.
+		 */
+		virtual Genode::Capability<Tx> _queue_cap(unsigned idx) {
+			return idx ? Genode::Capability<Tx>() : _tx.cap(); }
+
+		/**
+		 * Return number of queues, by default, only queue 0 is provided
+		 */
+		unsigned queues() override { return 1; }
+
 		Tx::Sink *tx_sink() { return _tx.sink(); }
 };
 
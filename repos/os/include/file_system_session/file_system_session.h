@@ -17,6 +17,7 @@
 #define _INCLUDE__FILE_SYSTEM_SESSION__FILE_SYSTEM_SESSION_H_
 
 #include <base/exception.h>
+#include <dataspace/capability.h>
 #include <os/packet_stream.h>
 #include <packet_stream_tx/packet_stream_tx.h>
 #include <session/session.h>
@@ -251,6 +252,10 @@ struct File_system::Control { /* to manipulate the executable bit */ };
 
 /**
  * Data structure returned when reading from a directory node
+ *
+ * A server may return multiple consecutive entries for one read request if
+ * the packet is large enough. The packet position is always the index of
+ * the first requested entry multiplied by 'sizeof(Directory_entry)'.
  */
 struct File_system::Directory_entry
 {
@@ -421,6 +426,23 @@ struct File_system::Session : public Genode::Session
 	virtual void move(Dir_handle, Name const &from,
 	                  Dir_handle, Name const &to) = 0;
 
+	/**
+	 * Request read-only dataspace exposing the content of a file
+	 *
+	 * File systems that keep the file content in memory may hand out their
+	 * backing store, which lets the client attach the content instead of
+	 * reading it via the packet stream. The dataspace stays valid as long
+	 * as the file handle is open. It does not reflect later modifications
+	 * of the file.
+	 *
+	 * \return invalid capability if the file system lacks support
+	 *
+	 * \throw Invalid_handle   file handle is invalid
+	 * \throw Unavailable      file vanished
+	 */
+	virtual Genode::Dataspace_capability dataspace(File_handle) {
+		return Genode::Dataspace_capability(); }
+
 
 	/*******************
 	 ** RPC interface **
@@ -472,12 +494,15 @@ struct File_system::Session : public Genode::Session
 	                 GENODE_TYPE_LIST(Invalid_handle, Invalid_name,
 	                                  Lookup_failed, Permission_denied, Unavailable),
 	                 Dir_handle, Name const &, Dir_handle, Name const &);
+	GENODE_RPC_THROW(Rpc_dataspace, Genode::Dataspace_capability, dataspace,
+	                 GENODE_TYPE_LIST(Invalid_handle, Unavailable),
+	                 File_handle);
 
 	GENODE_RPC_INTERFACE(Rpc_tx_cap,
 	                     Rpc_file, Rpc_symlink, Rpc_dir,
 	                     Rpc_node, Rpc_watch,
 	                     Rpc_close, Rpc_status, Rpc_control, Rpc_unlink,
-	                     Rpc_truncate, Rpc_move);
+	                     Rpc_truncate, Rpc_move, Rpc_dataspace);
 };
 
 #endif /* _INCLUDE__FILE_SYSTEM_SESSION__FILE_SYSTEM_SESSION_H_ */
@@ -16,10 +16,13 @@
 
 /* Genode includes */
 #include <net/ipv4.h>
+#include <net/port.h>
 #include <base/stdint.h>
 
 namespace Net {
 
+	class Internet_checksum_diff;
+
 	Genode::uint16_t internet_checksum(Genode::uint16_t const *addr,
 	                                   Genode::size_t          size,
 	                                   Genode::addr_t          init_sum = 0);
@@ -32,4 +35,45 @@ namespace Net {
 	                                             Ipv4_address           &ip_dst);
 }
 
+
+/**
+ * Accumulated modification of data that is covered by a checksum
+ *
+ * Instead of computing a checksum anew after some header fields were
+ * rewritten, the old checksum can be adapted to the modifications
+ * (RFC 1624). All values are handled in the byte order of the packet.
+ */
+class Net::Internet_checksum_diff
+{
+	private:
+
+		Genode::addr_t _value { 0 };
+
+	public:
+
+		/**
+		 * Account for a 16-bit word that changed from 'old_raw' to 'new_raw'
+		 */
+		void add_up_diff(Genode::uint16_t old_raw, Genode::uint16_t new_raw)
+		{
+			_value += (Genode::uint16_t)~old_raw;
+			_value += new_raw;
+		}
+
+		void add_up_diff(Ipv4_address const &old_ip, Ipv4_address const &new_ip);
+
+		void add_up_diff(Port old_port, Port new_port);
+
+		/**
+		 * Account for all modifications recorded by 'icd'
+		 */
+		void add_up_diff(Internet_checksum_diff const &icd) {
+			_value += icd._value; }
+
+		/**
+		 * Return checksum 'sum' adapted to the recorded modifications
+		 */
+		Genode::uint16_t apply_to(Genode::uint16_t sum) const;
+};
+
 #endif /* _NET__INTERNET_CHECKSUM_H_ */
@@ -31,6 +31,8 @@ namespace Net
 	class Ipv4_address;
 
 	class Ipv4_packet;
+
+	class Internet_checksum_diff;
 }
 
 
@@ -92,6 +94,8 @@ class Net::Ipv4_packet
 
 		void update_checksum();
 
+		void update_checksum(Internet_checksum_diff const &icd);
+
 		bool checksum_error() const;
 
 	private:
@@ -27,6 +27,7 @@ namespace Net
 {
 	class Tcp_state;
 	class Tcp_packet;
+	class Internet_checksum_diff;
 }
 
 /**
@@ -74,6 +75,8 @@ class Net::Tcp_packet
 		                     Ipv4_address ip_dst,
 		                     size_t       tcp_size);
 
+		void update_checksum(Internet_checksum_diff const &icd);
+
 
 		/***************
 		 ** Accessors **
@@ -100,6 +103,13 @@ class Net::Tcp_packet
 
 		void src_port(Port p) { _src_port = host_to_big_endian(p.value); }
 		void dst_port(Port p) { _dst_port = host_to_big_endian(p.value); }
+		void seq_nr(uint32_t v) { _seq_nr = host_to_big_endian(v); }
+
+		void flags(uint16_t v)
+		{
+			_flags_lsb = v & 0xff;
+			_flags_msb = (v >> 8) & 1;
+		}
 
 
 		/*********
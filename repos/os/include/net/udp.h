@@ -22,7 +22,11 @@
 #include <net/ethernet.h>
 #include <net/ipv4.h>
 
-namespace Net { class Udp_packet; }
+namespace Net
+{
+	class Udp_packet;
+	class Internet_checksum_diff;
+}
 
 
 /**
@@ -79,6 +83,8 @@ class Net::Udp_packet
 		void update_checksum(Ipv4_address ip_src,
 		                     Ipv4_address ip_dst);
 
+		void update_checksum(Internet_checksum_diff const &icd);
+
 		bool checksum_error(Ipv4_address ip_src,
 		                    Ipv4_address ip_dst) const;
 
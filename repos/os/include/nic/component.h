@@ -53,6 +53,7 @@ class Nic::Session_component : Communication_buffers, public Session_rpc_object
 
 		Genode::Entrypoint               &_ep;
 		Genode::Signal_context_capability _link_state_sigh { };
+		Offload                           _offload { };
 
 
 		/**
@@ -155,6 +156,19 @@ class Nic::Session_component : Communication_buffers, public Session_rpc_object
 		 * Return the MAC address of the device
 		 */
 		virtual Mac_address mac_address() = 0;
+
+		/**
+		 * Grant the requested offloads that the server supports
+		 *
+		 * \param args       session arguments
+		 * \param supported  offloads supported by the server
+		 */
+		void negotiate_offload(char const *args, Offload supported)
+		{
+			_offload = Offload::from_args(args).intersect(supported);
+		}
+
+		Offload offload() override { return _offload; }
 };
 
 
@@ -0,0 +1,177 @@
+/*
+ * \brief  Packet header and software fallbacks for NIC-session offloads
+ * \author Genode Labs
+ * \date   2018-03-31
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__NIC__OFFLOAD_H_
+#define _INCLUDE__NIC__OFFLOAD_H_
+
+/* Genode includes */
+#include <net/ethernet.h>
+#include <net/internet_checksum.h>
+#include <net/ipv4.h>
+#include <net/tcp.h>
+#include <util/string.h>
+
+namespace Nic {
+
+	struct Offload_header;
+
+	inline bool complete_checksum(void *frame, Genode::size_t size,
+	                              Offload_header &header);
+
+	template <typename FN>
+	inline bool for_each_segment(void const *frame, Genode::size_t size,
+	                             Offload_header const &header,
+	                             void *buf, Genode::size_t buf_size,
+	                             FN const &fn, unsigned first = 0);
+}
+
+
+/**
+ * Header that precedes each packet of a session with offloads
+ *
+ * The layout follows the virtio network header. All values are in host
+ * byte order. A header of zeros describes a plain Ethernet frame.
+ */
+struct Nic::Offload_header
+{
+	enum Flags    { NEEDS_CSUM = 1, CSUM_VALID = 2 };
+	enum Gso_type { GSO_NONE = 0, GSO_TCPV4 = 1 };
+
+	/*
+	 * With 'NEEDS_CSUM', the checksum field at 'csum_start + csum_offset'
+	 * holds the sum of the pseudo header and the checksum over the frame
+	 * from 'csum_start' on remains to be added.
+	 */
+	Genode::uint8_t  flags;
+	Genode::uint8_t  gso_type;
+	Genode::uint16_t hdr_len;     /* size of all headers of a segment */
+	Genode::uint16_t gso_size;    /* payload bytes per segment */
+	Genode::uint16_t csum_start;
+	Genode::uint16_t csum_offset;
+	Genode::uint16_t reserved;
+
+} __attribute__((packed));
+
+
+/**
+ * Complete a checksum left to the receiver of the frame
+ *
+ * \return  false if the header refers to data outside the frame
+ */
+bool Nic::complete_checksum(void *frame, Genode::size_t size,
+                            Offload_header &header)
+{
+	using namespace Genode;
+
+	if (!(header.flags & Offload_header::NEEDS_CSUM))
+		return true;
+
+	size_t const start = header.csum_start;
+	size_t const field = start + header.csum_offset;
+	if ((start & 1) || (field & 1) || field + sizeof(uint16_t) > size)
+		return false;
+
+	uint8_t *const base = (uint8_t *)frame;
+	*(uint16_t *)(base + field) =
+		Net::internet_checksum((uint16_t *)(base + start), size - start);
+
+	header.flags = (header.flags & ~Offload_header::NEEDS_CSUM)
+	             | Offload_header::CSUM_VALID;
+	return true;
+}
+
+
+/**
+ * Split a large TCP segment into segments of 'gso_size' payload bytes
+ *
+ * Each segment is assembled in 'buf' with complete IPv4 and TCP headers and
+ * checksums and passed to 'fn(void *segment, size_t segment_size)'.
+ *
+ * \param first  index of the first segment passed to 'fn', which permits
+ *               resuming an interrupted segmentation
+ *
+ * \return  false if the frame is malformed or a segment exceeds 'buf_size'
+ */
+template <typename FN>
+bool Nic::for_each_segment(void const *frame, Genode::size_t size,
+                           Offload_header const &header,
+                           void *buf, Genode::size_t buf_size,
+                           FN const &fn, unsigned first)
+{
+	using namespace Genode;
+	using namespace Net;
+
+	enum { FIN = 1 << 0, PSH = 1 << 3, CWR = 1 << 7 };
+
+	size_t const ip_off  = sizeof(Ethernet_frame);
+	size_t const hdr_len = header.hdr_len;
+	if (header.gso_type != Offload_header::GSO_TCPV4 || !header.gso_size ||
+	    hdr_len > size || hdr_len + header.gso_size > buf_size ||
+	    hdr_len < ip_off + sizeof(Ipv4_packet) + sizeof(Tcp_packet))
+	{
+		return false;
+	}
+
+	char const *const base = (char const *)frame;
+
+	Ipv4_packet const &ip = *(Ipv4_packet const *)(base + ip_off);
+	size_t const tcp_off = ip_off + ip.header_length() * 4;
+	if (ip.protocol() != Ipv4_packet::Protocol::TCP ||
+	    tcp_off + sizeof(Tcp_packet) > hdr_len)
+	{
+		return false;
+	}
+
+	Tcp_packet const &tcp = *(Tcp_packet const *)(base + tcp_off);
+	uint16_t const id    = ip.identification();
+	uint32_t const seq   = tcp.seq_nr();
+	uint16_t const flags = tcp.flags();
+
+	size_t const payload = size - hdr_len;
+	for (size_t off = 0, i = 0;; i++) {
+
+		size_t const seg_payload = min(payload - off, (size_t)header.gso_size);
+		bool   const last        = off + seg_payload == payload;
+
+		if (i < first) {
+			off += seg_payload;
+			if (last)
+				return true;
+			continue;
+		}
+
+		char *const seg = (char *)buf;
+		memcpy(seg, base, hdr_len);
+		memcpy(seg + hdr_len, base + hdr_len + off, seg_payload);
+
+		Ipv4_packet &seg_ip = *(Ipv4_packet *)(seg + ip_off);
+		seg_ip.total_length(hdr_len - ip_off + seg_payload);
+		seg_ip.identification(id + i);
+		seg_ip.update_checksum();
+
+		/* FIN and PSH belong to the last segment, CWR to the first one */
+		Tcp_packet &seg_tcp = *(Tcp_packet *)(seg + tcp_off);
+		seg_tcp.seq_nr(seq + off);
+		seg_tcp.flags(flags & ~(last ? 0 : FIN | PSH) & ~(i ? CWR : 0));
+		seg_tcp.update_checksum(seg_ip.src(), seg_ip.dst(),
+		                        hdr_len - tcp_off + seg_payload);
+
+		fn((void *)seg, hdr_len + seg_payload);
+
+		off += seg_payload;
+		if (last)
+			return true;
+	}
+}
+
+#endif /* _INCLUDE__NIC__OFFLOAD_H_ */
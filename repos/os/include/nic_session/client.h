@@ -19,33 +19,51 @@
 #include <packet_stream_tx/client.h>
 #include <packet_stream_rx/client.h>
 
-namespace Nic { class Session_client; }
+namespace Nic {
 
+	template <typename POLICY> class Session_client_tpl;
+	class Session_client;
+}
 
-class Nic::Session_client : public Genode::Rpc_client<Session>
+
+/**
+ * Client-side NIC session interface with a local packet-stream policy
+ *
+ * \param POLICY  packet-stream policy of the local tx source and rx sink,
+ *                e.g., 'Session::Lock_free_policy' for a client that drives
+ *                both streams from a single thread only
+ */
+template <typename POLICY>
+class Nic::Session_client_tpl : public Genode::Rpc_client<Session>
 {
-	private:
+	protected:
 
-		Packet_stream_tx::Client<Tx> _tx;
-		Packet_stream_rx::Client<Rx> _rx;
+		Packet_stream_tx::Client<Tx, POLICY> _tx;
+		Packet_stream_rx::Client<Rx, POLICY> _rx;
 
 	public:
 
+		typedef typename Packet_stream_tx::Channel<POLICY>::Source Tx_source;
+		typedef typename Packet_stream_rx::Channel<POLICY>::Sink   Rx_sink;
+
 		/**
 		 * Constructor
 		 *
 		 * \param tx_buffer_alloc  allocator used for managing the
 		 *                         transmission buffer
 		 */
-		Session_client(Session_capability       session,
-		               Genode::Range_allocator &tx_buffer_alloc,
-		               Genode::Region_map      &rm)
+		Session_client_tpl(Session_capability       session,
+		                   Genode::Range_allocator &tx_buffer_alloc,
+		                   Genode::Region_map      &rm)
 		:
 			Genode::Rpc_client<Session>(session),
 			_tx(call<Rpc_tx_cap>(), rm, tx_buffer_alloc),
-			_rx(call<Rpc_rx_cap>(),rm )
+			_rx(call<Rpc_rx_cap>(), rm)
 		{ }
 
+		Tx_source *tx_source() { return _tx.source(); }
+		Rx_sink   *rx_sink()   { return _rx.sink(); }
+
 
 		/***************************
 		 ** NIC session interface **
@@ -53,17 +71,38 @@ class Nic::Session_client : public Genode::Rpc_client<Session>
 
 		Mac_address mac_address() override { return call<Rpc_mac_address>(); }
 
-		Tx *tx_channel() { return &_tx; }
-		Rx *rx_channel() { return &_rx; }
-		Tx::Source *tx() { return _tx.source(); }
-		Rx::Sink   *rx() { return _rx.sink(); }
-
 		void link_state_sigh(Genode::Signal_context_capability sigh) override
 		{
 			call<Rpc_link_state_sigh>(sigh);
 		}
 
 		bool link_state() override { return call<Rpc_link_state>(); }
+
+		Offload offload() override { return call<Rpc_offload>(); }
+};
+
+
+class Nic::Session_client : public Session_client_tpl<Session::Policy>
+{
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param tx_buffer_alloc  allocator used for managing the
+		 *                         transmission buffer
+		 */
+		Session_client(Session_capability       session,
+		               Genode::Range_allocator &tx_buffer_alloc,
+		               Genode::Region_map      &rm)
+		:
+			Session_client_tpl<Session::Policy>(session, tx_buffer_alloc, rm)
+		{ }
+
+		Tx *tx_channel() override { return &_tx; }
+		Rx *rx_channel() override { return &_rx; }
+		Tx::Source *tx() override { return _tx.source(); }
+		Rx::Sink   *rx() override { return _rx.sink(); }
 };
 
 #endif /* _INCLUDE__NIC_SESSION__CLIENT_H_ */
@@ -18,10 +18,29 @@
 #include <base/connection.h>
 #include <base/allocator.h>
 
-namespace Nic { struct Connection; }
+namespace Nic {
 
+	template <typename CLIENT> struct Connection_tpl;
 
-struct Nic::Connection : Genode::Connection<Session>, Session_client
+	typedef Connection_tpl<Session_client> Connection;
+
+	/**
+	 * Connection for a client that drives both packet streams from a
+	 * single thread only
+	 */
+	typedef Connection_tpl<Session_client_tpl<Session::Lock_free_policy> >
+	        Lock_free_connection;
+}
+
+
+/**
+ * Connection to a NIC service
+ *
+ * \param CLIENT  session client, which determines the packet-stream policy
+ *                used at the client side
+ */
+template <typename CLIENT>
+struct Nic::Connection_tpl : Genode::Connection<Session>, CLIENT
 {
 	/**
 	 * Issue session request
@@ -31,12 +50,13 @@ struct Nic::Connection : Genode::Connection<Session>, Session_client
 	Genode::Capability<Nic::Session> _session(Genode::Parent &parent,
 	                                          char const *label,
 	                                          Genode::size_t tx_buf_size,
-	                                          Genode::size_t rx_buf_size)
+	                                          Genode::size_t rx_buf_size,
+	                                          Offload offload = Offload())
 	{
 		return session(parent,
-		               "ram_quota=%ld, cap_quota=%ld, tx_buf_size=%ld, rx_buf_size=%ld, label=\"%s\"",
+		               "ram_quota=%ld, cap_quota=%ld, tx_buf_size=%ld, rx_buf_size=%ld, offload=%u, label=\"%s\"",
 		               32*1024*sizeof(long) + tx_buf_size + rx_buf_size,
-		               CAP_QUOTA, tx_buf_size, rx_buf_size, label);
+		               Session::CAP_QUOTA, tx_buf_size, rx_buf_size, offload.value, label);
 	}
 
 	/**
@@ -46,16 +66,20 @@ struct Nic::Connection : Genode::Connection<Session>, Session_client
 	 *                         transmission buffer
 	 * \param tx_buf_size      size of transmission buffer in bytes
 	 * \param rx_buf_size      size of reception buffer in bytes
+	 * \param offload          offloads to request, the granted ones are
+	 *                         returned by 'offload()'
 	 */
-	Connection(Genode::Env             &env,
-	           Genode::Range_allocator *tx_block_alloc,
-	           Genode::size_t           tx_buf_size,
-	           Genode::size_t           rx_buf_size,
-	           char const              *label = "")
+	Connection_tpl(Genode::Env             &env,
+	               Genode::Range_allocator *tx_block_alloc,
+	               Genode::size_t           tx_buf_size,
+	               Genode::size_t           rx_buf_size,
+	               char const              *label   = "",
+	               Offload                  offload = Offload())
 	:
 		Genode::Connection<Session>(env, _session(env.parent(), label,
-		                                          tx_buf_size, rx_buf_size)),
-		Session_client(cap(), *tx_block_alloc, env.rm())
+		                                          tx_buf_size, rx_buf_size,
+		                                          offload)),
+		CLIENT(cap(), *tx_block_alloc, env.rm())
 	{ }
 
 	/**
@@ -65,14 +89,14 @@ struct Nic::Connection : Genode::Connection<Session>, Session_client
 	 * \deprecated  Use the constructor with 'Env &' as first
 	 *              argument instead
 	 */
-	Connection(Genode::Range_allocator *tx_block_alloc,
-	           Genode::size_t           tx_buf_size,
-	           Genode::size_t           rx_buf_size,
-	           char const              *label = "") __attribute__((deprecated))
+	Connection_tpl(Genode::Range_allocator *tx_block_alloc,
+	               Genode::size_t           tx_buf_size,
+	               Genode::size_t           rx_buf_size,
+	               char const              *label = "") __attribute__((deprecated))
 	:
 		Genode::Connection<Session>(_session(*Genode::env_deprecated()->parent(), label,
 		                                     tx_buf_size, rx_buf_size)),
-		Session_client(cap(), *tx_block_alloc, *Genode::env_deprecated()->rm_session())
+		CLIENT(cap(), *tx_block_alloc, *Genode::env_deprecated()->rm_session())
 	{ }
 };
 
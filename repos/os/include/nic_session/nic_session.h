@@ -18,6 +18,7 @@
 #include <base/signal.h>
 #include <base/rpc.h>
 #include <session/session.h>
+#include <util/arg_string.h>
 #include <packet_stream_tx/packet_stream_tx.h>
 #include <packet_stream_rx/packet_stream_rx.h>
 #include <net/mac_address.h>
@@ -26,6 +27,7 @@ namespace Nic {
 
 	using Mac_address = Net::Mac_address;
 
+	struct Offload;
 	struct Session;
 
 	using Genode::Packet_stream_sink;
@@ -35,6 +37,46 @@ namespace Nic {
 }
 
 
+/**
+ * Optional packet-processing offloads of a NIC session
+ *
+ * The client requests offloads via the 'offload' session argument. The
+ * server grants the subset that it supports and the client obtains the
+ * granted offloads via 'Session::offload'. If any offload is granted,
+ * each packet in either direction starts with a 'Nic::Offload_header'
+ * as defined in 'nic/offload.h'.
+ */
+struct Nic::Offload
+{
+	enum {
+		TX_CSUM     = 1 << 0, /* client may leave checksums to the server */
+		TX_GSO_TCP  = 1 << 1, /* client may submit large TCP segments */
+		RX_COALESCE = 1 << 2, /* server may deliver large TCP segments and
+		                         leave checksums to the client */
+	};
+
+	unsigned value;
+
+	Offload(unsigned value = 0) : value(value) { }
+
+	bool enabled()             const { return value != 0; }
+	bool has(unsigned offload) const { return (value & offload) == offload; }
+
+	/**
+	 * Return the subset of the offloads that is part of 'other'
+	 */
+	Offload intersect(Offload other) const { return Offload(value & other.value); }
+
+	/**
+	 * Return offloads requested by the session arguments 'args'
+	 */
+	static Offload from_args(char const *args)
+	{
+		return Offload(Genode::Arg_string::find_arg(args, "offload").ulong_value(0));
+	}
+};
+
+
 /*
  * NIC session interface
  *
@@ -63,6 +105,14 @@ struct Nic::Session : Genode::Session
 	typedef Genode::Packet_stream_policy<Genode::Packet_descriptor,
 	                                     QUEUE_SIZE, QUEUE_SIZE, char> Policy;
 
+	/*
+	 * Policy for components that drive a packet stream from a single
+	 * thread only, see 'Genode::Lock_free_packet_stream_policy'
+	 */
+	typedef Genode::Lock_free_packet_stream_policy<Genode::Packet_descriptor,
+	                                               QUEUE_SIZE, QUEUE_SIZE,
+	                                               char> Lock_free_policy;
+
 	typedef Packet_stream_tx::Channel<Policy> Tx;
 	typedef Packet_stream_rx::Channel<Policy> Rx;
 
@@ -116,6 +166,11 @@ struct Nic::Session : Genode::Session
 	 */
 	virtual void link_state_sigh(Genode::Signal_context_capability sigh) = 0;
 
+	/**
+	 * Request offloads granted to the session
+	 */
+	virtual Offload offload() { return Offload(); }
+
 	/*******************
 	 ** RPC interface **
 	 *******************/
@@ -126,9 +181,11 @@ struct Nic::Session : Genode::Session
 	GENODE_RPC(Rpc_link_state, bool, link_state);
 	GENODE_RPC(Rpc_link_state_sigh, void, link_state_sigh,
 	           Genode::Signal_context_capability);
+	GENODE_RPC(Rpc_offload, Offload, offload);
 
 	GENODE_RPC_INTERFACE(Rpc_mac_address, Rpc_link_state,
-	                     Rpc_link_state_sigh, Rpc_tx_cap, Rpc_rx_cap);
+	                     Rpc_link_state_sigh, Rpc_tx_cap, Rpc_rx_cap,
+	                     Rpc_offload);
 };
 
 #endif /* _INCLUDE__NIC_SESSION__NIC_SESSION_H_ */
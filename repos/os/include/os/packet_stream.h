@@ -61,6 +61,19 @@
  * acknowledge buffers using the methods 'packet_avail',
  * 'ready_to_submit', 'ready_to_ack', and 'ack_avail'.
  *
+ * For high packet rates, the source and the sink can move several packets
+ * at once using 'submit_packets', 'get_packets', 'acknowledge_packets', and
+ * 'get_acked_packets'. Each of these batched operations delivers at most one
+ * data-flow signal per batch.
+ *
+ * By default, each side of the stream serializes the access to its
+ * packet-descriptor queues by a lock, which enables the use of the same
+ * side by multiple threads. Components that drive each side of a stream from
+ * a single thread only may use the 'Lock_free_packet_stream_policy' instead,
+ * which accesses the queues without taking a lock. Because both policies
+ * share the same layout of the communication buffer, the choice is local to
+ * each side of the stream.
+ *
  * If bidirectional data exchange between two processes is desired, two pairs
  * of 'Packet_stream_source' and 'Packet_stream_sink' should be instantiated.
  */
@@ -78,6 +91,8 @@
 /* Genode includes */
 #include <base/env.h>
 #include <base/signal.h>
+#include <base/lock_guard.h>
+#include <cpu/memory_barrier.h>
 #include <dataspace/client.h>
 #include <util/string.h>
 #include <util/construct_at.h>
@@ -87,6 +102,7 @@ namespace Genode {
 	class Packet_descriptor;
 
 	template <typename, int> class Packet_descriptor_queue;
+	template <typename, int> class Lock_free_packet_descriptor_queue;
 	template <typename>      class Packet_descriptor_transmitter;
 	template <typename>      class Packet_descriptor_receiver;
 
@@ -95,6 +111,9 @@ namespace Genode {
 	template <typename, unsigned, unsigned, typename>
 	struct Packet_stream_policy;
 
+	template <typename, unsigned, unsigned, typename>
+	struct Lock_free_packet_stream_policy;
+
 	/**
 	 * Default configuration for packet-descriptor queues
 	 */
@@ -171,6 +190,12 @@ class Genode::Packet_descriptor_queue
 
 		typedef PACKET_DESCRIPTOR Packet_descriptor;
 
+		/**
+		 * Lock used by the transmitter and receiver to serialize the
+		 * queue accesses of concurrent threads on the same side
+		 */
+		typedef Genode::Lock Access_lock;
+
 		enum Role { PRODUCER, CONSUMER };
 
 		/**
@@ -255,6 +280,150 @@ class Genode::Packet_descriptor_queue
 };
 
 
+/**
+ * Lock-free single-producer/single-consumer variant of the ring buffer
+ *
+ * The queue has the same layout as 'Packet_descriptor_queue' and can thereby
+ * be combined with a 'Packet_descriptor_queue' at the other side of the
+ * stream. In contrast to the latter, it does not need to be protected by a
+ * lock. The producer solely modifies the head index and the consumer solely
+ * modifies the tail index. The memory barriers make sure that a descriptor is
+ * completely written before the producer publishes the new head and that it
+ * is completely read before the consumer hands the slot back to the producer.
+ *
+ * The queue must be used by no more than one thread at each side.
+ *
+ * This class is private to the packet-stream interface.
+ */
+template <typename PACKET_DESCRIPTOR, int QUEUE_SIZE>
+class Genode::Lock_free_packet_descriptor_queue
+{
+	private:
+
+		/*
+		 * The anonymous struct is needed to skip the initialization of the
+		 * members, which are shared by both sides of the packet stream.
+		 */
+		struct
+		{
+			unsigned volatile _head;
+			unsigned volatile _tail;
+			PACKET_DESCRIPTOR _queue[QUEUE_SIZE];
+		};
+
+		static unsigned _next(unsigned idx) { return (idx + 1)%QUEUE_SIZE; }
+
+	public:
+
+		typedef PACKET_DESCRIPTOR Packet_descriptor;
+
+		/**
+		 * Dummy lock because the queue is accessed by one thread per side
+		 */
+		struct Access_lock
+		{
+			void lock()   { }
+			void unlock() { }
+		};
+
+		enum Role { PRODUCER, CONSUMER };
+
+		/**
+		 * Constructor
+		 *
+		 * \see Packet_descriptor_queue
+		 */
+		Lock_free_packet_descriptor_queue(Role role)
+		{
+			if (role == PRODUCER) {
+				Genode::memset(_queue, 0, sizeof(_queue));
+				Genode::memory_barrier();
+				_head = 0;
+			} else
+				_tail = 0;
+		}
+
+		/**
+		 * Place packet descriptor into queue
+		 *
+		 * \return true on success, or
+		 *         false if queue is full
+		 */
+		bool add(PACKET_DESCRIPTOR packet)
+		{
+			unsigned const head = _head%QUEUE_SIZE;
+
+			if (_next(head) == _tail) return false;
+
+			_queue[head] = packet;
+
+			/* publish the descriptor not before it is completely written */
+			Genode::memory_barrier();
+			_head = _next(head);
+			return true;
+		}
+
+		/**
+		 * Take packet descriptor from queue
+		 *
+		 * \return  packet descriptor
+		 */
+		PACKET_DESCRIPTOR get()
+		{
+			unsigned const tail = _tail%QUEUE_SIZE;
+
+			/* read the descriptor not before the head was observed */
+			Genode::memory_barrier();
+			PACKET_DESCRIPTOR packet = _queue[tail];
+
+			/* release the slot not before the descriptor is completely read */
+			Genode::memory_barrier();
+			_tail = _next(tail);
+			return packet;
+		}
+
+		/**
+		 * Return current packet descriptor
+		 */
+		PACKET_DESCRIPTOR peek() const
+		{
+			unsigned const tail = _tail%QUEUE_SIZE;
+			Genode::memory_barrier();
+			return _queue[tail];
+		}
+
+		/**
+		 * Return true if packet-descriptor queue is empty
+		 */
+		bool empty() { return _tail == _head; }
+
+		/**
+		 * Return true if packet-descriptor queue is full
+		 */
+		bool full() { return _next(_head) == _tail; }
+
+		/**
+		 * Return true if a single element is stored in the queue
+		 */
+		bool single_element() { return _next(_tail) == _head; }
+
+		/**
+		 * Return true if a single slot is left to be put into the queue
+		 */
+		bool single_slot_free() { return (_head + 2)%QUEUE_SIZE == _tail; }
+
+		/**
+		 * Return number of slots left to be put into the queue
+		 */
+		unsigned slots_free()
+		{
+			unsigned const head = _head, tail = _tail;
+			return ((tail > head) ? tail - head
+			                      : QUEUE_SIZE - head + tail) - 1;
+		}
+};
+
+
 /**
  * Transmit packet descriptors with data-flow control
  *
@@ -273,7 +442,9 @@ class Genode::Packet_descriptor_transmitter
 		/* facility to send ready-to-receive signals */
 		Genode::Signal_transmitter         _rx_ready { };
 
-		Genode::Lock _tx_queue_lock { };
+		typedef typename TX_QUEUE::Access_lock Access_lock;
+
+		Access_lock  _tx_queue_lock { };
 		TX_QUEUE    *_tx_queue;
 
 		/*
@@ -318,13 +489,13 @@ class Genode::Packet_descriptor_transmitter
 
 		bool ready_for_tx()
 		{
-			Genode::Lock::Guard lock_guard(_tx_queue_lock);
+			Genode::Lock_guard<Access_lock> lock_guard(_tx_queue_lock);
 			return !_tx_queue->full();
 		}
 
 		void tx(typename TX_QUEUE::Packet_descriptor packet)
 		{
-			Genode::Lock::Guard lock_guard(_tx_queue_lock);
+			Genode::Lock_guard<Access_lock> lock_guard(_tx_queue_lock);
 
 			do {
 				/* block for signal if tx queue is full */
@@ -343,6 +514,48 @@ class Genode::Packet_descriptor_transmitter
 				_rx_ready.submit();
 		}
 
+		/**
+		 * Transmit a batch of packets
+		 *
+		 * The method blocks while the tx queue is full. In contrast to
+		 * calling 'tx' for each packet, the receiver gets notified at most
+		 * once, after the whole batch is queued or before blocking for free
+		 * queue slots.
+		 */
+		void tx_batch(typename TX_QUEUE::Packet_descriptor const *packets,
+		              unsigned count)
+		{
+			Genode::Lock_guard<Access_lock> lock_guard(_tx_queue_lock);
+
+			bool notify = false;
+
+			for (unsigned i = 0; i < count; ) {
+
+				if (_tx_queue->full()) {
+
+					/* let the receiver drain the queue before blocking */
+					if (notify) {
+						_rx_ready.submit();
+						notify = false;
+					}
+					_tx_ready.wait_for_signal();
+					continue;
+				}
+
+				if (!_tx_queue->add(packets[i]))
+					continue;
+
+				/* the receiver may have seen an empty queue */
+				if (_tx_queue->single_element())
+					notify = true;
+
+				i++;
+			}
+
+			if (notify)
+				_rx_ready.submit();
+		}
+
 		/**
 		 * Return number of slots left to be put into the tx queue
 		 */
@@ -368,8 +581,10 @@ class Genode::Packet_descriptor_receiver
 		/* facility to send ready-to-transmit signals */
 		Genode::Signal_transmitter        _tx_ready { };
 
-		Genode::Lock mutable  _rx_queue_lock { };
-		RX_QUEUE             *_rx_queue;
+		typedef typename RX_QUEUE::Access_lock Access_lock;
+
+		Access_lock mutable  _rx_queue_lock { };
+		RX_QUEUE            *_rx_queue;
 
 		/*
 		 * Noncopyable
@@ -413,13 +628,13 @@ class Genode::Packet_descriptor_receiver
 
 		bool ready_for_rx()
 		{
-			Genode::Lock::Guard lock_guard(_rx_queue_lock);
+			Genode::Lock_guard<Access_lock> lock_guard(_rx_queue_lock);
 			return !_rx_queue->empty();
 		}
 
 		void rx(typename RX_QUEUE::Packet_descriptor *out_packet)
 		{
-			Genode::Lock::Guard lock_guard(_rx_queue_lock);
+			Genode::Lock_guard<Access_lock> lock_guard(_rx_queue_lock);
 
 			while (_rx_queue->empty())
 				_rx_ready.wait_for_signal();
@@ -430,9 +645,47 @@ class Genode::Packet_descriptor_receiver
 				_tx_ready.submit();
 		}
 
+		/**
+		 * Receive a batch of packets
+		 *
+		 * The method blocks until at least one packet is available and
+		 * takes up to 'max_count' packets from the rx queue. The
+		 * transmitter gets notified at most once per batch.
+		 *
+		 * \return number of packets stored at 'out_packets'
+		 */
+		unsigned rx_batch(typename RX_QUEUE::Packet_descriptor *out_packets,
+		                  unsigned max_count)
+		{
+			Genode::Lock_guard<Access_lock> lock_guard(_rx_queue_lock);
+
+			if (!max_count)
+				return 0;
+
+			while (_rx_queue->empty())
+				_rx_ready.wait_for_signal();
+
+			bool     notify = false;
+			unsigned count  = 0;
+
+			for (; count < max_count && !_rx_queue->empty(); count++) {
+
+				out_packets[count] = _rx_queue->get();
+
+				/* the transmitter may have seen a full queue */
+				if (_rx_queue->single_slot_free())
+					notify = true;
+			}
+
+			if (notify)
+				_tx_ready.submit();
+
+			return count;
+		}
+
 		typename RX_QUEUE::Packet_descriptor rx_peek() const
 		{
-			Genode::Lock::Guard lock_guard(_rx_queue_lock);
+			Genode::Lock_guard<Access_lock> lock_guard(_rx_queue_lock);
 			return _rx_queue->peek();
 		}
 };
@@ -554,6 +807,38 @@ struct Genode::Packet_stream_policy
 };
 
 
+/**
+ * Policy for a side of the stream that is driven by a single thread
+ *
+ * The policy is interchangeable with the 'Packet_stream_policy' of the same
+ * arguments at the other side of the stream.
+ */
+template <typename PACKET_DESCRIPTOR,
+          unsigned SUBMIT_QUEUE_SIZE,
+          unsigned ACK_QUEUE_SIZE,
+          typename CONTENT_TYPE>
+struct Genode::Lock_free_packet_stream_policy
+{
+	typedef CONTENT_TYPE Content_type;
+
+	typedef PACKET_DESCRIPTOR Packet_descriptor;
+
+	typedef Lock_free_packet_descriptor_queue<PACKET_DESCRIPTOR, SUBMIT_QUEUE_SIZE>
+	        Submit_queue;
+
+	typedef Lock_free_packet_descriptor_queue<PACKET_DESCRIPTOR, ACK_QUEUE_SIZE>
+	        Ack_queue;
+
+	/* both policies must agree on the layout of the communication buffer */
+	static_assert(sizeof(Submit_queue) ==
+	              sizeof(Packet_descriptor_queue<PACKET_DESCRIPTOR, SUBMIT_QUEUE_SIZE>),
+	              "layout mismatch of lock-free submit queue");
+	static_assert(sizeof(Ack_queue) ==
+	              sizeof(Packet_descriptor_queue<PACKET_DESCRIPTOR, ACK_QUEUE_SIZE>),
+	              "layout mismatch of lock-free ack queue");
+};
+
+
 /**
  * Originator of a packet stream
  */
@@ -716,6 +1001,23 @@ class Genode::Packet_stream_source : private Packet_stream_base
 			_submit_transmitter.tx(packet);
 		}
 
+		/**
+		 * Tell sink about a batch of packets to process
+		 *
+		 * This method blocks while the submit queue is full. The sink
+		 * receives at most one 'packet_avail' signal per batch.
+		 */
+		void submit_packets(Packet_descriptor const *packets, unsigned count)
+		{
+			_submit_transmitter.tx_batch(packets, count);
+		}
+
+		/**
+		 * Return number of slots left in the submit queue
+		 */
+		unsigned submit_slots_free() {
+			return _submit_transmitter.tx_slots_free(); }
+
 		/**
 		 * Returns true if one or more packet acknowledgements are available
 		 */
@@ -731,6 +1033,18 @@ class Genode::Packet_stream_source : private Packet_stream_base
 			return packet;
 		}
 
+		/**
+		 * Get a batch of acknowledged packets
+		 *
+		 * This method blocks until at least one acknowledgement is available.
+		 *
+		 * \return number of packets stored at 'packets'
+		 */
+		unsigned get_acked_packets(Packet_descriptor *packets, unsigned max_count)
+		{
+			return _ack_receiver.rx_batch(packets, max_count);
+		}
+
 		/**
 		 * Release bulk-buffer space consumed by the packet
 		 */
@@ -849,6 +1163,19 @@ class Genode::Packet_stream_sink : private Packet_stream_base
 			return packet;
 		}
 
+		/**
+		 * Get a batch of packets from source
+		 *
+		 * This method blocks until at least one packet is available. The
+		 * source receives at most one 'ready_to_submit' signal per batch.
+		 *
+		 * \return number of packets stored at 'packets'
+		 */
+		unsigned get_packets(Packet_descriptor *packets, unsigned max_count)
+		{
+			return _submit_receiver.rx_batch(packets, max_count);
+		}
+
 		/**
 		 * Return but do not dequeue next packet
 		 *
@@ -893,6 +1220,17 @@ class Genode::Packet_stream_sink : private Packet_stream_base
 			_ack_transmitter.tx(packet);
 		}
 
+		/**
+		 * Acknowledge a batch of packets
+		 *
+		 * This method blocks while the acknowledgement queue is full. The
+		 * source receives at most one 'ack_avail' signal per batch.
+		 */
+		void acknowledge_packets(Packet_descriptor const *packets, unsigned count)
+		{
+			_ack_transmitter.tx_batch(packets, count);
+		}
+
 		void debug_print_buffers() {
 			Packet_stream_base::_debug_print_buffers(); }
 
@@ -17,8 +17,10 @@
 #include <util/retry.h>
 #include <util/reconstructible.h>
 #include <base/attached_dataspace.h>
+#include <base/attached_ram_dataspace.h>
 #include <report_session/connection.h>
 #include <util/xml_generator.h>
+#include <os/xml_delta.h>
 
 namespace Genode {
 	class Reporter;
@@ -32,6 +34,16 @@ class Genode::Reporter
 
 		typedef String<100> Name;
 
+		/**
+		 * Policy for submitting reports generated via 'Xml_generator'
+		 *
+		 * ALWAYS   submit each report
+		 * CHANGED  submit a report only if it differs from the previous one
+		 * DELTA    like CHANGED, but submit only the top-level sub nodes that
+		 *          changed if the report server is able to merge them
+		 */
+		enum class Submit { ALWAYS, CHANGED, DELTA };
+
 	private:
 
 		Name const _xml_name;
@@ -41,6 +53,10 @@ class Genode::Reporter
 
 		bool _enabled = false;
 
+		Submit _submit_policy = Submit::ALWAYS;
+
+		Env *_env = nullptr;
+
 		struct Connection
 		{
 			Report::Connection report;
@@ -52,6 +68,57 @@ class Genode::Reporter
 
 		Constructible<Connection> _conn { };
 
+		/**
+		 * Local copies of the current and the previous report
+		 *
+		 * Reports are generated into the local buffer and compared with the
+		 * previous report before being copied to the report buffer.
+		 */
+		struct History
+		{
+			Attached_ram_dataspace buf[2];
+
+			unsigned curr      = 0;
+			size_t   prev_len  = 0;
+			bool     prev_valid = false;
+			bool     delta_supported = true;
+
+			History(Env &env, size_t size)
+			:
+				buf { { env.ram(), env.rm(), size },
+				      { env.ram(), env.rm(), size } }
+			{ }
+
+			char *curr_base() { return buf[curr].local_addr<char>(); }
+			char *prev_base() { return buf[!curr].local_addr<char>(); }
+
+			void advance(size_t len)
+			{
+				prev_len   = len;
+				prev_valid = true;
+				curr       = !curr;
+			}
+		};
+
+		Constructible<History> _history { };
+
+		/*
+		 * Noncopyable
+		 */
+		Reporter(Reporter const &);
+		Reporter &operator = (Reporter const &);
+
+		void _update_history()
+		{
+			bool const needed = _enabled && _env && _submit_policy != Submit::ALWAYS;
+
+			if (needed && !_history.constructed())
+				_history.construct(*_env, _conn->ds.size());
+
+			if (!needed)
+				_history.destruct();
+		}
+
 		/**
 		 * Return size of report buffer
 		 */
@@ -62,13 +129,59 @@ class Genode::Reporter
 		 */
 		char *_base() { return _enabled ? _conn->ds.local_addr<char>() : 0; }
 
+		/**
+		 * Return pointer to buffer for generating a report
+		 */
+		char *_gen_base()
+		{
+			return _history.constructed() ? _history->curr_base() : _base();
+		}
+
+		/**
+		 * Submit report generated into '_gen_base()'
+		 */
+		void _submit(size_t length)
+		{
+			if (!_history.constructed()) {
+				_conn->report.submit(length);
+				return;
+			}
+
+			History &h = *_history;
+
+			char const * const curr = h.curr_base();
+			char const * const prev = h.prev_base();
+
+			if (h.prev_valid && length == h.prev_len && !memcmp(curr, prev, length))
+				return;
+
+			bool submitted = false;
+
+			if (_submit_policy == Submit::DELTA && h.prev_valid && h.delta_supported) {
+
+				size_t const delta_len =
+					Xml_delta::generate(prev, h.prev_len, curr, length, _base(), _size());
+
+				/* fall back to complete reports if the server rejects deltas */
+				if (delta_len)
+					submitted = h.delta_supported = _conn->report.submit_delta(delta_len);
+			}
+
+			if (!submitted) {
+				memcpy(_base(), curr, length);
+				_conn->report.submit(length);
+			}
+
+			h.advance(length);
+		}
+
 	public:
 
-		Reporter(Env &, char const *xml_name, char const *label = nullptr,
+		Reporter(Env &env, char const *xml_name, char const *label = nullptr,
 		         size_t buffer_size = 4096)
 		:
 			_xml_name(xml_name), _label(label ? label : xml_name),
-			_buffer_size(buffer_size)
+			_buffer_size(buffer_size), _env(&env)
 		{ }
 
 		/**
@@ -97,6 +210,7 @@ class Genode::Reporter
 				_conn.destruct();
 
 			_enabled = enabled;
+			_update_history();
 		}
 
 		/**
@@ -114,10 +228,28 @@ class Genode::Reporter
 
 		Name name() const { return _label; }
 
+		/**
+		 * Define policy for submitting generated reports
+		 *
+		 * The policies other than 'ALWAYS' are only supported by reporters
+		 * constructed with an 'Env' argument.
+		 */
+		void submit_policy(Submit policy)
+		{
+			_submit_policy = policy;
+			_update_history();
+		}
+
 		/**
 		 * Clear report buffer
 		 */
-		void clear() { memset(_base(), 0, _size()); }
+		void clear()
+		{
+			memset(_base(), 0, _size());
+
+			if (_history.constructed())
+				_history->prev_valid = false;
+		}
 
 		/**
 		 * Report data buffer
@@ -134,6 +266,9 @@ class Genode::Reporter
 
 			memcpy(base, data, length);
 			_conn->report.submit(length);
+
+			if (_history.constructed())
+				_history->prev_valid = false;
 		}
 
 		/**
@@ -144,13 +279,13 @@ class Genode::Reporter
 			template <typename FUNC>
 			Xml_generator(Reporter &reporter, FUNC const &func)
 			:
-				Genode::Xml_generator(reporter._base(),
+				Genode::Xml_generator(reporter._gen_base(),
 				                      reporter._size(),
 				                      reporter._xml_name.string(),
 				                      func)
 			{
 				if (reporter.enabled())
-					reporter._conn->report.submit(used());
+					reporter._submit(used());
 			}
 		};
 };
@@ -0,0 +1,253 @@
+/*
+ * \brief  Difference between two versions of an XML document
+ * \author Genode Labs
+ * \date   2018-04-03
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__OS__XML_DELTA_H_
+#define _INCLUDE__OS__XML_DELTA_H_
+
+#include <util/xml_node.h>
+#include <util/string.h>
+
+namespace Genode { struct Xml_delta; }
+
+
+/**
+ * Delta of an XML document relative to its previous version
+ *
+ * A delta is the new document where runs of top-level sub nodes that are
+ * unchanged compared to the previous version are replaced by
+ *
+ * ! <delta:keep from="<index>" count="<number>"/>
+ *
+ * The 'from' attribute refers to the position of the first node of the run
+ * among the top-level sub nodes of the previous version. Merging the delta
+ * with the previous version yields the new document.
+ */
+struct Genode::Xml_delta
+{
+	private:
+
+		/*
+		 * Number of nodes of the previous version that are compared with a
+		 * node of the new version, which limits the effort for documents
+		 * where most nodes changed
+		 */
+		enum { MAX_LOOKAHEAD = 8 };
+
+		/**
+		 * Output buffer that merely counts the bytes if no buffer is given
+		 */
+		class Out
+		{
+			private:
+
+				char  *_dst;
+				size_t _capacity;
+				size_t _used = 0;
+
+			public:
+
+				class Buffer_exceeded : public Exception { };
+
+				Out(char *dst, size_t capacity) : _dst(dst), _capacity(capacity) { }
+
+				void append(char const *src, size_t len)
+				{
+					if (_dst) {
+						if (_used + len > _capacity)
+							throw Buffer_exceeded();
+
+						memcpy(_dst + _used, src, len);
+					}
+					_used += len;
+				}
+
+				size_t used() const { return _used; }
+		};
+
+		static bool _identical(Xml_node const &a, Xml_node const &b)
+		{
+			return a.size() == b.size() && !memcmp(a.addr(), b.addr(), a.size());
+		}
+
+	public:
+
+		class Invalid_delta : public Exception { };
+
+		/**
+		 * Generate delta of 'curr' relative to 'prev'
+		 *
+		 * The sub nodes of the new version are matched against those of the
+		 * previous version in order. If a sub node does not match the
+		 * successor of the previously matched node, the following
+		 * 'MAX_LOOKAHEAD' nodes of the previous version are searched.
+		 *
+		 * \return  size of delta, or 0 if the delta would not be significantly
+		 *          smaller than the new document
+		 */
+		static size_t generate(char const *prev, size_t prev_len,
+		                       char const *curr, size_t curr_len,
+		                       char *dst, size_t dst_len)
+		{
+			try {
+				Xml_node const prev_node(prev, prev_len);
+				Xml_node const curr_node(curr, curr_len);
+
+				if (!prev_node.num_sub_nodes() || !curr_node.num_sub_nodes())
+					return 0;
+
+				Out out(dst, dst_len);
+
+				/* start of the text of 'curr' not yet passed to 'out' */
+				char const *pos = curr;
+
+				/* run of unchanged nodes */
+				unsigned    run_from  = 0, run_count = 0;
+				char const *run_start = nullptr, *run_end = nullptr;
+
+				auto flush_run = [&] ()
+				{
+					if (!run_count)
+						return;
+
+					String<64> const keep("<delta:keep from=\"", run_from, "\" "
+					                      "count=\"", run_count, "\"/>");
+
+					out.append(pos, run_start - pos);
+					out.append(keep.string(), keep.length() - 1);
+					pos       = run_end;
+					run_count = 0;
+				};
+
+				/* candidate for the next match in 'prev' */
+				Xml_node p     = prev_node.sub_node();
+				unsigned p_idx = 0;
+				bool     p_end = false;
+
+				curr_node.for_each_sub_node([&] (Xml_node const &node) {
+
+					/* search the following nodes of 'prev' for a match */
+					bool     found = false;
+					unsigned idx   = p_idx;
+					Xml_node match = p;
+					if (!p_end) {
+						try {
+							for (; idx < p_idx + MAX_LOOKAHEAD; match = match.next(), idx++)
+								if (_identical(match, node)) {
+									found = true;
+									break;
+								}
+						} catch (Xml_node::Nonexistent_sub_node) { }
+					}
+
+					if (!found) {
+						flush_run();
+						return;
+					}
+
+					char const *node_end = node.addr() + node.size();
+
+					if (run_count && idx == run_from + run_count) {
+						run_count++;
+						run_end = node_end;
+					} else {
+						flush_run();
+						run_from  = idx;
+						run_count = 1;
+						run_start = node.addr();
+						run_end   = node_end;
+					}
+
+					try { p = match.next(); p_idx = idx + 1; }
+					catch (Xml_node::Nonexistent_sub_node) { p_end = true; }
+				});
+
+				flush_run();
+				out.append(pos, curr + curr_len - pos);
+
+				/* a delta that saves less than a quarter is not worth merging */
+				if (out.used() > curr_len - curr_len/4)
+					return 0;
+
+				return out.used();
+			}
+			catch (Xml_node::Invalid_syntax)       { }
+			catch (Xml_node::Nonexistent_sub_node) { }
+			catch (Out::Buffer_exceeded)           { }
+
+			return 0;
+		}
+
+		/**
+		 * Merge 'delta' with the previous version 'prev'
+		 *
+		 * \param dst  destination buffer, or nullptr to obtain the size only
+		 *
+		 * \return  size of the new document
+		 *
+		 * \throw Invalid_delta
+		 */
+		static size_t merge(char const *prev, size_t prev_len,
+		                    char const *delta, size_t delta_len,
+		                    char *dst, size_t dst_len)
+		{
+			try {
+				Xml_node const prev_node(prev, prev_len);
+				Xml_node const delta_node(delta, delta_len);
+
+				Out out(dst, dst_len);
+
+				/* start of the text of 'delta' not yet passed to 'out' */
+				char const *pos = delta;
+
+				/* node of 'prev' at position 'p_idx' */
+				Xml_node p     = prev_node.sub_node();
+				unsigned p_idx = 0;
+
+				delta_node.for_each_sub_node("delta:keep", [&] (Xml_node const &keep) {
+
+					unsigned const from  = keep.attribute_value("from",  0U);
+					unsigned const count = keep.attribute_value("count", 0U);
+
+					if (!count)
+						throw Invalid_delta();
+
+					/* runs are usually in order, restart search otherwise */
+					if (from < p_idx) {
+						p     = prev_node.sub_node();
+						p_idx = 0;
+					}
+
+					for (; p_idx < from; p_idx++)
+						p = p.next();
+
+					char const *run_start = p.addr();
+					for (unsigned i = 1; i < count; i++, p_idx++)
+						p = p.next();
+
+					out.append(pos, keep.addr() - pos);
+					out.append(run_start, p.addr() + p.size() - run_start);
+					pos = keep.addr() + keep.size();
+				});
+
+				out.append(pos, delta + delta_len - pos);
+				return out.used();
+			}
+			catch (Xml_node::Invalid_syntax)       { }
+			catch (Xml_node::Nonexistent_sub_node) { }
+			catch (Out::Buffer_exceeded)           { }
+
+			throw Invalid_delta();
+		}
+};
+
+#endif /* _INCLUDE__OS__XML_DELTA_H_ */
@@ -17,20 +17,29 @@
 #include <packet_stream_rx/packet_stream_rx.h>
 #include <base/rpc_client.h>
 
-namespace Packet_stream_rx { template <typename> class Client; }
+namespace Packet_stream_rx {
 
+	/**
+	 * \param POLICY  packet-stream policy of the local sink, which may
+	 *                differ from the policy of the server, e.g., a
+	 *                'Genode::Lock_free_packet_stream_policy'
+	 */
+	template <typename CHANNEL, typename POLICY = typename CHANNEL::Policy>
+	class Client;
+}
 
-template <typename CHANNEL>
-class Packet_stream_rx::Client : public Genode::Rpc_client<CHANNEL>
+
+template <typename CHANNEL, typename POLICY>
+class Packet_stream_rx::Client : public Genode::Rpc_client<Channel<POLICY> >
 {
 	private:
 
-		typename CHANNEL::Sink _sink;
+		typename Channel<POLICY>::Sink _sink;
 
 		/*
 		 * Type shortcuts
 		 */
-		typedef Genode::Rpc_client<CHANNEL>        Base;
+		typedef Genode::Rpc_client<Channel<POLICY> > Base;
 		typedef typename Base::Rpc_dataspace       Rpc_dataspace;
 		typedef typename Base::Rpc_packet_avail    Rpc_packet_avail;
 		typedef typename Base::Rpc_ready_to_ack    Rpc_ready_to_ack;
@@ -45,7 +54,7 @@ class Packet_stream_rx::Client : public Genode::Rpc_client<CHANNEL>
 		Client(Genode::Capability<CHANNEL> channel_cap,
 		       Genode::Region_map &rm)
 		:
-			Genode::Rpc_client<CHANNEL>(channel_cap),
+			Base(Genode::reinterpret_cap_cast<Channel<POLICY> >(channel_cap)),
 			_sink(Base::template call<Rpc_dataspace>(), rm)
 		{
 			/* wire data-flow signals for the packet receiver */
@@ -62,7 +71,7 @@ class Packet_stream_rx::Client : public Genode::Rpc_client<CHANNEL>
 		void sigh_packet_avail(Genode::Signal_context_capability sigh) {
 			Base::template call<Rpc_packet_avail>(sigh); }
 
-		typename CHANNEL::Sink *sink() { return &_sink; }
+		typename Channel<POLICY>::Sink *sink() { return &_sink; }
 };
 
 #endif /* _INCLUDE__PACKET_STREAM_RX__CLIENT_H_ */
@@ -26,6 +26,8 @@ struct Packet_stream_rx::Channel : Genode::Interface
 	typedef Genode::Packet_stream_source<PACKET_STREAM_POLICY> Source;
 	typedef Genode::Packet_stream_sink<PACKET_STREAM_POLICY>   Sink;
 
+	typedef PACKET_STREAM_POLICY Policy;
+
 	/**
 	 * Request reception interface
 	 *
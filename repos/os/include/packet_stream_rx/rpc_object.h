@@ -17,17 +17,26 @@
 #include <packet_stream_rx/packet_stream_rx.h>
 #include <base/rpc_server.h>
 
-namespace Packet_stream_rx { template <typename> class Rpc_object; }
+namespace Packet_stream_rx {
 
+	/**
+	 * \param SOURCE  local packet-stream source, which may use a different
+	 *                packet-stream policy than the client, e.g., a
+	 *                'Genode::Lock_free_packet_stream_policy'
+	 */
+	template <typename CHANNEL, typename SOURCE = typename CHANNEL::Source>
+	class Rpc_object;
+}
 
-template <typename CHANNEL>
-class Packet_stream_rx::Rpc_object : public Genode::Rpc_object<CHANNEL, Rpc_object<CHANNEL> >
+
+template <typename CHANNEL, typename SOURCE>
+class Packet_stream_rx::Rpc_object : public Genode::Rpc_object<CHANNEL, Rpc_object<CHANNEL, SOURCE> >
 {
 	private:
 
 		Genode::Rpc_entrypoint     &_ep;
 		Genode::Capability<CHANNEL> _cap;
-		typename CHANNEL::Source    _source;
+		SOURCE                      _source;
 
 		Genode::Signal_context_capability _sigh_ready_to_submit;
 		Genode::Signal_context_capability _sigh_ack_avail;
@@ -89,7 +98,7 @@ class Packet_stream_rx::Rpc_object : public Genode::Rpc_object<CHANNEL, Rpc_obje
 		void sigh_ack_avail(Genode::Signal_context_capability sigh) {
 			_sigh_ack_avail = sigh; }
 
-		typename CHANNEL::Source *source() { return &_source; }
+		SOURCE *source() { return &_source; }
 
 		Genode::Capability<CHANNEL> cap() const { return _cap; }
 
@@ -17,18 +17,27 @@
 #include <packet_stream_tx/packet_stream_tx.h>
 #include <base/rpc_client.h>
 
-namespace Packet_stream_tx { template <typename> class Client; }
+namespace Packet_stream_tx {
 
+	/**
+	 * \param POLICY  packet-stream policy of the local source, which may
+	 *                differ from the policy of the server, e.g., a
+	 *                'Genode::Lock_free_packet_stream_policy'
+	 */
+	template <typename CHANNEL, typename POLICY = typename CHANNEL::Policy>
+	class Client;
+}
 
-template <typename CHANNEL>
-class Packet_stream_tx::Client : public Genode::Rpc_client<CHANNEL>
+
+template <typename CHANNEL, typename POLICY>
+class Packet_stream_tx::Client : public Genode::Rpc_client<Channel<POLICY> >
 {
 	private:
 
 		/*
 		 * Type shortcuts
 		 */
-		typedef Genode::Rpc_client<CHANNEL>        Base;
+		typedef Genode::Rpc_client<Channel<POLICY> > Base;
 		typedef typename Base::Rpc_dataspace       Rpc_dataspace;
 		typedef typename Base::Rpc_packet_avail    Rpc_packet_avail;
 		typedef typename Base::Rpc_ready_to_ack    Rpc_ready_to_ack;
@@ -38,7 +47,7 @@ class Packet_stream_tx::Client : public Genode::Rpc_client<CHANNEL>
 		/**
 		 * Packet-stream source
 		 */
-		typename CHANNEL::Source _source;
+		typename Channel<POLICY>::Source _source;
 
 	public:
 
@@ -52,7 +61,7 @@ class Packet_stream_tx::Client : public Genode::Rpc_client<CHANNEL>
 		       Genode::Region_map &rm,
 		       Genode::Range_allocator &buffer_alloc)
 		:
-			Genode::Rpc_client<CHANNEL>(channel_cap),
+			Base(Genode::reinterpret_cap_cast<Channel<POLICY> >(channel_cap)),
 			_source(Base::template call<Rpc_dataspace>(), rm, buffer_alloc)
 		{
 			/* wire data-flow signals for the packet transmitter */
@@ -68,7 +77,7 @@ class Packet_stream_tx::Client : public Genode::Rpc_client<CHANNEL>
 		void sigh_ack_avail(Genode::Signal_context_capability sigh) {
 			Base::template call<Rpc_ack_avail>(sigh); }
 
-		typename CHANNEL::Source *source() { return &_source; }
+		typename Channel<POLICY>::Source *source() { return &_source; }
 };
 
 #endif /* _INCLUDE__PACKET_STREAM_TX__CLIENT_H_ */
@@ -17,17 +17,26 @@
 #include <packet_stream_tx/packet_stream_tx.h>
 #include <base/rpc_server.h>
 
-namespace Packet_stream_tx { template <typename> class Rpc_object; }
+namespace Packet_stream_tx {
 
+	/**
+	 * \param SINK  local packet-stream sink, which may use a different
+	 *              packet-stream policy than the client, e.g., a
+	 *              'Genode::Lock_free_packet_stream_policy'
+	 */
+	template <typename CHANNEL, typename SINK = typename CHANNEL::Sink>
+	class Rpc_object;
+}
 
-template <typename CHANNEL>
-class Packet_stream_tx::Rpc_object : public Genode::Rpc_object<CHANNEL, Rpc_object<CHANNEL> >
+
+template <typename CHANNEL, typename SINK>
+class Packet_stream_tx::Rpc_object : public Genode::Rpc_object<CHANNEL, Rpc_object<CHANNEL, SINK> >
 {
 	private:
 
 		Genode::Rpc_entrypoint     &_ep;
 		Genode::Capability<CHANNEL> _cap;
-		typename CHANNEL::Sink      _sink;
+		SINK                        _sink;
 
 		Genode::Signal_context_capability _sigh_ready_to_ack;
 		Genode::Signal_context_capability _sigh_packet_avail;
@@ -86,7 +95,7 @@ class Packet_stream_tx::Rpc_object : public Genode::Rpc_object<CHANNEL, Rpc_obje
 		void sigh_packet_avail(Genode::Signal_context_capability sigh) {
 			_sigh_packet_avail = sigh; }
 
-		typename CHANNEL::Sink *sink() { return &_sink; }
+		SINK *sink() { return &_sink; }
 
 		Genode::Capability<CHANNEL> cap() const { return _cap; }
 
@@ -92,6 +92,20 @@ struct Report::Session_component : Genode::Rpc_object<Session>, Rom::Writer
 			_module.write_content(*this, _ds.local_addr<char>(), length);
 		}
 
+		bool submit_delta(size_t length) override
+		{
+			length = Genode::min(length, _ds.size());
+
+			if (!_module.write_delta(*this, _ds.local_addr<char>(), length))
+				return false;
+
+			if (_verbose) {
+				Genode::log("report '", _module.name(), "' (delta)");
+				_log_lines(_ds.local_addr<char>(), length);
+			}
+			return true;
+		}
+
 		void response_sigh(Genode::Signal_context_capability) override { }
 
 		size_t obtain_response() override { return 0; }
@@ -18,6 +18,7 @@
 #include <util/reconstructible.h>
 #include <os/session_policy.h>
 #include <base/attached_ram_dataspace.h>
+#include <os/xml_delta.h>
 
 namespace Rom {
 	using Genode::size_t;
@@ -164,6 +165,19 @@ struct Rom::Module : private Module_list::Element, Readable_module
 		 */
 		size_t _size = 0;
 
+		/**
+		 * Writer whose most recent report equals the content
+		 *
+		 * Only this writer can submit a delta to the content. In contrast
+		 * to '_last_writer', it is reset when a report gets rejected.
+		 */
+		Writer const *_delta_base = nullptr;
+
+		/**
+		 * Buffer for merging a delta with the current content
+		 */
+		Constructible<Attached_ram_dataspace> _merge_ds { };
+
 
 		/********************************
 		 ** Interface used by registry **
@@ -227,6 +241,9 @@ struct Rom::Module : private Module_list::Element, Readable_module
 				_size = 0;
 				_last_writer = nullptr;
 			}
+
+			if (_delta_base == &writer)
+				_delta_base = nullptr;
 		}
 
 		bool _has_name(Name const &name) const { return name == _name; }
@@ -254,7 +271,17 @@ struct Rom::Module : private Module_list::Element, Readable_module
 		 */
 		void write_content(Writer const &writer, char const * const src, size_t const src_len)
 		{
-			if (!_write_policy.write_permitted(*this, writer))
+			if (!_write_policy.write_permitted(*this, writer)) {
+				if (_delta_base == &writer)
+					_delta_base = nullptr;
+				return;
+			}
+
+			_delta_base = &writer;
+
+			/* spare the readers from re-obtaining unchanged content */
+			if (_last_writer == &writer && _ds.constructed() && src_len == _size
+			 && !Genode::memcmp(_ds->local_addr<char>(), src, src_len))
 				return;
 
 			_size = 0;
@@ -288,6 +315,36 @@ struct Rom::Module : private Module_list::Element, Readable_module
 			}
 		}
 
+		/**
+		 * Apply delta to the content most recently written by 'writer'
+		 *
+		 * \return  false if the delta cannot be applied
+		 */
+		bool write_delta(Writer const &writer, char const * const delta,
+		                 size_t const delta_len)
+		{
+			if (_delta_base != &writer || !_ds.constructed())
+				return false;
+
+			char const * const curr = _ds->local_addr<char>();
+
+			try {
+				size_t const len =
+					Genode::Xml_delta::merge(curr, _size, delta, delta_len, nullptr, 0);
+
+				if (!_merge_ds.constructed() || _merge_ds->size() < len)
+					_merge_ds.construct(_ram, _rm, len);
+
+				Genode::Xml_delta::merge(curr, _size, delta, delta_len,
+				                         _merge_ds->local_addr<char>(), len);
+
+				write_content(writer, _merge_ds->local_addr<char>(), len);
+			}
+			catch (Genode::Xml_delta::Invalid_delta) { return false; }
+
+			return true;
+		}
+
 		/**
 		 * Readable_module interface
 		 */
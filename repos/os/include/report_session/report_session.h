@@ -79,6 +79,20 @@ struct Report::Session : Genode::Session
 	 */
 	virtual void submit(size_t length) = 0;
 
+	/**
+	 * Submit delta to the previous report contained in the dataspace
+	 *
+	 * \param length  length of delta in bytes
+	 *
+	 * \return  false if the delta was not applied, in which case the client
+	 *          must submit the complete report
+	 *
+	 * The delta has the format produced by 'Genode::Xml_delta::generate'.
+	 * It refers to the report most recently submitted via the session.
+	 * Servers that do not merge deltas keep the default implementation.
+	 */
+	virtual bool submit_delta(size_t /* length */) { return false; }
+
 	/**
 	 * Install signal handler for response notifications
 	 */
@@ -101,10 +115,11 @@ struct Report::Session : Genode::Session
 
 	GENODE_RPC(Rpc_dataspace, Dataspace_capability, dataspace);
 	GENODE_RPC(Rpc_submit, void, submit, size_t);
+	GENODE_RPC(Rpc_submit_delta, bool, submit_delta, size_t);
 	GENODE_RPC(Rpc_response_sigh, void, response_sigh, Signal_context_capability);
 	GENODE_RPC(Rpc_obtain_response, size_t, obtain_response);
-	GENODE_RPC_INTERFACE(Rpc_dataspace, Rpc_submit, Rpc_response_sigh,
-	                     Rpc_obtain_response);
+	GENODE_RPC_INTERFACE(Rpc_dataspace, Rpc_submit, Rpc_submit_delta,
+	                     Rpc_response_sigh, Rpc_obtain_response);
 };
 
 #endif /* _INCLUDE__REPORT_SESSION__REPORT_SESSION_H_ */
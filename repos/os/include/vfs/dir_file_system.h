@@ -158,6 +158,328 @@ class Vfs::Dir_file_system : public File_system
 		 */
 		char _name[MAX_NAME_LEN];
 
+		/*
+		 * Index of the child file systems
+		 *
+		 * A '<dir>' child can only serve paths whose first element equals
+		 * its name, whereas any other child may serve arbitrary paths.
+		 * Hence, the '<dir>' children are hashed by name and the remaining
+		 * children are kept in a separate list. Both are ordered by the
+		 * position of the child within the configuration, which determines
+		 * the order in which the children are asked.
+		 */
+
+		enum { DIR_BUCKETS = 32 };
+
+		struct Plain_fs
+		{
+			File_system   &fs;
+			unsigned const position;
+			Plain_fs      *next = nullptr;
+
+			Plain_fs(File_system &fs, unsigned position)
+			: fs(fs), position(position) { }
+		};
+
+		Plain_fs        *_first_plain_fs = nullptr;
+		Plain_fs        *_last_plain_fs  = nullptr;
+		Dir_file_system *_dir_buckets[DIR_BUCKETS] { };
+		unsigned         _num_children   = 0;
+
+		/* position within the parent and next sibling of the same bucket */
+		unsigned         _position  = 0;
+		Dir_file_system *_hash_next = nullptr;
+
+		static unsigned _bucket(char const *name, Genode::size_t len)
+		{
+			unsigned long h = 5381;
+			for (Genode::size_t i = 0; i < len; i++)
+				h = h*33 + (unsigned char)name[i];
+			return (unsigned)(h % DIR_BUCKETS);
+		}
+
+		void _index_dir(Dir_file_system &dir)
+		{
+			dir._position = _num_children++;
+
+			Dir_file_system **tail = &_dir_buckets[_bucket(dir._name, strlen(dir._name))];
+			while (*tail)
+				tail = &(*tail)->_hash_next;
+
+			*tail = &dir;
+		}
+
+		void _index_plain_fs(File_system &fs)
+		{
+			Plain_fs *plain = new (_env.alloc()) Plain_fs(fs, _num_children++);
+
+			if (_last_plain_fs) _last_plain_fs->next = plain;
+			else                _first_plain_fs      = plain;
+
+			_last_plain_fs = plain;
+		}
+
+		bool _named(char const *name, Genode::size_t len) const {
+			return strlen(_name) == len && strcmp(_name, name, len) == 0; }
+
+		/**
+		 * Return first directory of bucket chain 'd' with the given name
+		 */
+		static Dir_file_system *_next_named(Dir_file_system *d,
+		                                    char const *name, Genode::size_t len)
+		{
+			while (d && !d->_named(name, len))
+				d = d->_hash_next;
+			return d;
+		}
+
+		/**
+		 * Determine first element of a path local to this directory
+		 *
+		 * \return length of the element, 0 if the path refers to the top
+		 *         directory
+		 */
+		static Genode::size_t _first_element(char const *path, char const *&name)
+		{
+			if (path[0] == '/')
+				path++;
+
+			Genode::size_t len = 0;
+			while (path[len] && path[len] != '/')
+				len++;
+
+			name = path;
+			return len;
+		}
+
+		/**
+		 * Apply functor to each child that may serve the given path
+		 *
+		 * \param path  path local to this directory
+		 * \param fn    functor taking a 'File_system &' argument, the
+		 *              iteration stops as soon as it returns true
+		 */
+		template <typename FN>
+		void _for_each_candidate(char const *path, FN const &fn)
+		{
+			char const *name = nullptr;
+			Genode::size_t const len = _first_element(path, name);
+
+			/* all children are concerned with the top directory */
+			if (len == 0) {
+				for (File_system *fs = _first_file_system; fs; fs = fs->next)
+					if (fn(*fs))
+						return;
+				return;
+			}
+
+			Plain_fs        *p = _first_plain_fs;
+			Dir_file_system *d = _next_named(_dir_buckets[_bucket(name, len)], name, len);
+
+			while (p || d) {
+
+				File_system *fs = nullptr;
+
+				if (d && (!p || d->_position < p->position)) {
+					fs = d;
+					d  = _next_named(d->_hash_next, name, len);
+				} else {
+					fs = &p->fs;
+					p  = p->next;
+				}
+
+				if (fn(*fs))
+					return;
+			}
+		}
+
+		/**
+		 * Return the only child that may serve paths below the given
+		 * element, or nullptr if the element is ambiguous
+		 */
+		Dir_file_system *_exclusive_dir(char const *name, Genode::size_t len)
+		{
+			if (_first_plain_fs)
+				return nullptr;
+
+			Dir_file_system *d = _next_named(_dir_buckets[_bucket(name, len)], name, len);
+			if (!d || _next_named(d->_hash_next, name, len))
+				return nullptr;
+
+			return d;
+		}
+
+		/**
+		 * Cache of path lookups, present at the VFS root only
+		 *
+		 * Path lookups traverse the nested '<dir>' nodes element by element.
+		 * For a directory path that leads through a chain of unambiguous
+		 * '<dir>' nodes, the cache remembers the innermost of those nodes
+		 * along with the offset of its element within the path. Requests
+		 * for this directory are then passed to the cached node directly.
+		 *
+		 * Because '<dir>' nodes are created only at construction time, the
+		 * cached entries stay valid. The cache is flushed on configuration
+		 * updates nevertheless.
+		 */
+		class Lookup_cache
+		{
+			public:
+
+				enum { ENTRIES = 64 };
+
+				struct Entry
+				{
+					unsigned         hash   = 0;
+					Genode::size_t   len    = 0;
+					Dir_file_system *dir    = nullptr;
+					Genode::size_t   offset = 0;
+					char             key[MAX_PATH_LEN] { };
+				};
+
+			private:
+
+				Genode::Lock _lock { };
+				Entry        _entries[ENTRIES];
+
+				static unsigned _hash(char const *key, Genode::size_t len)
+				{
+					unsigned h = 5381;
+					for (Genode::size_t i = 0; i < len; i++)
+						h = h*33 + (unsigned char)key[i];
+					return h;
+				}
+
+			public:
+
+				/**
+				 * Look up directory path 'key' of length 'len'
+				 *
+				 * \return true if an entry exists
+				 */
+				bool lookup(char const *key, Genode::size_t len,
+				            Dir_file_system *&dir, Genode::size_t &offset)
+				{
+					unsigned const h = _hash(key, len);
+					Entry const &e = _entries[h % ENTRIES];
+
+					Genode::Lock::Guard guard(_lock);
+
+					if (!e.dir || e.hash != h || e.len != len
+					 || strcmp(e.key, key, len) != 0)
+						return false;
+
+					dir    = e.dir;
+					offset = e.offset;
+					return true;
+				}
+
+				void insert(char const *key, Genode::size_t len,
+				            Dir_file_system &dir, Genode::size_t offset)
+				{
+					if (len >= MAX_PATH_LEN)
+						return;
+
+					unsigned const h = _hash(key, len);
+					Entry &e = _entries[h % ENTRIES];
+
+					Genode::Lock::Guard guard(_lock);
+
+					e.hash   = h;
+					e.len    = len;
+					e.dir    = &dir;
+					e.offset = offset;
+					Genode::memcpy(e.key, key, len);
+				}
+
+				void flush()
+				{
+					Genode::Lock::Guard guard(_lock);
+
+					for (unsigned i = 0; i < ENTRIES; i++)
+						_entries[i].dir = nullptr;
+				}
+		};
+
+		Lookup_cache *_lookup_cache = nullptr;
+
+		/**
+		 * Descend along unambiguous '<dir>' nodes of the directory part
+		 * of 'path'
+		 *
+		 * \param offset  resulting offset of the element of the returned
+		 *                directory within 'path'
+		 * \return        innermost unambiguous directory, or this directory
+		 */
+		Dir_file_system &_descend(char const *path, Genode::size_t dir_len,
+		                          Genode::size_t &offset)
+		{
+			Dir_file_system *dir = this;
+			offset = 0;
+
+			/* position of the next path element, skipping the leading slash */
+			Genode::size_t pos = 1;
+
+			for (;;) {
+
+				char const *name = nullptr;
+				Genode::size_t const len = _first_element(path + pos, name);
+
+				/* consider proper directory elements only */
+				if (len == 0 || pos + len > dir_len)
+					break;
+
+				Dir_file_system *sub = dir->_exclusive_dir(name, len);
+				if (!sub)
+					break;
+
+				dir    = sub;
+				offset = pos - 1;
+
+				/* skip element and the slash following it */
+				pos += len + 1;
+			}
+			return *dir;
+		}
+
+		/**
+		 * Resolve path at the VFS root via the lookup cache
+		 *
+		 * \param path  absolute path, replaced by the path to be passed to
+		 *              the resulting directory
+		 * \return      directory responsible for the path, or nullptr if
+		 *              the request must be handled by this directory
+		 */
+		Dir_file_system *_cached_lookup(char const *&path)
+		{
+			if (!_lookup_cache || path[0] != '/')
+				return nullptr;
+
+			/* directory part of the path */
+			Genode::size_t dir_len = 0;
+			for (Genode::size_t i = 0; path[i]; i++)
+				if (path[i] == '/')
+					dir_len = i;
+
+			/* nothing to gain for elements of the root directory */
+			if (dir_len == 0)
+				return nullptr;
+
+			Dir_file_system *dir    = nullptr;
+			Genode::size_t   offset = 0;
+
+			if (!_lookup_cache->lookup(path, dir_len, dir, offset)) {
+				dir = &_descend(path, dir_len, offset);
+				_lookup_cache->insert(path, dir_len, *dir, offset);
+			}
+
+			if (dir == this)
+				return nullptr;
+
+			path += offset;
+			return dir;
+		}
+
 		/**
 		 * Returns if path corresponds to top directory of file system
 		 */
@@ -203,17 +525,21 @@ class Vfs::Dir_file_system : public File_system
 			 */
 			RES error = ok;
 
+			bool succeeded = false;
+
 			/*
 			 * The given path refers to at least one of our sub directories.
 			 * Propagate the request into all of our file systems. If at least
 			 * one operation succeeds, we return success.
 			 */
-			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
+			_for_each_candidate(path, [&] (File_system &fs) {
 
-				RES const err = fn(*fs, path);
+				RES const err = fn(fs, path);
 
-				if (err == ok)
-					return err;
+				if (err == ok) {
+					succeeded = true;
+					return true;
+				}
 
 				if (err != no_entry && err != no_perm) {
 					error = err;
@@ -221,7 +547,12 @@ class Vfs::Dir_file_system : public File_system
 
 				if (err == no_perm)
 					permission_denied = true;
-			}
+
+				return false;
+			});
+
+			if (succeeded)
+				return ok;
 
 			/* none of our file systems could successfully operate on the path */
 			return error != ok ? error : permission_denied ? no_perm : no_entry;
@@ -267,9 +598,10 @@ class Vfs::Dir_file_system : public File_system
 		file_size _sum_dirents_of_file_systems(char const *path)
 		{
 			file_size cnt = 0;
-			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
-				cnt += fs->num_dirent(path);
-			}
+			_for_each_candidate(path, [&] (File_system &fs) {
+				cnt += fs.num_dirent(path);
+				return false;
+			});
 			return cnt;
 		}
 
@@ -377,14 +709,19 @@ class Vfs::Dir_file_system : public File_system
 			else
 				node.attribute("name").value(_name, sizeof(_name));
 
+			if (_vfs_root)
+				_lookup_cache = new (_env.alloc()) Lookup_cache();
+
 			for (unsigned i = 0; i < node.num_sub_nodes(); i++) {
 
 				Xml_node sub_node = node.sub_node(i);
 
 				/* traverse into <dir> nodes */
 				if (sub_node.has_type("dir")) {
-					_append_file_system(new (_env.alloc())
-						Dir_file_system(_env, sub_node, fs_factory));
+					Dir_file_system &dir = *new (_env.alloc())
+						Dir_file_system(_env, sub_node, fs_factory);
+					_append_file_system(&dir);
+					_index_dir(dir);
 					continue;
 				}
 
@@ -393,6 +730,7 @@ class Vfs::Dir_file_system : public File_system
 
 				if (fs) {
 					_append_file_system(fs);
+					_index_plain_fs(*fs);
 					continue;
 				}
 
@@ -415,6 +753,9 @@ class Vfs::Dir_file_system : public File_system
 
 		Dataspace_capability dataspace(char const *path) override
 		{
+			if (Dir_file_system *dir = _cached_lookup(path))
+				return dir->dataspace(path);
+
 			path = _sub_path(path);
 			if (!path)
 				return Dataspace_capability();
@@ -423,28 +764,57 @@ class Vfs::Dir_file_system : public File_system
 			 * Query sub file systems for dataspace using the path local to
 			 * the respective file system
 			 */
-			File_system *fs = _first_file_system;
-			for (; fs; fs = fs->next) {
-				Dataspace_capability ds = fs->dataspace(path);
-				if (ds.valid())
-					return ds;
-			}
+			Dataspace_capability ds;
+			_for_each_candidate(path, [&] (File_system &fs) {
+				ds = fs.dataspace(path);
+				return ds.valid();
+			});
 
-			return Dataspace_capability();
+			return ds;
+		}
+
+		bool dataspace_shared(char const *path) override
+		{
+			if (Dir_file_system *dir = _cached_lookup(path))
+				return dir->dataspace_shared(path);
+
+			path = _sub_path(path);
+			if (!path)
+				return false;
+
+			/* the first file system that contains the file decides */
+			bool shared = false;
+			_for_each_candidate(path, [&] (File_system &fs) {
+				if (!fs.leaf_path(path))
+					return false;
+
+				shared = fs.dataspace_shared(path);
+				return true;
+			});
+
+			return shared;
 		}
 
 		void release(char const *path, Dataspace_capability ds_cap) override
 		{
+			if (Dir_file_system *dir = _cached_lookup(path))
+				return dir->release(path, ds_cap);
+
 			path = _sub_path(path);
 			if (!path)
 				return;
 
-			for (File_system *fs = _first_file_system; fs; fs = fs->next)
-				fs->release(path, ds_cap);
+			_for_each_candidate(path, [&] (File_system &fs) {
+				fs.release(path, ds_cap);
+				return false;
+			});
 		}
 
 		Stat_result stat(char const *path, Stat &out) override
 		{
+			if (Dir_file_system *dir = _cached_lookup(path))
+				return dir->stat(path, out);
+
 			path = _sub_path(path);
 
 			/* path does not match directory name */
@@ -469,23 +839,21 @@ class Vfs::Dir_file_system : public File_system
 			 * The given path refers to one of our sub directories.
 			 * Propagate the request into our file systems.
 			 */
-			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
+			Stat_result result = STAT_ERR_NO_ENTRY;
+			_for_each_candidate(path, [&] (File_system &fs) {
+				result = fs.stat(path, out);
+				return result != STAT_ERR_NO_ENTRY;
+			});
 
-				Stat_result const err = fs->stat(path, out);
-
-				if (err == STAT_OK)
-					return err;
-
-				if (err != STAT_ERR_NO_ENTRY)
-					return err;
-			}
-
-			/* none of our file systems felt responsible for the path */
-			return STAT_ERR_NO_ENTRY;
+			/* unless changed, none of our file systems felt responsible */
+			return result;
 		}
 
 		file_size num_dirent(char const *path) override
 		{
+			if (Dir_file_system *dir = _cached_lookup(path))
+				return dir->num_dirent(path);
+
 			if (_vfs_root) {
 				return _sum_dirents_of_file_systems(path);
 
@@ -515,6 +883,9 @@ class Vfs::Dir_file_system : public File_system
 		 */
 		bool directory(char const *path) override
 		{
+			if (Dir_file_system *dir = _cached_lookup(path))
+				return dir->directory(path);
+
 			if (_top_dir(path))
 				return true;
 
@@ -526,11 +897,13 @@ class Vfs::Dir_file_system : public File_system
 			if (strlen(path) == 0)
 				return true;
 
-			for (File_system *fs = _first_file_system; fs; fs = fs->next)
-				if (fs->directory(path))
-					return true;
+			bool result = false;
+			_for_each_candidate(path, [&] (File_system &fs) {
+				result = fs.directory(path);
+				return result;
+			});
 
-			return false;
+			return result;
 		}
 
 		/**
@@ -543,6 +916,9 @@ class Vfs::Dir_file_system : public File_system
 
 		char const *leaf_path(char const *path) override
 		{
+			if (Dir_file_system *dir = _cached_lookup(path))
+				return dir->leaf_path(path);
+
 			path = _sub_path(path);
 			if (!path)
 				return 0;
@@ -550,13 +926,13 @@ class Vfs::Dir_file_system : public File_system
 			if (strlen(path) == 0)
 				return path;
 
-			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
-				char const *leaf_path = fs->leaf_path(path);
-				if (leaf_path)
-					return leaf_path;
-			}
+			char const *leaf_path = 0;
+			_for_each_candidate(path, [&] (File_system &fs) {
+				leaf_path = fs.leaf_path(path);
+				return leaf_path != 0;
+			});
 
-			return 0;
+			return leaf_path;
 		}
 
 		Open_result open(char const  *path,
@@ -564,6 +940,9 @@ class Vfs::Dir_file_system : public File_system
 		                 Vfs_handle **out_handle,
 		                 Allocator   &alloc) override
 		{
+			if (Dir_file_system *dir = _cached_lookup(path))
+				return dir->open(path, mode, out_handle, alloc);
+
 			/*
 			 * If 'path' is a directory, we create a 'Vfs_handle'
 			 * for the root directory so that subsequent 'dirent' calls
@@ -601,19 +980,14 @@ class Vfs::Dir_file_system : public File_system
 			}
 
 			/* path refers to any of our sub file systems */
-			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
+			Open_result result = OPEN_ERR_UNACCESSIBLE;
+			_for_each_candidate(path, [&] (File_system &fs) {
+				result = fs.open(path, mode, out_handle, alloc);
+				return result != OPEN_ERR_UNACCESSIBLE;
+			});
 
-				Open_result const err = fs->open(path, mode, out_handle, alloc);
-				switch (err) {
-				case OPEN_ERR_UNACCESSIBLE:
-					continue;
-				default:
-					return err;
-				}
-			}
-
-			/* path does not match any existing file or directory */
-			return OPEN_ERR_UNACCESSIBLE;
+			/* unless changed, path does not match any existing file or directory */
+			return result;
 		}
 
 		/**
@@ -625,10 +999,10 @@ class Vfs::Dir_file_system : public File_system
 		{
 			Opendir_result res = OPENDIR_ERR_LOOKUP_FAILED;
 			try {
-				for (File_system *fs = _first_file_system; fs; fs = fs->next) {
+				_for_each_candidate(sub_path, [&] (File_system &fs) {
 					Vfs_handle *sub_dir_handle = nullptr;
 
-					Opendir_result r = fs->opendir(
+					Opendir_result r = fs.opendir(
 						sub_path, false, &sub_dir_handle, dir_vfs_handle.alloc());
 
 					switch (r) {
@@ -636,9 +1010,10 @@ class Vfs::Dir_file_system : public File_system
 						break;
 					case OPEN_ERR_OUT_OF_RAM:
 					case OPEN_ERR_OUT_OF_CAPS:
-						return r;
+						res = r;
+						return true;
 					default:
-						continue;
+						return false;
 					}
 
 					new (dir_vfs_handle.alloc())
@@ -646,7 +1021,8 @@ class Vfs::Dir_file_system : public File_system
 							dir_vfs_handle.subdir_handle_registry, *sub_dir_handle);
 					/* return OK because at least one directory has been opened */
 					res = OPENDIR_OK;
-				}
+					return false;
+				});
 			}
 			catch (Genode::Out_of_ram)  { res = OPENDIR_ERR_OUT_OF_RAM; }
 			catch (Genode::Out_of_caps) { res = OPENDIR_ERR_OUT_OF_CAPS; }
@@ -742,6 +1118,9 @@ class Vfs::Dir_file_system : public File_system
 		                         Vfs_handle **out_handle,
 		                         Allocator &alloc) override
 		{
+			if (Dir_file_system *dir = _cached_lookup(path))
+				return dir->openlink(path, create, out_handle, alloc);
+
 			auto openlink_fn = [&] (File_system &fs, char const *path)
 			{
 				return fs.openlink(path, create, out_handle, alloc);
@@ -769,10 +1148,10 @@ class Vfs::Dir_file_system : public File_system
 			char const *sub_path = _sub_path(path);
 			if (!sub_path) return res;
 
-			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
+			_for_each_candidate(sub_path, [&] (File_system &fs) {
 				Vfs_watch_handle *sub_handle;
 
-				if (fs->watch(sub_path, &sub_handle, alloc) == WATCH_OK) {
+				if (fs.watch(sub_path, &sub_handle, alloc) == WATCH_OK) {
 					if (meta_handle == nullptr) {
 						/* at least one non-static FS, allocate handle */
 						meta_handle = new (alloc) Dir_watch_handle(*this, alloc);
@@ -785,7 +1164,8 @@ class Vfs::Dir_file_system : public File_system
 						Dir_watch_handle::Watch_handle_element(
 							meta_handle->handle_registry, *sub_handle);
 				}
-			}
+				return false;
+			});
 
 			return res;
 		}
@@ -798,6 +1178,9 @@ class Vfs::Dir_file_system : public File_system
 
 		Unlink_result unlink(char const *path) override
 		{
+			if (Dir_file_system *dir = _cached_lookup(path))
+				return dir->unlink(path);
+
 			auto unlink_fn = [] (File_system &fs, char const *path)
 			{
 				return fs.unlink(path);
@@ -830,14 +1213,15 @@ class Vfs::Dir_file_system : public File_system
 				return RENAME_ERR_CROSS_FS;
 
 			Rename_result final = RENAME_ERR_NO_ENTRY;
-			for (File_system *fs = _first_file_system; fs; fs = fs->next) {
-				switch (fs->rename(from_path, to_path)) {
-				case RENAME_OK:           return RENAME_OK;
-				case RENAME_ERR_NO_ENTRY: continue;
-				case RENAME_ERR_NO_PERM:  return RENAME_ERR_NO_PERM;
+			_for_each_candidate(from_path, [&] (File_system &fs) {
+				switch (fs.rename(from_path, to_path)) {
+				case RENAME_OK:           final = RENAME_OK;          return true;
+				case RENAME_ERR_NO_ENTRY:                             return false;
+				case RENAME_ERR_NO_PERM:  final = RENAME_ERR_NO_PERM; return true;
 				case RENAME_ERR_CROSS_FS: final = RENAME_ERR_CROSS_FS;
 				}
-			}
+				return false;
+			});
 			return final;
 		}
 
@@ -852,6 +1236,9 @@ class Vfs::Dir_file_system : public File_system
 		{
 			using namespace Genode;
 
+			if (_lookup_cache)
+				_lookup_cache->flush();
+
 			File_system *curr = _first_file_system;
 			for (unsigned i = 0; i < node.num_sub_nodes(); i++, curr = curr->next) {
 				Xml_node const &sub_node = node.sub_node(i);
@@ -948,6 +1335,13 @@ class Vfs::Dir_file_system : public File_system
 			return handle->fs().notify_read_ready(handle);
 		}
 
+		void drop_io_response(Vfs_handle::Context &context) override
+		{
+			/* the context may have been propagated to sub-handles */
+			for (File_system *fs = _first_file_system; fs; fs = fs->next)
+				fs->drop_io_response(context);
+		}
+
 		bool queue_sync(Vfs_handle *vfs_handle) override
 		{
 			bool result = true;
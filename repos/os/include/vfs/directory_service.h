@@ -30,6 +30,14 @@ struct Vfs::Directory_service : Interface
 	virtual Dataspace_capability dataspace(char const *path) = 0;
 	virtual void release(char const *path, Dataspace_capability) = 0;
 
+	/**
+	 * Return true if 'dataspace' hands out existing memory of the file
+	 *
+	 * Plugins returning false allocate a copy of the file content from the
+	 * RAM of the component for each 'dataspace' call.
+	 */
+	virtual bool dataspace_shared(char const *) { return false; }
+
 
 	enum General_error { ERR_FD_INVALID, NUM_GENERAL_ERRORS };
 
@@ -22,6 +22,7 @@ namespace Vfs {
 	class Vfs_handle;
 	struct Io_response_handler;
 	struct Watch_response_handler;
+	struct Io_batch;
 	struct File_io_service;
 }
 
@@ -37,6 +38,144 @@ struct Vfs::Watch_response_handler : Interface
 	virtual void handle_watch_response(Vfs_watch_handle::Context*) = 0;
 };
 
+/**
+ * Batch of read and write requests, possibly targeting different handles
+ *
+ * All requests of a batch are handed to the plugins at once via 'submit'.
+ * A plugin completes a request either right away or asynchronously. In the
+ * latter case, the I/O response handler is called with the batch 'context'
+ * once the last outstanding request of the batch got completed. Hence, a
+ * batch causes at most one wakeup.
+ *
+ * The batch and its requests must stay valid until all submitted requests
+ * are complete.
+ */
+struct Vfs::Io_batch
+{
+	/**
+	 * Buffer of a vectored request
+	 *
+	 * The content of the buffer is only read for write requests.
+	 */
+	struct Vector
+	{
+		char     *base;
+		file_size size;
+	};
+
+	struct Request : List<Request>::Element
+	{
+		enum Opcode { READ, WRITE };
+		enum State  { NEW, SUBMITTED, COMPLETE };
+
+		Vfs_handle   *handle       = nullptr;
+		Opcode        opcode       = READ;
+		file_size     offset       = 0;     /* absolute file offset */
+		Vector const *vectors      = nullptr;
+		unsigned      vector_count = 0;
+
+		/*
+		 * Result of the request
+		 */
+		State     state     = NEW;
+		bool      succeeded = false;
+		file_size count     = 0;   /* number of bytes transferred */
+
+		/*
+		 * Bookkeeping of the plugin processing the request
+		 */
+		Io_batch      *batch = nullptr;
+		Genode::addr_t tag   = 0;
+
+		/**
+		 * Return total size of the request's buffers
+		 */
+		file_size size() const
+		{
+			file_size size = 0;
+			for (unsigned i = 0; i < vector_count; i++)
+				size += vectors[i].size;
+			return size;
+		}
+
+		/**
+		 * Copy 'len' bytes from 'src' into the request's buffers
+		 */
+		void scatter(char const *src, file_size len) const
+		{
+			for (unsigned i = 0; i < vector_count && len; i++) {
+				file_size const n = min(len, vectors[i].size);
+				memcpy(vectors[i].base, src, n);
+				src += n; len -= n;
+			}
+		}
+
+		/**
+		 * Copy 'len' bytes from the request's buffers to 'dst'
+		 */
+		void gather(char *dst, file_size len) const
+		{
+			for (unsigned i = 0; i < vector_count && len; i++) {
+				file_size const n = min(len, vectors[i].size);
+				memcpy(dst, vectors[i].base, n);
+				dst += n; len -= n;
+			}
+		}
+	};
+
+	Request             *const requests;
+	unsigned             const count;
+	Vfs_handle::Context *const context;
+
+	private:
+
+		unsigned _outstanding = 0;
+		bool     _submitting  = false;
+
+	public:
+
+		Io_batch(Request *requests, unsigned count,
+		         Vfs_handle::Context *context)
+		: requests(requests), count(count), context(context) { }
+
+		/**
+		 * Submit all requests that are not submitted yet
+		 *
+		 * \return number of requests rejected by the plugins because of
+		 *         congestion, these must be submitted again after the
+		 *         next I/O response
+		 */
+		inline unsigned submit();
+
+		/**
+		 * Return true if all requests of the batch are complete
+		 */
+		bool complete() const
+		{
+			for (unsigned i = 0; i < count; i++)
+				if (requests[i].state != Request::COMPLETE)
+					return false;
+			return true;
+		}
+
+		/**
+		 * Complete request, called by the plugin processing it
+		 *
+		 * \return true if the plugin must call the I/O response handler
+		 *         with the batch context, i.e., if this was the last
+		 *         outstanding request completed asynchronously
+		 */
+		bool complete(Request &request, bool succeeded, file_size count)
+		{
+			request.succeeded = succeeded;
+			request.count     = count;
+			request.state     = Request::COMPLETE;
+
+			return --_outstanding == 0 && !_submitting;
+		}
+};
+
+
 struct Vfs::File_io_service : Interface
 {
 	enum General_error { ERR_FD_INVALID, NUM_GENERAL_ERRORS };
@@ -99,6 +238,14 @@ struct Vfs::File_io_service : Interface
 	 */
 	virtual bool notify_read_ready(Vfs_handle *) { return true; }
 
+	/**
+	 * Discard the pending I/O response for 'context'
+	 *
+	 * Must be called before destroying a context that was attached to a
+	 * handle of the file system.
+	 */
+	virtual void drop_io_response(Vfs_handle::Context &) { }
+
 
 	/***************
 	 ** Ftruncate **
@@ -181,6 +328,106 @@ struct Vfs::File_io_service : Interface
 	virtual bool queue_sync(Vfs_handle *) { return true; }
 
 	virtual Sync_result complete_sync(Vfs_handle *) { return SYNC_OK; }
+
+
+	/***********
+	 ** Batch **
+	 ***********/
+
+	/**
+	 * Submit request of an I/O batch
+	 *
+	 * The request is completed via 'Io_batch::complete', either before
+	 * returning or asynchronously. The default implementation processes the
+	 * request synchronously by using 'write' and 'queue_read'/'complete_read'
+	 * while preserving the seek offset of the handle.
+	 *
+	 * \return false if the request cannot be accepted right now
+	 */
+	virtual bool submit(Io_batch &batch, Io_batch::Request &request)
+	{
+		Vfs_handle &handle = *request.handle;
+		bool const  write  = request.opcode == Io_batch::Request::WRITE;
+
+		file_size const seek  = handle.seek();
+		file_size       count = 0;
+		bool            ok    = true;
+		bool            again = false;
+
+		for (unsigned i = 0; i < request.vector_count && ok; i++) {
+
+			Io_batch::Vector const &v = request.vectors[i];
+			file_size done = 0;
+
+			while (done < v.size) {
+
+				file_size n = 0;
+				handle.seek(request.offset + count);
+
+				if (write) {
+					Write_result res = WRITE_ERR_IO;
+					try { res = this->write(&handle, v.base + done, v.size - done, n); }
+					catch (Insufficient_buffer) { res = WRITE_ERR_AGAIN; }
+
+					again = (res == WRITE_ERR_AGAIN || res == WRITE_ERR_WOULD_BLOCK);
+					ok    = (res == WRITE_OK);
+				} else {
+					Read_result res = READ_ERR_AGAIN;
+					if (queue_read(&handle, v.size - done))
+						res = complete_read(&handle, v.base + done, v.size - done, n);
+
+					again = (res == READ_ERR_AGAIN || res == READ_ERR_WOULD_BLOCK
+					      || res == READ_QUEUED);
+					ok    = (res == READ_OK);
+				}
+
+				done  += n;
+				count += n;
+
+				/* short transfer or end of file */
+				if (!ok || n == 0) break;
+			}
+
+			if (done < v.size) break;
+		}
+
+		handle.seek(seek);
+
+		/* retry later if nothing was transferred yet */
+		if (again && count == 0)
+			return false;
+
+		batch.complete(request, ok || count > 0, count);
+		return true;
+	}
 };
 
+
+unsigned Vfs::Io_batch::submit()
+{
+	unsigned rejected = 0;
+
+	_submitting = true;
+
+	for (unsigned i = 0; i < count; i++) {
+
+		Request &r = requests[i];
+		if (r.state != Request::NEW)
+			continue;
+
+		r.batch = this;
+		r.state = Request::SUBMITTED;
+		_outstanding++;
+
+		if (!r.handle->fs().submit(*this, r)) {
+			r.state = Request::NEW;
+			_outstanding--;
+			rejected++;
+		}
+	}
+
+	_submitting = false;
+	return rejected;
+}
+
 #endif /* _INCLUDE__VFS__FILE_IO_SERVICE_H_ */
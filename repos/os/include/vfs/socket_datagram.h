@@ -0,0 +1,64 @@
+/*
+ * \brief  Record format of the 'datagrams' file of socket file systems
+ * \author Genode Labs
+ * \date   2018-03-29
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__VFS__SOCKET_DATAGRAM_H_
+#define _INCLUDE__VFS__SOCKET_DATAGRAM_H_
+
+#include <base/stdint.h>
+#include <util/misc_math.h>
+
+namespace Vfs { struct Socket_datagram; }
+
+
+/**
+ * Header of a datagram record
+ *
+ * The 'datagrams' file of a datagram socket transfers a batch of datagrams
+ * with a single read or write operation. The content consists of a
+ * sequence of records, each made of the header followed by the payload
+ * and padded to 'ALIGN' bytes.
+ *
+ * A read returns as many received datagrams as fit into the buffer but at
+ * least one. If the first datagram exceeds the buffer, its payload is
+ * truncated and the 'TRUNCATED' flag is set. The header carries the
+ * address of the sender.
+ *
+ * A write sends each datagram to the address given in its header and
+ * returns the number of bytes of completely sent records.
+ */
+struct Vfs::Socket_datagram
+{
+	enum { ALIGN = 4 };
+
+	enum Flags { TRUNCATED = 1 };
+
+	Genode::uint32_t length;   /* size of payload in bytes */
+	Genode::uint8_t  addr[4];  /* IPv4 address of the remote peer */
+	Genode::uint16_t port;     /* port of the remote peer in host byte order */
+	Genode::uint16_t flags;
+
+	/**
+	 * Return size of record with 'length' bytes of payload
+	 */
+	static Genode::size_t record_size(Genode::size_t length)
+	{
+		return Genode::align_addr(sizeof(Socket_datagram) + length,
+		                          Genode::log2((unsigned)ALIGN));
+	}
+
+	char       *payload()       { return (char *)(this + 1); }
+	char const *payload() const { return (char const *)(this + 1); }
+
+} __attribute__((packed));
+
+#endif /* _INCLUDE__VFS__SOCKET_DATAGRAM_H_ */
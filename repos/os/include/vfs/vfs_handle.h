@@ -44,8 +44,16 @@ class Vfs::Vfs_handle
 
 		/**
 		 * Opaque handle context
+		 *
+		 * The tag lets the user of contexts check the type of a context
+		 * delivered with an I/O response before downcasting it.
 		 */
-		struct Context : List<Context>::Element { };
+		struct Context : List<Context>::Element
+		{
+			unsigned const tag;
+
+			Context(unsigned tag = 0) : tag(tag) { }
+		};
 
 		Context *context = nullptr;
 
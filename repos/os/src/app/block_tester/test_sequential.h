@@ -24,9 +24,183 @@ namespace Test {
  *
  * This test reads or writes the given number of blocks from the
  * specified start block sequentially in sized requests.
+ *
+ * If more than one queue is requested, the blocks are split into
+ * consecutive regions, one per queue. Queue 0 is driven by the component's
+ * entrypoint whereas each additional queue is driven by an entrypoint of
+ * its own.
  */
 struct Test::Sequential : Test_base
 {
+	/*
+	 * Stream of requests of one queue of the block session
+	 */
+	struct Stream
+	{
+		Sequential                 &_test;
+		Block::Session::Tx::Source &_source;
+
+		Block::sector_t _start;
+		size_t    const _length_in_blocks;
+
+		size_t   _blocks     { 0 };
+		size_t   _ack_blocks { 0 };
+		size_t   _bytes      { 0 };
+		uint64_t _rx         { 0 };
+		uint64_t _tx         { 0 };
+		bool     _failed     { false };
+		bool     _done       { false };
+
+		Genode::Signal_transmitter _done_transmitter;
+
+		Stream(Sequential &test, Block::Session::Tx::Source &source,
+		       Block::sector_t start, size_t length_in_blocks,
+		       Genode::Signal_context_capability done_sigh)
+		:
+			_test(test), _source(source), _start(start),
+			_length_in_blocks(length_in_blocks), _done_transmitter(done_sigh)
+		{ }
+
+		void _complete(bool failed)
+		{
+			_failed = failed;
+			_done   = true;
+			_done_transmitter.submit();
+		}
+
+		void submit()
+		{
+			try {
+				bool next = true;
+				while (_blocks < _length_in_blocks && _source.ready_to_submit() && next) {
+
+					Block::Packet_descriptor tmp =
+						_source.alloc_packet(_test._size);
+
+					Block::Packet_descriptor p(tmp,
+						_test._op, _start, _test._size_in_blocks);
+
+					bool const write = _test._op == Block::Packet_descriptor::WRITE;
+
+					/* simulate write */
+					if (write) {
+						char * const content = _source.packet_content(p);
+						Genode::memcpy(content, _test._scratch_buffer, p.size());
+					}
+
+					try         { _source.submit_packet(p); }
+					catch (...) { _source.release_packet(p); }
+
+					if (_test._verbose) {
+						Genode::log("submit: lba:", _start, " size:", _test._size,
+						            " ", write ? "tx" : "rx");
+					}
+
+					_start  += _test._size_in_blocks;
+					_blocks += _test._size_in_blocks;
+
+					/* wrap if needed */
+					if (_start >= _test._block_count) { _start = 0; }
+
+					next = !_test._synchronous;
+				}
+			} catch (...) { }
+		}
+
+		void ack()
+		{
+			if (_done) { return; }
+
+			while (_source.ack_avail()) {
+
+				Block::Packet_descriptor p = _source.get_acked_packet();
+
+				if (!p.succeeded()) {
+					Genode::error("processing ", p.block_number(), " ",
+					              p.block_count(), " failed");
+
+					_source.release_packet(p);
+					_complete(true);
+					return;
+				}
+
+				bool const read = _test._op == Block::Packet_descriptor::READ;
+
+				/* simulate read */
+				if (read) {
+					char * const content = _source.packet_content(p);
+					Genode::memcpy(_test._scratch_buffer, content, p.size());
+				}
+
+				size_t                           const psize = p.size();
+				size_t                           const count = psize / _test._block_size;
+				Block::Packet_descriptor::Opcode const op    = p.operation();
+
+				_rx += (op == Block::Packet_descriptor::READ)  * count;
+				_tx += (op == Block::Packet_descriptor::WRITE) * count;
+
+				_bytes      += psize;
+				_ack_blocks += count;
+
+				if (_test._verbose) {
+					Genode::log("ack: lba:", p.block_number(), " size:", p.size(),
+					            " ", read ? "rx" : "tx");
+				}
+
+				_source.release_packet(p);
+			}
+
+			if (_ack_blocks >= _length_in_blocks) {
+				_complete(false);
+				return;
+			}
+
+			submit();
+		}
+	};
+
+	/*
+	 * Additional queue driven by an entrypoint of its own
+	 */
+	struct Queue
+	{
+		enum { STACK_SIZE = 4*1024*sizeof(long) };
+
+		Genode::Entrypoint    _ep;
+		Genode::Allocator_avl _block_alloc;
+		Block::Queue_client   _client;
+		Stream                _stream;
+
+		Genode::Signal_handler<Queue> _ack_sigh {
+			_ep, *this, &Queue::_handle_ack };
+
+		Genode::Signal_handler<Queue> _submit_sigh {
+			_ep, *this, &Queue::_handle_submit };
+
+		/* kick off the stream from within the entrypoint of the queue */
+		Genode::Signal_handler<Queue> _start_sigh {
+			_ep, *this, &Queue::_handle_submit };
+
+		void _handle_ack()    { _stream.ack(); }
+		void _handle_submit() { _stream.submit(); }
+
+		Queue(Genode::Env &env, Genode::Allocator &alloc, Sequential &test,
+		      Genode::Capability<Block::Session::Tx> cap,
+		      Block::sector_t start, size_t length_in_blocks,
+		      Genode::Signal_context_capability done_sigh)
+		:
+			_ep(env, STACK_SIZE, "block_tester_queue"),
+			_block_alloc(&alloc),
+			_client(cap, env.rm(), _block_alloc),
+			_stream(test, *_client.source(), start, length_in_blocks, done_sigh)
+		{
+			_client.sigh_ack_avail(_ack_sigh);
+			_client.sigh_ready_to_submit(_submit_sigh);
+		}
+
+		void start() { Genode::Signal_transmitter(_start_sigh).submit(); }
+	};
+
 	Genode::Env       &_env;
 	Genode::Allocator &_alloc;
 
@@ -34,6 +208,7 @@ struct Test::Sequential : Test_base
 	Block::sector_t _start  { 0 };
 	size_t          _length { 0 };
 	size_t          _size   { 0 };
+	unsigned        _queues { 1 };
 
 	/* _synchronous controls bulk */
 	bool _synchronous { false };
@@ -49,105 +224,63 @@ struct Test::Sequential : Test_base
 	Genode::Constructible<Timer::Connection> _timer { };
 
 	/* test data */
-	size_t _blocks     { 0 };
-	size_t _ack_blocks { 0 };
 	char   _scratch_buffer[1u<<20] { };
 
-	Genode::Constructible<Timer::Periodic_timeout<Sequential>> _progress_timeout { };
+	Genode::Constructible<Stream> _stream { };
+	Genode::Constructible<Queue>  _queue[Block::Session::MAX_QUEUES - 1];
 
-	void _handle_progress_timeout(Genode::Duration)
+	template <typename FN>
+	void _for_each_stream(FN const &fn)
 	{
-		Genode::log("progress: rx:", _rx, " tx:", _tx);
-	}
+		if (_stream.constructed())
+			fn(*_stream);
 
-	void _handle_submit()
-	{
-		try {
-			bool next = true;
-			while (_blocks < _length_in_blocks && _block->tx()->ready_to_submit() && next) {
-
-				Block::Packet_descriptor tmp =
-					_block->tx()->alloc_packet(_size);
-
-				Block::Packet_descriptor p(tmp,
-					_op, _start, _size_in_blocks);
-
-				bool const write = _op == Block::Packet_descriptor::WRITE;
-
-				/* simulate write */
-				if (write) {
-					char * const content = _block->tx()->packet_content(p);
-					Genode::memcpy(content, _scratch_buffer, p.size());
-				}
-
-				try         { _block->tx()->submit_packet(p); }
-				catch (...) { _block->tx()->release_packet(p); }
-
-				if (_verbose) {
-					Genode::log("submit: lba:", _start, " size:", _size,
-					            " ", write ? "tx" : "rx");
-				}
-
-				_start  += _size_in_blocks;
-				_blocks += _size_in_blocks;
+		for (unsigned i = 0; i + 1 < _queues; i++)
+			if (_queue[i].constructed())
+				fn(_queue[i]->_stream);
+	}
 
-				/* wrap if needed */
-				if (_start >= _block_count) { _start = 0; }
+	Genode::Constructible<Timer::Periodic_timeout<Sequential>> _progress_timeout { };
 
-				next = !_synchronous;
-			}
-		} catch (...) { }
+	void _handle_progress_timeout(Genode::Duration)
+	{
+		Genode::log("progress: rx:", _stream->_rx, " tx:", _stream->_tx);
 	}
 
+	void _handle_submit() { _stream->submit(); }
+
 	void _handle_ack()
 	{
 		if (_finished) { return; }
 
-		while (_block->tx()->ack_avail()) {
-
-			Block::Packet_descriptor p = _block->tx()->get_acked_packet();
-
-			if (!p.succeeded()) {
-				Genode::error("processing ", p.block_number(), " ",
-				              p.block_count(), " failed");
-
-				if (_stop_on_error) { throw Test_failed(); }
-				else                { _finish(); break; }
-			}
-
-			bool const read = _op == Block::Packet_descriptor::READ;
-
-			/* simulate read */
-			if (read) {
-				char * const content = _block->tx()->packet_content(p);
-				Genode::memcpy(_scratch_buffer, content, p.size());
-			}
-
-			size_t                           const psize = p.size();
-			size_t                           const count = psize / _block_size;
-			Block::Packet_descriptor::Opcode const op    = p.operation();
+		_stream->ack();
+	}
 
-			_rx += (op == Block::Packet_descriptor::READ)  * count;
-			_tx += (op == Block::Packet_descriptor::WRITE) * count;
+	/**
+	 * Called whenever a stream is completed
+	 */
+	void _handle_stream_done()
+	{
+		if (_finished) { return; }
 
-			_bytes      += psize;
-			_ack_blocks += count;
+		bool done = true, failed = false;
+		_for_each_stream([&] (Stream const &stream) {
+			done   &= stream._done;
+			failed |= stream._failed; });
 
-			if (_verbose) {
-				Genode::log("ack: lba:", p.block_number(), " size:", p.size(),
-				            " ", read ? "rx" : "tx");
-			}
+		if (failed && _stop_on_error) { throw Test_failed(); }
 
-			_block->tx()->release_packet(p);
-		}
+		if (!done && !failed) { return; }
 
-		if (_bytes >= _length || _ack_blocks == _length_in_blocks) {
-			_success = true;
-			_finish();
-			return;
-		}
+		/* the counters of all streams are stable now */
+		_bytes = 0; _rx = 0; _tx = 0;
+		_for_each_stream([&] (Stream const &stream) {
+			_bytes += stream._bytes;
+			_rx    += stream._rx;
+			_tx    += stream._tx; });
 
-		_handle_submit();
+		_success = !failed;
+		_finish();
 	}
 
 	void _finish()
@@ -163,6 +296,9 @@ struct Test::Sequential : Test_base
 	Genode::Signal_handler<Sequential> _submit_sigh {
 		_env.ep(), *this, &Sequential::_handle_submit };
 
+	Genode::Signal_handler<Sequential> _stream_done_sigh {
+		_env.ep(), *this, &Sequential::_handle_stream_done };
+
 	Genode::Xml_node _node;
 
 	/**
@@ -187,13 +323,19 @@ struct Test::Sequential : Test_base
 	{
 		_stop_on_error = stop_on_error;
 
-		_block.construct(_env, &_block_alloc, TX_BUF_SIZE);
+		_queues = Genode::max(1U, Genode::min(_node.attribute_value("queues", 1U),
+		                                      (unsigned)Block::Session::MAX_QUEUES));
+
+		_block.construct(_env, &_block_alloc, TX_BUF_SIZE, "", _queues);
 
 		_block->tx_channel()->sigh_ack_avail(_ack_sigh);
 		_block->tx_channel()->sigh_ready_to_submit(_submit_sigh);
 
 		_block->info(&_block_count, &_block_size, &_block_ops);
 
+		/* the server may grant fewer queues than requested */
+		_queues = Genode::max(1U, _block->queues());
+
 		_synchronous = _node.attribute_value("synchronous", false);
 
 		_start = _node.attribute_value("start", 0u);
@@ -223,6 +365,19 @@ struct Test::Sequential : Test_base
 		_size_in_blocks   = _size   / _block_size;
 		_length_in_blocks = _length / _block_size;
 
+		/* split the blocks into request-aligned regions, one per queue */
+		size_t const requests   = _length_in_blocks / _size_in_blocks;
+		size_t const per_queue  = (requests / _queues) * _size_in_blocks;
+		size_t const first_part = _length_in_blocks - per_queue*(_queues - 1);
+
+		_stream.construct(*this, *_block->tx(), _start, first_part,
+		                  _stream_done_sigh);
+
+		for (unsigned i = 1; i < _queues; i++)
+			_queue[i - 1].construct(_env, _alloc, *this, _block->queue_cap(i),
+			                        _start + first_part + per_queue*(i - 1),
+			                        per_queue, _stream_done_sigh);
+
 		_timer.construct(_env);
 
 		uint64_t const progress_interval = _node.attribute_value("progress", 0ul);
@@ -233,12 +388,21 @@ struct Test::Sequential : Test_base
 		}
 
 		_start_time = _timer->elapsed_ms();
-		_handle_submit();
+
+		for (unsigned i = 1; i < _queues; i++)
+			_queue[i - 1]->start();
+
+		_stream->submit();
 	}
 
 	Result finish() override
 	{
 		_timer.destruct();
+
+		for (unsigned i = 1; i < _queues; i++)
+			_queue[i - 1].destruct();
+
+		_stream.destruct();
 		_block.destruct();
 
 		return Result(_success, _end_time - _start_time,
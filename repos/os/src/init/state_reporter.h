@@ -110,6 +110,9 @@ class Init::State_reporter : public Report_update_trigger
 				if (buffer_size != _buffer_size || !_reporter.constructed()) {
 					_buffer_size = buffer_size;
 					_reporter.construct(_env, "state", "state", _buffer_size);
+
+					/* spare the consumers from unchanged reports */
+					_reporter->submit_policy(Reporter::Submit::DELTA);
 				}
 
 				_report_detail.construct(report);
@@ -18,21 +18,75 @@ using namespace Net;
 using namespace Genode;
 
 
+/*
+ * Vector of four 32-bit words
+ *
+ * With the vector extension of the compiler, the block loop below is
+ * translated to SSE2 or NEON instructions if the target supports them and
+ * to plain integer instructions otherwise. The reduced alignment permits
+ * loads from 32-bit aligned addresses.
+ */
+typedef uint32_t Vector_4x32 __attribute__((vector_size(16), aligned(4)));
+
+
+/**
+ * Add up 16-byte blocks of 32-bit aligned data
+ *
+ * The one's complement sum of a 32-bit word equals the sum of its two
+ * 16-bit halves (RFC 1071), so each vector lane accumulates the halves of
+ * its words. The lanes are drained before they can overflow.
+ *
+ * \param addr  data pointer, advanced by the consumed bytes
+ * \param size  size of data in bytes, decreased by the consumed bytes
+ */
+static uint64_t add_up_blocks(uint32_t const *&addr, size_t &size)
+{
+	enum { BLOCK_SIZE = sizeof(Vector_4x32), MAX_BLOCKS_PER_ROUND = 1 << 15 };
+
+	uint64_t sum = 0;
+	while (size >= BLOCK_SIZE) {
+
+		Vector_4x32 acc = { 0, 0, 0, 0 };
+		for (unsigned i = 0; i < MAX_BLOCKS_PER_ROUND && size >= BLOCK_SIZE;
+		     i++, size -= BLOCK_SIZE, addr += 4)
+		{
+			Vector_4x32 const data = *(Vector_4x32 const *)addr;
+			acc += (data & 0xffff) + (data >> 16);
+		}
+		sum += (uint64_t)acc[0] + acc[1] + acc[2] + acc[3];
+	}
+	return sum;
+}
+
+
 uint16_t Net::internet_checksum(uint16_t const *addr,
                                 size_t          size,
                                 addr_t          init_sum)
 {
-	/* add up bytes in pairs */
-	addr_t sum = init_sum;
-	for (; size > 1; size -= 2)
-		sum += *addr++;
+	uint64_t sum = init_sum;
 
-	/* add left-over byte, if any */
+	/* add up leading 16-bit word to reach 32-bit alignment */
+	if (((addr_t)addr & 2) && size > 1) {
+		sum  += *addr++;
+		size -= 2;
+	}
+	/* add up bulk of the data and the remaining 32-bit words */
+	uint32_t const *addr_32 = (uint32_t const *)addr;
+	sum += add_up_blocks(addr_32, size);
+	for (; size > 3; size -= 4)
+		sum += *addr_32++;
+
+	/* add up remaining 16-bit word and left-over byte, if any */
+	addr = (uint16_t const *)addr_32;
+	if (size > 1) {
+		sum  += *addr++;
+		size -= 2;
+	}
 	if (size > 0)
 		sum += *(uint8_t *)addr;
 
 	/* fold sum to 16-bit value */
-	while (addr_t const sum_rsh = sum >> 16)
+	while (uint64_t const sum_rsh = sum >> 16)
 		sum = (sum & 0xffff) + sum_rsh;
 
 	/* return one's complement */
@@ -62,3 +116,36 @@ uint16_t Net::internet_checksum_pseudo_ip(uint16_t        const *ip_data,
 	/* add up IP data bytes */
 	return internet_checksum(ip_data, ip_data_sz, sum);
 }
+
+
+/****************************
+ ** Internet_checksum_diff **
+ ****************************/
+
+void Internet_checksum_diff::add_up_diff(Ipv4_address const &old_ip,
+                                         Ipv4_address const &new_ip)
+{
+	for (size_t i = 0; i < Ipv4_packet::ADDR_LEN; i += 2)
+		add_up_diff(*(uint16_t const *)&old_ip.addr[i],
+		            *(uint16_t const *)&new_ip.addr[i]);
+}
+
+
+void Internet_checksum_diff::add_up_diff(Port old_port, Port new_port)
+{
+	add_up_diff(host_to_big_endian(old_port.value),
+	            host_to_big_endian(new_port.value));
+}
+
+
+uint16_t Internet_checksum_diff::apply_to(uint16_t sum) const
+{
+	/* RFC 1624, equation 3: HC' = ~(~HC + ~m + m') */
+	addr_t result = (uint16_t)~sum + _value;
+
+	/* fold sum to 16-bit value */
+	while (addr_t const result_rsh = result >> 16)
+		result = (result & 0xffff) + result_rsh;
+
+	return ~result;
+}
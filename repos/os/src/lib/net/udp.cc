@@ -41,6 +41,18 @@ void Net::Udp_packet::update_checksum(Ipv4_address ip_src,
 }
 
 
+void Net::Udp_packet::update_checksum(Internet_checksum_diff const &icd)
+{
+	/* a checksum of zero means that the sender did not compute one */
+	if (!_checksum) {
+		return; }
+
+	_checksum = icd.apply_to(_checksum);
+	if (!_checksum) {
+		_checksum = 0xffff; }
+}
+
+
 bool Net::Udp_packet::checksum_error(Ipv4_address ip_src,
                                      Ipv4_address ip_dst) const
 {
@@ -0,0 +1,89 @@
+#include <util/string.h>
+#include <trace/policy.h>
+
+using namespace Genode;
+
+enum { MAX_EVENT_SIZE = 64 };
+
+/*
+ * The policy module is linked without the base library, hence we cannot
+ * use Genode's output facilities.
+ */
+static size_t append_string(char *dst, char const *s)
+{
+	size_t len = strlen(s);
+
+	memcpy(dst, (void*)s, len);
+	return len;
+}
+
+static size_t append_hex(char *dst, unsigned long value)
+{
+	size_t len = 0;
+	for (int shift = sizeof(value)*8 - 4; shift >= 0; shift -= 4)
+		dst[len++] = "0123456789abcdef"[(value >> shift) & 0xf];
+
+	return len;
+}
+
+static size_t append_decimal(char *dst, unsigned value)
+{
+	char   digits[10];
+	size_t num = 0;
+	do {
+		digits[num++] = '0' + value % 10;
+		value /= 10;
+	} while (value);
+
+	for (size_t i = 0; i < num; i++)
+		dst[i] = digits[num - 1 - i];
+
+	return num;
+}
+
+size_t max_event_size()
+{
+	return MAX_EVENT_SIZE;
+}
+
+size_t rpc_call(char *dst, char const *rpc_name, Msgbuf_base const &)
+{
+	return 0;
+}
+
+size_t rpc_returned(char *dst, char const *rpc_name, Msgbuf_base const &)
+{
+	return 0;
+}
+
+size_t rpc_dispatch(char *dst, char const *rpc_name)
+{
+	return 0;
+}
+
+size_t rpc_reply(char *dst, char const *rpc_name)
+{
+	return 0;
+}
+
+size_t signal_submit(char *dst, unsigned const)
+{
+	return 0;
+}
+
+size_t signal_receive(char *dst, Signal_context const &, unsigned)
+{
+	return 0;
+}
+
+size_t lock_contention(char *dst, void const *lock, unsigned spin_rounds)
+{
+	size_t len = 0;
+
+	len += append_string(dst + len, "lock 0x");
+	len += append_hex(dst + len, (unsigned long)lock);
+	len += append_string(dst + len, " blocked, spin rounds ");
+	len += append_decimal(dst + len, spin_rounds);
+
+	return len;
+}
@@ -0,0 +1,5 @@
+TARGET = lock_contention_policy
+
+TARGET_POLICY = lock_contention
+
+include $(PRG_DIR)/../policy.inc
@@ -37,3 +37,8 @@ size_t signal_receive(char *dst, Signal_context const &, unsigned)
 	return 0;
 }
 
+size_t lock_contention(char *dst, void const *, unsigned)
+{
+	return 0;
+}
+
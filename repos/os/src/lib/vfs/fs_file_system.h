@@ -54,6 +54,37 @@ class Vfs::Fs_file_system : public File_system
 		Handle_space _handle_space { };
 		Handle_space _watch_handle_space { };
 
+		/* batched requests in flight, tagged with their packet offset */
+		List<Io_batch::Request> _batch_requests { };
+
+		/*
+		 * Packets of batched requests whose handle got closed before the
+		 * acknowledgement arrived, to be released on acknowledgement
+		 */
+		struct Orphaned_packet : List<Orphaned_packet>::Element
+		{
+			Genode::addr_t const offset;
+
+			Orphaned_packet(Genode::addr_t offset) : offset(offset) { }
+		};
+
+		List<Orphaned_packet> _orphaned_packets { };
+
+		/**
+		 * Dataspace handed out by the server, valid while the file is open
+		 */
+		struct Mapped_file : List<Mapped_file>::Element
+		{
+			Dataspace_capability       const ds;
+			::File_system::File_handle const handle;
+
+			Mapped_file(Dataspace_capability ds,
+			            ::File_system::File_handle handle)
+			: ds(ds), handle(handle) { }
+		};
+
+		List<Mapped_file> _mapped_files { };
+
 		struct Handle_state
 		{
 			enum class Read_ready_state { IDLE, PENDING, READY };
@@ -163,6 +194,11 @@ class Vfs::Fs_file_system : public File_system
 			::File_system::File_handle file_handle() const
 			{ return ::File_system::File_handle { id().value }; }
 
+			/**
+			 * Return true if the handle's content maps 1:1 to packets
+			 */
+			virtual bool batchable() const { return false; }
+
 			virtual bool queue_read(file_size /* count */)
 			{
 				Genode::error("Fs_vfs_handle::queue_read() called");
@@ -236,6 +272,8 @@ class Vfs::Fs_file_system : public File_system
 		{
 			using Fs_vfs_handle::Fs_vfs_handle;
 
+			bool batchable() const override { return true; }
+
 			bool queue_read(file_size count) override
 			{
 				return _queue_read(count, seek());
@@ -252,15 +290,54 @@ class Vfs::Fs_file_system : public File_system
 		{
 			enum { DIRENT_SIZE = sizeof(::File_system::Directory_entry) };
 
-			using Fs_vfs_handle::Fs_vfs_handle;
+			/*
+			 * Directory entries are requested in batches because servers
+			 * may return several consecutive entries per packet. Servers
+			 * that return one entry at a time fill the first slot only.
+			 */
+			enum { BATCH = 16 };
+
+			::File_system::Directory_entry _entries[BATCH];
+
+			file_size _first_index  = 0; /* index of '_entries[0]' */
+			unsigned  _num_entries  = 0; /* valid entries in '_entries' */
+			file_size _queued_index = 0; /* first index of the read in flight */
+
+			Fs_vfs_dir_handle(File_system &fs, Allocator &alloc,
+			                  int status_flags, Handle_space &space,
+			                  ::File_system::Node_handle node_handle,
+			                  ::File_system::Connection &fs_connection,
+			                  Io_response_handler &io_handler)
+			:
+				Fs_vfs_handle(fs, alloc, status_flags, space, node_handle,
+				              fs_connection, io_handler),
+				_entries()
+			{ }
+
+			file_size _index() const { return seek() / sizeof(Dirent); }
+
+			bool _buffered(file_size index) const {
+				return index >= _first_index && index - _first_index < _num_entries; }
 
 			bool queue_read(file_size count) override
 			{
 				if (count < sizeof(Dirent))
 					return true;
 
-				return _queue_read(DIRENT_SIZE,
-				                   (seek() / sizeof(Dirent) * DIRENT_SIZE));
+				file_size const index = _index();
+
+				/* reading the first entry refetches the directory content */
+				if (index == 0)
+					_num_entries = 0;
+
+				if (_buffered(index))
+					return true;
+
+				if (!_queue_read(BATCH*DIRENT_SIZE, index*DIRENT_SIZE))
+					return false;
+
+				_queued_index = index;
+				return true;
 			}
 
 			Read_result complete_read(char *dst, file_size count,
@@ -271,24 +348,33 @@ class Vfs::Fs_file_system : public File_system
 
 				using ::File_system::Directory_entry;
 
-				Directory_entry entry;
-				file_size       entry_out_count;
+				file_size const index = _index();
+
+				if (!_buffered(index)) {
+
+					file_size entries_out_count = 0;
 
-				Read_result read_result =
-					_complete_read(&entry, DIRENT_SIZE, entry_out_count);
+					Read_result read_result =
+						_complete_read(_entries, sizeof(_entries), entries_out_count);
 
-				if (read_result != READ_OK)
-					return read_result;
+					if (read_result != READ_OK)
+						return read_result;
+
+					_first_index = _queued_index;
+					_num_entries = (unsigned)(entries_out_count / DIRENT_SIZE);
+				}
 
 				Dirent *dirent = (Dirent*)dst;
 
-				if (entry_out_count < DIRENT_SIZE) {
+				if (!_buffered(index)) {
 					/* no entry found for the given index, or error */
 					*dirent = Dirent();
 					out_count = sizeof(Dirent);
 					return READ_OK;
 				}
 
+				Directory_entry const &entry = _entries[index - _first_index];
+
 				/*
 				 * The default value has no meaning because the switch below
 				 * assigns a value in each possible branch. But it is needed to
@@ -415,6 +501,12 @@ class Vfs::Fs_file_system : public File_system
 				_ep.schedule_post_signal_hook(this);
 			}
 
+			void drop_io_event(Vfs_handle::Context &context)
+			{
+				Lock::Guard list_guard(_list_lock);
+				_context_list.remove(&context);
+			}
+
 			void arm_watch_event(Vfs_watch_handle::Context &context)
 			{
 				{
@@ -558,6 +650,89 @@ class Vfs::Fs_file_system : public File_system
 			return count;
 		}
 
+		/**
+		 * Look up and dequeue batched request of acknowledged packet
+		 */
+		Io_batch::Request *_batch_request(::File_system::Packet_descriptor const &packet)
+		{
+			Lock::Guard guard(_lock);
+
+			for (Io_batch::Request *r = _batch_requests.first(); r; r = r->next())
+				if (r->tag == (Genode::addr_t)packet.offset()) {
+					_batch_requests.remove(r);
+					return r;
+				}
+			return nullptr;
+		}
+
+		/**
+		 * Look up and dequeue orphaned packet, called with '_lock' held
+		 */
+		bool _orphaned(::File_system::Packet_descriptor const &packet)
+		{
+			for (Orphaned_packet *o = _orphaned_packets.first(); o; o = o->next())
+				if (o->offset == (Genode::addr_t)packet.offset()) {
+					_orphaned_packets.remove(o);
+					destroy(_env.alloc(), o);
+					return true;
+				}
+			return false;
+		}
+
+		/**
+		 * Complete batched requests of a handle that is about to be closed,
+		 * called with '_lock' held
+		 *
+		 * The packets of the requests are released once acknowledged.
+		 */
+		void _drop_batch_requests(Vfs_handle &handle)
+		{
+			for (Io_batch::Request *r = _batch_requests.first(); r; ) {
+
+				Io_batch::Request *next = r->next();
+
+				if (r->handle == &handle) {
+					_batch_requests.remove(r);
+
+					try {
+						_orphaned_packets.insert(new (_env.alloc())
+							Orphaned_packet(r->tag));
+					} catch (...) {
+						Genode::warning("leaking packet of closed VFS handle"); }
+
+					Io_batch &batch = *r->batch;
+					if (batch.complete(*r, false, 0))
+						_post_signal_hook.arm_io_event(batch.context);
+				}
+				r = next;
+			}
+		}
+
+		/**
+		 * Complete batched request with the acknowledged packet
+		 */
+		void _complete_batch_request(Io_batch::Request &request,
+		                             ::File_system::Packet_descriptor const &packet)
+		{
+			::File_system::Session::Tx::Source &source = *_fs.tx();
+			using ::File_system::Packet_descriptor;
+
+			if (packet.operation() == Packet_descriptor::READ && packet.succeeded())
+				request.scatter(source.packet_content(packet), packet.length());
+
+			Io_batch &batch = *request.batch;
+			if (batch.complete(request, packet.succeeded(), packet.length()))
+				_post_signal_hook.arm_io_event(batch.context);
+
+			{
+				Lock::Guard guard(_lock);
+				source.release_packet(packet);
+			}
+
+			/* notify anyone who might have failed on 'alloc_packet()' */
+			_post_signal_hook.arm_io_event(nullptr);
+		}
+
 		void _ready_to_submit()
 		{
 			/* notify anyone who might have failed on write() ready_to_submit */
@@ -573,6 +748,29 @@ class Vfs::Fs_file_system : public File_system
 
 				Packet_descriptor const packet = source.get_acked_packet();
 
+				if (packet.operation() == Packet_descriptor::READ
+				 || packet.operation() == Packet_descriptor::WRITE) {
+
+					if (Io_batch::Request *r = _batch_request(packet)) {
+						_complete_batch_request(*r, packet);
+						continue;
+					}
+
+					bool orphaned = false;
+					{
+						Lock::Guard guard(_lock);
+						orphaned = _orphaned(packet);
+						if (orphaned)
+							source.release_packet(packet);
+					}
+
+					if (orphaned) {
+						/* notify anyone who might have failed on 'alloc_packet()' */
+						_post_signal_hook.arm_io_event(nullptr);
+						continue;
+					}
+				}
+
 				Handle_space::Id const id(packet.handle());
 
 				try {
@@ -655,13 +853,78 @@ class Vfs::Fs_file_system : public File_system
 		 ** Directory-service interface **
 		 *********************************/
 
-		Dataspace_capability dataspace(char const *) override
+		/**
+		 * Obtain file content from the server without copying
+		 *
+		 * Only servers that expose their backing store support this, the
+		 * file content is never read via the packet stream here as this
+		 * cannot be implemented without blocking.
+		 */
+		Dataspace_capability dataspace(char const *path) override
 		{
-			/* cannot be implemented without blocking */
+			Lock::Guard guard(_lock);
+
+			Absolute_path dir_path(path);
+			dir_path.strip_last_element();
+
+			Absolute_path file_name(path);
+			file_name.keep_only_last_element();
+
+			try {
+				::File_system::Dir_handle dir = _fs.dir(dir_path.base(), false);
+				Fs_handle_guard dir_guard(*this, _fs, dir, _handle_space, _fs,
+				                          _env.io_handler());
+
+				::File_system::File_handle file =
+					_fs.file(dir, file_name.base() + 1,
+					         ::File_system::READ_ONLY, false);
+
+				Dataspace_capability ds;
+				try {
+					ds = _fs.dataspace(file);
+					if (ds.valid())
+						_mapped_files.insert(new (_env.alloc())
+						                     Mapped_file(ds, file));
+				} catch (...) {
+					/* also covers servers that lack the RPC function */
+					ds = Dataspace_capability();
+				}
+
+				/* keep the file open as long as the dataspace is in use */
+				if (!ds.valid())
+					_fs.close(file);
+
+				return ds;
+			}
+			catch (::File_system::Lookup_failed)     { }
+			catch (::File_system::Permission_denied) { }
+			catch (::File_system::Invalid_handle)    { }
+			catch (::File_system::Invalid_name)      { }
+			catch (::File_system::Name_too_long)     { }
+			catch (::File_system::Unavailable)       { }
+			catch (Genode::Out_of_ram)               { }
+			catch (Genode::Out_of_caps)              { }
+
 			return Dataspace_capability();
 		}
 
-		void release(char const *, Dataspace_capability) override { }
+		/* the dataspace is provided by the server, not copied locally */
+		bool dataspace_shared(char const *) override { return true; }
+
+		void release(char const *, Dataspace_capability ds) override
+		{
+			Lock::Guard guard(_lock);
+
+			for (Mapped_file *f = _mapped_files.first(); f; f = f->next()) {
+				if (!(f->ds == ds))
+					continue;
+
+				_fs.close(f->handle);
+				_mapped_files.remove(f);
+				destroy(_env.alloc(), f);
+				return;
+			}
+		}
 
 		Stat_result stat(char const *path, Stat &out) override
 		{
@@ -924,6 +1187,8 @@ class Vfs::Fs_file_system : public File_system
 
 			Fs_vfs_handle *fs_handle = static_cast<Fs_vfs_handle *>(vfs_handle);
 
+			_drop_batch_requests(*fs_handle);
+
 			_fs.close(fs_handle->file_handle());
 			destroy(fs_handle->alloc(), fs_handle);
 		}
@@ -1045,6 +1310,11 @@ class Vfs::Fs_file_system : public File_system
 			return true;
 		}
 
+		void drop_io_response(Vfs_handle::Context &context) override
+		{
+			_post_signal_hook.drop_io_event(context);
+		}
+
 		Ftruncate_result ftruncate(Vfs_handle *vfs_handle, file_size len) override
 		{
 			Fs_vfs_handle const *handle = static_cast<Fs_vfs_handle *>(vfs_handle);
@@ -1077,6 +1347,55 @@ class Vfs::Fs_file_system : public File_system
 
 			return handle->complete_sync();
 		}
+
+		/**
+		 * Map batched request directly onto one packet
+		 *
+		 * Requests exceeding the maximum packet size are shortened.
+		 */
+		bool submit(Io_batch &batch, Io_batch::Request &request) override
+		{
+			Lock::Guard guard(_lock);
+
+			Fs_vfs_handle &handle = static_cast<Fs_vfs_handle &>(*request.handle);
+
+			if (!handle.batchable()) {
+				batch.complete(request, false, 0);
+				return true;
+			}
+
+			::File_system::Session::Tx::Source &source = *_fs.tx();
+			using ::File_system::Packet_descriptor;
+
+			if (!source.ready_to_submit())
+				return false;
+
+			file_size const count = min(source.bulk_buffer_size() / 2,
+			                            request.size());
+
+			bool const write = request.opcode == Io_batch::Request::WRITE;
+
+			Packet_descriptor p;
+			try {
+				p = source.alloc_packet(count);
+			} catch (::File_system::Session::Tx::Source::Packet_alloc_failed) {
+				return false;
+			}
+
+			Packet_descriptor const
+				packet(p, handle.file_handle(),
+				       write ? Packet_descriptor::WRITE : Packet_descriptor::READ,
+				       count, request.offset);
+
+			if (write)
+				request.gather(source.packet_content(packet), count);
+
+			request.tag = (Genode::addr_t)packet.offset();
+			_batch_requests.insert(&request);
+
+			source.submit_packet(packet);
+			return true;
+		}
 };
 
 #endif /* _INCLUDE__VFS__FS_FILE_SYSTEM_H_ */
@@ -14,11 +14,14 @@
 #ifndef _INCLUDE__VFS__RAM_FILE_SYSTEM_H_
 #define _INCLUDE__VFS__RAM_FILE_SYSTEM_H_
 
-#include <ram_fs/chunk.h>
 #include <vfs/file_system.h>
 #include <dataspace/client.h>
+#include <base/heap.h>
+#include <os/reporter.h>
 #include <util/avl_tree.h>
 
+#include "ram_storage.h"
+
 namespace Vfs { class Ram_file_system; }
 
 namespace Vfs_ram {
@@ -235,49 +238,47 @@ class Vfs_ram::File : public Vfs_ram::Node
 {
 	private:
 
-		typedef ::File_system::Chunk<4096>      Chunk_level_3;
-		typedef ::File_system::Chunk_index<128, Chunk_level_3> Chunk_level_2;
-		typedef ::File_system::Chunk_index<64,  Chunk_level_2> Chunk_level_1;
-		typedef ::File_system::Chunk_index<64,  Chunk_level_1> Chunk_level_0;
+		/*
+		 * Noncopyable
+		 */
+		File(File const &);
+		File &operator = (File const &);
 
-		Chunk_level_0 _chunk;
-		file_size     _length = 0;
+		Allocator &_alloc;
+		Storage   &_storage;
+		file_size  _length = 0;
+
+		static Storage &_new_storage(Allocator &alloc, Extent_pool *pool)
+		{
+			if (pool)
+				return *new (alloc) Extent_storage(alloc, *pool);
+
+			return *new (alloc) Chunk_storage(alloc);
+		}
 
 	public:
 
-		File(char const *name, Allocator &alloc)
-		: Node(name), _chunk(alloc, 0) { }
+		/**
+		 * Constructor
+		 *
+		 * \param alloc  allocator used for the file content
+		 * \param pool   extent pool, or nullptr to use chunk storage
+		 */
+		File(char const *name, Allocator &alloc, Extent_pool *pool)
+		: Node(name), _alloc(alloc), _storage(_new_storage(alloc, pool)) { }
+
+		~File() { destroy(_alloc, &_storage); }
 
 		size_t read(char *dst, size_t len, file_size seek_offset) override
 		{
-			file_size const chunk_used_size = _chunk.used_size();
-
 			if (seek_offset >= _length)
 				return 0;
 
-			/*
-			 * Constrain read transaction to available chunk data
-			 *
-			 * Note that 'chunk_used_size' may be lower than '_length'
-			 * because 'Chunk' may have truncated tailing zeros.
-			 */
+			/* constrain read transaction to the file length */
 			if (seek_offset + len >= _length)
 				len = _length - seek_offset;
 
-			file_size read_len = len;
-
-			if (seek_offset + read_len > chunk_used_size) {
-				if (chunk_used_size >= seek_offset)
-					read_len = chunk_used_size - seek_offset;
-				else
-					read_len = 0;
-			}
-
-			_chunk.read(dst, read_len, seek_offset);
-
-			/* add zero padding if needed */
-			if (read_len < len)
-				memset(dst + read_len, 0, len - read_len);
+			_storage.read(dst, len, seek_offset);
 
 			return len;
 		}
@@ -294,18 +295,22 @@ class Vfs_ram::File : public Vfs_ram::Node
 		size_t write(char const *src, size_t len, file_size seek_offset) override
 		{
 			if (seek_offset == (file_size)(~0))
-				seek_offset = _chunk.used_size();
+				seek_offset = _length;
 
-			if (seek_offset + len >= Chunk_level_0::SIZE)
-				len = Chunk_level_0::SIZE - (seek_offset + len);
+			file_size const max_size = _storage.max_size();
 
-			try { _chunk.write(src, len, (size_t)seek_offset); }
+			if (seek_offset >= max_size)
+				return 0;
+
+			if (len > max_size - seek_offset)
+				len = max_size - seek_offset;
+
+			try { _storage.write(src, len, seek_offset); }
 			catch (Out_of_memory) { return 0; }
 
 			/*
-			 * Keep track of file length. We cannot use 'chunk.used_size()'
-			 * as file length because trailing zeros may by represented
-			 * by zero chunks, which do not contribute to 'used_size()'.
+			 * Keep track of file length. The storage does not know it
+			 * because holes and trailing zeros may not be backed by memory.
 			 */
 			_length = max(_length, seek_offset + len);
 
@@ -316,8 +321,8 @@ class Vfs_ram::File : public Vfs_ram::Node
 
 		void truncate(file_size size) override
 		{
-			if (size < _chunk.used_size())
-				_chunk.truncate(size);
+			if (size < _length)
+				_storage.truncate(size);
 
 			_length = size;
 		}
@@ -479,9 +484,79 @@ class Vfs::Ram_file_system : public Vfs::File_system
 
 		friend class Genode::List<Vfs_ram::Watch_handle>;
 
+		/*
+		 * Noncopyable
+		 */
+		Ram_file_system(Ram_file_system const &);
+		Ram_file_system &operator = (Ram_file_system const &);
+
 		Vfs::Env           &_env;
 		Vfs_ram::Directory  _root = { "" };
 
+		/*
+		 * Heap for file content and its meta data, used instead of the VFS
+		 * allocator only if the storage is explicitly configured
+		 */
+		Genode::Constructible<Genode::Heap> _content_heap { };
+
+		Genode::Allocator &_content_alloc() {
+			return _content_heap.constructed() ? *_content_heap : _env.alloc(); }
+
+		Genode::Constructible<Vfs_ram::Extent_pool> _extent_pool { };
+
+		Genode::Constructible<Genode::Reporter> _reporter { };
+
+		struct Usage
+		{
+			Genode::size_t               heap;
+			Vfs_ram::Extent_pool::Usage  extents;
+
+			bool operator != (Usage const &other) const
+			{
+				return heap            != other.heap
+				    || extents.pool    != other.extents.pool
+				    || extents.used    != other.extents.used
+				    || extents.extents != other.extents.extents;
+			}
+		};
+
+		Usage _reported_usage { 0, { 0, 0, 0 } };
+
+		Vfs_ram::Extent_pool *_pool() {
+			return _extent_pool.constructed() ? &*_extent_pool : nullptr; }
+
+		/**
+		 * Report memory usage if changed since the last report
+		 */
+		void _report_usage()
+		{
+			if (!_reporter.constructed())
+				return;
+
+			Usage const usage { _content_alloc().consumed(),
+			                    _extent_pool.constructed()
+			                    ? _extent_pool->usage()
+			                    : Vfs_ram::Extent_pool::Usage { 0, 0, 0 } };
+
+			if (!(usage != _reported_usage))
+				return;
+
+			_reported_usage = usage;
+
+			try {
+				Genode::Reporter::Xml_generator xml(*_reporter, [&] () {
+					xml.attribute("storage", _extent_pool.constructed()
+					                         ? "extents" : "chunks");
+					xml.attribute("heap", usage.heap);
+					if (_extent_pool.constructed()) {
+						xml.attribute("pool",    usage.extents.pool);
+						xml.attribute("used",    usage.extents.used);
+						xml.attribute("extents", usage.extents.extents);
+					}
+				});
+			} catch (...) { Genode::warning("could not report RAM usage"); }
+		}
+
 		Vfs_ram::Node *lookup(char const *path, bool return_parent = false)
 		{
 			using namespace Vfs_ram;
@@ -544,7 +619,38 @@ class Vfs::Ram_file_system : public Vfs::File_system
 
 	public:
 
-		Ram_file_system(Vfs::Env &env, Genode::Xml_node) : _env(env) { }
+		/**
+		 * Constructor
+		 *
+		 * The 'storage' attribute selects the storage of file content,
+		 * "chunks" or "extents". Without the attribute, the content is
+		 * stored in chunks allocated from the VFS allocator. Otherwise, the
+		 * file system allocates the content from a heap of its own. With
+		 * 'report="yes"', the memory usage is reported to the "ram_usage"
+		 * report whenever it changed after a file got modified. See the
+		 * README for details.
+		 */
+		Ram_file_system(Vfs::Env &env, Genode::Xml_node config) : _env(env)
+		{
+			typedef Genode::String<16> Storage_name;
+			Storage_name const storage =
+				config.attribute_value("storage", Storage_name());
+
+			if (storage.valid())
+				_content_heap.construct(_env.env().ram(), _env.env().rm());
+
+			if (storage == "extents")
+				_extent_pool.construct(_env.env().ram(), _env.env().rm(),
+				                       *_content_heap);
+			else if (storage.valid() && storage != "chunks")
+				Genode::warning("unknown RAM VFS storage '", storage, "'");
+
+			if (config.attribute_value("report", false)) {
+				_reporter.construct(_env.env(), "ram_usage");
+				_reporter->enabled(true);
+				_report_usage();
+			}
+		}
 
 		~Ram_file_system() { _root.empty(_env.alloc()); }
 
@@ -599,7 +705,7 @@ class Vfs::Ram_file_system : public Vfs::File_system
 				if (strlen(name) >= MAX_NAME_LEN)
 					return OPEN_ERR_NAME_TOO_LONG;
 
-				try { file = new (_env.alloc()) File(name, _env.alloc()); }
+				try { file = new (_env.alloc()) File(name, _content_alloc(), _pool()); }
 				catch (Out_of_memory) { return OPEN_ERR_NO_SPACE; }
 				parent->adopt(file);
 				parent->notify(_env.watch_handler());
@@ -757,8 +863,10 @@ class Vfs::Ram_file_system : public Vfs::File_system
 
 			if (ram_handle->node.unlinked() && !ram_handle->node.opened()) {
 				destroy(_env.alloc(), &ram_handle->node);
+				_report_usage();
 			} else if (node_modified) {
 				node.notify(_env.watch_handler());
+				_report_usage();
 			}
 		}
 
@@ -861,6 +969,7 @@ class Vfs::Ram_file_system : public Vfs::File_system
 			parent->release(node);
 			parent->notify(_env.watch_handler());
 			remove(node);
+			_report_usage();
 			return UNLINK_OK;
 		}
 
@@ -965,6 +1074,50 @@ class Vfs::Ram_file_system : public Vfs::File_system
 
 		bool read_ready(Vfs_handle *) override { return true; }
 
+		/**
+		 * Complete batched request inline
+		 */
+		bool submit(Io_batch &batch, Io_batch::Request &request) override
+		{
+			bool const write = request.opcode == Io_batch::Request::WRITE;
+
+			if (write && (request.handle->status_flags() & OPEN_MODE_ACCMODE)
+			             == OPEN_MODE_RDONLY) {
+				batch.complete(request, false, 0);
+				return true;
+			}
+
+			Vfs_ram::Io_handle *handle =
+				static_cast<Vfs_ram::Io_handle *>(request.handle);
+
+			Vfs_ram::Node::Guard guard(&handle->node);
+
+			file_size count = 0;
+			bool      ok    = true;
+
+			for (unsigned i = 0; i < request.vector_count; i++) {
+
+				Io_batch::Vector const &v = request.vectors[i];
+				file_size n = 0;
+
+				if (write)
+					n = handle->node.write(v.base, v.size, request.offset + count);
+				else
+					ok = handle->node.complete_read(v.base, v.size,
+					                                request.offset + count, n)
+					     == READ_OK;
+
+				count += n;
+				if (!ok || n < v.size) break;
+			}
+
+			if (write)
+				handle->modifying = true;
+
+			batch.complete(request, ok, count);
+			return true;
+		}
+
 		Ftruncate_result ftruncate(Vfs_handle *vfs_handle, file_size len) override
 		{
 			if ((vfs_handle->status_flags() & OPEN_MODE_ACCMODE) ==  OPEN_MODE_RDONLY)
@@ -992,6 +1145,7 @@ class Vfs::Ram_file_system : public Vfs::File_system
 				handle->node.close(*handle);
 				handle->node.notify(_env.watch_handler());
 				handle->node.open(*handle);
+				_report_usage();
 			}
 			return SYNC_OK;
 		}
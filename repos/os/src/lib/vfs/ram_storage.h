@@ -0,0 +1,496 @@
+/*
+ * \brief  Storage back ends of the embedded RAM VFS
+ * \author Genode Labs
+ * \date   2018-03-21
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _INCLUDE__VFS__RAM_STORAGE_H_
+#define _INCLUDE__VFS__RAM_STORAGE_H_
+
+#include <ram_fs/chunk.h>
+#include <vfs/types.h>
+#include <base/allocator_avl.h>
+#include <util/avl_tree.h>
+#include <util/interface.h>
+
+namespace Vfs_ram {
+
+	using namespace Genode;
+	using namespace Vfs;
+
+	struct Storage;
+	class  Chunk_storage;
+	class  Extent_pool;
+	class  Extent_storage;
+}
+
+
+/**
+ * Interface of the content storage of a file
+ */
+struct Vfs_ram::Storage : Genode::Interface
+{
+	/**
+	 * Read file content, holes read as zeros
+	 */
+	virtual void read(char *dst, size_t len, file_size offset) = 0;
+
+	/**
+	 * Write file content
+	 *
+	 * \throw Allocator::Out_of_memory
+	 */
+	virtual void write(char const *src, size_t len, file_size offset) = 0;
+
+	/**
+	 * Discard content beyond 'size'
+	 */
+	virtual void truncate(file_size size) = 0;
+
+	/**
+	 * Return maximum file size supported by the storage
+	 */
+	virtual file_size max_size() const = 0;
+};
+
+
+/**
+ * Storage using a fixed-depth tree of heap-allocated chunks
+ */
+class Vfs_ram::Chunk_storage : public Storage
+{
+	private:
+
+		typedef ::File_system::Chunk<4096>      Chunk_level_3;
+		typedef ::File_system::Chunk_index<128, Chunk_level_3> Chunk_level_2;
+		typedef ::File_system::Chunk_index<64,  Chunk_level_2> Chunk_level_1;
+		typedef ::File_system::Chunk_index<64,  Chunk_level_1> Chunk_level_0;
+
+		Chunk_level_0 _chunk;
+
+	public:
+
+		Chunk_storage(Allocator &alloc) : _chunk(alloc, 0) { }
+
+		void read(char *dst, size_t len, file_size offset) override
+		{
+			file_size const chunk_used_size = _chunk.used_size();
+
+			/*
+			 * Constrain read transaction to available chunk data
+			 *
+			 * Note that 'chunk_used_size' may be lower than the file length
+			 * because 'Chunk' may have truncated tailing zeros.
+			 */
+			file_size read_len = len;
+
+			if (offset + read_len > chunk_used_size) {
+				if (chunk_used_size >= offset)
+					read_len = chunk_used_size - offset;
+				else
+					read_len = 0;
+			}
+
+			_chunk.read(dst, read_len, offset);
+
+			/* add zero padding if needed */
+			if (read_len < len)
+				memset(dst + read_len, 0, len - read_len);
+		}
+
+		void write(char const *src, size_t len, file_size offset) override {
+			_chunk.write(src, len, (size_t)offset); }
+
+		void truncate(file_size size) override
+		{
+			if (size < _chunk.used_size())
+				_chunk.truncate(size);
+		}
+
+		file_size max_size() const override { return Chunk_level_0::SIZE; }
+};
+
+
+/**
+ * Pool of contiguous memory for file extents
+ *
+ * The memory is obtained as large RAM dataspaces, each managed by an
+ * allocator of its own. A dataspace is handed back as soon as the last
+ * extent within it is freed.
+ */
+class Vfs_ram::Extent_pool
+{
+	public:
+
+		enum { BLOCK_SIZE     = 4096,
+		       MIN_DATASPACE  = 1024*1024,
+		       MAX_DATASPACE  = 64*1024*1024 };
+
+		struct Usage
+		{
+			size_t        pool;    /* size of all dataspaces */
+			size_t        used;    /* bytes allocated for extents */
+			unsigned long extents;
+		};
+
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		Extent_pool(Extent_pool const &);
+		Extent_pool &operator = (Extent_pool const &);
+
+		struct Dataspace : Genode::List<Dataspace>::Element
+		{
+			Ram_dataspace_capability const cap;
+			addr_t                   const base;
+			size_t                   const size;
+			Allocator_avl                  range;
+			size_t                         used = 0;
+
+			Dataspace(Ram_dataspace_capability cap, addr_t base, size_t size,
+			          Allocator &md_alloc)
+			: cap(cap), base(base), size(size), range(&md_alloc)
+			{
+				range.add_range(base, size);
+			}
+
+			bool contains(addr_t addr) const {
+				return addr >= base && addr < base + size; }
+		};
+
+		Genode::Ram_session    &_ram;
+		Genode::Region_map     &_rm;
+		Allocator              &_md_alloc;
+		Genode::List<Dataspace> _dataspaces { };
+		Genode::Lock            _lock       { };
+		size_t                  _next_size  = MIN_DATASPACE;
+		Usage                   _usage      { 0, 0, 0 };
+
+		/**
+		 * Add dataspace that can hold at least 'size' bytes
+		 *
+		 * \throw Allocator::Out_of_memory
+		 */
+		Dataspace &_grow(size_t size)
+		{
+			size = max(align_addr(size, 12), _next_size);
+
+			Ram_dataspace_capability cap;
+			try { cap = _ram.alloc(size); }
+			catch (Genode::Out_of_ram)  { throw Allocator::Out_of_memory(); }
+			catch (Genode::Out_of_caps) { throw Allocator::Out_of_memory(); }
+
+			try {
+				addr_t const base = _rm.attach(cap);
+				Dataspace *ds = new (_md_alloc) Dataspace(cap, base, size, _md_alloc);
+				_dataspaces.insert(ds);
+				_usage.pool += size;
+				_next_size   = min(2*_next_size, (size_t)MAX_DATASPACE);
+				return *ds;
+			}
+			catch (...) {
+				_ram.free(cap);
+				throw Allocator::Out_of_memory();
+			}
+		}
+
+		void _release(Dataspace &ds)
+		{
+			_dataspaces.remove(&ds);
+			_usage.pool -= ds.size;
+
+			addr_t const base = ds.base;
+			Ram_dataspace_capability const cap = ds.cap;
+
+			destroy(_md_alloc, &ds);
+			_rm.detach(base);
+			_ram.free(cap);
+		}
+
+		static char *_alloc_in(Dataspace &ds, size_t size)
+		{
+			void *addr = nullptr;
+			if (ds.range.alloc_aligned(size, &addr, 12).error())
+				return nullptr;
+
+			ds.used += size;
+			return (char *)addr;
+		}
+
+	public:
+
+		Extent_pool(Genode::Ram_session &ram, Genode::Region_map &rm,
+		            Allocator &md_alloc)
+		: _ram(ram), _rm(rm), _md_alloc(md_alloc) { }
+
+		~Extent_pool()
+		{
+			while (Dataspace *ds = _dataspaces.first())
+				_release(*ds);
+		}
+
+		/**
+		 * Allocate extent of 'size' bytes, a multiple of 'BLOCK_SIZE'
+		 *
+		 * \throw Allocator::Out_of_memory
+		 */
+		char *alloc(size_t size)
+		{
+			Genode::Lock::Guard guard(_lock);
+
+			char *addr = nullptr;
+			for (Dataspace *ds = _dataspaces.first(); ds && !addr; ds = ds->next())
+				addr = _alloc_in(*ds, size);
+
+			if (!addr)
+				addr = _alloc_in(_grow(size), size);
+
+			if (!addr)
+				throw Allocator::Out_of_memory();
+
+			_usage.used += size;
+			_usage.extents++;
+			return addr;
+		}
+
+		void free(char *addr, size_t size)
+		{
+			Genode::Lock::Guard guard(_lock);
+
+			for (Dataspace *ds = _dataspaces.first(); ds; ds = ds->next()) {
+
+				if (!ds->contains((addr_t)addr))
+					continue;
+
+				ds->range.free(addr, size);
+				ds->used -= size;
+
+				_usage.used -= size;
+				_usage.extents--;
+
+				if (ds->used == 0)
+					_release(*ds);
+				return;
+			}
+		}
+
+		Usage usage()
+		{
+			Genode::Lock::Guard guard(_lock);
+			return _usage;
+		}
+};
+
+
+/**
+ * Storage using a tree of contiguous extents
+ *
+ * Extents cover block-aligned ranges of the file. Ranges without an extent
+ * are holes that read as zeros, which makes sparse files cheap. Because
+ * file offsets are not bound to a fixed index structure, the file size is
+ * only limited by the available memory. Truncating a file drops the
+ * extents beyond the new end without copying any content.
+ */
+class Vfs_ram::Extent_storage : public Storage
+{
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		Extent_storage(Extent_storage const &);
+		Extent_storage &operator = (Extent_storage const &);
+
+		enum { BLOCK_SIZE = Extent_pool::BLOCK_SIZE,
+		       MAX_EXTENT = 1024*1024 };
+
+		struct Extent : Genode::Avl_node<Extent>
+		{
+			/*
+			 * Noncopyable
+			 */
+			Extent(Extent const &);
+			Extent &operator = (Extent const &);
+
+			file_size const start;
+			size_t    const size;
+			char    * const data;
+
+			Extent(file_size start, size_t size, char *data)
+			: start(start), size(size), data(data) { }
+
+			file_size end() const { return start + size; }
+
+			bool higher(Extent *e) { return e->start > start; }
+		};
+
+		Allocator             &_md_alloc;
+		Extent_pool           &_pool;
+		Genode::Avl_tree<Extent> _extents { };
+
+		/**
+		 * Return extent with the highest start offset not above 'offset'
+		 */
+		Extent *_floor(file_size offset)
+		{
+			Extent *best = nullptr;
+			for (Extent *e = _extents.first(); e; ) {
+				if (e->start <= offset) {
+					best = e;
+					e = e->child(Extent::RIGHT);
+				} else {
+					e = e->child(Extent::LEFT);
+				}
+			}
+			return best;
+		}
+
+		/**
+		 * Return extent with the lowest start offset not below 'offset'
+		 */
+		Extent *_ceil(file_size offset)
+		{
+			Extent *best = nullptr;
+			for (Extent *e = _extents.first(); e; ) {
+				if (e->start >= offset) {
+					best = e;
+					e = e->child(Extent::LEFT);
+				} else {
+					e = e->child(Extent::RIGHT);
+				}
+			}
+			return best;
+		}
+
+		/**
+		 * Return extent containing 'offset', or nullptr for a hole
+		 */
+		Extent *_lookup(file_size offset)
+		{
+			Extent *e = _floor(offset);
+			return (e && offset < e->end()) ? e : nullptr;
+		}
+
+		void _remove(Extent &e)
+		{
+			_extents.remove(&e);
+			_pool.free(e.data, e.size);
+			destroy(_md_alloc, &e);
+		}
+
+		/**
+		 * Allocate extent filling the hole at 'offset'
+		 *
+		 * \param wanted  number of bytes about to be written at 'offset'
+		 *
+		 * \throw Allocator::Out_of_memory
+		 */
+		Extent &_fill_hole(file_size offset, size_t wanted)
+		{
+			file_size const start = offset & ~(file_size)(BLOCK_SIZE - 1);
+
+			size_t size = align_addr(offset - start + wanted, 12);
+
+			/* grow extents of sequentially written files */
+			Extent const *prev = _floor(offset);
+			if (prev && prev->end() == start)
+				size = max(size, min(2*prev->size, (size_t)MAX_EXTENT));
+
+			size = min(size, (size_t)MAX_EXTENT);
+
+			/* do not overlap the next extent */
+			if (Extent const *next = _ceil(start))
+				size = (size_t)min((file_size)size, next->start - start);
+
+			/* fall back to smaller extents if memory is fragmented */
+			char *data = nullptr;
+			for (;;) {
+				try { data = _pool.alloc(size); break; }
+				catch (Allocator::Out_of_memory) {
+					if (size <= BLOCK_SIZE)
+						throw;
+					size = align_addr(size / 2, 12);
+				}
+			}
+
+			Extent *e = nullptr;
+			try { e = new (_md_alloc) Extent(start, size, data); }
+			catch (...) {
+				_pool.free(data, size);
+				throw Allocator::Out_of_memory();
+			}
+
+			memset(data, 0, size);
+			_extents.insert(e);
+			return *e;
+		}
+
+	public:
+
+		Extent_storage(Allocator &md_alloc, Extent_pool &pool)
+		: _md_alloc(md_alloc), _pool(pool) { }
+
+		~Extent_storage()
+		{
+			while (Extent *e = _extents.first())
+				_remove(*e);
+		}
+
+		void read(char *dst, size_t len, file_size offset) override
+		{
+			while (len) {
+
+				size_t n = 0;
+
+				if (Extent *e = _lookup(offset)) {
+					n = (size_t)min((file_size)len, e->end() - offset);
+					memcpy(dst, e->data + (offset - e->start), n);
+				} else {
+					Extent *next = _ceil(offset);
+					n = next ? (size_t)min((file_size)len, next->start - offset) : len;
+					memset(dst, 0, n);
+				}
+
+				dst += n; offset += n; len -= n;
+			}
+		}
+
+		void write(char const *src, size_t len, file_size offset) override
+		{
+			while (len) {
+
+				Extent *e = _lookup(offset);
+				if (!e)
+					e = &_fill_hole(offset, len);
+
+				size_t const n = (size_t)min((file_size)len, e->end() - offset);
+				memcpy(e->data + (offset - e->start), src, n);
+
+				src += n; offset += n; len -= n;
+			}
+		}
+
+		void truncate(file_size size) override
+		{
+			while (Extent *e = _ceil(size))
+				_remove(*e);
+
+			/* zero the tail of the last extent, which may be read after growing */
+			if (size)
+				if (Extent *e = _lookup(size - 1))
+					memset(e->data + (size - e->start), 0, (size_t)(e->end() - size));
+		}
+
+		file_size max_size() const override { return ~(file_size)0; }
+};
+
+#endif /* _INCLUDE__VFS__RAM_STORAGE_H_ */
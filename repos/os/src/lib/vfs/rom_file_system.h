@@ -140,6 +140,8 @@ class Vfs::Rom_file_system : public Single_file_system
 			return _rom.cap();
 		}
 
+		bool dataspace_shared(char const *) override { return true; }
+
 		/********************************
 		 ** File I/O service interface **
 		 ********************************/
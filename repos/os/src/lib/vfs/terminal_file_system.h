@@ -56,6 +56,12 @@ class Vfs::Terminal_file_system : public Single_file_system
 				_ep.schedule_post_signal_hook(this);
 			}
 
+			void drop(Vfs_handle::Context &context)
+			{
+				if (_context == &context)
+					_context = nullptr;
+			}
+
 			void function() override
 			{
 				/*
@@ -156,6 +162,11 @@ class Vfs::Terminal_file_system : public Single_file_system
 			return _terminal.avail();
 		}
 
+		void drop_io_response(Vfs_handle::Context &context) override
+		{
+			_post_signal_hook.drop(context);
+		}
+
 		Ftruncate_result ftruncate(Vfs_handle *, file_size) override
 		{
 			return FTRUNCATE_OK;
@@ -0,0 +1,104 @@
+/*
+ * \brief  Adaptive replacement cache (ARC) strategy
+ * \author Genode Labs
+ * \date   2018-03-16
+ *
+ * Resident chunks are split into 'T1', accessed once recently, and 'T2',
+ * accessed at least twice. The histories 'B1' and 'B2' remember chunks
+ * evicted from either list. A hit in a history adapts the target size 'p'
+ * of 'T1' in favour of the list that would have kept the chunk.
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _ARC_H_
+#define _ARC_H_
+
+#include "policy.h"
+
+namespace Cache { class Arc; }
+
+
+class Cache::Arc : public Replacement_policy
+{
+	private:
+
+		Dlist<Element> _t1 { };
+		Dlist<Element> _t2 { };
+		Ghost_list     _b1;
+		Ghost_list     _b2;
+
+		/* capacity of the cache in chunks, learned at eviction time */
+		unsigned long _c = 0;
+
+		/* target size of '_t1' */
+		unsigned long _p = 0;
+
+	public:
+
+		Arc(Genode::Allocator &alloc) : _b1(alloc), _b2(alloc) { }
+
+		void access(Element &e, offset_t key) override
+		{
+			if (_t1.contains(e)) { _t1.remove(e); _t2.insert_head(e); return; }
+			if (_t2.contains(e)) { _t2.touch(e); return; }
+
+			unsigned long const b1 = _b1.count(), b2 = _b2.count();
+
+			if (_b1.remove(key)) {
+				_p = Genode::min(_c, _p + Genode::max(1UL, b2 / b1));
+				_t2.insert_head(e);
+				return;
+			}
+
+			if (_b2.remove(key)) {
+				unsigned long const delta = Genode::max(1UL, b1 / b2);
+				_p = _p > delta ? _p - delta : 0;
+				_t2.insert_head(e);
+				return;
+			}
+
+			_t1.insert_head(e);
+		}
+
+		Element *victim(unsigned long skip) override
+		{
+			_c = Genode::max(_c, resident());
+
+			if (_t1.tail() && (_t1.count() > _p || !_t2.tail()))
+				return nth_victim(_t1, _t2, skip);
+
+			return nth_victim(_t2, _t1, skip);
+		}
+
+		void evict(Element &e, offset_t key) override
+		{
+			if (_t1.contains(e)) {
+				_t1.remove(e);
+				_b1.insert(key);
+			} else if (_t2.contains(e)) {
+				_t2.remove(e);
+				_b2.insert(key);
+			}
+
+			/* keep the histories within the size of the cache */
+			_b1.trim(_c > _t1.count() ? _c - _t1.count() : 0);
+			_b2.trim(_c > _t2.count() ? _c - _t2.count() : 0);
+		}
+
+		void remove(Element &e) override
+		{
+			if (_t1.contains(e)) _t1.remove(e);
+			if (_t2.contains(e)) _t2.remove(e);
+		}
+
+		unsigned long resident() const override {
+			return _t1.count() + _t2.count(); }
+};
+
+#endif /* _ARC_H_ */
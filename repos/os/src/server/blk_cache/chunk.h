@@ -118,7 +118,10 @@ namespace Cache {
 		private:
 
 			char        _data[CHUNK_SIZE];
-			unsigned    _writes;
+			bool        _valid;  /* chunk holds the device content */
+			bool        _dirty;  /* content differs from the device */
+			bool        _writing = false; /* write back in progress  */
+			unsigned    _version = 0;     /* incremented on each write */
 
 		public:
 
@@ -136,12 +139,12 @@ namespace Cache {
 			 * of 'Chunk_index'.
 			 */
 			Chunk(Genode::Allocator &, offset_t base_offset, Chunk_base *p)
-			: Chunk_base(base_offset, p), _writes(0) { }
+			: Chunk_base(base_offset, p), _valid(false), _dirty(false) { }
 
 			/**
 			 * Construct zero chunk
 			 */
-			Chunk() : _writes(0) { }
+			Chunk() : _valid(false), _dirty(false) { }
 
 			/**
 			 * Return number of used entries
@@ -152,6 +155,48 @@ namespace Cache {
 			 */
 			size_t used_size() const { return _num_entries; }
 
+			/**
+			 * Return true if the chunk must be written back before eviction
+			 */
+			bool dirty() const { return _dirty; }
+
+			/**
+			 * Return true if a write back of the chunk is in progress
+			 */
+			bool writing() const { return _writing; }
+
+			/**
+			 * Return version of the content, which changes on each write
+			 */
+			unsigned version() const { return _version; }
+
+			/**
+			 * Mark write back of the content handed out via 'POLICY::sync'
+			 * as submitted to the backend device
+			 *
+			 * The chunk remains dirty until the device acknowledged the
+			 * write back via 'write_back_done'.
+			 */
+			void write_back_submitted() { _writing = true; }
+
+			/**
+			 * Complete write back of the chunk
+			 *
+			 * \param succeeded  true if the device acknowledged the write
+			 * \param version    version of the content written back
+			 *
+			 * The chunk becomes clean only if the write succeeded and the
+			 * chunk was not written in the meantime. Otherwise, it remains
+			 * dirty and is written back again.
+			 */
+			void write_back_done(bool succeeded, unsigned version)
+			{
+				_writing = false;
+
+				if (succeeded && version == _version)
+					_dirty = false;
+			}
+
 			void write(char const *src, size_t len, offset_t seek_offset)
 			{
 				assert_valid_range(seek_offset, len, SIZE);
@@ -165,7 +210,33 @@ namespace Cache {
 
 				_num_entries = Genode::max(_num_entries, local_offset + len);
 
-				_writes++;
+				_valid = true;
+				_dirty = true;
+				_version++;
+			}
+
+			/**
+			 * Populate chunk with content read from the backend device
+			 *
+			 * Dirty chunks are left untouched, their content is newer than
+			 * the one of the device, e.g., when a client wrote to a chunk
+			 * while it was read ahead.
+			 */
+			void fill(char const *src, size_t len, offset_t seek_offset)
+			{
+				assert_valid_range(seek_offset, len, SIZE);
+
+				if (_dirty) return;
+
+				POLICY::write(this);
+
+				offset_t const local_offset = seek_offset - base_offset();
+
+				Genode::memcpy(&_data[local_offset], src, len);
+
+				_num_entries = Genode::max(_num_entries, local_offset + len);
+
+				_valid = true;
 			}
 
 			void read(char *dst, size_t len, offset_t seek_offset) const
@@ -181,16 +252,15 @@ namespace Cache {
 			{
 				assert_valid_range(seek_offset, len, SIZE);
 
-				if (_writes == 0)
+				if (!_valid)
 					throw Range_incomplete(base_offset(), SIZE);
 			}
 
 			void sync(size_t len, offset_t seek_offset)
 			{
-				if (_writes > 1) {
+				/* a chunk is written back by one request at a time */
+				if (_dirty && !_writing)
 					POLICY::sync(this, (char*)_data);
-					_writes = 1;
-				}
 			}
 
 			void alloc(size_t len, offset_t seek_offset) { }
@@ -215,7 +285,7 @@ namespace Cache {
 
 			void free(size_t, offset_t)
 			{
-				if (_writes > 1) throw Dirty_chunk(_base_offset, SIZE);
+				if (_dirty) throw Dirty_chunk(_base_offset, SIZE);
 
 				_num_entries = 0;
 				if (_parent) _parent->free(SIZE, _base_offset);
@@ -409,6 +479,20 @@ namespace Cache {
 				}
 			};
 
+			struct Fill_func
+			{
+				typedef ENTRY_TYPE Entry;
+
+				static Entry &lookup(Chunk_index &chunk, unsigned i) {
+					return chunk._alloc_entry(i); }
+
+				void operator () (Entry &entry, char const *src, size_t len,
+				                  offset_t seek_offset) const
+				{
+					entry.fill(src, len, seek_offset);
+				}
+			};
+
 			struct Read_func
 			{
 				typedef ENTRY_TYPE const Entry;
@@ -515,6 +599,12 @@ namespace Cache {
 			void write(char const *src, size_t len, offset_t seek_offset) {
 				_range_op(*this, src, len, seek_offset, Write_func()); }
 
+			/**
+			 * Populate chunks with device content, skipping dirty chunks
+			 */
+			void fill(char const *src, size_t len, offset_t seek_offset) {
+				_range_op(*this, src, len, seek_offset, Fill_func()); }
+
 			/**
 			 * Allocate needed chunks
 			 */
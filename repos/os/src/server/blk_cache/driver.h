@@ -15,6 +15,9 @@
 #include <block_session/connection.h>
 #include <block/component.h>
 #include <os/packet_allocator.h>
+#include <os/reporter.h>
+#include <timer_session/connection.h>
+#include <util/xml_node.h>
 
 #include "chunk.h"
 
@@ -22,6 +25,12 @@
  * Cache driver used by the generic block driver framework
  *
  * \param POLICY  the cache replacement policy (e.g. LRU)
+ *
+ * Client writes are cached and written back to the device periodically,
+ * when the session gets synchronized or closed, or when a dirty chunk gets
+ * evicted. Adjacent dirty chunks are merged into one device request.
+ * Sequential read streams are detected and the blocks ahead of them are
+ * prefetched into the cache.
  */
 template <typename POLICY>
 class Driver : public Block::Driver
@@ -43,6 +52,12 @@ class Driver : public Block::Driver
 			        char * const              b)
 				: srv(s), cli(c), buffer(b) {}
 
+			/*
+			 * \return true if the request got issued by the readahead
+			 *         without a client waiting for it
+			 */
+			bool prefetch() const { return !buffer; }
+
 			/*
 			 * \return true when the given response packet matches
 			 *         the request send to the backend device
@@ -88,18 +103,64 @@ class Driver : public Block::Driver
 		};
 
 
-		/*
-		 * The given policy class is extended by a synchronization routine,
-		 * used by the cache chunk structure
+		/**
+		 * Sequential read stream
 		 */
-		struct Policy : POLICY {
-			static void sync(const typename POLICY::Element *e, char *src); };
+		struct Stream
+		{
+			Block::sector_t next    = 0; /* block expected next      */
+			Block::sector_t ra_end  = 0; /* end of prefetched blocks */
+			unsigned        hits    = 0; /* sequential requests      */
+			unsigned long   used    = 0; /* time of last use         */
+		};
 
 	public:
 
+		/*
+		 * The given policy class is extended by synchronization routines,
+		 * used by the cache chunk structure and the policy
+		 */
+		struct Policy : POLICY
+		{
+			/**
+			 * Hand out dirty chunk for being written back
+			 *
+			 * \throw Write_failed
+			 */
+			static void sync(const typename POLICY::Element *e, char *src);
+
+			/**
+			 * Write back dirty chunk immediately
+			 *
+			 * \return false if the backend device is congested
+			 */
+			static bool write_back(typename POLICY::Element *e);
+		};
+
 		enum {
 			SLAB_SZ = Block::Session::TX_QUEUE_SIZE*sizeof(Request),
-			CACHE_BLK_SIZE = 4096
+			CACHE_BLK_SIZE = 4096,
+
+			/* maximum number of chunks written back by one request */
+			MAX_EXTENT_CHUNKS = 64,
+
+			/* maximum amount of data prefetched ahead of a stream */
+			MAX_READAHEAD = 64*CACHE_BLK_SIZE,
+
+			/* number of sequential requests that trigger the readahead */
+			STREAM_THRESHOLD = 2,
+			STREAMS          = 8,
+		};
+
+		struct Stats
+		{
+			unsigned long hits           = 0;
+			unsigned long misses         = 0;
+			unsigned long prefetches     = 0; /* readahead requests    */
+			unsigned long prefetched     = 0; /* chunks read ahead     */
+			unsigned long write_backs    = 0; /* write-back requests   */
+			unsigned long written_chunks = 0; /* chunks written back   */
+			unsigned long failed_writes  = 0; /* failed write backs    */
 		};
 
 		/**
@@ -126,6 +187,39 @@ class Driver : public Block::Driver
 		Genode::Io_signal_handler<Driver> _source_ack;
 		Genode::Io_signal_handler<Driver> _source_submit;
 		Genode::Io_signal_handler<Driver> _yield;
+		Timer::Connection                 _timer;
+		Genode::Signal_handler<Driver>    _timeout;
+		Genode::Reporter                  _reporter;
+		Stats                             _stats { };
+
+		/* dirty chunks gathered for being written back by one request */
+		struct Extent_chunk { Chunk_level_4 *chunk; char const *data; };
+
+		Extent_chunk    _extent[MAX_EXTENT_CHUNKS];
+		unsigned        _extent_cnt = 0;
+		Cache::offset_t _extent_off = 0;
+
+		/*
+		 * Write back in progress
+		 *
+		 * The chunks remain dirty, and thereby cannot be evicted, until the
+		 * backend device acknowledged the request.
+		 */
+		struct Write_back : Genode::List<Write_back>::Element
+		{
+			Block::Packet_descriptor packet { };
+			unsigned                 cnt = 0;
+
+			struct { Chunk_level_4 *chunk; unsigned version; }
+				chunks[MAX_EXTENT_CHUNKS] { };
+		};
+
+		Genode::Allocator        &_wb_alloc;
+		Genode::List<Write_back>  _write_backs { };
+
+		Stream          _streams[STREAMS];
+		unsigned long   _stream_time = 0;
+		Genode::size_t  _ra_blocks   = 0; /* readahead window in blocks */
 
 		Driver(Driver const&);            /* singleton pattern */
 		Driver& operator=(Driver const&); /* singleton pattern */
@@ -157,13 +251,18 @@ class Driver : public Block::Driver
 		 */
 		inline void _handle_reply(Block::Packet_descriptor &srv, Request *r)
 		{
+			if (!srv.succeeded()) {
+				ack_packet(r->cli, false);
+				return;
+			}
+
 			try {
 			if (r->cli.operation() == Block::Packet_descriptor::READ)
-				read(r->cli.block_number(), r->cli.block_count(),
-				     r->buffer, r->cli);
-			else
-				write(r->cli.block_number(), r->cli.block_count(),
+				_read(r->cli.block_number(), r->cli.block_count(),
 				      r->buffer, r->cli);
+			else
+				_write(r->cli.block_number(), r->cli.block_count(),
+				       r->buffer, r->cli);
 			} catch(Block::Driver::Request_congestion) {
 				Genode::warning("cli (", r->cli.block_number(), " ",
 				                         r->cli.block_count(), ") "
@@ -181,17 +280,26 @@ class Driver : public Block::Driver
 				Block::Packet_descriptor p = _blk.tx()->get_acked_packet();
 
 				/* when reading, write result into cache */
-				if (p.operation() == Block::Packet_descriptor::READ)
-					_cache.write(_blk.tx()->packet_content(p),
-					             p.block_count() * _blk_sz,
-					             p.block_number() * _blk_sz);
+				if (p.operation() == Block::Packet_descriptor::READ
+				 && p.succeeded()) {
+					try {
+						_cache.fill(_blk.tx()->packet_content(p),
+						            p.block_count() * _blk_sz,
+						            p.block_number() * _blk_sz);
+					} catch (Block::Driver::Request_congestion) {
+						/* cache exhausted, clients will request again */ }
+				}
+
+				if (p.operation() == Block::Packet_descriptor::WRITE)
+					_write_back_done(p);
 
 				/* loop through the list of requests, and ack all related */
 				for (Request *r = _r_list.first(), *r_to_handle = r; r;
 				     r_to_handle = r) {
 					r = r->next();
 					if (r_to_handle->match(p)) {
-						_handle_reply(p, r_to_handle);
+						if (!r_to_handle->prefetch())
+							_handle_reply(p, r_to_handle);
 						_r_list.remove(r_to_handle);
 						Genode::destroy(&_r_slab, r_to_handle);
 					}
@@ -201,6 +309,35 @@ class Driver : public Block::Driver
 			}
 		}
 
+		/*
+		 * Complete write back acknowledged by the backend device
+		 *
+		 * Chunks of a failed write back remain dirty and are written back
+		 * again on the next synchronization.
+		 */
+		void _write_back_done(Block::Packet_descriptor const &p)
+		{
+			Write_back *wb = _write_backs.first();
+			for (; wb && wb->packet.offset() != p.offset(); wb = wb->next());
+
+			if (!wb)
+				return;
+
+			if (!p.succeeded()) {
+				Genode::error("write back of blocks ", p.block_number(),
+				              "-", p.block_number() + p.block_count() - 1,
+				              " failed");
+				_stats.failed_writes++;
+			}
+
+			for (unsigned i = 0; i < wb->cnt; i++)
+				wb->chunks[i].chunk->write_back_done(p.succeeded(),
+				                                     wb->chunks[i].version);
+
+			_write_backs.remove(wb);
+			Genode::destroy(&_wb_alloc, wb);
+		}
+
 		/*
 		 * Handle that the backend device is ready to receive again
 		 */
@@ -260,8 +397,183 @@ class Driver : public Block::Driver
 			}
 		}
 
+		/*
+		 * Return true if the cache block at given offset is cached or
+		 * requested from the backend device already
+		 */
+		bool _present(Block::sector_t nr)
+		{
+			for (Request *r = _r_list.first(); r; r = r->next())
+				if (r->match(false, nr, _cache_blk_mod()))
+					return true;
+
+			try {
+				_cache.stat(CACHE_BLK_SIZE, nr * _blk_sz);
+				return true;
+			} catch (Cache::Chunk_base::Range_incomplete) { }
+			return false;
+		}
+
+		/*
+		 * Read cache blocks within the given range into the cache
+		 *
+		 * Only the first contiguous range of missing cache blocks is read by
+		 * one request. Prefetching is best effort, it's skipped whenever the
+		 * backend device or the cache is congested.
+		 *
+		 * \return block number up to which the range got prefetched
+		 */
+		Block::sector_t _prefetch(Block::sector_t from, Block::sector_t to)
+		{
+			while (from < to && _present(from))
+				from += _cache_blk_mod();
+
+			Block::sector_t end = from;
+			while (end < to && !_present(end))
+				end += _cache_blk_mod();
+
+			if (end == from)
+				return to;
+
+			if (!_blk.tx()->ready_to_submit())
+				return from;
+
+			Genode::size_t const cnt = end - from;
+			Block::Packet_descriptor p;
+
+			try {
+				p = Block::Packet_descriptor(_blk.dma_alloc_packet(_blk_sz*cnt),
+				                             Block::Packet_descriptor::READ,
+				                             from, cnt);
+			} catch (Block::Session::Tx::Source::Packet_alloc_failed) {
+				return from;
+			}
+
+			try {
+				_cache.alloc(cnt * _blk_sz, from * _blk_sz);
+				_r_list.insert(new (&_r_slab) Request(p, p, nullptr));
+			} catch (Block::Driver::Request_congestion) {
+				_blk.tx()->release_packet(p);
+				return from;
+			} catch (Genode::Allocator::Out_of_memory) {
+				_blk.tx()->release_packet(p);
+				return from;
+			}
+
+			_blk.tx()->submit_packet(p);
+			_stats.prefetches++;
+			_stats.prefetched += cnt / _cache_blk_mod();
+			return end;
+		}
+
+		/*
+		 * Detect sequential read streams and read ahead of them
+		 *
+		 * \param nr   block number of client's read request
+		 * \param cnt  number of blocks of client's read request
+		 */
+		void _readahead(Block::sector_t nr, Genode::size_t cnt)
+		{
+			if (!_ra_blocks)
+				return;
+
+			/* lookup stream continued by the request */
+			Stream *s = nullptr, *oldest = &_streams[0];
+			for (Stream &stream : _streams) {
+				if (stream.hits && stream.next == nr) {
+					s = &stream;
+					break;
+				}
+				if (stream.used < oldest->used)
+					oldest = &stream;
+			}
+
+			if (s) {
+				s->hits++;
+			} else {
+				/* start new stream in place of the least recently used */
+				s = oldest;
+				s->hits   = 1;
+				s->ra_end = 0;
+			}
+
+			s->next = nr + cnt;
+			s->used = ++_stream_time;
+
+			if (s->hits < STREAM_THRESHOLD)
+				return;
+
+			/* keep at least half of the window prefetched */
+			if (s->ra_end >= s->next + _ra_blocks / 2)
+				return;
+
+			Block::sector_t const from =
+				_cache_blk_round_up(Genode::max(s->next, s->ra_end));
+			Block::sector_t const to =
+				Genode::min((Block::sector_t)_cache_blk_round_off(s->next + _ra_blocks),
+				            (Block::sector_t)_cache_blk_round_off(_blk_cnt));
+
+			if (from < to)
+				s->ra_end = _prefetch(from, to);
+		}
+
+		/*
+		 * Submit the dirty chunks gathered so far to the backend device
+		 *
+		 * The chunks remain dirty until the device acknowledged the write.
+		 */
+		void _submit_extent()
+		{
+			if (!_extent_cnt)
+				return;
+
+			unsigned const        cnt  = _extent_cnt;
+			Cache::offset_t const off  = _extent_off;
+			Genode::size_t  const size = cnt * CACHE_BLK_SIZE;
+
+			_extent_cnt = 0;
+
+			if (!_blk.tx()->ready_to_submit())
+				throw Write_failed(off);
+
+			Write_back *wb = nullptr;
+			try { wb = new (&_wb_alloc) Write_back(); }
+			catch (Genode::Allocator::Out_of_memory) { throw Write_failed(off); }
+
+			Block::Packet_descriptor p;
+			try {
+				p = Block::Packet_descriptor(_blk.dma_alloc_packet(size),
+				                             Block::Packet_descriptor::WRITE,
+				                             off / _blk_sz, size / _blk_sz);
+			} catch(Block::Session::Tx::Source::Packet_alloc_failed) {
+				Genode::destroy(&_wb_alloc, wb);
+				throw Write_failed(off);
+			}
+
+			char *dst = _blk.tx()->packet_content(p);
+			for (unsigned i = 0; i < cnt; i++) {
+				Chunk_level_4 &chunk = *_extent[i].chunk;
+
+				Genode::memcpy(dst + i*CACHE_BLK_SIZE, _extent[i].data,
+				               CACHE_BLK_SIZE);
+
+				wb->chunks[i].chunk   = &chunk;
+				wb->chunks[i].version = chunk.version();
+				chunk.write_back_submitted();
+			}
+			wb->packet = p;
+			wb->cnt    = cnt;
+			_write_backs.insert(wb);
+
+			_blk.tx()->submit_packet(p);
+			_stats.write_backs++;
+			_stats.written_chunks += cnt;
+		}
+
 		/*
 		 * Synchronize dirty chunks with backend device
+		 *
+		 * Returns once the device acknowledged all write backs.
 		 */
 		void _sync()
 		{
@@ -271,6 +583,7 @@ class Driver : public Block::Driver
 			while (len > 0) {
 				try {
 					_cache.sync(len, off);
+					_submit_extent();
 					len = 0;
 				} catch(Write_failed &e) {
 					/**
@@ -282,6 +595,9 @@ class Driver : public Block::Driver
 					_env.ep().wait_and_dispatch_one_io_signal();
 				}
 			}
+
+			while (_write_backs.first())
+				_env.ep().wait_and_dispatch_one_io_signal();
 		}
 
 		/*
@@ -309,6 +625,84 @@ class Driver : public Block::Driver
 			return false;
 		}
 
+		/*
+		 * Serve client's read request from the cache
+		 *
+		 * \return false if the blocks got requested from the device first
+		 */
+		bool _read(Block::sector_t           block_number,
+		           Genode::size_t            block_count,
+		           char*                     buffer,
+		           Block::Packet_descriptor &packet)
+		{
+			if (!_stat(block_number, block_count, buffer, packet))
+				return false;
+
+			_cache.read(buffer, block_count*_blk_sz, block_number*_blk_sz);
+			ack_packet(packet);
+			return true;
+		}
+
+		void _write(Block::sector_t           block_number,
+		            Genode::size_t            block_count,
+		            const char *              buffer,
+		            Block::Packet_descriptor &packet)
+		{
+			_cache.alloc(block_count * _blk_sz, block_number * _blk_sz);
+
+			if ((block_number % _cache_blk_mod()) &&
+			    !_stat(block_number, 1, const_cast<char* const>(buffer), packet))
+				return;
+
+			if (((block_number+block_count) % _cache_blk_mod())
+				&& !_stat(block_number+block_count-1, 1,
+				          const_cast<char* const>(buffer), packet))
+				return;
+
+			_cache.write(buffer, block_count * _blk_sz,
+			             block_number * _blk_sz);
+			ack_packet(packet);
+		}
+
+		void _report()
+		{
+			if (!_reporter.enabled())
+				return;
+
+			typename POLICY::Stats const policy = POLICY::stats();
+
+			try {
+				Genode::Reporter::Xml_generator xml(_reporter, [&] () {
+					xml.attribute("policy",         POLICY::name());
+					xml.attribute("hits",           _stats.hits);
+					xml.attribute("misses",         _stats.misses);
+					xml.attribute("evictions",      policy.evictions);
+					xml.attribute("resident",       policy.resident);
+					xml.attribute("prefetches",     _stats.prefetches);
+					xml.attribute("prefetched",     _stats.prefetched);
+					xml.attribute("write_backs",    _stats.write_backs);
+					xml.attribute("written_chunks", _stats.written_chunks);
+					xml.attribute("failed_writes",  _stats.failed_writes);
+				});
+			} catch (Genode::Xml_generator::Buffer_exceeded) { }
+		}
+
+		/*
+		 * Periodically write back dirty chunks
+		 *
+		 * In contrast to '_sync', the write back doesn't wait for a
+		 * congested backend device but is resumed at the next period.
+		 */
+		void _handle_timeout()
+		{
+			try {
+				_cache.sync(_blk_sz * _blk_cnt, 0);
+				_submit_extent();
+			} catch (Write_failed) { }
+
+			_report();
+		}
+
 		/*
 		 * Signal handler for yield requests of the parent
 		 */
@@ -330,9 +724,11 @@ class Driver : public Block::Driver
 		/*
 		 * Constructor
 		 *
-		 * \param ep  server entrypoint
+		 * \param env     component environment
+		 * \param heap    allocator for the cache chunks
+		 * \param config  component configuration
 		 */
-		Driver(Genode::Env &env, Genode::Heap &heap)
+		Driver(Genode::Env &env, Genode::Heap &heap, Genode::Xml_node config)
 		: Block::Driver(env.ram()),
 		  _env(env),
 		  _r_slab(&heap),
@@ -343,7 +739,11 @@ class Driver : public Block::Driver
 		  _cache(heap, 0),
 		  _source_ack(env.ep(), *this, &Driver::_ack_avail),
 		  _source_submit(env.ep(), *this, &Driver::_ready_to_submit),
-		  _yield(env.ep(), *this, &Driver::_parent_yield)
+		  _yield(env.ep(), *this, &Driver::_parent_yield),
+		  _timer(env),
+		  _timeout(env.ep(), *this, &Driver::_handle_timeout),
+		  _reporter(env, "statistics"),
+		  _wb_alloc(heap)
 		{
 			using namespace Genode;
 
@@ -360,6 +760,24 @@ class Driver : public Block::Driver
 
 			/* truncate chunk structure to real size of the device */
 			_cache.truncate(_blk_sz*_blk_cnt);
+
+			Genode::size_t const readahead =
+				config.attribute_value("readahead",
+				                       Genode::Number_of_bytes(MAX_READAHEAD/4));
+			_ra_blocks = Genode::min(readahead, (Genode::size_t)MAX_READAHEAD)
+			             / CACHE_BLK_SIZE * _cache_blk_mod();
+
+			try {
+				_reporter.enabled(config.sub_node("report")
+				                  .attribute_value("statistics", false));
+			} catch (Genode::Xml_node::Nonexistent_sub_node) { }
+
+			unsigned long const interval_ms =
+				config.attribute_value("write_back_interval_ms", 1000UL);
+			if (interval_ms) {
+				_timer.sigh(_timeout);
+				_timer.trigger_periodic(interval_ms*1000);
+			}
 		}
 
 		~Driver()
@@ -372,6 +790,43 @@ class Driver : public Block::Driver
 		Block::Session_client* blk()    { return &_blk;   }
 		Genode::size_t         blk_sz() { return _blk_sz; }
 
+		/*
+		 * Add dirty chunk to the request currently gathered for write back
+		 *
+		 * \throw Write_failed
+		 */
+		void write_back(Chunk_level_4 &chunk, char const *data)
+		{
+			Cache::offset_t const off = chunk.base_offset();
+
+			if (_extent_cnt
+			 && (_extent_cnt == MAX_EXTENT_CHUNKS
+			  || off != _extent_off + _extent_cnt*CACHE_BLK_SIZE))
+				_submit_extent();
+
+			if (!_extent_cnt)
+				_extent_off = off;
+
+			_extent[_extent_cnt++] = Extent_chunk { &chunk, data };
+		}
+
+		/*
+		 * Write back single dirty chunk immediately
+		 *
+		 * \return false as long as the chunk is not clean, i.e., the
+		 *         write back was not acknowledged by the device yet
+		 */
+		bool write_back(Chunk_level_4 &chunk)
+		{
+			try {
+				_submit_extent();
+				chunk.sync(CACHE_BLK_SIZE, chunk.base_offset());
+				_submit_extent();
+			} catch (Write_failed) { }
+
+			return !chunk.dirty();
+		}
+
 
 		/****************************
 		 ** Block-driver interface **
@@ -389,11 +844,12 @@ class Driver : public Block::Driver
 			if (!_ops.supported(Block::Packet_descriptor::READ))
 				throw Io_error();
 
-			if (!_stat(block_number, block_count, buffer, packet))
-				return;
+			if (_read(block_number, block_count, buffer, packet))
+				_stats.hits++;
+			else
+				_stats.misses++;
 
-			_cache.read(buffer, block_count*_blk_sz, block_number*_blk_sz);
-			ack_packet(packet);
+			_readahead(block_number, block_count);
 		}
 
 		void write(Block::sector_t           block_number,
@@ -404,20 +860,7 @@ class Driver : public Block::Driver
 			if (!_ops.supported(Block::Packet_descriptor::WRITE))
 				throw Io_error();
 
-			_cache.alloc(block_count * _blk_sz, block_number * _blk_sz);
-
-			if ((block_number % _cache_blk_mod()) &&
-			    !_stat(block_number, 1, const_cast<char* const>(buffer), packet))
-				return;
-
-			if (((block_number+block_count) % _cache_blk_mod())
-				&& !_stat(block_number+block_count-1, 1,
-				          const_cast<char* const>(buffer), packet))
-				return;
-
-			_cache.write(buffer, block_count * _blk_sz,
-			             block_number * _blk_sz);
-			ack_packet(packet);
+			_write(block_number, block_count, buffer, packet);
 		}
 
 		void sync() { _sync(); }
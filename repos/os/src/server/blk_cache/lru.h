@@ -5,21 +5,43 @@
  */
 
 /*
- * Copyright (C) 2013-2017 Genode Labs GmbH
+ * Copyright (C) 2013-2018 Genode Labs GmbH
  *
  * This file is part of the Genode OS framework, which is distributed
  * under the terms of the GNU Affero General Public License version 3.
  */
 
-#include <util/list.h>
+#ifndef _LRU_H_
+#define _LRU_H_
 
-#include "chunk.h"
+#include "policy.h"
 
-struct Lru_policy
+namespace Cache { class Lru; }
+
+
+class Cache::Lru : public Replacement_policy
 {
-	class Element : public Genode::List<Element>::Element {};
+	private:
+
+		Dlist<Element> _list { };
+
+	public:
+
+		void access(Element &e, offset_t) override
+		{
+			if (_list.contains(e)) _list.touch(e);
+			else                   _list.insert_head(e);
+		}
 
-	static void read(const Element  *e);
-	static void write(const Element *e);
-	static void flush(Cache::size_t size = 0);
+		Element *victim(unsigned long skip) override {
+			return _list.nth_from_tail(skip); }
+
+		void evict(Element &e, offset_t) override { remove(e); }
+
+		void remove(Element &e) override {
+			if (_list.contains(e)) _list.remove(e); }
+
+		unsigned long resident() const override { return _list.count(); }
 };
+
+#endif /* _LRU_H_ */
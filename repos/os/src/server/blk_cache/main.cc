@@ -12,36 +12,38 @@
  */
 
 #include <base/component.h>
+#include <base/attached_rom_dataspace.h>
 
-#include "lru.h"
+#include "policy.h"
 #include "driver.h"
 
-using Policy = Lru_policy;
+using Policy = Cache_policy;
 static Driver<Policy> * driver = nullptr;
 
 
 /**
  * Synchronize a chunk with the backend device
+ *
+ * The chunk is gathered with adjacent dirty chunks into one write request.
  */
 template <typename POLICY>
-void Driver<POLICY>::Policy::sync(const typename POLICY::Element *e, char *dst)
+void Driver<POLICY>::Policy::sync(const typename POLICY::Element *e, char *src)
 {
-	Cache::offset_t off =
-		static_cast<const Driver<POLICY>::Chunk_level_4*>(e)->base_offset();
-
-	if (!driver) throw Write_failed(off);
-
-	if (!driver->blk()->tx()->ready_to_submit())
-		throw Write_failed(off);
-	try {
-		Block::Packet_descriptor
-			p(driver->blk()->dma_alloc_packet(Driver::CACHE_BLK_SIZE),
-		      Block::Packet_descriptor::WRITE, off / driver->blk_sz(),
-		      Driver::CACHE_BLK_SIZE / driver->blk_sz());
-		driver->blk()->tx()->submit_packet(p);
-	} catch(Block::Session::Tx::Source::Packet_alloc_failed) {
-		throw Write_failed(off);
-	}
+	Driver<POLICY>::Chunk_level_4 *chunk =
+		const_cast<Driver<POLICY>::Chunk_level_4*>(
+			static_cast<const Driver<POLICY>::Chunk_level_4*>(e));
+
+	if (!driver) throw Write_failed(chunk->base_offset());
+
+	driver->write_back(*chunk, src);
+}
+
+
+template <typename POLICY>
+bool Driver<POLICY>::Policy::write_back(typename POLICY::Element *e)
+{
+	return driver && driver->write_back(
+		*static_cast<Driver<POLICY>::Chunk_level_4*>(e));
 }
 
 
@@ -50,32 +52,44 @@ struct Main
 	template <typename T>
 	struct Factory : Block::Driver_factory
 	{
-		Genode::Env  &env;
-		Genode::Heap &heap;
+		Genode::Env                    &env;
+		Genode::Heap                   &heap;
+		Genode::Attached_rom_dataspace &config;
 
-		Factory(Genode::Env &env, Genode::Heap &heap) : env(env), heap(heap) {}
+		Factory(Genode::Env &env, Genode::Heap &heap,
+		        Genode::Attached_rom_dataspace &config)
+		: env(env), heap(heap), config(config) {}
 
 		Block::Driver *create()
 		{
-			driver = new (&heap) ::Driver<T>(env, heap);
+			config.update();
+			driver = new (&heap) ::Driver<T>(env, heap, config.xml());
 			return driver;
 		}
 
-		void destroy(Block::Driver *driver) {
-			Genode::destroy(&heap, static_cast<::Driver<T>*>(driver)); }
+		void destroy(Block::Driver *d)
+		{
+			Genode::destroy(&heap, static_cast<::Driver<T>*>(d));
+			driver = nullptr;
+		}
 	};
 
 	void resource_handler() { }
 
-	Genode::Env                 &env;
-	Genode::Heap                 heap    { env.ram(), env.rm()     };
-	Factory<Lru_policy>          factory { env, heap               };
-	Block::Root                  root    { env.ep(), heap, env.rm(), factory, true };
-	Genode::Signal_handler<Main> resource_dispatcher {
+	Genode::Env                   &env;
+	Genode::Heap                   heap    { env.ram(), env.rm()     };
+	Genode::Attached_rom_dataspace config  { env, "config"           };
+	Factory<Policy>                factory { env, heap, config       };
+	Block::Root                    root    { env.ep(), heap, env.rm(), factory, true };
+	Genode::Signal_handler<Main>   resource_dispatcher {
 		env.ep(), *this, &Main::resource_handler };
 
 	Main(Genode::Env &env) : env(env)
 	{
+		Cache_policy::construct(heap,
+			config.xml().attribute_value("policy",
+			                             Genode::String<8>("lru")).string());
+
 		env.parent().announce(env.ep().manage(root));
 		env.parent().resource_avail_sigh(resource_dispatcher);
 	}
@@ -0,0 +1,104 @@
+/*
+ * \brief  Selection of the cache replacement strategy
+ * \author Genode Labs
+ * \date   2018-03-16
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#include <base/log.h>
+
+#include "lru.h"
+#include "two_q.h"
+#include "arc.h"
+#include "driver.h"
+
+typedef Driver<Cache_policy>::Chunk_level_4 Chunk;
+
+static Cache::Replacement_policy *policy      = nullptr;
+static char const                *policy_name = "none";
+static unsigned long              evictions   = 0;
+
+
+static Cache::offset_t key(Cache_policy::Element const *e) {
+	return static_cast<Chunk const *>(e)->base_offset(); }
+
+
+Cache::Policy_element::~Policy_element() { Cache_policy::remove(*this); }
+
+
+void Cache_policy::construct(Genode::Allocator &alloc, char const *name)
+{
+	using namespace Genode;
+
+	if (policy) return;
+
+	if (!strcmp(name, "arc")) {
+		policy = new (&alloc) Cache::Arc(alloc);
+		policy_name = "arc";
+	} else if (!strcmp(name, "2q")) {
+		policy = new (&alloc) Cache::Two_q(alloc);
+		policy_name = "2q";
+	} else {
+		if (strcmp(name, "lru"))
+			warning("unknown cache policy '", name, "', using LRU");
+		policy = new (&alloc) Cache::Lru();
+		policy_name = "lru";
+	}
+}
+
+
+char const *Cache_policy::name() { return policy_name; }
+
+
+Cache_policy::Stats Cache_policy::stats() {
+	return Stats { evictions, policy ? policy->resident() : 0 }; }
+
+
+void Cache_policy::read(const Element *e) {
+	if (policy) policy->access(*const_cast<Element *>(e), key(e)); }
+
+
+void Cache_policy::write(const Element *e) {
+	if (policy) policy->access(*const_cast<Element *>(e), key(e)); }
+
+
+void Cache_policy::remove(Element &e) {
+	if (policy) policy->remove(e); }
+
+
+void Cache_policy::flush(Cache::size_t size)
+{
+	if (!policy) return;
+
+	Cache::size_t s = 0;
+
+	/* dirty chunks that could not be written back stay in place */
+	unsigned long skipped = 0;
+
+	while ((size == 0) || (s < size)) {
+
+		Element *e = policy->victim(skipped);
+		if (!e)
+			break;
+
+		Chunk *cb = static_cast<Chunk*>(e);
+
+		if (cb->dirty() && !Driver<Cache_policy>::Policy::write_back(cb)) {
+			skipped++;
+			continue;
+		}
+
+		policy->evict(*e, cb->base_offset());
+		cb->free(Driver<Cache_policy>::CACHE_BLK_SIZE, cb->base_offset());
+		s += sizeof(Chunk);
+		evictions++;
+	}
+
+	if (s < size) throw Block::Driver::Request_congestion();
+}
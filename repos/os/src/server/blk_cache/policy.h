@@ -0,0 +1,335 @@
+/*
+ * \brief  Interface of cache replacement policies
+ * \author Genode Labs
+ * \date   2018-03-16
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _POLICY_H_
+#define _POLICY_H_
+
+/* Genode includes */
+#include <base/allocator.h>
+#include <util/interface.h>
+#include <util/string.h>
+
+#include "chunk.h"
+
+namespace Cache {
+
+	template <typename> class Dlist;
+
+	class Policy_element;
+	class Ghost_list;
+	struct Replacement_policy;
+}
+
+
+/**
+ * Intrusive doubly-linked list with constant-time removal
+ *
+ * The head of the list holds the most recently inserted element.
+ */
+template <typename T>
+class Cache::Dlist
+{
+	public:
+
+		class Element
+		{
+			private:
+
+				friend class Dlist;
+
+				T     *_prev = nullptr;
+				T     *_next = nullptr;
+				Dlist *_list = nullptr;
+
+			public:
+
+				T *next() const { return _next; }
+				T *prev() const { return _prev; }
+		};
+
+	private:
+
+		T            *_head  = nullptr;
+		T            *_tail  = nullptr;
+		unsigned long _count = 0;
+
+	public:
+
+		T *head() const { return _head; }
+		T *tail() const { return _tail; }
+
+		unsigned long count() const { return _count; }
+
+		bool contains(T const &e) const {
+			return static_cast<Element const &>(e)._list == this; }
+
+		void insert_head(T &e)
+		{
+			Element &le = e;
+			le._prev = nullptr;
+			le._next = _head;
+			le._list = this;
+
+			if (_head) static_cast<Element &>(*_head)._prev = &e;
+			else       _tail = &e;
+
+			_head = &e;
+			_count++;
+		}
+
+		/**
+		 * Remove element, which must be part of this list
+		 */
+		void remove(T &e)
+		{
+			Element &le = e;
+
+			if (le._prev) static_cast<Element &>(*le._prev)._next = le._next;
+			else          _head = le._next;
+
+			if (le._next) static_cast<Element &>(*le._next)._prev = le._prev;
+			else          _tail = le._prev;
+
+			le._prev = le._next = nullptr;
+			le._list = nullptr;
+			_count--;
+		}
+
+		/**
+		 * Return element at position 'n' counted from the tail, or nullptr
+		 */
+		T *nth_from_tail(unsigned long n) const
+		{
+			T *e = _tail;
+			for (; e && n; n--)
+				e = static_cast<Element *>(e)->_prev;
+			return e;
+		}
+
+		/**
+		 * Move element to the head of the list
+		 */
+		void touch(T &e)
+		{
+			if (_head == &e) return;
+			remove(e);
+			insert_head(e);
+		}
+};
+
+
+/**
+ * Per-chunk meta data of the replacement policy
+ */
+class Cache::Policy_element : public Dlist<Policy_element>::Element
+{
+	public:
+
+		/**
+		 * Destructor, detaches the element from the active policy
+		 */
+		~Policy_element();
+};
+
+
+/**
+ * History of recently evicted chunks
+ *
+ * Only the offsets of evicted chunks are remembered, in FIFO order. Lookup
+ * is done via a hash table.
+ */
+class Cache::Ghost_list
+{
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		Ghost_list(Ghost_list const &);
+		Ghost_list &operator = (Ghost_list const &);
+
+		struct Ghost : Dlist<Ghost>::Element
+		{
+			offset_t const key;
+			Ghost         *hash_next = nullptr;
+
+			Ghost(offset_t key) : key(key) { }
+		};
+
+		enum { BUCKETS = 1024, GRANULARITY = 4096 };
+
+		Genode::Allocator &_alloc;
+		Dlist<Ghost>       _fifo { };
+		Ghost             *_buckets[BUCKETS];
+
+		static unsigned _bucket(offset_t key) {
+			return (unsigned)((key / GRANULARITY) % BUCKETS); }
+
+		void _unlink(Ghost &g)
+		{
+			for (Ghost **p = &_buckets[_bucket(g.key)]; *p; p = &(*p)->hash_next)
+				if (*p == &g) { *p = g.hash_next; break; }
+
+			_fifo.remove(g);
+			Genode::destroy(&_alloc, &g);
+		}
+
+	public:
+
+		Ghost_list(Genode::Allocator &alloc) : _alloc(alloc) {
+			Genode::memset(_buckets, 0, sizeof(_buckets)); }
+
+		~Ghost_list() { trim(0); }
+
+		unsigned long count() const { return _fifo.count(); }
+
+		/**
+		 * Remember evicted chunk
+		 *
+		 * The history is best effort, when running out of memory the chunk
+		 * is just forgotten.
+		 */
+		void insert(offset_t key)
+		{
+			try {
+				Ghost &g = *new (&_alloc) Ghost(key);
+				g.hash_next = _buckets[_bucket(key)];
+				_buckets[_bucket(key)] = &g;
+				_fifo.insert_head(g);
+			} catch (Genode::Allocator::Out_of_memory) { }
+		}
+
+		/**
+		 * Forget chunk
+		 *
+		 * \return true if the chunk was part of the history
+		 */
+		bool remove(offset_t key)
+		{
+			for (Ghost *g = _buckets[_bucket(key)]; g; g = g->hash_next)
+				if (g->key == key) {
+					_unlink(*g);
+					return true;
+				}
+			return false;
+		}
+
+		/**
+		 * Drop oldest entries until at most 'max' entries are left
+		 */
+		void trim(unsigned long max)
+		{
+			while (_fifo.count() > max)
+				_unlink(*_fifo.tail());
+		}
+};
+
+
+/**
+ * Interface of a cache replacement policy
+ *
+ * The policy keeps track of all cached chunks, which are identified by
+ * their element and their device offset ('key').
+ */
+struct Cache::Replacement_policy : Genode::Interface
+{
+	typedef Policy_element Element;
+
+	/**
+	 * Chunk got read or written
+	 *
+	 * The first access of a chunk inserts it into the policy.
+	 */
+	virtual void access(Element &e, offset_t key) = 0;
+
+	/**
+	 * Return next chunk to evict
+	 *
+	 * \param skip  number of candidates to pass over in eviction order,
+	 *              e.g., dirty chunks that cannot be written back yet
+	 *
+	 * Passing over a candidate leaves the state of the policy untouched.
+	 *
+	 * \return  chunk to evict, or nullptr if less than 'skip' + 1 chunks
+	 *          are cached
+	 */
+	virtual Element *victim(unsigned long skip) = 0;
+
+	/**
+	 * Chunk is about to get evicted
+	 */
+	virtual void evict(Element &e, offset_t key) = 0;
+
+	/**
+	 * Chunk vanishes without being evicted, e.g., when truncating the cache
+	 */
+	virtual void remove(Element &e) = 0;
+
+	/**
+	 * Return number of chunks tracked as cached
+	 */
+	virtual unsigned long resident() const = 0;
+
+	/**
+	 * Return candidate at position 'n' of the eviction order that
+	 * continues with 'second' once 'first' is exhausted
+	 */
+	static Element *nth_victim(Dlist<Element> const &first,
+	                           Dlist<Element> const &second, unsigned long n)
+	{
+		return n < first.count() ? first.nth_from_tail(n)
+		                         : second.nth_from_tail(n - first.count());
+	}
+};
+
+
+/**
+ * Replacement policy used as template argument of the cache driver
+ *
+ * The static interface dispatches to the policy selected at startup.
+ */
+struct Cache_policy
+{
+	typedef Cache::Policy_element Element;
+
+	struct Stats
+	{
+		unsigned long evictions;
+		unsigned long resident;
+	};
+
+	/**
+	 * Select replacement policy by name ("lru", "2q", or "arc")
+	 *
+	 * Unknown names fall back to LRU.
+	 */
+	static void construct(Genode::Allocator &alloc, char const *name);
+
+	static char const *name();
+	static Stats       stats();
+
+	static void read(const Element  *e);
+	static void write(const Element *e);
+	static void remove(Element &e);
+
+	/**
+	 * Evict chunks to free at least 'size' bytes, all if 'size' is 0
+	 *
+	 * Dirty chunks are written back before eviction.
+	 *
+	 * \throw Block::Driver::Request_congestion
+	 */
+	static void flush(Cache::size_t size = 0);
+};
+
+#endif /* _POLICY_H_ */
@@ -0,0 +1,85 @@
+/*
+ * \brief  2Q cache replacement strategy
+ * \author Genode Labs
+ * \date   2018-03-16
+ *
+ * Chunks accessed once are kept in the FIFO 'A1in'. When evicted from
+ * there, they are remembered in the history 'A1out'. Only chunks that are
+ * accessed again while being remembered get promoted to the LRU list 'Am'.
+ * Hence, a sequential scan cannot displace the frequently used chunks.
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _TWO_Q_H_
+#define _TWO_Q_H_
+
+#include "policy.h"
+
+namespace Cache { class Two_q; }
+
+
+class Cache::Two_q : public Replacement_policy
+{
+	private:
+
+		Dlist<Element> _a1in { };
+		Dlist<Element> _am   { };
+		Ghost_list     _a1out;
+
+		/* capacity of the cache in chunks, learned at eviction time */
+		unsigned long _capacity = 0;
+
+		unsigned long _kin()  const { return Genode::max(1UL, _capacity / 4); }
+		unsigned long _kout() const { return _capacity / 2; }
+
+	public:
+
+		Two_q(Genode::Allocator &alloc) : _a1out(alloc) { }
+
+		void access(Element &e, offset_t key) override
+		{
+			if (_am.contains(e))   { _am.touch(e); return; }
+			if (_a1in.contains(e)) return;
+
+			if (_a1out.remove(key)) _am.insert_head(e);
+			else                    _a1in.insert_head(e);
+		}
+
+		Element *victim(unsigned long skip) override
+		{
+			_capacity = Genode::max(_capacity, resident());
+
+			if (_a1in.count() > _kin() || !_am.tail())
+				return nth_victim(_a1in, _am, skip);
+
+			return nth_victim(_am, _a1in, skip);
+		}
+
+		void evict(Element &e, offset_t key) override
+		{
+			if (_a1in.contains(e)) {
+				_a1in.remove(e);
+				_a1out.insert(key);
+				_a1out.trim(_kout());
+				return;
+			}
+			remove(e);
+		}
+
+		void remove(Element &e) override
+		{
+			if (_a1in.contains(e)) _a1in.remove(e);
+			if (_am.contains(e))   _am.remove(e);
+		}
+
+		unsigned long resident() const override {
+			return _a1in.count() + _am.count(); }
+};
+
+#endif /* _TWO_Q_H_ */
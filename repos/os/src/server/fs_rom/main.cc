@@ -91,6 +91,13 @@ class Fs_rom::Rom_session_component : public  Rpc_object<Rom_session>,
 		 */
 		Attached_ram_dataspace _file_ds;
 
+		/**
+		 * Dataspace provided by the file system, which exposes the file
+		 * content without copying, and the file handle it is bound to
+		 */
+		Dataspace_capability     _direct_ds     { };
+		File_system::File_handle _direct_handle { ~0UL };
+
 		/**
 		 * Signal destination for ROM file changes
 		 */
@@ -161,6 +168,36 @@ class Fs_rom::Rom_session_component : public  Rpc_object<Rom_session>,
 			_watching_file = false;
 		}
 
+		void _release_direct_dataspace()
+		{
+			if (!_direct_ds.valid())
+				return;
+
+			_fs.close(_direct_handle);
+			_direct_ds = Dataspace_capability();
+		}
+
+		/**
+		 * Try to use the file content in place
+		 *
+		 * \return true if the file system exposes the file content, in this
+		 *         case the file handle is kept open
+		 */
+		bool _use_direct_dataspace(File_system::File_handle file)
+		{
+			Dataspace_capability ds;
+			try { ds = _fs.dataspace(file); }
+			catch (...) { /* also covers servers that lack the RPC function */ }
+
+			if (!ds.valid())
+				return false;
+
+			_release_direct_dataspace();
+			_direct_ds     = ds;
+			_direct_handle = file;
+			return true;
+		}
+
 		enum { UPDATE_OR_REPLACE = false, UPDATE_ONLY = true };
 
 		/**
@@ -183,8 +220,22 @@ class Fs_rom::Rom_session_component : public  Rpc_object<Rom_session>,
 			_file_handle = _fs.file(
 				parent_handle, file_name.base() + 1,
 				File_system::READ_ONLY, false);
+
+			/* ...and kept open if the file content is used in place... */
+			if (!update_only && _use_direct_dataspace(_file_handle)) {
+				_handed_out_version = _curr_version;
+				return true;
+			}
+
 			Handle_guard file_guard(_fs, _file_handle);
-			/* ...but only for the lifetime of this procedure */
+			/* ...but otherwise only for the lifetime of this procedure */
+
+			/* an in-place dataspace cannot be updated */
+			if (_direct_ds.valid()) {
+				if (update_only)
+					return false;
+				_release_direct_dataspace();
+			}
 
 			_file_seek = 0;
 			_file_size = _fs.status(_file_handle).size;
@@ -304,6 +355,7 @@ class Fs_rom::Rom_session_component : public  Rpc_object<Rom_session>,
 		 */
 		~Rom_session_component()
 		{
+			_release_direct_dataspace();
 			_close_watch_handle();
 		}
 
@@ -316,6 +368,9 @@ class Fs_rom::Rom_session_component : public  Rpc_object<Rom_session>,
 
 			_try_read_dataspace(UPDATE_OR_REPLACE);
 
+			if (_direct_ds.valid())
+				return static_cap_cast<Rom_dataspace>(_direct_ds);
+
 			/* always serve a valid, even empty, dataspace */
 			if (_file_ds.size() < 1) {
 				_file_ds.realloc(&_env.ram(), 1);
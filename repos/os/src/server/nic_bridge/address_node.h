@@ -15,7 +15,6 @@
 #define _ADDRESS_NODE_H_
 
 /* Genode */
-#include <util/avl_tree.h>
 #include <util/list.h>
 #include <nic_session/nic_session.h>
 #include <net/netaddress.h>
@@ -30,24 +29,40 @@ namespace Net {
 
 	/**
 	 * An Address_node encapsulates a session-component and can be hold in
-	 * a list and/or avl-tree, whereby the network-address (MAC or IP)
+	 * a list and/or hash table, whereby the network-address (MAC or IP)
 	 * acts as a key.
 	 */
 	template <typename ADDRESS> class Address_node;
 
-	using Ipv4_address_node = Address_node<Ipv4_address>;
-	using Mac_address_node  = Address_node<Mac_address>;
+	/**
+	 * Hash table of address nodes
+	 */
+	template <typename NODE> class Address_table;
+
+	using Ipv4_address_node  = Address_node<Ipv4_address>;
+	using Mac_address_node   = Address_node<Mac_address>;
+	using Ipv4_address_table = Address_table<Ipv4_address_node>;
+	using Mac_address_table  = Address_table<Mac_address_node>;
 }
 
 
 template <typename ADDRESS>
-class Net::Address_node : public Genode::Avl_node<Address_node<ADDRESS> >,
-                          public Genode::List<Address_node<ADDRESS> >::Element
+class Net::Address_node : public Genode::List<Address_node<ADDRESS> >::Element
 {
+	friend class Address_table<Address_node>;
+
 	private:
 
-		ADDRESS            _addr;       /* MAC or IP address  */
-		Session_component &_component;  /* client's component */
+		ADDRESS            _addr;                 /* MAC or IP address  */
+		Session_component &_component;            /* client's component */
+		Address_node      *_hash_next { nullptr };
+		bool               _hashed    { false };
+
+		/*
+		 * Noncopyable
+		 */
+		Address_node(Address_node const &);
+		Address_node &operator = (Address_node const &);
 
 	public:
 
@@ -67,37 +82,86 @@ class Net::Address_node : public Genode::Avl_node<Address_node<ADDRESS> >,
 		 ** Accessors **
 		 ***************/
 
-		void               addr(Address addr) { _addr = addr;      }
-		Address            addr()             { return _addr;      }
-		Session_component &component()        { return _component; }
+		/**
+		 * Set address, must not be called while the node is in a table
+		 */
+		void               addr(Address addr)   { _addr = addr;      }
+		Address            addr()         const { return _addr;      }
+		Session_component &component()         { return _component; }
+		bool               hashed()       const { return _hashed;    }
+};
+
 
+template <typename NODE>
+class Net::Address_table
+{
+	private:
+
+		/*
+		 * The number of clients of a bridge is in the order of tens, so
+		 * a fixed number of buckets keeps the chains short without the
+		 * need for growing the table.
+		 */
+		enum { BUCKETS = 256 };
 
-		/************************
-		 ** Avl node interface **
-		 ************************/
+		using Address = typename NODE::Address;
 
-		bool higher(Address_node *c)
+		NODE *_buckets[BUCKETS] { };
+
+		static unsigned _hash(Address const &addr)
 		{
-			using namespace Genode;
+			/* the last bytes differ most in a local network */
+			unsigned hash = 0;
+			for (unsigned i = 0; i < sizeof(addr.addr); i++) {
+				hash = (hash << 3) ^ (hash >> 5) ^ addr.addr[i]; }
 
-			return (memcmp(&c->_addr.addr, &_addr.addr,
-			               sizeof(_addr.addr)) > 0);
+			return hash & (BUCKETS - 1);
 		}
 
+	public:
+
 		/**
-		 * Find by address
+		 * Insert node, a node with the same address shadows older ones
 		 */
-		Address_node *find_by_address(Address addr)
+		void insert(NODE &node)
 		{
-			using namespace Genode;
+			if (node._hashed) {
+				return; }
 
-			if (addr == _addr)
-				return this;
+			NODE *&bucket   = _buckets[_hash(node._addr)];
+			node._hash_next = bucket;
+			node._hashed    = true;
+			bucket          = &node;
+		}
 
-			bool side = memcmp(&addr.addr, _addr.addr,
-			                   sizeof(_addr.addr)) > 0;
-			Address_node *c = Avl_node<Address_node>::child(side);
-			return c ? c->find_by_address(addr) : 0;
+		void remove(NODE &node)
+		{
+			if (!node._hashed) {
+				return; }
+
+			for (NODE **n = &_buckets[_hash(node._addr)]; *n; n = &(*n)->_hash_next) {
+				if (*n != &node) {
+					continue; }
+
+				*n = node._hash_next;
+				break;
+			}
+			node._hash_next = nullptr;
+			node._hashed    = false;
+		}
+
+		/**
+		 * Find by address
+		 *
+		 * \return  pointer to the node or nullptr if there is none
+		 */
+		NODE *find(Address const &addr) const
+		{
+			for (NODE *n = _buckets[_hash(addr)]; n; n = n->_hash_next) {
+				if (n->_addr == addr) {
+					return n; }
+			}
+			return nullptr;
 		}
 };
 
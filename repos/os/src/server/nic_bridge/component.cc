@@ -25,6 +25,9 @@ using namespace Genode;
 bool Session_component::handle_arp(Ethernet_frame *eth, Genode::size_t size)
 {
 	Arp_packet &arp = eth->data<Arp_packet>(size - sizeof(Ethernet_frame));
+	if (arp.ethernet_ipv4())
+		_learn_ipv4_address(arp.src_ip());
+
 	if (arp.ethernet_ipv4() &&
 		arp.opcode() == Arp_packet::REQUEST) {
 
@@ -39,10 +42,7 @@ bool Session_component::handle_arp(Ethernet_frame *eth, Genode::size_t size)
 		 if (arp.src_ip() == arp.dst_ip())
 			return false;
 
-		Ipv4_address_node *node = vlan().ip_tree.first();
-		if (node)
-			node = node->find_by_address(arp.dst_ip());
-		if (!node) {
+		if (!vlan().session_by_ip(arp.dst_ip())) {
 			arp.src_mac(_nic.mac());
 		}
 	}
@@ -55,6 +55,8 @@ bool Session_component::handle_ip(Ethernet_frame *eth, Genode::size_t size)
 	size_t const ip_max_size = size - sizeof(Ethernet_frame);
 	Ipv4_packet &ip = eth->data<Ipv4_packet>(ip_max_size);
 	size_t const ip_size = ip.size(ip_max_size);
+	_learn_ipv4_address(ip.src());
+
 	if (ip.protocol() == Ipv4_packet::Protocol::UDP) {
 
 		size_t const udp_size = ip_size - sizeof(Ipv4_packet);
@@ -77,25 +79,98 @@ bool Session_component::handle_ip(Ethernet_frame *eth, Genode::size_t size)
 void Session_component::finalize_packet(Ethernet_frame *eth,
                                                     Genode::size_t size)
 {
-	Mac_address_node *node = vlan().mac_tree.first();
-	if (node)
-		node = node->find_by_address(eth->dst());
-	if (node)
-		node->component().send(eth, size);
+	Session_component *session = vlan().session_by_mac(eth->dst());
+	if (session)
+		forward(*session, eth, size);
 	else {
 		/* set our MAC as sender */
 		eth->src(_nic.mac());
-		_nic.send(eth, size);
+		forward(_nic, eth, size);
 	}
 }
 
 
-void Session_component::_unset_ipv4_node()
+void Session_component::_set_ipv4_address(Ipv4_address const &ip_addr)
+{
+	/* an IP address belongs to one client at most */
+	Ipv4_address_node *owner = vlan().ip_table.find(ip_addr);
+	if (owner)
+		vlan().ip_table.remove(*owner);
+
+	vlan().ip_table.remove(_ipv4_node);
+	_ipv4_node.addr(ip_addr);
+	vlan().ip_table.insert(_ipv4_node);
+	_ipv4_seen    = vlan().now;
+	_ipv4_learned = false;
+}
+
+
+void Session_component::_learn_ipv4_address(Ipv4_address const &ip_addr)
+{
+	if (!vlan().learn_ip)
+		return;
+
+	/*
+	 * The common case of a known address is checked without taking the
+	 * lock. A concurrent change of the address by the uplink can only
+	 * cause a stale refresh, which is harmless.
+	 */
+	if (_ipv4_node.hashed() && _ipv4_node.addr() == ip_addr) {
+		_ipv4_seen = vlan().now;
+		return;
+	}
+	if (!ip_addr.valid() || ip_addr == Ipv4_packet::broadcast())
+		return;
+
+	Genode::Lock::Guard guard(vlan().lock);
+
+	/*
+	 * Keep addresses assigned via DHCP or policy and those of others,
+	 * including the addresses of the hosts at the uplink
+	 */
+	if (_ipv4_node.hashed() || vlan().ip_table.find(ip_addr)
+	 || vlan().uplink_ip(ip_addr))
+		return;
+
+	_set_ipv4_address(ip_addr);
+	_ipv4_learned = true;
+}
+
+
+void Session_component::expire_ipv4_address(unsigned long now,
+                                            unsigned long max_age)
+{
+	if (!_ipv4_learned || !_ipv4_node.hashed() || now - _ipv4_seen < max_age)
+		return;
+
+	Genode::log("expired ip = ", _ipv4_node.addr(), " of vmac = ", _mac_node.addr());
+	vlan().ip_table.remove(_ipv4_node);
+	_ipv4_learned = false;
+}
+
+
+void Session_component::drop_learned_ipv4_address()
 {
-	Ipv4_address_node * first = vlan().ip_tree.first();
-	if (!first) return;
-	if (first->find_by_address(_ipv4_node.addr()))
-		vlan().ip_tree.remove(&_ipv4_node);
+	if (!_ipv4_learned || !_ipv4_node.hashed())
+		return;
+
+	Genode::warning("uplink claims learned ip = ", _ipv4_node.addr(),
+	                " of vmac = ", _mac_node.addr());
+	vlan().ip_table.remove(_ipv4_node);
+	_ipv4_learned = false;
+}
+
+
+void Session_component::report(Genode::Xml_generator &xml)
+{
+	xml.node("session", [&] () {
+		xml.attribute("label", _label.string());
+		xml.attribute("mac", Genode::String<32>(_mac_node.addr()));
+		if (_ipv4_node.hashed())
+			xml.attribute("ip", Genode::String<16>(_ipv4_node.addr()));
+
+		stats().report(xml);
+	});
 }
 
 
@@ -104,21 +179,21 @@ bool Session_component::link_state() { return _nic.link_state(); }
 
 void Session_component::set_ipv4_address(Ipv4_address ip_addr)
 {
-	_unset_ipv4_node();
-	_ipv4_node.addr(ip_addr);
-	vlan().ip_tree.insert(&_ipv4_node);
+	Genode::Lock::Guard guard(vlan().lock);
+	_set_ipv4_address(ip_addr);
 }
 
 
-Session_component::Session_component(Genode::Ram_session        &ram,
-                                     Genode::Region_map         &rm,
-                                     Genode::Entrypoint         &ep,
-                                     Genode::size_t              amount,
-                                     Genode::size_t              tx_buf_size,
-                                     Genode::size_t              rx_buf_size,
-                                     Mac_address                 vmac,
-                                     Net::Nic                   &nic,
-                                     char                       *ip_addr)
+Session_component::Session_component(Genode::Ram_session         &ram,
+                                     Genode::Region_map          &rm,
+                                     Genode::Entrypoint          &ep,
+                                     Genode::size_t               amount,
+                                     Genode::size_t               tx_buf_size,
+                                     Genode::size_t               rx_buf_size,
+                                     Mac_address                  vmac,
+                                     Genode::Session_label const &label,
+                                     Net::Nic                    &nic,
+                                     char                        *ip_addr)
 : Stream_allocator(ram, rm, amount),
   Stream_dataspaces(ram, tx_buf_size, rx_buf_size),
   Session_rpc_object(rm,
@@ -126,12 +201,16 @@ Session_component::Session_component(Genode::Ram_session        &ram,
                      Stream_dataspaces::rx_ds,
                      Stream_allocator::range_allocator(), ep.rpc_ep()),
   Packet_handler(ep, nic.vlan()),
+  _label(label),
   _mac_node(*this, vmac),
   _ipv4_node(*this),
   _nic(nic)
 {
-	vlan().mac_tree.insert(&_mac_node);
-	vlan().mac_list.insert(&_mac_node);
+	{
+		Genode::Lock::Guard guard(vlan().lock);
+		vlan().mac_table.insert(_mac_node);
+		vlan().mac_list.insert(&_mac_node);
+	}
 
 	/* static ip parsing */
 	if (ip_addr != 0 && Genode::strlen(ip_addr)) {
@@ -152,8 +231,13 @@ Session_component::Session_component(Genode::Ram_session        &ram,
 }
 
 
-Session_component::~Session_component() {
-	vlan().mac_tree.remove(&_mac_node);
+Session_component::~Session_component()
+{
+	/* wait until the uplink does not refer to the session anymore */
+	Genode::Lock::Guard handling_guard(_nic.handling_lock());
+	Genode::Lock::Guard guard(vlan().lock);
+
+	vlan().mac_table.remove(_mac_node);
 	vlan().mac_list.remove(&_mac_node);
-	_unset_ipv4_node();
+	vlan().ip_table.remove(_ipv4_node);
 }
@@ -100,12 +100,28 @@ class Net::Session_component : private Net::Stream_allocator,
 {
 	private:
 
+		Genode::Session_label const       _label;
 		Mac_address_node                  _mac_node;
 		Ipv4_address_node                 _ipv4_node;
 		Net::Nic                         &_nic;
 		Genode::Signal_context_capability _link_state_sigh { };
 
-		void _unset_ipv4_node();
+		/* IP address was learned from a packet and is subject to aging */
+		bool                              _ipv4_learned { false };
+
+		/* time of the last packet from the IP address, see 'Vlan::now' */
+		unsigned long                     _ipv4_seen    { 0 };
+
+		/**
+		 * Assign IP address to the client, must be called with the
+		 * lock of the VLAN held
+		 */
+		void _set_ipv4_address(Ipv4_address const &ip_addr);
+
+		/**
+		 * Learn IP address from a packet sent by the client
+		 */
+		void _learn_ipv4_address(Ipv4_address const &ip_addr);
 
 	public:
 
@@ -119,16 +135,18 @@ class Net::Session_component : private Net::Stream_allocator,
 		 * \param tx_buf_size  buffer size for tx channel
 		 * \param rx_buf_size  buffer size for rx channel
 		 * \param vmac         virtual mac address
+		 * \param label        label of the session
 		 */
-		Session_component(Genode::Ram_session &ram,
-		                  Genode::Region_map  &rm,
-		                  Genode::Entrypoint  &ep,
-		                  Genode::size_t       amount,
-		                  Genode::size_t       tx_buf_size,
-		                  Genode::size_t       rx_buf_size,
-		                  Mac_address          vmac,
-		                  Net::Nic            &nic,
-		                  char                *ip_addr = 0);
+		Session_component(Genode::Ram_session         &ram,
+		                  Genode::Region_map          &rm,
+		                  Genode::Entrypoint          &ep,
+		                  Genode::size_t               amount,
+		                  Genode::size_t               tx_buf_size,
+		                  Genode::size_t               rx_buf_size,
+		                  Mac_address                  vmac,
+		                  Genode::Session_label const &label,
+		                  Net::Nic                    &nic,
+		                  char                        *ip_addr = 0);
 
 		~Session_component();
 
@@ -148,6 +166,24 @@ class Net::Session_component : private Net::Stream_allocator,
 
 		void set_ipv4_address(Ipv4_address ip_addr);
 
+		/**
+		 * Forget a learned IP address that was not used for 'max_age'
+		 * seconds, must be called with the lock of the VLAN held
+		 */
+		void expire_ipv4_address(unsigned long now, unsigned long max_age);
+
+		/**
+		 * Forget a learned IP address because the uplink claims it, must be
+		 * called with the lock of the VLAN held
+		 */
+		void drop_learned_ipv4_address();
+
+		/**
+		 * Report state and counters, must be called with the lock of the
+		 * VLAN held
+		 */
+		void report(Genode::Xml_generator &xml);
+
 
 		/****************************************
 		 ** Nic::Driver notification interface **
@@ -197,8 +233,8 @@ class Net::Root : public Genode::Root_component<Net::Session_component>
 			char ip_addr[MAX_IP_ADDR_LENGTH];
 			memset(ip_addr, 0, MAX_IP_ADDR_LENGTH);
 
-			 try {
-				Session_label const label = label_from_args(args);
+			Session_label const label = label_from_args(args);
+			try {
 				Session_policy policy(label, _config);
 				policy.attribute("ip_addr").value(ip_addr, sizeof(ip_addr));
 			} catch (Xml_node::Nonexistent_attribute) {
@@ -216,7 +252,7 @@ class Net::Root : public Genode::Root_component<Net::Session_component>
 				return new (md_alloc())
 					Session_component(_env.ram(), _env.rm(), _env.ep(),
 					                  ram_quota, tx_buf_size, rx_buf_size,
-					                  _mac_alloc.alloc(), _nic, ip_addr);
+					                  _mac_alloc.alloc(), label, _nic, ip_addr);
 			}
 			catch (Mac_allocator::Alloc_failed) {
 				Genode::warning("Mac address allocation failed!");
@@ -20,6 +20,8 @@
 #include <base/log.h>
 #include <nic_session/connection.h>
 #include <nic/packet_allocator.h>
+#include <os/reporter.h>
+#include <timer_session/connection.h>
 
 /* local includes */
 #include <component.h>
@@ -27,13 +29,74 @@
 
 struct Main
 {
-	Genode::Env                    &env;
-	Genode::Entrypoint             &ep     { env.ep() };
-	Genode::Heap                    heap   { env.ram(), env.rm() };
-	Genode::Attached_rom_dataspace  config { env, "config" };
-	Net::Vlan                       vlan   { };
-	Net::Nic                        nic    { env, heap, vlan };
-	Net::Root                       root   { env, nic, heap, config.xml() };
+	enum { UPLINK_STACK_SIZE = 4 * 1024 * sizeof(Genode::addr_t) };
+
+	Genode::Env                               &env;
+	Genode::Entrypoint                        &ep     { env.ep() };
+	Genode::Heap                               heap   { env.ram(), env.rm() };
+	Genode::Attached_rom_dataspace             config { env, "config" };
+	Net::Vlan                                  vlan   { };
+	Genode::Constructible<Genode::Entrypoint>  uplink_ep { };
+	Net::Nic                                   nic    { env, uplink_entrypoint(), heap, vlan };
+	Net::Root                                  root   { env, nic, heap, config.xml() };
+
+	unsigned long const ip_aging_sec {
+		config.xml().attribute_value("ip_aging_sec", 0UL) };
+
+	unsigned long report_interval_sec { 0 };
+
+	Genode::Constructible<Timer::Connection>          timer    { };
+	Genode::Constructible<Genode::Expanding_reporter> reporter { };
+
+	Genode::Signal_handler<Main> timer_handler {
+		ep, *this, &Main::handle_timer };
+
+	/**
+	 * Return entrypoint for the uplink
+	 *
+	 * By default, the uplink is handled by the component's entrypoint.
+	 * With the 'uplink_thread' config attribute set, it is handled by a
+	 * dedicated thread so that traffic between clients is not serialized
+	 * with the traffic from the uplink.
+	 */
+	Genode::Entrypoint &uplink_entrypoint()
+	{
+		if (!config.xml().attribute_value("uplink_thread", false))
+			return ep;
+
+		uplink_ep.construct(env, UPLINK_STACK_SIZE, "uplink_ep");
+		return *uplink_ep;
+	}
+
+	void handle_timer()
+	{
+		unsigned long const now = ++vlan.now;
+
+		if (ip_aging_sec)
+			vlan.for_each_session([&] (Net::Session_component &session) {
+				session.expire_ipv4_address(now, ip_aging_sec); });
+
+		if (reporter.constructed() && now % report_interval_sec == 0)
+			reporter->generate([&] (Genode::Xml_generator &xml) {
+				xml.node("uplink", [&] () {
+					xml.attribute("mac", Genode::String<32>(nic.mac()));
+					nic.stats().report(xml);
+				});
+				vlan.for_each_session([&] (Net::Session_component &session) {
+					session.report(xml); });
+			});
+	}
+
+	void handle_report_config()
+	{
+		try {
+			Genode::Xml_node const report = config.xml().sub_node("report");
+			report_interval_sec =
+				Genode::max(report.attribute_value("interval_sec", 5UL), 1UL);
+			reporter.construct(env, "state", "state");
+		}
+		catch (Genode::Xml_node::Nonexistent_sub_node) { }
+	}
 
 	void handle_config()
 	{
@@ -51,6 +114,15 @@ struct Main
 		try {
 			/* read configuration file */
 			handle_config();
+			vlan.learn_ip = config.xml().attribute_value("learn_ip", false);
+			handle_report_config();
+
+			/* the timer is needed for aging and reporting only */
+			if (ip_aging_sec || reporter.constructed()) {
+				timer.construct(env);
+				timer->sigh(timer_handler);
+				timer->trigger_periodic(1000*1000);
+			}
 
 			/* show MAC address to use */
 			Net::Mac_address mac(nic.mac());
@@ -31,11 +31,20 @@ bool Net::Nic::handle_arp(Ethernet_frame *eth, Genode::size_t size) {
 	if (!arp.ethernet_ipv4())
 		return true;
 
+	/* clients must not claim the address of a host at the uplink */
+	if (vlan().learn_ip && arp.src_ip().valid()) {
+		Genode::Lock::Guard guard(vlan().lock);
+
+		vlan().add_uplink_ip(arp.src_ip());
+
+		Ipv4_address_node *node = vlan().ip_table.find(arp.src_ip());
+		if (node)
+			node->component().drop_learned_ipv4_address();
+	}
+
 	/* look whether the IP address is one of our client's */
-	Ipv4_address_node *node = vlan().ip_tree.first();
-	if (node)
-		node = node->find_by_address(arp.dst_ip());
-	if (node) {
+	Session_component *session = vlan().session_by_ip(arp.dst_ip());
+	if (session) {
 		if (arp.opcode() == Arp_packet::REQUEST) {
 			/*
 			 * The ARP packet gets re-written, we interchange source
@@ -52,12 +61,12 @@ bool Net::Nic::handle_arp(Ethernet_frame *eth, Genode::size_t size) {
 
 			/* set our MAC as sender */
 			eth->src(mac());
-			send(eth, size);
+			forward(*this, eth, size);
 		} else {
 			/* overwrite destination MAC */
-			arp.dst_mac(node->component().mac_address().addr);
-			eth->dst(node->component().mac_address().addr);
-			node->component().send(eth, size);
+			arp.dst_mac(session->mac_address().addr);
+			eth->dst(session->mac_address().addr);
+			forward(*session, eth, size);
 		}
 		return false;
 	}
@@ -94,12 +103,10 @@ bool Net::Nic::handle_ip(Ethernet_frame *eth, Genode::size_t size) {
 					 * session-component
 					 */
 					if (msg_type == Dhcp_packet::Message_type::ACK) {
-						Mac_address_node *node =
-							vlan().mac_tree.first();
-						if (node)
-							node = node->find_by_address(dhcp.client_mac());
-						if (node)
-							node->component().set_ipv4_address(dhcp.yiaddr());
+						Session_component *session =
+							vlan().session_by_mac(dhcp.client_mac());
+						if (session)
+							session->set_ipv4_address(dhcp.yiaddr());
 					}
 				}
 				catch (Dhcp_packet::Option_not_found) { }
@@ -109,25 +116,23 @@ bool Net::Nic::handle_ip(Ethernet_frame *eth, Genode::size_t size) {
 
 	/* is it an unicast message to one of our clients ? */
 	if (eth->dst() == mac()) {
-		Ipv4_address_node *node = vlan().ip_tree.first();
-		if (node) {
-			node = node->find_by_address(ip.dst());
-			if (node) {
-				/* overwrite destination MAC */
-				eth->dst(node->component().mac_address().addr);
-
-				/* deliver the packet to the client */
-				node->component().send(eth, size);
-				return false;
-			}
+		Session_component *session = vlan().session_by_ip(ip.dst());
+		if (session) {
+			/* overwrite destination MAC */
+			eth->dst(session->mac_address().addr);
+
+			/* deliver the packet to the client */
+			forward(*session, eth, size);
+			return false;
 		}
 	}
 	return true;
 }
 
 
-Net::Nic::Nic(Genode::Env &env, Genode::Heap &heap, Net::Vlan &vlan)
-: Packet_handler(env.ep(), vlan),
+Net::Nic::Nic(Genode::Env &env, Genode::Entrypoint &ep, Genode::Heap &heap,
+              Net::Vlan &vlan)
+: Packet_handler(ep, vlan),
   _tx_block_alloc(&heap),
   _nic(env, &_tx_block_alloc, BUF_SIZE, BUF_SIZE),
   _mac(_nic.mac_address().addr)
@@ -37,7 +37,13 @@ class Net::Nic : public Net::Packet_handler
 
 	public:
 
-		Nic(Genode::Env&, Genode::Heap&, Vlan&);
+		/**
+		 * Constructor
+		 *
+		 * \param ep  entrypoint that handles the packets of the uplink,
+		 *            either the one of the component or a dedicated one
+		 */
+		Nic(Genode::Env&, Genode::Entrypoint &ep, Genode::Heap&, Vlan&);
 
 		::Nic::Connection          *nic() { return &_nic; }
 		Mac_address mac() { return _mac; }
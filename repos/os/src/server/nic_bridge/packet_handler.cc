@@ -25,37 +25,102 @@ using namespace Net;
 
 void Packet_handler::_ready_to_submit()
 {
+	Genode::Lock::Guard guard(_handling_lock);
+
 	/* as long as packets are available, and we can ack them */
 	while (sink()->packet_avail()) {
-		_packet = sink()->get_packet();
-		if (!_packet.size()) continue;
-		handle_ethernet(sink()->packet_content(_packet), _packet.size());
 
-		if (!sink()->ready_to_ack()) {
+		unsigned const max = Genode::min((unsigned)MAX_BURST,
+		                                 sink()->ack_slots_free());
+		if (!max) {
 			Genode::warning("ack state FULL");
 			return;
 		}
+		unsigned const cnt = sink()->get_packets(_rx_burst, max);
+		for (unsigned i = 0; i < cnt; i++) {
+
+			Packet_descriptor const &packet  = _rx_burst[i];
+			void                    *content = sink()->packet_content(packet);
+			if (!packet.size() || !content) continue;
 
-		sink()->acknowledge_packet(_packet);
+			_stats.rx_packets++;
+			_stats.rx_bytes += packet.size();
+			handle_ethernet(content, packet.size());
+		}
+		_flush_destinations();
+		sink()->acknowledge_packets(_rx_burst, cnt);
 	}
 }
 
 
 void Packet_handler::_ready_to_ack()
 {
+	Genode::Lock::Guard guard(_source_lock);
+
 	/* check for acknowledgements */
-	while (source()->ack_avail())
-		source()->release_packet(source()->get_acked_packet());
+	Packet_descriptor acked[MAX_BURST];
+	while (source()->ack_avail()) {
+		unsigned const cnt = source()->get_acked_packets(acked, MAX_BURST);
+		for (unsigned i = 0; i < cnt; i++)
+			source()->release_packet(acked[i]);
+	}
 }
 
 
 void Packet_handler::_link_state()
 {
-	Mac_address_node *node = _vlan.mac_list.first();
-	while (node) {
-		node->component().link_state_changed();
-		node = node->next();
+	Genode::Lock::Guard guard(_handling_lock);
+
+	_vlan.for_each_session([&] (Session_component &session) {
+		session.link_state_changed(); });
+}
+
+
+bool Packet_handler::_enqueue(Ethernet_frame const &eth, Genode::size_t size)
+{
+	/* do not block on a client that does not process its packets */
+	if (_tx_burst_cnt >= source()->submit_slots_free()) {
+		_stats.tx_dropped++;
+		return false;
+	}
+	try {
+		/* copy and queue packet */
+		Packet_descriptor packet  = source()->alloc_packet(size);
+		char             *content = source()->packet_content(packet);
+		Genode::memcpy((void*)content, (void*)&eth, size);
+		_tx_burst[_tx_burst_cnt++] = packet;
+		_stats.tx_packets++;
+		_stats.tx_bytes += size;
+	} catch(Packet_stream_source< ::Nic::Session::Policy>::Packet_alloc_failed) {
+		Genode::warning("Packet dropped");
+		_stats.tx_dropped++;
+		return false;
+	}
+	if (_tx_burst_cnt == MAX_BURST)
+		_flush();
+
+	return true;
+}
+
+
+void Packet_handler::_flush()
+{
+	if (!_tx_burst_cnt)
+		return;
+
+	source()->submit_packets(_tx_burst, _tx_burst_cnt);
+	_tx_burst_cnt = 0;
+}
+
+
+void Packet_handler::_flush_destinations()
+{
+	for (unsigned i = 0; i < _destinations_cnt; i++) {
+		Packet_handler &dst = *_destinations[i];
+		Genode::Lock::Guard guard(dst._source_lock);
+		dst._flush();
 	}
+	_destinations_cnt = 0;
 }
 
 
@@ -63,14 +128,10 @@ void Packet_handler::broadcast_to_clients(Ethernet_frame *eth, Genode::size_t si
 {
 	/* check whether it's really a broadcast packet */
 	if (eth->dst() == Ethernet_frame::broadcast()) {
-		/* iterate through the list of clients */
-		Mac_address_node *node =
-			_vlan.mac_list.first();
-		while (node) {
-			/* deliver packet */
-			node->component().send(eth, size);
-			node = node->next();
-		}
+
+		/* deliver packet to all clients */
+		_vlan.for_each_session([&] (Session_component &session) {
+			forward(session, eth, size); });
 	}
 }
 
@@ -103,17 +164,42 @@ void Packet_handler::handle_ethernet(void* src, Genode::size_t size)
 }
 
 
-void Packet_handler::send(Ethernet_frame *eth, Genode::size_t size)
+void Packet_handler::forward(Packet_handler &dst, Ethernet_frame *eth,
+                             Genode::size_t size)
 {
-	try {
-		/* copy and submit packet */
-		Packet_descriptor packet  = source()->alloc_packet(size);
-		char             *content = source()->packet_content(packet);
-		Genode::memcpy((void*)content, (void*)eth, size);
-		source()->submit_packet(packet);
-	} catch(Packet_stream_source< ::Nic::Session::Policy>::Packet_alloc_failed) {
-		Genode::warning("Packet dropped");
+	{
+		Genode::Lock::Guard guard(dst._source_lock);
+		if (!dst._enqueue(*eth, size))
+			return;
 	}
+	/* remember destination for the flush at the end of the burst */
+	for (unsigned i = 0; i < _destinations_cnt; i++)
+		if (_destinations[i] == &dst)
+			return;
+
+	if (_destinations_cnt < MAX_DESTINATIONS) {
+		_destinations[_destinations_cnt++] = &dst;
+		return;
+	}
+	Genode::Lock::Guard guard(dst._source_lock);
+	dst._flush();
+}
+
+
+Packet_handler::Stats Packet_handler::stats()
+{
+	Genode::Lock::Guard guard(_source_lock);
+	return _stats;
+}
+
+
+void Packet_handler::Stats::report(Genode::Xml_generator &xml) const
+{
+	xml.attribute("rx_packets", rx_packets);
+	xml.attribute("rx_bytes",   rx_bytes);
+	xml.attribute("tx_packets", tx_packets);
+	xml.attribute("tx_bytes",   tx_bytes);
+	xml.attribute("tx_dropped", tx_dropped);
 }
 
 
@@ -15,9 +15,9 @@
 #define _PACKET_HANDLER_H_
 
 /* Genode */
-#include <base/semaphore.h>
-#include <base/thread.h>
+#include <base/lock.h>
 #include <nic_session/connection.h>
+#include <util/xml_generator.h>
 #include <net/ethernet.h>
 #include <net/ipv4.h>
 
@@ -37,10 +37,76 @@ namespace Net {
  */
 class Net::Packet_handler
 {
+	public:
+
+		/**
+		 * Per-port counters
+		 */
+		struct Stats
+		{
+			unsigned long rx_packets { 0 };
+			unsigned long rx_bytes   { 0 };
+			unsigned long tx_packets { 0 };
+			unsigned long tx_bytes   { 0 };
+			unsigned long tx_dropped { 0 };
+
+			void report(Genode::Xml_generator &xml) const;
+		};
+
 	private:
 
-		Packet_descriptor _packet { };
+		/*
+		 * Received packets are handled in bursts of at most 'MAX_BURST'
+		 * packets. Packets that are forwarded while handling a burst are
+		 * collected at their destination and submitted in one batch at
+		 * the end of the burst. 'MAX_DESTINATIONS' limits the number of
+		 * destinations that are flushed at the end of a burst, further
+		 * destinations are flushed immediately.
+		 */
+		enum { MAX_BURST = 32, MAX_DESTINATIONS = 64 };
+
 		Net::Vlan        &_vlan;
+		Packet_descriptor _rx_burst[MAX_BURST] { };
+		Packet_descriptor _tx_burst[MAX_BURST] { };
+		unsigned          _tx_burst_cnt { 0 };
+		Packet_handler   *_destinations[MAX_DESTINATIONS] { };
+		unsigned          _destinations_cnt { 0 };
+		Stats             _stats { };
+
+		/*
+		 * The source of a handler is used by all handlers that forward
+		 * packets to it and, thereby, by all threads of the bridge.
+		 */
+		Genode::Lock      _source_lock { };
+
+		/*
+		 * Held while the handler processes received packets or link-state
+		 * changes
+		 */
+		Genode::Lock      _handling_lock { };
+
+		/*
+		 * Noncopyable
+		 */
+		Packet_handler(Packet_handler const &);
+		Packet_handler &operator = (Packet_handler const &);
+
+		/**
+		 * Copy ethernet frame into a packet of the source and queue it
+		 *
+		 * \return  true if the packet was queued, false if it was dropped
+		 */
+		bool _enqueue(Ethernet_frame const &eth, Genode::size_t size);
+
+		/**
+		 * Submit all queued packets
+		 */
+		void _flush();
+
+		/**
+		 * Flush all destinations of the current burst
+		 */
+		void _flush_destinations();
 
 		/**
 		 * submit queue not empty anymore
@@ -92,6 +158,13 @@ class Net::Packet_handler
 
 		Net::Vlan & vlan() { return _vlan; }
 
+		Genode::Lock &handling_lock() { return _handling_lock; }
+
+		/**
+		 * Return a copy of the per-port counters
+		 */
+		Stats stats();
+
 		/**
 		 * Broadcasts ethernet frame to all clients,
 		 * as long as its really a broadcast packtet.
@@ -103,12 +176,18 @@ class Net::Packet_handler
 		                                 Genode::size_t size);
 
 		/**
-		 * Send ethernet frame
+		 * Send ethernet frame via another handler or this one
+		 *
+		 * The frame is submitted at the end of the burst that is
+		 * currently handled, together with all other frames for the
+		 * same destination.
 		 *
+		 * \param dst   handler to send the frame to.
 		 * \param eth   ethernet frame to send.
 		 * \param size  ethernet frame's size.
 		 */
-		void send(Ethernet_frame *eth, Genode::size_t size);
+		void forward(Packet_handler &dst, Ethernet_frame *eth,
+		             Genode::size_t size);
 
 		/**
 		 * Handle an ethernet packet
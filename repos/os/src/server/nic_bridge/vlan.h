@@ -3,7 +3,7 @@
  * \author Stefan Kalkowski
  * \date   2010-08-18
  *
- * A database containing all clients sorted by IP and MAC addresses.
+ * A database containing all clients hashed by IP and MAC addresses.
  */
 
 /*
@@ -16,7 +16,7 @@
 #ifndef _VLAN_H_
 #define _VLAN_H_
 
-#include <util/avl_tree.h>
+#include <base/lock.h>
 #include <util/list.h>
 #include <address_node.h>
 
@@ -24,17 +24,96 @@ namespace Net {
 
 	/*
 	 * The Vlan is a database containing all clients
-	 * sorted by IP and MAC addresses.
+	 * hashed by IP and MAC addresses.
+	 *
+	 * If the uplink is handled by a dedicated thread, the database is
+	 * accessed concurrently. Therefore, all accesses must be done with
+	 * 'lock' held.
 	 */
 	struct Vlan
 	{
-		using Mac_address_tree  = Genode::Avl_tree<Mac_address_node>;
-		using Ipv4_address_tree = Genode::Avl_tree<Ipv4_address_node>;
-		using Mac_address_list  = Genode::List<Mac_address_node>;
+		using Mac_address_list = Genode::List<Mac_address_node>;
 
-		Mac_address_tree  mac_tree { };
-		Mac_address_list  mac_list { };
-		Ipv4_address_tree ip_tree  { };
+		Genode::Lock       lock     { };
+		Mac_address_table  mac_table { };
+		Mac_address_list   mac_list  { };
+		Ipv4_address_table ip_table  { };
+
+		/*
+		 * Coarse clock in seconds for the aging of learned IP
+		 * addresses, advanced only if aging is enabled
+		 */
+		unsigned long now { 0 };
+
+		/* learn the IP addresses of clients from their packets */
+		bool learn_ip { false };
+
+		/*
+		 * IP addresses the uplink has shown as its own by sending ARP
+		 * packets, which must not be learned for a client
+		 *
+		 * The set is bounded. An address is displaced by a later one that
+		 * maps to the same slot. The slot is selected by the least
+		 * significant bits of the address, so the hosts of the uplink's
+		 * subnet do not displace each other.
+		 */
+		enum { UPLINK_IPS = 1024 };
+
+		Ipv4_address uplink_ips[UPLINK_IPS] { };
+
+		static unsigned _uplink_slot(Ipv4_address const &ip) {
+			return ((ip.addr[2] << 8) | ip.addr[3]) % UPLINK_IPS; }
+
+		/**
+		 * Remember IP address of the uplink, must be called with 'lock' held
+		 */
+		void add_uplink_ip(Ipv4_address const &ip) {
+			uplink_ips[_uplink_slot(ip)] = ip; }
+
+		/**
+		 * Return whether the uplink has shown the IP address as its own,
+		 * must be called with 'lock' held
+		 */
+		bool uplink_ip(Ipv4_address const &ip) const {
+			return uplink_ips[_uplink_slot(ip)] == ip; }
+
+		/**
+		 * Return client that owns the MAC address 'mac'
+		 *
+		 * \return  pointer to the client's session or nullptr
+		 */
+		Session_component *session_by_mac(Mac_address const &mac)
+		{
+			Genode::Lock::Guard guard(lock);
+			Mac_address_node *node = mac_table.find(mac);
+			return node ? &node->component() : nullptr;
+		}
+
+		/**
+		 * Return client that owns the IP address 'ip'
+		 *
+		 * \return  pointer to the client's session or nullptr
+		 */
+		Session_component *session_by_ip(Ipv4_address const &ip)
+		{
+			Genode::Lock::Guard guard(lock);
+			Ipv4_address_node *node = ip_table.find(ip);
+			return node ? &node->component() : nullptr;
+		}
+
+		/**
+		 * Apply 'fn' to all clients while holding the lock
+		 */
+		template <typename FN>
+		void for_each_session(FN const &fn)
+		{
+			Genode::Lock::Guard guard(lock);
+			for (Mac_address_node *node = mac_list.first(); node;
+			     node = node->next())
+			{
+				fn(node->component());
+			}
+		}
 	};
 }
 
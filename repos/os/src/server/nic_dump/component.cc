@@ -54,14 +54,15 @@ Session_component_base(Allocator    &guarded_alloc_backing,
  ** Session_component **
  ***********************/
 
-Net::Session_component::Session_component(Allocator         &alloc,
-                                          size_t const       amount,
-                                          size_t const       tx_buf_size,
-                                          size_t const       rx_buf_size,
-                                          Xml_node           config,
-                                          Timer::Connection &timer,
-                                          Duration          &curr_time,
-                                          Env               &env)
+Net::Session_component::Session_component(Allocator             &alloc,
+                                          size_t const           amount,
+                                          size_t const           tx_buf_size,
+                                          size_t const           rx_buf_size,
+                                          Xml_node               config,
+                                          Timer::Connection     &timer,
+                                          Duration              &curr_time,
+                                          Pointer<Pcap_capture>  pcap,
+                                          Env                   &env)
 :
 	Session_component_base(alloc, amount, env.ram(), tx_buf_size, rx_buf_size),
 	Session_rpc_object(env.rm(), _tx_buf, _rx_buf, &_range_alloc,
@@ -78,6 +79,10 @@ Net::Session_component::Session_component(Allocator         &alloc,
 	_rx.sigh_ready_to_submit(_source_submit);
 	Interface::remote(_uplink);
 	_uplink.Interface::remote(*this);
+	if (pcap.valid()) {
+		Interface::pcap(pcap.deref());
+		_uplink.Interface::pcap(pcap.deref());
+	}
 	_uplink.link_state_sigh(_link_state_handler);
 	_print_state();
 }
@@ -145,7 +150,7 @@ Session_component *Net::Root::_create_session(char const *args)
 		return new (md_alloc())
 			Session_component(*md_alloc(), ram_quota - session_size,
 			                  tx_buf_size, rx_buf_size, _config, _timer,
-			                  _curr_time, _env);
+			                  _curr_time, _pcap, _env);
 	}
 	catch (...) { throw Service_denied(); }
 }
@@ -90,14 +90,15 @@ class Net::Session_component : private Session_component_base,
 
 	public:
 
-		Session_component(Genode::Allocator    &alloc,
-		                  Genode::size_t const  amount,
-		                  Genode::size_t const  tx_buf_size,
-		                  Genode::size_t const  rx_buf_size,
-		                  Genode::Xml_node      config,
-		                  Timer::Connection    &timer,
-		                  Genode::Duration     &curr_time,
-		                  Genode::Env          &env);
+		Session_component(Genode::Allocator     &alloc,
+		                  Genode::size_t const   amount,
+		                  Genode::size_t const   tx_buf_size,
+		                  Genode::size_t const   rx_buf_size,
+		                  Genode::Xml_node       config,
+		                  Timer::Connection     &timer,
+		                  Genode::Duration      &curr_time,
+		                  Pointer<Pcap_capture>  pcap,
+		                  Genode::Env           &env);
 
 
 		/******************
@@ -118,8 +119,9 @@ class Net::Root : public Genode::Root_component<Session_component,
 
 		Genode::Env       &_env;
 		Genode::Xml_node   _config;
-		Timer::Connection &_timer;
-		Genode::Duration  &_curr_time;
+		Timer::Connection     &_timer;
+		Genode::Duration      &_curr_time;
+		Pointer<Pcap_capture>  _pcap { };
 
 
 		/********************
@@ -135,6 +137,11 @@ class Net::Root : public Genode::Root_component<Session_component,
 		     Genode::Xml_node   config,
 		     Timer::Connection &timer,
 		     Genode::Duration  &curr_time);
+
+		/**
+		 * Capture the packets of all sessions via 'pcap'
+		 */
+		void pcap(Pcap_capture &pcap) { _pcap.set(pcap); }
 };
 
 #endif /* _COMPONENT_H_ */
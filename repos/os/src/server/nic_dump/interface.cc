@@ -23,6 +23,25 @@ using namespace Net;
 using namespace Genode;
 
 
+void Net::Interface::_log_eth(Ethernet_frame &eth, Interface &remote)
+{
+	if (_log_time) {
+		Genode::Duration const new_time    = _timer.curr_time();
+		unsigned long    const new_time_ms = new_time.trunc_to_plain_us().value / 1000;
+		unsigned long    const old_time_ms = _curr_time.trunc_to_plain_us().value / 1000;
+
+		log("\033[33m(", remote._label, " <- ", _label, ")\033[0m ",
+		    packet_log(eth, _log_cfg), " \033[33mtime ", new_time_ms,
+		    " ms (Δ ", new_time_ms - old_time_ms, " ms)\033[0m");
+
+		_curr_time = new_time;
+	} else {
+		log("\033[33m(", remote._label, " <- ", _label, ")\033[0m ", 
+		    packet_log(eth, _log_cfg));
+	}
+}
+
+
 void Net::Interface::_handle_eth(void              *const  eth_base,
                                  size_t             const  eth_size,
                                  Packet_descriptor  const &)
@@ -31,20 +50,12 @@ void Net::Interface::_handle_eth(void              *const  eth_base,
 		Ethernet_frame &eth = *reinterpret_cast<Ethernet_frame *>(eth_base);
 		Interface &remote = _remote.deref();
 
-		if (_log_time) {
-			Genode::Duration const new_time    = _timer.curr_time();
-			unsigned long    const new_time_ms = new_time.trunc_to_plain_us().value / 1000;
-			unsigned long    const old_time_ms = _curr_time.trunc_to_plain_us().value / 1000;
+		if (_pcap.valid()) {
+			_pcap.deref().capture(eth, eth_size); }
 
-			log("\033[33m(", remote._label, " <- ", _label, ")\033[0m ",
-			    packet_log(eth, _log_cfg), " \033[33mtime ", new_time_ms,
-			    " ms (Δ ", new_time_ms - old_time_ms, " ms)\033[0m");
+		if (_log) {
+			_log_eth(eth, remote); }
 
-			_curr_time = new_time;
-		} else {
-			log("\033[33m(", remote._label, " <- ", _label, ")\033[0m ", 
-			    packet_log(eth, _log_cfg));
-		}
 		remote._send(eth, eth_size);
 	}
 	catch (Pointer<Interface>::Invalid) {
@@ -107,6 +118,7 @@ Net::Interface::Interface(Entrypoint        &ep,
 	_label             { label },
 	_timer             { timer },
 	_curr_time         { curr_time },
+	_log               { config.attribute_value("log", true) },
 	_log_time          { log_time },
 	_default_log_style { config.attribute_value("default", Packet_log_style::DEFAULT) },
 	_log_cfg           { config.attribute_value("eth",     _default_log_style),
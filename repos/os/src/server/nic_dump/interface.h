@@ -17,6 +17,7 @@
 /* local includes */
 #include <pointer.h>
 #include <packet_log.h>
+#include <pcap_capture.h>
 
 /* Genode includes */
 #include <nic_session/nic_session.h>
@@ -51,15 +52,19 @@ class Net::Interface
 
 		Genode::Allocator       &_alloc;
 		Pointer<Interface>       _remote { };
+		Pointer<Pcap_capture>    _pcap   { };
 		Interface_label          _label;
 		Timer::Connection       &_timer;
 		Genode::Duration        &_curr_time;
+		bool                     _log;
 		bool                     _log_time;
 		Packet_log_style  const  _default_log_style;
 		Packet_log_config const  _log_cfg;
 
 		void _send(Ethernet_frame &eth, Genode::size_t const eth_size);
 
+		void _log_eth(Ethernet_frame &eth, Interface &remote);
+
 		void _handle_eth(void              *const  eth_base,
 		                 Genode::size_t     const  eth_size,
 		                 Packet_descriptor  const &pkt);
@@ -91,6 +96,8 @@ class Net::Interface
 		virtual ~Interface() { }
 
 		void remote(Interface &remote) { _remote.set(remote); }
+
+		void pcap(Pcap_capture &pcap) { _pcap.set(pcap); }
 };
 
 #endif /* _INTERFACE_H_ */
@@ -34,6 +34,10 @@ class Main
 		Heap                   _heap;
 		Net::Root              _root;
 
+		Constructible<Pcap_capture> _pcap { };
+
+		void _init_pcap(Env &env);
+
 	public:
 
 		Main(Env &env);
@@ -45,8 +49,35 @@ Main::Main(Env &env)
 	_config(env, "config"), _timer(env), _heap(&env.ram(), &env.rm()),
 	_root(env, _heap, _config.xml(), _timer, _curr_time)
 {
+	_init_pcap(env);
 	env.parent().announce(env.ep().manage(_root));
 }
 
 
+void Main::_init_pcap(Env &env)
+{
+	try {
+		_pcap.construct(env, _heap, _timer, _config.xml().sub_node("pcap"));
+		_root.pcap(*_pcap);
+	}
+	catch (Xml_node::Nonexistent_sub_node) { }
+	catch (Packet_filter::Invalid_expression) {
+		error("invalid pcap filter, capture disabled"); }
+	catch (Pcap_capture::Invalid_config) {
+		error("invalid pcap config, capture disabled"); }
+	catch (File_system::Lookup_failed) {
+		error("failed to open pcap file, capture disabled"); }
+	catch (File_system::Permission_denied) {
+		error("failed to open pcap file, capture disabled"); }
+	catch (File_system::Invalid_name) {
+		error("failed to open pcap file, capture disabled"); }
+	catch (File_system::Name_too_long) {
+		error("failed to open pcap file, capture disabled"); }
+	catch (File_system::No_space) {
+		error("failed to open pcap file, capture disabled"); }
+	catch (Service_denied) {
+		error("no file system for pcap file, capture disabled"); }
+}
+
+
 void Component::construct(Env &env) { static Main main(env); }
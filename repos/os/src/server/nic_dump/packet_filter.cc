@@ -0,0 +1,307 @@
+/*
+ * \brief  Filter for network packets in the style of BPF expressions
+ * \author Genode Labs
+ * \date   2018-03-28
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <net/arp.h>
+#include <net/tcp.h>
+#include <net/udp.h>
+#include <util/string.h>
+
+/* local includes */
+#include <packet_filter.h>
+
+using namespace Net;
+using namespace Genode;
+
+
+/***************************
+ ** Packet_filter::Parser **
+ ***************************/
+
+/**
+ * Recursive-descent parser that emits the program in postfix order
+ */
+class Net::Packet_filter::Parser
+{
+	private:
+
+		typedef String<32> Token;
+
+		Packet_filter &_filter;
+		char const    *_pos;
+		Token          _token { };
+
+		/*
+		 * Noncopyable
+		 */
+		Parser(Parser const &);
+		Parser &operator = (Parser const &);
+
+		static bool _delimiter(char c) { return c == '(' || c == ')'; }
+
+		/**
+		 * Read next token into '_token', an empty token marks the end
+		 */
+		void _next()
+		{
+			while (*_pos == ' ' || *_pos == '\t' || *_pos == '\n') {
+				_pos++; }
+
+			size_t len = 0;
+			if (_delimiter(_pos[len])) {
+				len = 1; }
+			else {
+				while (_pos[len] && _pos[len] != ' '  && _pos[len] != '\t' &&
+				       _pos[len] != '\n' && !_delimiter(_pos[len]))
+				{
+					len++;
+				}
+			}
+			if (len >= Token::capacity()) {
+				throw Invalid_expression(); }
+
+			_token = Token(Cstring(_pos, len));
+			_pos  += len;
+		}
+
+		bool _is(char const *s) const { return _token == s; }
+
+		bool _end() const { return _token.length() <= 1; }
+
+		void _emit(Instruction const &instr)
+		{
+			if (_filter._length == MAX_INSTRUCTIONS) {
+				throw Invalid_expression(); }
+
+			_filter._program[_filter._length++] = instr;
+		}
+
+		void _emit(Opcode op)
+		{
+			Instruction instr;
+			instr.op = op;
+			_emit(instr);
+		}
+
+		void _primitive()
+		{
+			Instruction instr;
+			if (_is("arp"))  { _emit(Opcode::ARP);  _next(); return; }
+			if (_is("ip"))   { _emit(Opcode::IPV4); _next(); return; }
+			if (_is("icmp")) { _emit(Opcode::ICMP); _next(); return; }
+			if (_is("tcp"))  { _emit(Opcode::TCP);  _next(); return; }
+			if (_is("udp"))  { _emit(Opcode::UDP);  _next(); return; }
+
+			if (_is("src")) { instr.direction = SRC; _next(); }
+			else if (_is("dst")) { instr.direction = DST; _next(); }
+
+			if (_is("host")) {
+				_next();
+				instr.op = Opcode::HOST;
+				if (_end() ||
+				    ascii_to(_token.string(), instr.ip) != _token.length() - 1)
+				{
+					throw Invalid_expression();
+				}
+			}
+			else if (_is("port")) {
+				_next();
+				instr.op = Opcode::PORT;
+				unsigned long port = 0;
+				if (_end() ||
+				    ascii_to(_token.string(), port) != _token.length() - 1 ||
+				    port > 0xffff)
+				{
+					throw Invalid_expression();
+				}
+				instr.port = Port((uint16_t)port);
+			}
+			else {
+				throw Invalid_expression(); }
+
+			_emit(instr);
+			_next();
+		}
+
+		void _factor()
+		{
+			if (_is("not")) {
+				_next();
+				_factor();
+				_emit(Opcode::NOT);
+				return;
+			}
+			if (_is("(")) {
+				_next();
+				_expr();
+				if (!_is(")")) {
+					throw Invalid_expression(); }
+
+				_next();
+				return;
+			}
+			_primitive();
+		}
+
+		void _term()
+		{
+			_factor();
+			while (_is("and")) {
+				_next();
+				_factor();
+				_emit(Opcode::AND);
+			}
+		}
+
+		void _expr()
+		{
+			_term();
+			while (_is("or")) {
+				_next();
+				_term();
+				_emit(Opcode::OR);
+			}
+		}
+
+	public:
+
+		Parser(Packet_filter &filter, char const *expression)
+		:
+			_filter(filter), _pos(expression)
+		{
+			_next();
+			if (_end()) {
+				return; }
+
+			_expr();
+			if (!_end()) {
+				throw Invalid_expression(); }
+		}
+};
+
+
+/*********************************
+ ** Packet_filter::Packet_info **
+ *********************************/
+
+Packet_filter::Packet_info::Packet_info(Ethernet_frame const &eth,
+                                        size_t                size)
+{
+	if (size < sizeof(Ethernet_frame)) {
+		return; }
+
+	try {
+		size_t const eth_data_size = size - sizeof(Ethernet_frame);
+		switch (eth.type()) {
+		case Ethernet_frame::Type::ARP:
+			{
+				Arp_packet const &arp_pkt = eth.data<Arp_packet>(eth_data_size);
+				arp    = true;
+				src_ip = arp_pkt.src_ip();
+				dst_ip = arp_pkt.dst_ip();
+				break;
+			}
+		case Ethernet_frame::Type::IPV4:
+			{
+				Ipv4_packet const &ip = eth.data<Ipv4_packet>(eth_data_size);
+				size_t const ip_data_size = eth_data_size - sizeof(Ipv4_packet);
+				ipv4     = true;
+				protocol = (uint8_t)ip.protocol();
+				src_ip   = ip.src();
+				dst_ip   = ip.dst();
+				switch (ip.protocol()) {
+				case Ipv4_packet::Protocol::TCP:
+					{
+						Tcp_packet const &tcp = ip.data<Tcp_packet>(ip_data_size);
+						ports    = true;
+						src_port = tcp.src_port();
+						dst_port = tcp.dst_port();
+						break;
+					}
+				case Ipv4_packet::Protocol::UDP:
+					{
+						Udp_packet const &udp = ip.data<Udp_packet>(ip_data_size);
+						ports    = true;
+						src_port = udp.src_port();
+						dst_port = udp.dst_port();
+						break;
+					}
+				default: break;
+				}
+				break;
+			}
+		default: break;
+		}
+	}
+	catch (Ethernet_frame::Bad_data_type) { }
+	catch (Ipv4_packet::Bad_data_type)    { }
+}
+
+
+/*******************
+ ** Packet_filter **
+ *******************/
+
+Packet_filter::Packet_filter(char const *expression)
+{
+	Parser parser(*this, expression);
+}
+
+
+bool Packet_filter::_execute(Instruction const &instr,
+                             Packet_info const &info) const
+{
+	switch (instr.op) {
+	case Opcode::ARP:  return info.arp;
+	case Opcode::IPV4: return info.ipv4;
+	case Opcode::ICMP: return info.ipv4 && info.protocol == (uint8_t)Ipv4_packet::Protocol::ICMP;
+	case Opcode::TCP:  return info.ipv4 && info.protocol == (uint8_t)Ipv4_packet::Protocol::TCP;
+	case Opcode::UDP:  return info.ipv4 && info.protocol == (uint8_t)Ipv4_packet::Protocol::UDP;
+	case Opcode::HOST:
+		if (!info.arp && !info.ipv4) {
+			return false; }
+
+		return ((instr.direction & SRC) && info.src_ip == instr.ip) ||
+		       ((instr.direction & DST) && info.dst_ip == instr.ip);
+	case Opcode::PORT:
+		if (!info.ports) {
+			return false; }
+
+		return ((instr.direction & SRC) && info.src_port == instr.port) ||
+		       ((instr.direction & DST) && info.dst_port == instr.port);
+	default: return false;
+	}
+}
+
+
+bool Packet_filter::match(Ethernet_frame const &eth, size_t size) const
+{
+	if (!_length) {
+		return true; }
+
+	Packet_info const info(eth, size);
+
+	bool     stack[MAX_DEPTH];
+	unsigned depth = 0;
+	for (unsigned i = 0; i < _length; i++) {
+
+		Instruction const &instr = _program[i];
+		switch (instr.op) {
+		case Opcode::AND: depth--; stack[depth - 1] = stack[depth - 1] && stack[depth]; break;
+		case Opcode::OR:  depth--; stack[depth - 1] = stack[depth - 1] || stack[depth]; break;
+		case Opcode::NOT: stack[depth - 1] = !stack[depth - 1]; break;
+		default:          stack[depth++] = _execute(instr, info); break;
+		}
+	}
+	return stack[0];
+}
@@ -0,0 +1,106 @@
+/*
+ * \brief  Filter for network packets in the style of BPF expressions
+ * \author Genode Labs
+ * \date   2018-03-28
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _PACKET_FILTER_H_
+#define _PACKET_FILTER_H_
+
+/* Genode includes */
+#include <base/exception.h>
+#include <net/ethernet.h>
+#include <net/ipv4.h>
+#include <net/port.h>
+
+namespace Net { class Packet_filter; }
+
+
+/**
+ * Filter that decides whether a packet matches an expression
+ *
+ * The expression follows the syntax of the packet filters of tcpdump:
+ *
+ *   expr      := term { 'or' term }
+ *   term      := factor { 'and' factor }
+ *   factor    := 'not' factor | '(' expr ')' | primitive
+ *   primitive := 'arp' | 'ip' | 'icmp' | 'tcp' | 'udp'
+ *              | [ 'src' | 'dst' ] 'host' <IPv4 address>
+ *              | [ 'src' | 'dst' ] 'port' <number>
+ *
+ * The expression is compiled to a program for a small stack machine
+ * when the filter is constructed, so matching a packet does not involve
+ * any parsing of strings. An empty expression matches all packets.
+ */
+class Net::Packet_filter
+{
+	public:
+
+		struct Invalid_expression : Genode::Exception { };
+
+	private:
+
+		enum { MAX_INSTRUCTIONS = 32, MAX_DEPTH = MAX_INSTRUCTIONS };
+
+		enum class Opcode : Genode::uint8_t
+		{
+			ARP, IPV4, ICMP, TCP, UDP, HOST, PORT, AND, OR, NOT,
+		};
+
+		enum Direction : Genode::uint8_t { SRC = 1, DST = 2, ANY = SRC | DST };
+
+		struct Instruction
+		{
+			Opcode       op        { Opcode::IPV4 };
+			Direction    direction { ANY };
+			Ipv4_address ip        { };
+			Port         port      { 0 };
+		};
+
+		/**
+		 * Header fields of a packet that are relevant for the filter
+		 */
+		struct Packet_info
+		{
+			bool         arp      { false };
+			bool         ipv4     { false };
+			bool         ports    { false };
+			Genode::uint8_t protocol { 0 };
+			Ipv4_address src_ip   { };
+			Ipv4_address dst_ip   { };
+			Port         src_port { 0 };
+			Port         dst_port { 0 };
+
+			Packet_info(Ethernet_frame const &eth, Genode::size_t size);
+		};
+
+		class Parser;
+
+		Instruction _program[MAX_INSTRUCTIONS] { };
+		unsigned    _length { 0 };
+
+		bool _execute(Instruction const &instr, Packet_info const &info) const;
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \throw Invalid_expression
+		 */
+		Packet_filter(char const *expression);
+
+		/**
+		 * Return whether the Ethernet frame 'eth' matches the filter
+		 */
+		bool match(Ethernet_frame const &eth, Genode::size_t size) const;
+};
+
+#endif /* _PACKET_FILTER_H_ */
@@ -0,0 +1,248 @@
+/*
+ * \brief  Capture of network packets to a file in the pcap format
+ * \author Genode Labs
+ * \date   2018-03-28
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/log.h>
+#include <file_system/util.h>
+#include <os/path.h>
+
+/* local includes */
+#include <pcap_capture.h>
+
+using namespace Net;
+using namespace Genode;
+
+typedef String<256> Filter_expression;
+typedef String<File_system::MAX_PATH_LEN> File_path;
+
+
+/*
+ * File format as defined by libpcap, all values are written in host byte
+ * order, which is detected by the reader via the magic number
+ */
+
+struct Pcap_file_header
+{
+	enum {
+		MAGIC         = 0xa1b2c3d4,
+		VERSION_MAJOR = 2,
+		VERSION_MINOR = 4,
+		LINKTYPE_ETH  = 1,
+	};
+
+	uint32_t magic;
+	uint16_t version_major;
+	uint16_t version_minor;
+	int32_t  thiszone;
+	uint32_t sigfigs;
+	uint32_t snaplen;
+	uint32_t network;
+
+} __attribute__((packed));
+
+
+struct Pcap_record_header
+{
+	uint32_t ts_sec;
+	uint32_t ts_usec;
+	uint32_t incl_len;
+	uint32_t orig_len;
+
+} __attribute__((packed));
+
+
+File_system::File_handle Pcap_capture::_open(File_system::Session &fs,
+                                             char const           *path)
+{
+	using namespace File_system;
+
+	Genode::Path<MAX_PATH_LEN> dir_path(path);
+	dir_path.strip_last_element();
+	Genode::Path<MAX_PATH_LEN> file_path(path);
+
+	Dir_handle   dir = ensure_dir(fs, dir_path.base());
+	Handle_guard dir_guard(fs, dir);
+
+	try { return fs.file(dir, file_path.last_element(), WRITE_ONLY, true); }
+	catch (Node_already_exists) { }
+
+	/* overwrite the content of an existing file */
+	File_handle const file =
+		fs.file(dir, file_path.last_element(), WRITE_ONLY, false);
+
+	fs.truncate(file, 0);
+	return file;
+}
+
+
+bool Pcap_capture::_reserve(size_t size)
+{
+	if (_current_valid && _current_used + size > _current.size()) {
+		_submit(); }
+
+	if (_current_valid) {
+		return true; }
+
+	if (!_free_cnt) {
+		return false; }
+
+	_current       = _free[--_free_cnt];
+	_current_valid = true;
+	_current_used  = 0;
+	return true;
+}
+
+
+void Pcap_capture::_append(void const *data, size_t size)
+{
+	memcpy(_fs.tx()->packet_content(_current) + _current_used, data, size);
+	_current_used += size;
+}
+
+
+void Pcap_capture::_submit()
+{
+	if (!_current_valid) {
+		return; }
+
+	if (!_current_used) {
+		_free[_free_cnt++] = _current;
+		_current_valid = false;
+		return;
+	}
+	_fs.tx()->submit_packet(
+		Packet_descriptor(_current, _file, Packet_descriptor::WRITE,
+		                  _current_used, _offset));
+
+	_offset        += _current_used;
+	_current_valid  = false;
+}
+
+
+void Pcap_capture::_handle_ack()
+{
+	while (_fs.tx()->ack_avail()) {
+
+		Packet_descriptor const pkt = _fs.tx()->get_acked_packet();
+		if (!pkt.succeeded() && !_write_errors++) {
+			error("failed to write captured packets"); }
+
+		/* put buffer back into the ring */
+		_free[_free_cnt++] = Packet_descriptor(pkt.offset(), pkt.size());
+	}
+}
+
+
+void Pcap_capture::_handle_flush_timeout(Duration)
+{
+	_submit();
+
+	if (_dropped != _reported_dropped) {
+		warning("dropped ", _dropped - _reported_dropped, " of ",
+		        _captured, " captured packets, no buffer available");
+
+		_reported_dropped = _dropped;
+	}
+}
+
+
+void Pcap_capture::capture(Ethernet_frame const &eth, size_t size)
+{
+	if (!_filter.match(eth, size)) {
+		return; }
+
+	if (++_sample_cnt < _sample) {
+		return; }
+
+	_sample_cnt = 0;
+	_captured++;
+
+	size_t const incl_len = min(size, _snap_len);
+	if (!_reserve(sizeof(Pcap_record_header) + incl_len)) {
+		_dropped++;
+		return;
+	}
+	uint64_t const time_us = _timer.curr_time().trunc_to_plain_us().value;
+
+	Pcap_record_header const header {
+		(uint32_t)(time_us / 1000000), (uint32_t)(time_us % 1000000),
+		(uint32_t)incl_len, (uint32_t)size };
+
+	_append(&header, sizeof(header));
+	_append(&eth, incl_len);
+}
+
+
+Pcap_capture::Pcap_capture(Env       &env,
+                           Allocator &alloc,
+                           Timer::Connection &timer,
+                           Xml_node   config)
+:
+	_ep           { env.ep() },
+	_fs_alloc     { &alloc },
+	_buffer_size  { max(config.attribute_value("buffer_size",
+	                                           Number_of_bytes(DEFAULT_BUFFER_SIZE)),
+	                    Number_of_bytes(4096)) },
+	_num_buffers  { max(min(config.attribute_value("buffers", (unsigned)DEFAULT_BUFFERS),
+	                        (unsigned)MAX_BUFFERS), 2U) },
+	_fs           { env, _fs_alloc, config.attribute_value("label", String<64>()).string(),
+	                "/", true, _buffer_size * _num_buffers + 4096 },
+	_file         { _open(_fs, config.attribute_value("file", File_path("/nic_dump.pcap")).string()) },
+	_timer        { timer },
+	_filter       { config.attribute_value("filter", Filter_expression()).string() },
+	_snap_len     { min(max(config.attribute_value("snap_len", (size_t)DEFAULT_SNAP_LEN),
+	                        (size_t)sizeof(Ethernet_frame)),
+	                    _buffer_size - sizeof(Pcap_record_header)) },
+	_sample       { max(config.attribute_value("sample", 1UL), 1UL) },
+	_free         { },
+	_ack_handler  { env.ep(), *this, &Pcap_capture::_handle_ack },
+	_flush_timeout { timer, *this, &Pcap_capture::_handle_flush_timeout,
+	                 Microseconds(max(config.attribute_value("flush_ms",
+	                                                         (unsigned long)DEFAULT_FLUSH_MS),
+	                                  1UL) * 1000) }
+{
+	_fs.sigh_ack_avail(_ack_handler);
+
+	/* allocate the ring of buffers once */
+	for (; _free_cnt < _num_buffers; _free_cnt++) {
+		try { _free[_free_cnt] = _fs.tx()->alloc_packet(_buffer_size); }
+		catch (File_system::Session::Tx::Source::Packet_alloc_failed) {
+			throw Invalid_config(); }
+	}
+
+	Pcap_file_header const header {
+		Pcap_file_header::MAGIC, Pcap_file_header::VERSION_MAJOR,
+		Pcap_file_header::VERSION_MINOR, 0, 0, (uint32_t)_snap_len,
+		Pcap_file_header::LINKTYPE_ETH };
+
+	_reserve(sizeof(header));
+	_append(&header, sizeof(header));
+
+	log("capturing packets to ", config.attribute_value("file", File_path("/nic_dump.pcap")),
+	    " (snap_len=", _snap_len, " sample=", _sample, ")");
+}
+
+
+Pcap_capture::~Pcap_capture()
+{
+	_submit();
+
+	/* wait until the file system acknowledged all buffers in flight */
+	while (_free_cnt < _num_buffers) {
+		if (_fs.tx()->ack_avail()) {
+			_handle_ack(); }
+		else {
+			_ep.wait_and_dispatch_one_io_signal(); }
+	}
+	_fs.close(_file);
+}
@@ -0,0 +1,135 @@
+/*
+ * \brief  Capture of network packets to a file in the pcap format
+ * \author Genode Labs
+ * \date   2018-03-28
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _PCAP_CAPTURE_H_
+#define _PCAP_CAPTURE_H_
+
+/* Genode includes */
+#include <base/allocator_avl.h>
+#include <file_system_session/connection.h>
+#include <timer_session/connection.h>
+#include <util/xml_node.h>
+
+/* local includes */
+#include <packet_filter.h>
+
+namespace Net { class Pcap_capture; }
+
+
+/**
+ * Writer of captured packets to a file of a File_system session
+ *
+ * The records are gathered in a ring of buffers that are allocated from
+ * the bulk buffer of the session once at construction time. A buffer is
+ * written as a whole as soon as it is full or when the flush interval
+ * elapsed. The write operations are submitted asynchronously. If all
+ * buffers are in flight, records are dropped instead of stalling the
+ * observed traffic.
+ */
+class Net::Pcap_capture
+{
+	private:
+
+		enum {
+			MAX_BUFFERS         = File_system::Session::TX_QUEUE_SIZE,
+			DEFAULT_BUFFERS     = 8,
+			DEFAULT_BUFFER_SIZE = 64 * 1024,
+			DEFAULT_SNAP_LEN    = 65535,
+			DEFAULT_FLUSH_MS    = 1000,
+		};
+
+		using Packet_descriptor = File_system::Packet_descriptor;
+
+		Genode::Entrypoint             &_ep;
+		Genode::Allocator_avl           _fs_alloc;
+		Genode::size_t            const _buffer_size;
+		unsigned                  const _num_buffers;
+		File_system::Connection         _fs;
+		File_system::File_handle        _file;
+		File_system::seek_off_t         _offset       { 0 };
+		Timer::Connection              &_timer;
+		Packet_filter             const _filter;
+		Genode::size_t            const _snap_len;
+		unsigned long             const _sample;
+		unsigned long                   _sample_cnt   { 0 };
+		Packet_descriptor               _free[MAX_BUFFERS];
+		unsigned                        _free_cnt     { 0 };
+		Packet_descriptor               _current      { };
+		bool                            _current_valid { false };
+		Genode::size_t                  _current_used { 0 };
+		unsigned long                   _captured     { 0 };
+		unsigned long                   _dropped      { 0 };
+		unsigned long                   _reported_dropped { 0 };
+		unsigned long                   _write_errors { 0 };
+
+		Genode::Io_signal_handler<Pcap_capture> _ack_handler;
+		Timer::Periodic_timeout<Pcap_capture>   _flush_timeout;
+
+		/*
+		 * Noncopyable
+		 */
+		Pcap_capture(Pcap_capture const &);
+		Pcap_capture &operator = (Pcap_capture const &);
+
+		static File_system::File_handle _open(File_system::Session &fs,
+		                                      char const           *path);
+
+		/**
+		 * Make a buffer with 'size' free bytes current
+		 *
+		 * \return  false if no buffer is available
+		 */
+		bool _reserve(Genode::size_t size);
+
+		void _append(void const *data, Genode::size_t size);
+
+		/**
+		 * Submit the current buffer to the file system
+		 */
+		void _submit();
+
+		void _handle_ack();
+
+		void _handle_flush_timeout(Genode::Duration);
+
+	public:
+
+		struct Invalid_config : Genode::Exception { };
+
+		/**
+		 * Constructor
+		 *
+		 * \param config  'pcap' sub node of the component configuration
+		 *
+		 * \throw Invalid_config
+		 * \throw Packet_filter::Invalid_expression
+		 */
+		Pcap_capture(Genode::Env       &env,
+		             Genode::Allocator &alloc,
+		             Timer::Connection &timer,
+		             Genode::Xml_node   config);
+
+		/**
+		 * Destructor
+		 *
+		 * Blocks until all buffers are written to the file.
+		 */
+		~Pcap_capture();
+
+		/**
+		 * Record the Ethernet frame if it passes filter and sampling
+		 */
+		void capture(Ethernet_frame const &eth, Genode::size_t size);
+};
+
+#endif /* _PCAP_CAPTURE_H_ */
@@ -3,6 +3,7 @@ TARGET = nic_dump
 LIBS += base net
 
 SRC_CC += component.cc main.cc packet_log.cc uplink.cc interface.cc
+SRC_CC += pcap_capture.cc packet_filter.cc
 
 INC_DIR += $(PRG_DIR)
 
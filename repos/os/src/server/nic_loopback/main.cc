@@ -19,6 +19,7 @@
 #include <util/arg_string.h>
 #include <util/misc_math.h>
 #include <nic/component.h>
+#include <nic/offload.h>
 #include <nic/packet_allocator.h>
 
 namespace Nic_loopback {
@@ -32,8 +33,39 @@ namespace Nic_loopback {
 
 class Nic_loopback::Session_component : public Nic::Session_component
 {
+	private:
+
+		enum { SEGMENT_SIZE = Nic::Packet_allocator::DEFAULT_PACKET_SIZE };
+
+		char _segment[SEGMENT_SIZE] { };
+
+		/**
+		 * Return number of rx packets needed to echo 'packet'
+		 */
+		unsigned _rx_packets_needed(Packet_descriptor const packet);
+
+		/**
+		 * Echo a packet of a session with offloads
+		 *
+		 * Large segments and partial checksums are echoed as they are if
+		 * the client accepts them on reception. Otherwise, the packet is
+		 * completed and segmented in software.
+		 */
+		void _echo_offloaded(Packet_descriptor const packet);
+
+		void _echo(void const *content, size_t size);
+
 	public:
 
+		/**
+		 * Offloads granted to clients
+		 */
+		static Nic::Offload supported_offload()
+		{
+			return Nic::Offload(Nic::Offload::TX_CSUM | Nic::Offload::TX_GSO_TCP |
+			                    Nic::Offload::RX_COALESCE);
+		}
+
 		/**
 		 * Constructor
 		 *
@@ -71,10 +103,82 @@ class Nic_loopback::Session_component : public Nic::Session_component
 };
 
 
-void Nic_loopback::Session_component::_handle_packet_stream()
+unsigned Nic_loopback::Session_component::_rx_packets_needed(Packet_descriptor const packet)
+{
+	if (!_offload.enabled() || _offload.has(Nic::Offload::RX_COALESCE) ||
+	    packet.size() < sizeof(Nic::Offload_header))
+		return 1;
+
+	Nic::Offload_header const &header =
+		*(Nic::Offload_header const *)_tx.sink()->packet_content(packet);
+
+	size_t const frame_size = packet.size() - sizeof(header);
+	if (header.gso_type == Nic::Offload_header::GSO_NONE ||
+	    !header.gso_size || header.hdr_len >= frame_size)
+		return 1;
+
+	return (frame_size - header.hdr_len + header.gso_size - 1) / header.gso_size;
+}
+
+
+void Nic_loopback::Session_component::_echo(void const *content, size_t size)
 {
-	size_t const alloc_size = Nic::Packet_allocator::DEFAULT_PACKET_SIZE;
+	Packet_descriptor packet_to_client;
+	try {
+		packet_to_client = _rx.source()->alloc_packet(size); }
+	catch (Session::Rx::Source::Packet_alloc_failed) {
 
+		/* drop the packet like a congested link */
+		return;
+	}
+
+	memcpy(_rx.source()->packet_content(packet_to_client), content, size);
+	_rx.source()->submit_packet(packet_to_client);
+}
+
+
+void Nic_loopback::Session_component::_echo_offloaded(Packet_descriptor const packet)
+{
+	char *const content = _tx.sink()->packet_content(packet);
+
+	if (packet.size() < sizeof(Nic::Offload_header) ||
+	    _offload.has(Nic::Offload::RX_COALESCE)) {
+		_echo(content, packet.size());
+		return;
+	}
+
+	Nic::Offload_header &header = *(Nic::Offload_header *)content;
+	char  *const frame      = content + sizeof(header);
+	size_t const frame_size = packet.size() - sizeof(header);
+
+	if (header.gso_type == Nic::Offload_header::GSO_NONE) {
+		if (!Nic::complete_checksum(frame, frame_size, header)) {
+			warning("malformed offload header");
+			return;
+		}
+		header = Nic::Offload_header { };
+		_echo(content, packet.size());
+		return;
+	}
+
+	/* echo each segment with a plain offload header in front */
+	Nic::Offload_header const plain { };
+	memcpy(_segment, &plain, sizeof(plain));
+
+	bool const ok =
+		Nic::for_each_segment(frame, frame_size, header,
+		                      _segment + sizeof(plain),
+		                      sizeof(_segment) - sizeof(plain),
+		                      [&] (void *, size_t segment_size) {
+			_echo(_segment, sizeof(plain) + segment_size); });
+
+	if (!ok)
+		warning("failed to segment large packet");
+}
+
+
+void Nic_loopback::Session_component::_handle_packet_stream()
+{
 	/* loop while we can make progress */
 	for (;;) {
 
@@ -108,32 +212,32 @@ void Nic_loopback::Session_component::_handle_packet_stream()
 			return;
 
 		/*
-		 * We are safe to process one packet without blocking.
+		 * A large segment that the client does not accept on reception
+		 * is echoed as multiple packets. Wait until all of them fit into
+		 * the submit queue, or drop the packet if they never do.
 		 */
+		unsigned const rx_packets = _rx_packets_needed(_tx.sink()->peek_packet());
+		if (rx_packets <= Nic::Session::QUEUE_SIZE &&
+		    rx_packets > _rx.source()->submit_slots_free())
+			return;
 
-
-		Packet_descriptor packet_to_client;
-		try {
-			packet_to_client = _rx.source()->alloc_packet(alloc_size); }
-		catch (Session::Rx::Source::Packet_alloc_failed) {
-			continue; }
+		/*
+		 * We are safe to process one packet without blocking.
+		 */
 
 		/* obtain packet */
 		Packet_descriptor const packet_from_client = _tx.sink()->get_packet();
 		if (!packet_from_client.size()) {
 			warning("received zero-size packet");
-			_rx.source()->release_packet(packet_to_client);
-			continue;
+		} else if (rx_packets > Nic::Session::QUEUE_SIZE) {
+			warning("dropped large packet with too many segments");
+		} else if (_offload.enabled()) {
+			_echo_offloaded(packet_from_client);
+		} else {
+			_echo(_tx.sink()->packet_content(packet_from_client),
+			      packet_from_client.size());
 		}
 
-		memcpy(_rx.source()->packet_content(packet_to_client),
-		       _tx.sink()->packet_content(packet_from_client),
-		       packet_from_client.size());
-
-		packet_to_client = Packet_descriptor(packet_to_client.offset(),
-		                                     packet_from_client.size());
-		_rx.source()->submit_packet(packet_to_client);
-
 		_tx.sink()->acknowledge_packet(packet_from_client);
 	}
 }
@@ -169,8 +273,11 @@ class Nic_loopback::Root : public Root_component<Session_component>
 				throw Insufficient_ram_quota();
 			}
 
-			return new (md_alloc()) Session_component(tx_buf_size, rx_buf_size,
-			                                          *md_alloc(), _env);
+			Session_component *session = new (md_alloc())
+				Session_component(tx_buf_size, rx_buf_size, *md_alloc(), _env);
+
+			session->negotiate_offload(args, Session_component::supported_offload());
+			return session;
 		}
 
 	public:
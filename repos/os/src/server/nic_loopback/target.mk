@@ -1,3 +1,3 @@
 TARGET = nic_loopback
 SRC_CC = main.cc
-LIBS   = base
+LIBS   = base net
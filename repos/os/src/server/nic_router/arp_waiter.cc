@@ -23,10 +23,11 @@ using namespace Genode;
 Arp_waiter::Arp_waiter(Interface               &src,
                        Domain                  &dst,
                        Ipv4_address      const &ip,
-                       Packet_descriptor const &packet)
+                       Packet_descriptor const &packet,
+                       unsigned          const  segment)
 :
 	_src_le(this), _src(src), _dst_le(this), _dst(dst), _ip(ip),
-	_packet(packet)
+	_packet(packet), _segment(segment)
 {
 	_src.own_arp_waiters().insert(&_src_le);
 	_dst().foreign_arp_waiters().insert(&_dst_le);
@@ -45,13 +45,21 @@ class Net::Arp_waiter
 		Reference<Domain>        _dst;
 		Ipv4_address      const  _ip;
 		Packet_descriptor const  _packet;
+		unsigned          const  _segment;
 
 	public:
 
+		/**
+		 * Constructor
+		 *
+		 * \param segment  index of the segment of a large packet that
+		 *                 waits, 0 for other packets
+		 */
 		Arp_waiter(Interface               &src,
 		           Domain                  &dst,
 		           Ipv4_address      const &ip,
-		           Packet_descriptor const &packet);
+		           Packet_descriptor const &packet,
+		           unsigned          const  segment);
 
 		~Arp_waiter();
 
@@ -69,10 +77,11 @@ class Net::Arp_waiter
 		 ** Accessors **
 		 ***************/
 
-		Interface               &src()    const { return _src; }
-		Ipv4_address      const &ip()     const { return _ip; }
-		Packet_descriptor const &packet() const { return _packet; }
-		Domain                  &dst()          { return _dst(); }
+		Interface               &src()     const { return _src; }
+		Ipv4_address      const &ip()      const { return _ip; }
+		Packet_descriptor const &packet()  const { return _packet; }
+		unsigned                 segment() const { return _segment; }
+		Domain                  &dst()           { return _dst(); }
 };
 
 #endif /* _ARP_WAITER_H_ */
@@ -92,7 +92,8 @@ Net::Session_component::Session_component(Allocator           &alloc,
                                           Mac_address   const &router_mac,
                                           Session_label const &label,
                                           Interface_list      &interfaces,
-                                          Configuration       &config)
+                                          Configuration       &config,
+                                          ::Nic::Offload const offload)
 :
 	Session_component_base(alloc, amount, buf_ram, tx_buf_size, rx_buf_size,
 	                       config, label),
@@ -105,6 +106,8 @@ Net::Session_component::Session_component(Allocator           &alloc,
 	_tx.sigh_packet_avail(_sink_submit);
 	_rx.sigh_ack_avail(_source_ack);
 	_rx.sigh_ready_to_submit(_source_submit);
+
+	_offload = offload;
 }
 
 
@@ -159,7 +162,9 @@ Session_component *Net::Root::_create_session(char const *args)
 			Session_component(*md_alloc(), _timer, ram_quota - session_size,
 			                  _buf_ram, tx_buf_size, rx_buf_size, _region_map,
 			                  _mac_alloc.alloc(), _ep, _router_mac, label,
-			                  _interfaces, _config());
+			                  _interfaces, _config(),
+			                  ::Nic::Offload::from_args(args).intersect(
+			                  	Session_component::supported_offload()));
 
 		component.init();
 		return &component;
@@ -119,7 +119,20 @@ class Net::Session_component : private Session_component_base,
 		                  Mac_address           const &router_mac,
 		                  Genode::Session_label const &label,
 		                  Interface_list              &interfaces,
-		                  Configuration               &config);
+		                  Configuration               &config,
+		                  ::Nic::Offload        const  offload);
+
+		/**
+		 * Offloads that the router supports for its clients
+		 *
+		 * The router completes the packets of a client before routing
+		 * them and sends complete frames only.
+		 */
+		static ::Nic::Offload supported_offload()
+		{
+			return ::Nic::Offload(::Nic::Offload::TX_CSUM |
+			                      ::Nic::Offload::TX_GSO_TCP);
+		}
 
 
 		/******************
@@ -128,6 +141,7 @@ class Net::Session_component : private Session_component_base,
 
 		Mac_address mac_address() override { return _mac; }
 		bool link_state() override { return Interface::link_state(); }
+		::Nic::Offload offload() override { return _offload; }
 		void link_state_sigh(Genode::Signal_context_capability sigh) override { Interface::link_state_sigh(sigh); }
 };
 
@@ -43,6 +43,7 @@ class Net::Configuration
 		Genode::Microseconds const  _udp_idle_timeout        { DEFAULT_UDP_IDLE_TIMEOUT_SEC      };
 		Genode::Microseconds const  _tcp_idle_timeout        { DEFAULT_TCP_IDLE_TIMEOUT_SEC      };
 		Genode::Microseconds const  _tcp_max_segm_lifetime   { DEFAULT_TCP_MAX_SEGM_LIFETIME_SEC };
+		unsigned             const  _burst_size              { DEFAULT_BURST_SIZE };
 		Mac_address          const  _mac_first               { mac_from_string("02:02:02:02:02:00") };
 		Pointer<Report>             _report                  { };
 		Pointer<Genode::Reporter>   _reporter                { };
@@ -59,6 +60,7 @@ class Net::Configuration
 		enum { DEFAULT_UDP_IDLE_TIMEOUT_SEC      =  30 };
 		enum { DEFAULT_TCP_IDLE_TIMEOUT_SEC      = 600 };
 		enum { DEFAULT_TCP_MAX_SEGM_LIFETIME_SEC =  30 };
+		enum { DEFAULT_BURST_SIZE                =  32 };
 
 		Configuration(Genode::Xml_node const  node,
 		              Genode::Allocator      &alloc);
@@ -86,6 +88,7 @@ class Net::Configuration
 		Genode::Microseconds  udp_idle_timeout()      const { return _udp_idle_timeout; }
 		Genode::Microseconds  tcp_idle_timeout()      const { return _tcp_idle_timeout; }
 		Genode::Microseconds  tcp_max_segm_lifetime() const { return _tcp_max_segm_lifetime; }
+		unsigned              burst_size()            const { return _burst_size; }
 		Domain_tree          &domains()                     { return _domains; }
 		Report               &report()                      { return _report(); }
 		Genode::Xml_node      node()                  const { return _node; }
@@ -16,6 +16,7 @@
 
 /* local includes */
 #include <ipv4_address_prefix.h>
+#include <prefix_table.h>
 #include <rule.h>
 #include <list.h>
 
@@ -68,34 +69,56 @@ struct Net::Direct_rule : Direct_rule_base,
 
 
 template <typename T>
-struct Net::Direct_rule_list : List<T>
+class Net::Direct_rule_list : public List<T>
 {
-	using Base = List<T>;
+	private:
 
-	struct No_match : Genode::Exception { };
+		using Base = List<T>;
 
-	T const &longest_prefix_match(Ipv4_address const &ip) const
-	{
-		/* first match is sufficient as the list is prefix-size-sorted */
-		for (T const *curr = Base::first(); curr; curr = curr->next()) {
-			if (curr->dst().prefix_matches(ip)) {
-				return *curr; }
+		Prefix_table<T> _table;
+
+	public:
+
+		struct No_match : Genode::Exception { };
+
+		Direct_rule_list(Genode::Allocator &alloc) : _table(alloc) { }
+
+		T const &longest_prefix_match(Ipv4_address const &ip) const
+		{
+			if (_table.valid()) {
+				T const *const rule = _table.longest_prefix_match(ip);
+				if (!rule) {
+					throw No_match(); }
+
+				return *rule;
+			}
+			/* first match is sufficient as the list is prefix-size-sorted */
+			for (T const *curr = Base::first(); curr; curr = curr->next()) {
+				if (curr->dst().prefix_matches(ip)) {
+					return *curr; }
+			}
+			throw No_match();
 		}
-		throw No_match();
-	}
-
-	void insert(T &rule)
-	{
-		/* ensure that the list stays prefix-size-sorted (descending) */
-		T *behind = nullptr;
-		for (T *curr = Base::first(); curr; curr = curr->next()) {
-			if (rule.dst().prefix >= curr->dst().prefix) {
-				break; }
-
-			behind = curr;
+
+		void insert(T &rule)
+		{
+			/* ensure that the list stays prefix-size-sorted (descending) */
+			T *behind = nullptr;
+			for (T *curr = Base::first(); curr; curr = curr->next()) {
+				if (rule.dst().prefix >= curr->dst().prefix) {
+					break; }
+
+				behind = curr;
+			}
+			Base::insert(&rule, behind);
+			_table.insert(rule);
+		}
+
+		void destroy_each(Genode::Deallocator &dealloc)
+		{
+			_table.clear();
+			Base::destroy_each(dealloc);
 		}
-		Base::insert(&rule, behind);
-	}
 };
 
 #endif /* _RULE_H_ */
@@ -131,7 +131,7 @@ Domain::Domain(Configuration &config, Xml_node const node, Allocator &alloc)
 }
 
 
-Link_side_tree &Domain::links(L3_protocol const protocol)
+Link_side_table &Domain::links(L3_protocol const protocol)
 {
 	switch (protocol) {
 	case L3_protocol::TCP:  return _tcp_links;
@@ -290,7 +290,8 @@ void Domain::report(Xml_generator &xml)
 {
 	bool const bytes  = _config.report().bytes();
 	bool const config = _config.report().config();
-	if (!bytes && !config) {
+	bool const bursts = _config.report().bursts();
+	if (!bytes && !config && !bursts) {
 		return;
 	}
 	xml.node("domain", [&] () {
@@ -303,6 +304,19 @@ void Domain::report(Xml_generator &xml)
 			xml.attribute("ipv4", String<19>(ip_config().interface));
 			xml.attribute("gw",   String<16>(ip_config().gateway));
 		}
+		if (bursts) {
+			_interfaces.for_each([&] (Interface &interface) {
+				Interface::Burst_stats const &stats = interface.burst_stats();
+				xml.node("interface", [&] () {
+					xml.attribute("mac",          String<18>(interface.mac()));
+					xml.attribute("rx_bursts",    stats.rx_bursts);
+					xml.attribute("rx_packets",   stats.rx_packets);
+					xml.attribute("rx_max_burst", stats.rx_max_burst);
+					xml.attribute("tx_batches",   stats.tx_batches);
+					xml.attribute("tx_packets",   stats.tx_packets);
+				});
+			});
+		}
 	});
 }
 
@@ -16,6 +16,8 @@
 #include <net/udp.h>
 #include <net/icmp.h>
 #include <net/arp.h>
+#include <net/internet_checksum.h>
+#include <nic/offload.h>
 
 /* local includes */
 #include <interface.h>
@@ -35,6 +37,10 @@ using Genode::Signal_context_capability;
 using Genode::Signal_transmitter;
 
 
+bool       Interface::_tx_deferred     = false;
+Interface *Interface::_tx_pending_head = nullptr;
+
+
 /***************
  ** Utilities **
  ***************/
@@ -96,31 +102,6 @@ static void _link_packet(L3_protocol  const  prot,
 }
 
 
-static void _update_checksum(L3_protocol   const prot,
-                             void         *const prot_base,
-                             size_t        const prot_size,
-                             Ipv4_address  const src,
-                             Ipv4_address  const dst,
-                             size_t        const ip_size)
-{
-	switch (prot) {
-	case L3_protocol::TCP:
-		((Tcp_packet *)prot_base)->update_checksum(src, dst, prot_size);
-		return;
-	case L3_protocol::UDP:
-		((Udp_packet *)prot_base)->update_checksum(src, dst);
-		return;
-	case L3_protocol::ICMP:
-		{
-			Icmp_packet &icmp = *(Icmp_packet *)prot_base;
-			icmp.update_checksum(ip_size - sizeof(Ipv4_packet) -
-			                               sizeof(Icmp_packet));
-			return;
-		}
-	default: throw Interface::Bad_transport_protocol(); }
-}
-
-
 static Port _dst_port(L3_protocol const prot, void *const prot_base)
 {
 	switch (prot) {
@@ -192,15 +173,57 @@ void Interface::_destroy_link(Link &link)
 }
 
 
-void Interface::_pass_prot(Ethernet_frame       &eth,
-                           size_t         const  eth_size,
-                           Ipv4_packet          &ip,
-                           L3_protocol    const  prot,
-                           void          *const  prot_base,
-                           size_t         const  prot_size)
+static void _update_checksums(L3_protocol         const  prot,
+                              void               *const  prot_base,
+                              Ipv4_packet               &ip,
+                              Link_side_id        const &old_id)
+{
+	/* the IP header covers the addresses only */
+	Internet_checksum_diff ip_icd;
+	ip_icd.add_up_diff(old_id.src_ip, ip.src());
+	ip_icd.add_up_diff(old_id.dst_ip, ip.dst());
+	ip.update_checksum(ip_icd);
+
+	/* TCP and UDP also cover the addresses via the pseudo header */
+	Internet_checksum_diff prot_icd;
+	switch (prot) {
+	case L3_protocol::TCP:
+	case L3_protocol::UDP:
+		prot_icd.add_up_diff(ip_icd);
+		prot_icd.add_up_diff(old_id.src_port, _src_port(prot, prot_base));
+		prot_icd.add_up_diff(old_id.dst_port, _dst_port(prot, prot_base));
+		break;
+	case L3_protocol::ICMP:
+
+		/* the source and destination port both refer to the query ID */
+		prot_icd.add_up_diff(old_id.src_port, _src_port(prot, prot_base));
+		break;
+	default: throw Interface::Bad_transport_protocol(); }
+
+	switch (prot) {
+	case L3_protocol::TCP:  ((Tcp_packet  *)prot_base)->update_checksum(prot_icd); return;
+	case L3_protocol::UDP:  ((Udp_packet  *)prot_base)->update_checksum(prot_icd); return;
+	case L3_protocol::ICMP: ((Icmp_packet *)prot_base)->update_checksum(prot_icd); return;
+	default: throw Interface::Bad_transport_protocol(); }
+}
+
+
+void Interface::_pass_prot(Ethernet_frame             &eth,
+                           size_t              const  eth_size,
+                           Ipv4_packet               &ip,
+                           L3_protocol         const  prot,
+                           void               *const  prot_base,
+                           Link_side_id        const &old_id,
+                           Domain                    &remote_domain)
 {
-	_update_checksum(prot, prot_base, prot_size, ip.src(), ip.dst(), ip.total_length());
-	_pass_ip(eth, eth_size, ip);
+	/*
+	 * Adapt the checksums to the rewritten addresses and ports instead of
+	 * computing them anew over the whole packet (RFC 1624).
+	 */
+	_update_checksums(prot, prot_base, ip, old_id);
+	remote_domain.interfaces().for_each([&] (Interface &interface) {
+		interface.send(eth, eth_size);
+	});
 }
 
 
@@ -414,7 +437,7 @@ void Interface::_adapt_eth(Ethernet_frame          &eth,
 			interface._broadcast_arp_request(remote_ip_cfg.interface.address,
 			                                 hop_ip);
 		});
-		new (_alloc) Arp_waiter(*this, remote_domain, hop_ip, pkt);
+		new (_alloc) Arp_waiter(*this, remote_domain, hop_ip, pkt, _segment_idx);
 		throw Packet_postponed();
 	}
 	eth.src(_router_mac);
@@ -426,7 +449,6 @@ void Interface::_nat_link_and_pass(Ethernet_frame        &eth,
                                    Ipv4_packet           &ip,
                                    L3_protocol     const  prot,
                                    void           *const  prot_base,
-                                   size_t          const  prot_size,
                                    Link_side_id    const &local_id,
                                    Domain                &local_domain,
                                    Domain                &remote_domain)
@@ -445,9 +467,7 @@ void Interface::_nat_link_and_pass(Ethernet_frame        &eth,
 	Link_side_id const remote_id = { ip.dst(), _dst_port(prot, prot_base),
 	                                 ip.src(), _src_port(prot, prot_base) };
 	_new_link(prot, local_id, remote_port_alloc, remote_domain, remote_id);
-	remote_domain.interfaces().for_each([&] (Interface &interface) {
-		interface._pass_prot(eth, eth_size, ip, prot, prot_base, prot_size);
-	});
+	_pass_prot(eth, eth_size, ip, prot, prot_base, local_id, remote_domain);
 }
 
 
@@ -746,7 +766,6 @@ void Interface::_handle_icmp_query(Ethernet_frame          &eth,
                                    Packet_descriptor const &pkt,
                                    L3_protocol              prot,
                                    void                    *prot_base,
-                                   size_t                   prot_size,
                                    Domain                  &local_domain)
 {
 	Link_side_id const local_id = { ip.src(), _src_port(prot, prot_base),
@@ -768,13 +787,11 @@ void Interface::_handle_icmp_query(Ethernet_frame          &eth,
 		_src_port(prot, prot_base, remote_side.dst_port());
 		_dst_port(prot, prot_base, remote_side.src_port());
 
-		remote_domain.interfaces().for_each([&] (Interface &interface) {
-			interface._pass_prot(eth, eth_size, ip, prot, prot_base, prot_size);
-		});
+		_pass_prot(eth, eth_size, ip, prot, prot_base, local_id, remote_domain);
 		_link_packet(prot, prot_base, link, client);
 		return;
 	}
-	catch (Link_side_tree::No_match) { }
+	catch (Link_side_table::No_match) { }
 
 	/* try to route via ICMP rules */
 	try {
@@ -786,8 +803,8 @@ void Interface::_handle_icmp_query(Ethernet_frame          &eth,
 
 		Domain &remote_domain = rule.domain();
 		_adapt_eth(eth, local_id.dst_ip, pkt, remote_domain);
-		_nat_link_and_pass(eth, eth_size, ip, prot, prot_base, prot_size,
-		                   local_id, local_domain, remote_domain);
+		_nat_link_and_pass(eth, eth_size, ip, prot, prot_base, local_id,
+		                   local_domain, remote_domain);
 
 		return;
 	}
@@ -856,7 +873,7 @@ void Interface::_handle_icmp_error(Ethernet_frame          &eth,
 			_link_packet(embed_prot, embed_prot_base, link, client); }
 	}
 	/* drop packet if there is no matching link */
-	catch (Link_side_tree::No_match) {
+	catch (Link_side_table::No_match) {
 		throw Drop_packet_inform("no link that matches packet embedded in ICMP error"); }
 }
 
@@ -867,7 +884,6 @@ void Interface::_handle_icmp(Ethernet_frame          &eth,
                              Packet_descriptor const &pkt,
                              L3_protocol              prot,
                              void                    *prot_base,
-                             size_t                   prot_size,
                              Domain                  &local_domain)
 {
 	/* drop packet if ICMP checksum is invalid */
@@ -880,7 +896,7 @@ void Interface::_handle_icmp(Ethernet_frame          &eth,
 	/* select ICMP message type */
 	switch (icmp.type()) {
 	case Icmp_packet::Type::ECHO_REPLY:
-	case Icmp_packet::Type::ECHO_REQUEST:    _handle_icmp_query(eth, eth_size, ip, pkt, prot, prot_base, prot_size, local_domain); break;
+	case Icmp_packet::Type::ECHO_REQUEST:    _handle_icmp_query(eth, eth_size, ip, pkt, prot, prot_base, local_domain); break;
 	case Icmp_packet::Type::DST_UNREACHABLE: _handle_icmp_error(eth, eth_size, ip, pkt, local_domain, icmp, icmp_sz); break;
 	default: Drop_packet_inform("unknown ICMP message type"); }
 }
@@ -938,7 +954,7 @@ void Interface::_handle_ip(Ethernet_frame          &eth,
 			}
 		}
 		else if (prot == L3_protocol::ICMP) {
-			_handle_icmp(eth, eth_size, ip, pkt, prot, prot_base, prot_size, local_domain);
+			_handle_icmp(eth, eth_size, ip, pkt, prot, prot_base, local_domain);
 			return;
 		}
 
@@ -961,13 +977,11 @@ void Interface::_handle_ip(Ethernet_frame          &eth,
 			_src_port(prot, prot_base, remote_side.dst_port());
 			_dst_port(prot, prot_base, remote_side.src_port());
 
-			remote_domain.interfaces().for_each([&] (Interface &interface) {
-				interface._pass_prot(eth, eth_size, ip, prot, prot_base, prot_size);
-			});
+			_pass_prot(eth, eth_size, ip, prot, prot_base, local_id, remote_domain);
 			_link_packet(prot, prot_base, link, client);
 			return;
 		}
-		catch (Link_side_tree::No_match) { }
+		catch (Link_side_table::No_match) { }
 
 		/* try to route via forward rules */
 		if (local_id.dst_ip == local_intf.address) {
@@ -982,7 +996,7 @@ void Interface::_handle_ip(Ethernet_frame          &eth,
 				_adapt_eth(eth, rule.to(), pkt, remote_domain);
 				ip.dst(rule.to());
 				_nat_link_and_pass(eth, eth_size, ip, prot, prot_base,
-				                   prot_size, local_id, local_domain, remote_domain);
+				                   local_id, local_domain, remote_domain);
 				return;
 			}
 			catch (Forward_rule_tree::No_match) { }
@@ -1001,8 +1015,8 @@ void Interface::_handle_ip(Ethernet_frame          &eth,
 
 			Domain &remote_domain = permit_rule.domain();
 			_adapt_eth(eth, local_id.dst_ip, pkt, remote_domain);
-			_nat_link_and_pass(eth, eth_size, ip, prot, prot_base, prot_size,
-			                   local_id, local_domain, remote_domain);
+			_nat_link_and_pass(eth, eth_size, ip, prot, prot_base, local_id,
+			                   local_domain, remote_domain);
 			return;
 		}
 		catch (Transport_rule_list::No_match) { }
@@ -1097,7 +1111,7 @@ void Interface::_handle_arp_reply(Ethernet_frame &eth,
 			Arp_waiter &waiter = *waiter_le->object();
 			waiter_le = waiter_le->next();
 			if (ip != waiter.ip()) { continue; }
-			waiter.src()._continue_handle_eth(waiter.packet());
+			waiter.src()._continue_handle_eth(waiter.packet(), waiter.segment());
 			destroy(waiter.src()._alloc, &waiter);
 		}
 	}
@@ -1194,22 +1208,51 @@ void Interface::_handle_arp(Ethernet_frame &eth,
 
 void Interface::_ready_to_submit()
 {
+	unsigned const burst_size = Genode::min(_config().burst_size(),
+	                                        (unsigned)MAX_BURST_SIZE);
+
 	while (_sink().packet_avail()) {
 
-		Packet_descriptor const pkt = _sink().get_packet();
-		if (!pkt.size()) {
-			continue; }
+		/* fetch no more packets than we can acknowledge at once */
+		Packet_descriptor pkts[MAX_BURST_SIZE];
+		unsigned const max_cnt =
+			Genode::max(Genode::min(burst_size, _sink().ack_slots_free()), 1U);
+		unsigned const cnt     = _sink().get_packets(pkts, max_cnt);
+
+		_burst_stats.rx_bursts++;
+		_burst_stats.rx_packets   += cnt;
+		_burst_stats.rx_max_burst  = Genode::max(_burst_stats.rx_max_burst, cnt);
+
+		/*
+		 * Collect the packets that the burst produces at each interface
+		 * and submit them at the end of the burst. For a single packet,
+		 * this would be pure overhead.
+		 */
+		Packet_descriptor acks[MAX_BURST_SIZE];
+		unsigned ack_cnt = 0;
+		{
+			Tx_defer_guard defer_tx_guard(cnt > 1);
+
+			for (unsigned i = 0; i < cnt; i++) {
+
+				Packet_descriptor const &pkt = pkts[i];
+				if (!pkt.size()) {
+					continue; }
 
-		try { _handle_eth(_sink().packet_content(pkt), pkt.size(), pkt); }
-		catch (Packet_postponed) { continue; }
-		_ack_packet(pkt);
+				try { _handle_pkt(pkt); }
+				catch (Packet_postponed) { continue; }
+				acks[ack_cnt++] = pkt;
+			}
+		}
+		_ack_packets(acks, ack_cnt);
 	}
 }
 
 
-void Interface::_continue_handle_eth(Packet_descriptor const &pkt)
+void Interface::_continue_handle_eth(Packet_descriptor const &pkt,
+                                     unsigned          const  first_segment)
 {
-	try { _handle_eth(_sink().packet_content(pkt), pkt.size(), pkt); }
+	try { _handle_pkt(pkt, first_segment); }
 	catch (Packet_postponed) { error("failed twice to handle packet"); }
 	_ack_packet(pkt);
 }
@@ -1239,6 +1282,54 @@ void Interface::_destroy_released_dhcp_allocations(Domain &local_domain)
 }
 
 
+void Interface::_handle_pkt(Packet_descriptor const &pkt,
+                            unsigned          const  first_segment)
+{
+	char *const pkt_base = _sink().packet_content(pkt);
+	_segment_idx = 0;
+
+	if (!_offload.enabled()) {
+		_handle_eth(pkt_base, pkt.size(), pkt);
+		return;
+	}
+	if (pkt.size() < sizeof(::Nic::Offload_header)) {
+		warning("packet without offload header");
+		return;
+	}
+	::Nic::Offload_header &header = *(::Nic::Offload_header *)pkt_base;
+	char  *const eth_base = pkt_base + sizeof(header);
+	size_t const eth_size = pkt.size() - sizeof(header);
+
+	if (header.gso_type == ::Nic::Offload_header::GSO_NONE) {
+		if (!::Nic::complete_checksum(eth_base, eth_size, header)) {
+			warning("malformed offload header");
+			return;
+		}
+		_handle_eth(eth_base, eth_size, pkt);
+		return;
+	}
+	/*
+	 * If a segment must wait for an ARP reply, the ARP waiter remembers
+	 * the index of the segment and the segmentation of the packet resumes
+	 * at this segment later. The segments sent already are not repeated.
+	 */
+	_segment_idx = first_segment;
+	bool const ok =
+		::Nic::for_each_segment(eth_base, eth_size, header,
+		                        _segment, sizeof(_segment),
+		                        [&] (void *seg_base, size_t seg_size) {
+
+			_handle_eth(seg_base, seg_size, pkt);
+			_segment_idx++;
+		},
+		first_segment);
+
+	_segment_idx = 0;
+	if (!ok) {
+		warning("failed to segment large packet"); }
+}
+
+
 void Interface::_handle_eth(void              *const  eth_base,
                             size_t             const  eth_size,
                             Packet_descriptor  const &pkt)
@@ -1313,8 +1404,17 @@ void Interface::_send_alloc_pkt(Packet_descriptor &pkt,
                                 void            * &pkt_base,
                                 size_t             pkt_size)
 {
-	pkt      = _source().alloc_packet(pkt_size);
+	size_t const header_size =
+		_offload.enabled() ? sizeof(::Nic::Offload_header) : 0;
+
+	pkt      = _source().alloc_packet(header_size + pkt_size);
 	pkt_base = _source().packet_content(pkt);
+
+	/* the router sends complete frames only */
+	if (header_size) {
+		Genode::memset(pkt_base, 0, header_size);
+		pkt_base = (char *)pkt_base + header_size;
+	}
 }
 
 
@@ -1328,7 +1428,68 @@ void Interface::_send_submit_pkt(Packet_descriptor &pkt,
 		log("[", local_domain, "] snd ",
 		    *reinterpret_cast<Ethernet_frame *>(pkt_base));
 	}
+	if (_tx_deferred) {
+		if (_tx_burst_cnt == MAX_BURST_SIZE) {
+			_flush_tx_burst(); }
+
+		_tx_burst[_tx_burst_cnt++] = pkt;
+		_enqueue_tx_pending();
+		return;
+	}
 	_source().submit_packet(pkt);
+	_burst_stats.tx_batches++;
+	_burst_stats.tx_packets++;
+}
+
+
+void Interface::_flush_tx_burst()
+{
+	if (!_tx_burst_cnt) {
+		return; }
+
+	_source().submit_packets(_tx_burst, _tx_burst_cnt);
+	_burst_stats.tx_batches++;
+	_burst_stats.tx_packets += _tx_burst_cnt;
+	_tx_burst_cnt = 0;
+}
+
+
+void Interface::_enqueue_tx_pending()
+{
+	if (_tx_pending) {
+		return; }
+
+	_tx_pending_next = _tx_pending_head;
+	_tx_pending_head = this;
+	_tx_pending      = true;
+}
+
+
+void Interface::_dequeue_tx_pending()
+{
+	if (!_tx_pending) {
+		return; }
+
+	for (Interface **intf = &_tx_pending_head; *intf; intf = &(*intf)->_tx_pending_next) {
+		if (*intf == this) {
+			*intf = _tx_pending_next;
+			break;
+		}
+	}
+	_tx_pending_next = nullptr;
+	_tx_pending      = false;
+}
+
+
+void Interface::_flush_deferred_tx()
+{
+	_tx_deferred = false;
+
+	/* visit only the interfaces that sent packets during the burst */
+	while (Interface *interface = _tx_pending_head) {
+		interface->_dequeue_tx_pending();
+		interface->_flush_tx_burst();
+	}
 }
 
 
@@ -1594,6 +1755,23 @@ void Interface::_ack_packet(Packet_descriptor const &pkt)
 }
 
 
+void Interface::_ack_packets(Packet_descriptor const *pkts,
+                             unsigned                 cnt)
+{
+	/*
+	 * Postponed packets that were continued during the burst may have
+	 * consumed acknowledgement slots in the meantime.
+	 */
+	if (cnt > _sink().ack_slots_free()) {
+		for (unsigned i = 0; i < cnt; i++) {
+			_ack_packet(pkts[i]); }
+
+		return;
+	}
+	_sink().acknowledge_packets(pkts, cnt);
+}
+
+
 void Interface::cancel_arp_waiting(Arp_waiter &waiter)
 {
 	warning("waiting for ARP cancelled");
@@ -1604,6 +1782,7 @@ void Interface::cancel_arp_waiting(Arp_waiter &waiter)
 
 Interface::~Interface()
 {
+	_dequeue_tx_pending();
 	_detach_from_domain();
 	_interfaces.remove(this);
 }
@@ -24,6 +24,7 @@
 
 /* Genode includes */
 #include <nic_session/nic_session.h>
+#include <nic/packet_allocator.h>
 #include <net/dhcp.h>
 #include <net/icmp.h>
 
@@ -63,6 +64,24 @@ class Net::Interface : private Interface_list::Element
 	friend class List<Interface>;
 	friend class Genode::List<Interface>;
 
+	public:
+
+		/**
+		 * Statistics about the burst processing of the interface
+		 *
+		 * Received packets are fetched in bursts of up to 'burst_size'
+		 * packets. Packets sent while a burst is processed are submitted
+		 * in batches that trigger one wakeup of the receiver each.
+		 */
+		struct Burst_stats
+		{
+			unsigned long rx_bursts    { 0 };
+			unsigned long rx_packets   { 0 };
+			unsigned      rx_max_burst { 0 };
+			unsigned long tx_batches   { 0 };
+			unsigned long tx_packets   { 0 };
+		};
+
 	protected:
 
 		using Signal_handler = Genode::Signal_handler<Interface>;
@@ -73,10 +92,19 @@ class Net::Interface : private Interface_list::Element
 		Signal_handler      _source_submit;
 		Mac_address  const  _router_mac;
 		Mac_address  const  _mac;
+		::Nic::Offload      _offload { };
 
 	private:
 
+		/*
+		 * Noncopyable
+		 */
+		Interface(Interface const &);
+		Interface &operator = (Interface const &);
+
 		enum { IPV4_TIME_TO_LIVE = 64 };
+		enum { MAX_BURST_SIZE    = 64 };
+		enum { SEGMENT_SIZE      = ::Nic::Packet_allocator::DEFAULT_PACKET_SIZE };
 
 		struct Dismiss_link       : Genode::Exception { };
 		struct Dismiss_arp_waiter : Genode::Exception { };
@@ -99,6 +127,13 @@ class Net::Interface : private Interface_list::Element
 		Interface_list                    &_interfaces;
 		bool                               _apply_foreign_arp_pending { false };
 		Genode::Signal_context_capability  _link_state_sigh           { };
+		Packet_descriptor                  _tx_burst[MAX_BURST_SIZE]  { };
+		unsigned                           _tx_burst_cnt              { 0 };
+		Interface                         *_tx_pending_next           { nullptr };
+		bool                               _tx_pending                { false };
+		Burst_stats                        _burst_stats               { };
+		char                               _segment[SEGMENT_SIZE]     { };
+		unsigned                           _segment_idx               { 0 };
 
 		void _new_link(L3_protocol             const  protocol,
 		               Link_side_id            const &local_id,
@@ -166,7 +201,6 @@ class Net::Interface : private Interface_list::Element
 		                        Packet_descriptor const &pkt,
 		                        L3_protocol              prot,
 		                        void                    *prot_base,
-		                        Genode::size_t           prot_size,
 		                        Domain                  &local_domain);
 
 		void _handle_icmp_error(Ethernet_frame          &eth,
@@ -183,7 +217,6 @@ class Net::Interface : private Interface_list::Element
 		                  Packet_descriptor const &pkt,
 		                  L3_protocol              prot,
 		                  void                    *prot_base,
-		                  Genode::size_t           prot_size,
 		                  Domain                  &local_domain);
 
 		void _adapt_eth(Ethernet_frame          &eth,
@@ -196,7 +229,6 @@ class Net::Interface : private Interface_list::Element
 		                        Ipv4_packet            &ip,
 		                        L3_protocol      const  prot,
 		                        void            *const  prot_base,
-		                        Genode::size_t   const  prot_size,
 		                        Link_side_id     const &local_id,
 		                        Domain                 &local_domain,
 		                        Domain                 &remote_domain);
@@ -213,13 +245,15 @@ class Net::Interface : private Interface_list::Element
 		                Ipv4_packet            &ip,
 		                L3_protocol      const  prot,
 		                void            *const  prot_base,
-		                Genode::size_t   const  prot_size);
+		                Link_side_id     const &old_id,
+		                Domain                 &remote_domain);
 
 		void _pass_ip(Ethernet_frame       &eth,
 		              Genode::size_t const  eth_size,
 		              Ipv4_packet          &ip);
 
-		void _continue_handle_eth(Packet_descriptor const &pkt);
+		void _continue_handle_eth(Packet_descriptor const &pkt,
+		                          unsigned                 first_segment);
 
 		Ipv4_address const &_router_ip() const;
 
@@ -227,8 +261,64 @@ class Net::Interface : private Interface_list::Element
 		                 Genode::size_t     const  eth_size,
 		                 Packet_descriptor  const &pkt);
 
+		/**
+		 * Handle a received packet, which may be subject to offloads
+		 *
+		 * Partial checksums are completed and large segments are split
+		 * up in software before routing because other interfaces may not
+		 * support offloads.
+		 *
+		 * \param first_segment  segment to resume a postponed packet at
+		 */
+		void _handle_pkt(Packet_descriptor const &pkt,
+		                 unsigned                 first_segment = 0);
+
 		void _ack_packet(Packet_descriptor const &pkt);
 
+		void _ack_packets(Packet_descriptor const *pkts,
+		                  unsigned                 cnt);
+
+		/*
+		 * Interfaces with packets deferred by the current receive burst
+		 *
+		 * All interfaces are served by the same entrypoint, so there is
+		 * at most one receive burst at a time.
+		 */
+		static bool       _tx_deferred;
+		static Interface *_tx_pending_head;
+
+		/**
+		 * Defer the submission of sent packets until the guard vanishes
+		 */
+		class Tx_defer_guard
+		{
+			private:
+
+				bool const _defer;
+
+			public:
+
+				Tx_defer_guard(bool defer) : _defer(defer)
+				{
+					if (_defer) {
+						Interface::_tx_deferred = true; }
+				}
+
+				~Tx_defer_guard()
+				{
+					if (_defer) {
+						Interface::_flush_deferred_tx(); }
+				}
+		};
+
+		void _flush_tx_burst();
+
+		void _enqueue_tx_pending();
+
+		void _dequeue_tx_pending();
+
+		static void _flush_deferred_tx();
+
 		virtual Packet_stream_sink &_sink() = 0;
 
 		virtual Packet_stream_source &_source() = 0;
@@ -367,9 +457,11 @@ class Net::Interface : private Interface_list::Element
 		 ** Accessors **
 		 ***************/
 
-		Domain          &domain()           { return _domain(); }
-		Mac_address      router_mac() const { return _router_mac; }
-		Arp_waiter_list &own_arp_waiters()  { return _own_arp_waiters; }
+		Domain            &domain()           { return _domain(); }
+		Mac_address        router_mac() const { return _router_mac; }
+		Mac_address        mac()        const { return _mac; }
+		Arp_waiter_list   &own_arp_waiters()  { return _own_arp_waiters; }
+		Burst_stats const &burst_stats() const { return _burst_stats; }
 };
 
 #endif /* _INTERFACE_H_ */
@@ -21,7 +21,10 @@
 namespace Net {
 
 	class  Ip_rule;
-	struct Ip_rule_list : Direct_rule_list<Ip_rule> { };
+	struct Ip_rule_list : Direct_rule_list<Ip_rule>
+	{
+		using Direct_rule_list<Ip_rule>::Direct_rule_list;
+	};
 }
 
 
@@ -45,6 +45,18 @@ bool Link_side_id::operator > (Link_side_id const &id) const
 }
 
 
+uint32_t Link_side_id::hash() const
+{
+	/* FNV-1a over the 4-tuple */
+	uint8_t const *byte = (uint8_t const *)data_base();
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < data_size(); i++) {
+		h = (h ^ byte[i]) * 16777619u; }
+
+	return h ^ (h >> 16);
+}
+
+
 /***************
  ** Link_side **
  ***************/
@@ -62,44 +74,89 @@ Link_side::Link_side(Domain             &domain,
 }
 
 
-Link_side const &Link_side::find_by_id(Link_side_id const &id) const
+void Link_side::print(Output &output) const
 {
-	if (id == _id) {
-		return *this; }
+	Genode::print(output, "src ", src_ip(), ":", src_port(),
+	                     " dst ", dst_ip(), ":", dst_port());
+}
 
-	bool const side = id > _id;
-	Link_side *const link_side = Avl_node<Link_side>::child(side);
-	if (!link_side) {
-		throw Link_side_tree::No_match(); }
 
-	return link_side->find_by_id(id);
+bool Link_side::is_client() const
+{
+	return this == &_link.client();
 }
 
 
-void Link_side::print(Output &output) const
+/*********************
+ ** Link_side_table **
+ *********************/
+
+Link_side_table::~Link_side_table()
 {
-	Genode::print(output, "src ", src_ip(), ":", src_port(),
-	                     " dst ", dst_ip(), ":", dst_port());
+	if (_buckets != _initial_buckets) {
+		_alloc.free(_buckets, _num_buckets * sizeof(Link_side *)); }
 }
 
 
-bool Link_side::is_client() const
+void Link_side_table::_grow()
 {
-	return this == &_link.client();
+	unsigned long const num_buckets = _num_buckets << 1;
+	Link_side **buckets = nullptr;
+	if (!_alloc.alloc(num_buckets * sizeof(Link_side *), (void **)&buckets)) {
+		return; }
+
+	for (unsigned long i = 0; i < num_buckets; i++) {
+		buckets[i] = nullptr; }
+
+	/* move all link sides to the new buckets */
+	for (unsigned long i = 0; i < _num_buckets; i++) {
+		while (Link_side *side = _buckets[i]) {
+			_buckets[i] = side->_hash_next;
+			Link_side *&bucket = buckets[side->_id.hash() & (num_buckets - 1)];
+			side->_hash_next = bucket;
+			bucket = side;
+		}
+	}
+	if (_buckets != _initial_buckets) {
+		_alloc.free(_buckets, _num_buckets * sizeof(Link_side *)); }
+
+	_buckets     = buckets;
+	_num_buckets = num_buckets;
 }
 
 
-/********************
- ** Link_side_tree **
- ********************/
+void Link_side_table::insert(Link_side &side)
+{
+	if (_count >= _num_buckets) {
+		_grow(); }
 
-Link_side const &Link_side_tree::find_by_id(Link_side_id const &id) const
+	Link_side *&bucket = _bucket(side._id);
+	side._hash_next = bucket;
+	bucket = &side;
+	_count++;
+}
+
+
+void Link_side_table::remove(Link_side &side)
 {
-	Link_side *const link_side = first();
-	if (!link_side) {
-		throw No_match(); }
+	for (Link_side **s = &_bucket(side._id); *s; s = &(*s)->_hash_next) {
+		if (*s == &side) {
+			*s = side._hash_next;
+			side._hash_next = nullptr;
+			_count--;
+			return;
+		}
+	}
+}
+
 
-	return link_side->find_by_id(id);
+Link_side const &Link_side_table::find_by_id(Link_side_id const &id) const
+{
+	for (Link_side const *s = _bucket(id); s; s = s->_hash_next) {
+		if (s->_id == id) {
+			return *s; }
+	}
+	throw No_match();
 }
 
 
@@ -133,8 +190,8 @@ Link::Link(Interface                     &cln_interface,
 	_server(srv_domain, srv_id, *this)
 {
 	_client_interface.links(_protocol).insert(this);
-	_client.domain().links(_protocol).insert(&_client);
-	_server.domain().links(_protocol).insert(&_server);
+	_client.domain().links(_protocol).insert(_client);
+	_server.domain().links(_protocol).insert(_server);
 	_dissolve_timeout.schedule(_dissolve_timeout_us);
 }
 
@@ -149,8 +206,8 @@ void Link::_handle_dissolve_timeout(Duration)
 
 void Link::dissolve()
 {
-	_client.domain().links(_protocol).remove(&_client);
-	_server.domain().links(_protocol).remove(&_server);
+	_client.domain().links(_protocol).remove(_client);
+	_server.domain().links(_protocol).remove(_server);
 	if (_config().verbose()) {
 		log("Dissolve ", l3_protocol_name(_protocol), " link: ", *this); }
 
@@ -182,16 +239,16 @@ void Link::handle_config(Domain                        &cln_domain,
 	_dissolve_timeout_us = dissolve_timeout_us;
 	_dissolve_timeout.schedule(_dissolve_timeout_us);
 
-	_client.domain().links(_protocol).remove(&_client);
-	_server.domain().links(_protocol).remove(&_server);
+	_client.domain().links(_protocol).remove(_client);
+	_server.domain().links(_protocol).remove(_server);
 
 	_config            = config;
 	_client._domain    = cln_domain;
 	_server._domain    = srv_domain;
 	_server_port_alloc = srv_port_alloc;
 
-	cln_domain.links(_protocol).insert(&_client);
-	srv_domain.links(_protocol).insert(&_server);
+	cln_domain.links(_protocol).insert(_client);
+	srv_domain.links(_protocol).insert(_server);
 
 	if (config.verbose()) {
 		log("[", cln_domain, "] update link client: ", _client);
@@ -32,7 +32,7 @@
 
 /* Genode includes */
 #include <timer_session/connection.h>
-#include <util/avl_tree.h>
+#include <base/allocator.h>
 #include <util/list.h>
 #include <net/ipv4.h>
 #include <net/port.h>
@@ -52,7 +52,7 @@ namespace Net {
 	class  Interface;
 	class  Link_side_id;
 	class  Link_side;
-	class  Link_side_tree;
+	class  Link_side_table;
 	class  Link;
 	struct Link_list : List<Link> { };
 	class  Tcp_link;
@@ -72,6 +72,11 @@ struct Net::Link_side_id
 
 	void *data_base() const { return (void *)&src_ip; }
 
+	/**
+	 * Return hash value of the 4-tuple
+	 */
+	Genode::uint32_t hash() const;
+
 
 	/************************
 	 ** Standard operators **
@@ -84,15 +89,23 @@ struct Net::Link_side_id
 __attribute__((__packed__));
 
 
-class Net::Link_side : public Genode::Avl_node<Link_side>
+class Net::Link_side
 {
 	friend class Link;
+	friend class Link_side_table;
 
 	private:
 
 		Reference<Domain>   _domain;
 		Link_side_id const  _id;
 		Link               &_link;
+		Link_side          *_hash_next { nullptr };
+
+		/*
+		 * Noncopyable
+		 */
+		Link_side(Link_side const &);
+		Link_side &operator = (Link_side const &);
 
 	public:
 
@@ -100,18 +113,9 @@ class Net::Link_side : public Genode::Avl_node<Link_side>
 		          Link_side_id const &id,
 		          Link               &link);
 
-		Link_side const &find_by_id(Link_side_id const &id) const;
-
 		bool is_client() const;
 
 
-		/**************
-		 ** Avl_node **
-		 **************/
-
-		bool higher(Link_side *side) { return side->_id > _id; }
-
-
 		/*********
 		 ** Log **
 		 *********/
@@ -132,11 +136,52 @@ class Net::Link_side : public Genode::Avl_node<Link_side>
 };
 
 
-struct Net::Link_side_tree : Genode::Avl_tree<Link_side>
+/**
+ * Hash table of the link sides of a domain and protocol
+ *
+ * The table is indexed by the 4-tuple of the link side. It starts with an
+ * embedded bucket array and grows whenever the number of link sides exceeds
+ * the number of buckets. If growing fails due to a lack of memory, the
+ * table keeps working with longer bucket chains.
+ */
+class Net::Link_side_table
 {
-	struct No_match : Genode::Exception { };
+	private:
+
+		enum { INITIAL_BUCKETS = 64 };
+
+		Genode::Allocator &_alloc;
+		Link_side         *_initial_buckets[INITIAL_BUCKETS] { };
+		Link_side        **_buckets     { _initial_buckets };
+		unsigned long      _num_buckets { INITIAL_BUCKETS };
+		unsigned long      _count       { 0 };
+
+		/*
+		 * Noncopyable
+		 */
+		Link_side_table(Link_side_table const &);
+		Link_side_table &operator = (Link_side_table const &);
+
+		Link_side *&_bucket(Link_side_id const &id) const {
+			return _buckets[id.hash() & (_num_buckets - 1)]; }
+
+		void _grow();
+
+	public:
+
+		struct No_match : Genode::Exception { };
+
+		Link_side_table(Genode::Allocator &alloc) : _alloc(alloc) { }
+
+		~Link_side_table();
+
+		void insert(Link_side &side);
+
+		void remove(Link_side &side);
+
+		Link_side const &find_by_id(Link_side_id const &id) const;
 
-	Link_side const &find_by_id(Link_side_id const &id) const;
+		unsigned long count() const { return _count; }
 };
 
 
@@ -33,10 +33,22 @@ class Net::Main
 {
 	private:
 
+		/**
+		 * Heap that returns the backing store of vanished sessions and
+		 * configurations to the RAM session
+		 */
+		struct Returning_heap : Genode::Heap
+		{
+			Returning_heap(Genode::Env &env) : Heap(&env.ram(), &env.rm())
+			{
+				return_unused_dataspaces();
+			}
+		};
+
 		Genode::Env                    &_env;
 		Interface_list                  _interfaces     { };
 		Timer::Connection               _timer          { _env };
-		Genode::Heap                    _heap           { &_env.ram(), &_env.rm() };
+		Returning_heap                  _heap           { _env };
 		Genode::Attached_rom_dataspace  _config_rom     { _env, "config" };
 		Reference<Configuration>        _config         { _init_config() };
 		Signal_handler<Main>            _config_handler { _env.ep(), *this, &Main::_handle_config };
@@ -0,0 +1,166 @@
+/*
+ * \brief  Longest-prefix-match table for IPv4 rules
+ * \author Genode Labs
+ * \date   2018-03-26
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _PREFIX_TABLE_H_
+#define _PREFIX_TABLE_H_
+
+/* Genode includes */
+#include <base/allocator.h>
+#include <util/string.h>
+#include <net/ipv4.h>
+
+/* local includes */
+#include <ipv4_address_prefix.h>
+
+namespace Net { template <typename> class Prefix_table; }
+
+
+/**
+ * Multibit trie with a stride of one address byte
+ *
+ * Each rule is stored at the level that covers the last byte of its prefix.
+ * At this level, the prefix is expanded to all matching entries (controlled
+ * prefix expansion), so a lookup takes at most four steps, one per address
+ * byte. Rules at deeper levels always have longer prefixes, therefore the
+ * deepest match is the longest-prefix match.
+ *
+ * \param T  rule type that provides 'Ipv4_address_prefix const &dst()'
+ */
+template <typename T>
+class Net::Prefix_table
+{
+	private:
+
+		enum { STRIDE = 8, ENTRIES = 1 << STRIDE, LEVELS = 4 };
+
+		struct Node
+		{
+			T const *rule  [ENTRIES];
+			Node    *child [ENTRIES];
+
+			Node()
+			{
+				Genode::memset(rule,  0, sizeof(rule));
+				Genode::memset(child, 0, sizeof(child));
+			}
+		};
+
+		Genode::Allocator &_alloc;
+		Node              *_root  { nullptr };
+		bool               _valid { true };
+
+		/*
+		 * Noncopyable
+		 */
+		Prefix_table(Prefix_table const &);
+		Prefix_table &operator = (Prefix_table const &);
+
+		void _destroy(Node *node)
+		{
+			for (unsigned i = 0; i < ENTRIES; i++) {
+				if (node->child[i]) {
+					_destroy(node->child[i]); }
+			}
+			Genode::destroy(_alloc, node);
+		}
+
+		void _insert(T const &rule)
+		{
+			Ipv4_address_prefix const &dst = rule.dst();
+			if (dst.prefix > 8 * LEVELS) {
+				throw Invalid_prefix(); }
+
+			if (!_root) {
+				_root = new (_alloc) Node; }
+
+			/* descend to the level that covers the last prefix byte */
+			Node *node = _root;
+			unsigned level = 0;
+			for (; dst.prefix > STRIDE * (level + 1); level++) {
+				Node *&child = node->child[dst.address.addr[level]];
+				if (!child) {
+					child = new (_alloc) Node; }
+
+				node = child;
+			}
+			/* expand the remaining prefix bits to all covered entries */
+			unsigned const bits  = dst.prefix - STRIDE * level;
+			unsigned const first = dst.address.addr[level] &
+			                       (0xff00 >> bits) & 0xff;
+
+			for (unsigned i = first; i < first + (1U << (STRIDE - bits)); i++) {
+				T const *&entry = node->rule[i];
+				if (!entry || entry->dst().prefix <= dst.prefix) {
+					entry = &rule; }
+			}
+		}
+
+	public:
+
+		struct Invalid_prefix : Genode::Exception { };
+
+		Prefix_table(Genode::Allocator &alloc) : _alloc(alloc) { }
+
+		~Prefix_table() { clear(); }
+
+		/**
+		 * Add rule to the table
+		 *
+		 * Of two rules with the same prefix, the one added last takes
+		 * precedence. If the table cannot be completed, e.g., because
+		 * of a lack of memory, it is marked invalid and the caller is
+		 * expected to fall back to a linear search.
+		 */
+		void insert(T const &rule)
+		{
+			if (!_valid) {
+				return; }
+
+			try { _insert(rule); }
+			catch (Invalid_prefix)      { _valid = false; }
+			catch (Genode::Out_of_ram)  { _valid = false; }
+			catch (Genode::Out_of_caps) { _valid = false; }
+		}
+
+		/**
+		 * Return rule with the longest prefix that matches 'ip'
+		 *
+		 * \return  pointer to the rule or nullptr if no rule matches
+		 */
+		T const *longest_prefix_match(Ipv4_address const &ip) const
+		{
+			T const *match = nullptr;
+			Node const *node = _root;
+			for (unsigned level = 0; node && level < LEVELS; level++) {
+				unsigned const idx = ip.addr[level];
+				if (node->rule[idx]) {
+					match = node->rule[idx]; }
+
+				node = node->child[idx];
+			}
+			return match;
+		}
+
+		void clear()
+		{
+			if (_root) {
+				_destroy(_root); }
+
+			_root  = nullptr;
+			_valid = true;
+		}
+
+		bool valid() const { return _valid; }
+};
+
+#endif /* _PREFIX_TABLE_H_ */
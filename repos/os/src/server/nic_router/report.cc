@@ -27,6 +27,7 @@ Net::Report::Report(Xml_node const     node,
 :
 	_config(node.attribute_value("config", true)),
 	_bytes (node.attribute_value("bytes",  true)),
+	_bursts(node.attribute_value("bursts", false)),
 	_reporter(reporter),
 	_domains(domains),
 	_timeout(timer, *this, &Report::_handle_report_timeout,
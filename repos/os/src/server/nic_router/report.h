@@ -37,6 +37,7 @@ class Net::Report
 
 		bool const                       _config;
 		bool const                       _bytes;
+		bool const                       _bursts;
 		Genode::Reporter                &_reporter;
 		Domain_tree                     &_domains;
 		Timer::Periodic_timeout<Report>  _timeout;
@@ -57,6 +58,7 @@ class Net::Report
 
 		bool config() const { return _config; }
 		bool bytes()  const { return _bytes; }
+		bool bursts() const { return _bursts; }
 };
 
 #endif /* _REPORT_H_ */
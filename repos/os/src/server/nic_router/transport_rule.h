@@ -25,7 +25,10 @@ namespace Net {
 
 	class  Configuration;
 	class  Transport_rule;
-	struct Transport_rule_list : Direct_rule_list<Transport_rule> { };
+	struct Transport_rule_list : Direct_rule_list<Transport_rule>
+	{
+		using Direct_rule_list<Transport_rule>::Direct_rule_list;
+	};
 }
 
 
@@ -30,10 +30,14 @@ Net::Uplink::Uplink(Env               &env,
                     Configuration     &config)
 :
 	Nic::Packet_allocator(&alloc),
-	Nic::Connection(env, this, BUF_SIZE, BUF_SIZE),
+	Nic::Connection(env, this, BUF_SIZE, BUF_SIZE, "",
+	                Nic::Offload(Nic::Offload::RX_COALESCE)),
 	Net::Interface(env.ep(), timer, mac_address(), alloc, Mac_address(),
 	               config, interfaces, _intf_policy)
 {
+	/* coalesced segments from the uplink are split up on reception */
+	_offload = Nic::Connection::offload();
+
 	rx_channel()->sigh_ready_to_ack(_sink_ack);
 	rx_channel()->sigh_packet_avail(_sink_submit);
 	tx_channel()->sigh_ack_avail(_source_ack);
@@ -21,6 +21,7 @@
 #include <block_session/rpc_object.h>
 
 #include "gpt.h"
+#include "queue.h"
 
 namespace Block {
 
@@ -57,6 +58,10 @@ class Block::Session_component : public  Block::Session_rpc_object,
 		Block::Driver                    &_driver;
 		bool                              _writeable;
 
+		/* additional queues of a multi-queue session */
+		Constructible<Queue_component>    _queues[Session::MAX_QUEUES - 1];
+		unsigned                          _num_queues = 1;
+
 		/**
 		 * Acknowledge a packet already handled
 		 */
@@ -139,16 +144,18 @@ class Block::Session_component : public  Block::Session_rpc_object,
 		 */
 		Session_component(Ram_dataspace_capability  rq_ds,
 		                  Partition                *partition,
-		                  Genode::Entrypoint       &ep,
-		                  Genode::Region_map       &rm,
+		                  Genode::Env              &env,
 		                  Block::Driver            &driver,
+		                  Queue_workers            &workers,
+		                  unsigned                  queues,
+		                  size_t                    buf_size,
 		                  bool                      writeable)
-		: Session_rpc_object(rm, rq_ds, ep.rpc_ep()),
+		: Session_rpc_object(env.rm(), rq_ds, env.ep().rpc_ep()),
 		  _rq_ds(rq_ds),
 		  _rq_phys(Dataspace_client(_rq_ds).phys_addr()),
 		  _partition(partition),
-		  _sink_ack(ep, *this, &Session_component::_ready_to_ack),
-		  _sink_submit(ep, *this, &Session_component::_packet_avail),
+		  _sink_ack(env.ep(), *this, &Session_component::_ready_to_ack),
+		  _sink_submit(env.ep(), *this, &Session_component::_packet_avail),
 		  _req_queue_full(false),
 		  _ack_queue_full(false),
 		  _p_in_fly(0),
@@ -157,10 +164,19 @@ class Block::Session_component : public  Block::Session_rpc_object,
 		{
 			_tx.sigh_ready_to_ack(_sink_ack);
 			_tx.sigh_packet_avail(_sink_submit);
+
+			queues = min(queues, workers.queues());
+			for (; _num_queues < queues; _num_queues++)
+				_queues[_num_queues - 1].construct(env, workers.worker(_num_queues),
+				                                   *partition, buf_size, writeable);
 		}
 
 		~Session_component()
 		{
+			/* the queues are dissolved by the entrypoints serving them */
+			for (unsigned i = 1; i < _num_queues; i++)
+				_queues[i - 1]->worker().destruct(_queues[i - 1]);
+
 			_driver.remove_dispatcher(*this);
 
 			if (_req_queue_full)
@@ -225,6 +241,16 @@ class Block::Session_component : public  Block::Session_rpc_object,
 		}
 
 		void sync() { _driver.session().sync(); }
+
+		unsigned queues() override { return _num_queues; }
+
+		Capability<Session::Tx> _queue_cap(unsigned idx) override
+		{
+			if (idx == 0)          return _tx.cap();
+			if (idx < _num_queues) return _queues[idx - 1]->cap();
+
+			return Capability<Session::Tx>();
+		}
 };
 
 
@@ -240,6 +266,7 @@ class Block::Root :
 		Genode::Xml_node        _config;
 		Block::Driver          &_driver;
 		Block::Partition_table &_table;
+		Block::Queue_workers   &_workers;
 
 	protected:
 
@@ -288,10 +315,14 @@ class Block::Root :
 				Arg_string::find_arg(args, "ram_quota"  ).ulong_value(0);
 			size_t tx_buf_size =
 				Arg_string::find_arg(args, "tx_buf_size").ulong_value(0);
+			unsigned queues =
+				Arg_string::find_arg(args, "queues").ulong_value(1);
 
 			if (!tx_buf_size)
 				throw Service_denied();
 
+			queues = max(1U, min(queues, _workers.queues()));
+
 			/* delete ram quota by the memory needed for the session */
 			size_t session_size = max((size_t)4096,
 			                          sizeof(Session_component)
@@ -300,13 +331,13 @@ class Block::Root :
 				throw Insufficient_ram_quota();
 
 			/*
-			 * Check if donated ram quota suffices for both
+			 * Check if donated ram quota suffices for all
 			 * communication buffers. Also check both sizes separately
 			 * to handle a possible overflow of the sum of both sizes.
 			 */
-			if (tx_buf_size > ram_quota - session_size) {
+			if (tx_buf_size > (ram_quota - session_size) / queues) {
 				error("insufficient 'ram_quota', got ", ram_quota, ", need ",
-				     tx_buf_size + session_size);
+				     tx_buf_size*queues + session_size);
 				throw Insufficient_ram_quota();
 			}
 
@@ -316,8 +347,8 @@ class Block::Root :
 			Ram_dataspace_capability ds_cap;
 			ds_cap = _env.ram().alloc(tx_buf_size);
 			Session_component *session = new (md_alloc())
-				Session_component(ds_cap, _table.partition(num),
-				                  _env.ep(), _env.rm(), _driver,
+				Session_component(ds_cap, _table.partition(num), _env,
+				                  _driver, _workers, queues, tx_buf_size,
 				                  writeable);
 
 			log("session opened at partition ", num, " for '", label_str, "'");
@@ -327,9 +358,10 @@ class Block::Root :
 	public:
 
 		Root(Genode::Env &env, Genode::Xml_node config, Genode::Heap &heap,
-		     Block::Driver &driver, Block::Partition_table &table)
+		     Block::Driver &driver, Block::Partition_table &table,
+		     Block::Queue_workers &workers)
 		: Root_component(env.ep(), heap), _env(env), _config(config),
-		  _driver(driver), _table(table) { }
+		  _driver(driver), _table(table), _workers(workers) { }
 };
 
 #endif /* _PART_BLK__COMPONENT_H_ */
@@ -81,6 +81,7 @@ class Block::Driver
 		Genode::List<Request>          _r_list { };
 		Genode::Allocator_avl          _block_alloc;
 		Block::Connection              _session;
+		unsigned const                 _queues;
 		Block::sector_t                _blk_cnt  = 0;
 		Genode::size_t                 _blk_size = 0;
 		Genode::Signal_handler<Driver> _source_ack;
@@ -109,10 +110,18 @@ class Block::Driver
 
 	public:
 
-		Driver(Genode::Env &env, Genode::Heap &heap)
+		enum { QUEUE_BUF_SIZE = 4 * 1024 * 1024 };
+
+		/**
+		 * Constructor
+		 *
+		 * \param queues  number of queues requested from the back end
+		 */
+		Driver(Genode::Env &env, Genode::Heap &heap, unsigned queues = 1)
 		: _r_slab(&heap),
 		  _block_alloc(&heap),
-		  _session(env, &_block_alloc, 4 * 1024 * 1024),
+		  _session(env, &_block_alloc, QUEUE_BUF_SIZE, "", queues),
+		  _queues(_session.queues()),
 		  _source_ack(env.ep(), *this, &Driver::_ack_avail),
 		  _source_submit(env.ep(), *this, &Driver::_ready_to_submit)
 		{
@@ -124,6 +133,11 @@ class Block::Driver
 		Session::Operations ops() { return _ops; }
 		Session_client& session() { return _session;  }
 
+		/**
+		 * Return number of queues granted by the back end
+		 */
+		unsigned queues() const { return _queues; }
+
 		void work_asynchronously()
 		{
 			_session.tx_channel()->sigh_ack_avail(_source_ack);
@@ -36,12 +36,17 @@ class Main
 
 		Genode::Attached_rom_dataspace _config { _env, "config" };
 
-		Genode::Heap        _heap     { _env.ram(), _env.rm() };
-		Block::Driver       _driver   { _env, _heap      };
-		Genode::Reporter    _reporter { _env, "partitions" };
-		Mbr_partition_table _mbr      { _heap, _driver, _reporter };
-		Gpt                 _gpt      { _heap, _driver, _reporter };
-		Block::Root         _root     { _env, _config.xml(), _heap, _driver, _table() };
+		unsigned const _queues {
+			_config.xml().attribute_value("queues", 1U) };
+
+		Genode::Heap         _heap     { _env.ram(), _env.rm() };
+		Block::Driver        _driver   { _env, _heap, _queues };
+		Genode::Reporter     _reporter { _env, "partitions" };
+		Mbr_partition_table  _mbr      { _heap, _driver, _reporter };
+		Gpt                  _gpt      { _heap, _driver, _reporter };
+		Block::Queue_workers _workers  { _env, _heap, _driver };
+		Block::Root          _root     { _env, _config.xml(), _heap, _driver,
+		                                 _table(), _workers };
 
 	public:
 
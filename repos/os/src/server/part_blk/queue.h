@@ -0,0 +1,421 @@
+/*
+ * \brief  Additional queues of multi-queue sessions of the partition server
+ * \author Genode Labs
+ * \date   2018-03-14
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+#ifndef _PART_BLK__QUEUE_H_
+#define _PART_BLK__QUEUE_H_
+
+#include <base/entrypoint.h>
+#include <base/allocator_avl.h>
+#include <base/tslab.h>
+#include <base/heap.h>
+#include <util/list.h>
+#include <util/reconstructible.h>
+#include <block_session/rpc_object.h>
+#include <block_session/client.h>
+
+#include "partition_table.h"
+
+namespace Block {
+
+	class Queue_worker;
+	class Queue_workers;
+	class Queue_component_base;
+	class Queue_component;
+}
+
+
+/**
+ * Thread that serves one additional back-end queue
+ *
+ * The worker owns the back-end queue with the same index as the front-end
+ * queues it serves. All front-end queues of this index, one per session,
+ * are handled by the worker's entrypoint. Hence, the back-end queue and the
+ * requests in flight are accessed by the worker thread only. The lock solely
+ * protects the list of front-end queues, which is modified by the main
+ * entrypoint whenever a session is opened or closed.
+ */
+class Block::Queue_worker
+{
+	public:
+
+		struct Request : Genode::List<Request>::Element
+		{
+			Queue_component  &queue;
+			Packet_descriptor cli;
+			Packet_descriptor srv;
+
+			Request(Queue_component &queue, Packet_descriptor cli,
+			        Packet_descriptor srv)
+			: queue(queue), cli(cli), srv(srv) { }
+		};
+
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		Queue_worker(Queue_worker const &);
+		Queue_worker &operator = (Queue_worker const &);
+
+		enum { STACK_SIZE = 4*1024*sizeof(long),
+		       BLK_SZ     = Session::TX_QUEUE_SIZE*sizeof(Request) };
+
+		friend class Queue_component;
+
+		Genode::Entrypoint                   _ep;
+		Genode::Allocator_avl                _block_alloc;
+		Queue_client                         _backend;
+		Genode::size_t const                 _blk_size;
+		Genode::Tslab<Request, BLK_SZ>       _r_slab;
+		Genode::List<Request>                _r_list   { };
+		Genode::List<Queue_component>        _queues   { };
+		Genode::Lock                         _lock     { };
+		Genode::Signal_handler<Queue_worker> _ack_avail;
+		Genode::Signal_handler<Queue_worker> _ready_to_submit;
+
+		/*
+		 * Front-end queue to be destructed by the worker's entrypoint,
+		 * see 'destruct'
+		 */
+		Genode::Constructible<Queue_component> *_destruct_queue = nullptr;
+		Genode::Lock                            _destructed { Genode::Lock::LOCKED };
+		Genode::Signal_handler<Queue_worker>    _destruct;
+
+		inline void _handle_ack_avail();
+		inline void _handle_ready_to_submit();
+		inline void _handle_destruct();
+
+	public:
+
+		/**
+		 * Constructor
+		 *
+		 * \param backend_cap  capability of the back-end queue
+		 * \param blk_size     block size of the back-end device
+		 */
+		Queue_worker(Genode::Env &env, Genode::Heap &heap,
+		             Genode::Capability<Session::Tx> backend_cap,
+		             Genode::size_t blk_size)
+		:
+			_ep(env, STACK_SIZE, "part_blk_queue"),
+			_block_alloc(&heap),
+			_backend(backend_cap, env.rm(), _block_alloc),
+			_blk_size(blk_size),
+			_r_slab(&heap),
+			_ack_avail(_ep, *this, &Queue_worker::_handle_ack_avail),
+			_ready_to_submit(_ep, *this, &Queue_worker::_handle_ready_to_submit),
+			_destruct(_ep, *this, &Queue_worker::_handle_destruct)
+		{
+			_backend.sigh_ack_avail(_ack_avail);
+			_backend.sigh_ready_to_submit(_ready_to_submit);
+		}
+
+		Genode::Entrypoint &ep() { return _ep; }
+
+		inline void insert(Queue_component &queue);
+		inline void remove(Queue_component &queue);
+
+		/**
+		 * Destruct front-end queue served by the worker
+		 *
+		 * The signal handlers and the packet stream of the queue are
+		 * dispatched by the worker's entrypoint. Hence, they are dissolved
+		 * by this entrypoint, which cannot execute a handler of the queue
+		 * at the same time. The caller blocks until the queue is destructed.
+		 */
+		inline void destruct(Genode::Constructible<Queue_component> &queue);
+};
+
+
+/**
+ * Workers for all additional queues granted by the back end
+ */
+class Block::Queue_workers
+{
+	private:
+
+		Genode::Constructible<Queue_worker> _workers[Session::MAX_QUEUES - 1];
+
+		unsigned _queues = 1;
+
+	public:
+
+		Queue_workers(Genode::Env &env, Genode::Heap &heap, Driver &driver)
+		{
+			for (; _queues < driver.queues(); _queues++)
+				_workers[_queues - 1].construct(env, heap,
+				                                driver.session().queue_cap(_queues),
+				                                driver.blk_size());
+		}
+
+		/**
+		 * Return number of queues including queue 0 served by the driver
+		 */
+		unsigned queues() const { return _queues; }
+
+		Queue_worker &worker(unsigned queue) { return *_workers[queue - 1]; }
+};
+
+
+/**
+ * Bulk buffer of a front-end queue, which must outlive the packet stream
+ */
+class Block::Queue_component_base
+{
+	protected:
+
+		Genode::Ram_session            &_ram;
+		Genode::Ram_dataspace_capability _ds;
+
+		Queue_component_base(Genode::Ram_session &ram, Genode::size_t buf_size)
+		: _ram(ram), _ds(_ram.alloc(buf_size)) { }
+
+		~Queue_component_base() { _ram.free(_ds); }
+};
+
+
+/**
+ * Additional front-end queue of a session
+ */
+class Block::Queue_component : Queue_component_base,
+                               public Genode::List<Queue_component>::Element
+{
+	private:
+
+		/*
+		 * Noncopyable
+		 */
+		Queue_component(Queue_component const &);
+		Queue_component &operator = (Queue_component const &);
+
+		friend class Queue_worker;
+
+		Queue_worker                             &_worker;
+		Partition                                &_partition;
+		bool const                                _writeable;
+		Packet_stream_tx::Rpc_object<Session::Tx> _tx;
+		Genode::Signal_handler<Queue_component>  _sink_ack;
+		Genode::Signal_handler<Queue_component>  _sink_submit;
+		unsigned                                  _p_in_fly = 0;
+
+		Session::Tx::Sink &_sink() { return *_tx.sink(); }
+
+		void _ack(Packet_descriptor packet)
+		{
+			_sink().acknowledge_packet(packet);
+			_p_in_fly--;
+		}
+
+		/**
+		 * Forward request to back end
+		 *
+		 * \return false if the back end is congested
+		 */
+		bool _forward(Packet_descriptor packet)
+		{
+			Session::Tx::Source &backend = *_worker._backend.source();
+
+			packet.succeeded(false);
+
+			bool const write = packet.operation() == Packet_descriptor::WRITE;
+
+			/* acknowledge invalid requests right away */
+			if (!packet.size() || (write && !_writeable)
+			 || !_sink().packet_content(packet)
+			 || packet.block_number() + packet.block_count() > _partition.sectors
+			 || packet.block_count() * _worker._blk_size > packet.size()) {
+				_ack(packet);
+				return true;
+			}
+
+			if (!backend.ready_to_submit())
+				return false;
+
+			Genode::size_t const size = packet.block_count() * _worker._blk_size;
+
+			Packet_descriptor srv;
+			try {
+				srv = Packet_descriptor(backend.alloc_packet(size, Packet_descriptor::PACKET_ALIGNMENT),
+				                        packet.operation(),
+				                        packet.block_number() + _partition.lba,
+				                        packet.block_count());
+			} catch (Session::Tx::Source::Packet_alloc_failed) { return false; }
+
+			Queue_worker::Request *r = new (&_worker._r_slab)
+				Queue_worker::Request(*this, packet, srv);
+			_worker._r_list.insert(r);
+
+			if (write)
+				Genode::memcpy(backend.packet_content(srv),
+				               _sink().packet_content(packet), size);
+
+			backend.submit_packet(srv);
+			return true;
+		}
+
+		/**
+		 * Complete request acknowledged by the back end
+		 */
+		void _complete(Packet_descriptor &cli, Packet_descriptor const &reply)
+		{
+			if (cli.operation() == Packet_descriptor::READ && reply.succeeded())
+				Genode::memcpy(_sink().packet_content(cli),
+				               _worker._backend.source()->packet_content(reply),
+				               cli.block_count() * _worker._blk_size);
+
+			cli.succeeded(reply.succeeded());
+			_ack(cli);
+		}
+
+		/**
+		 * Forward pending requests as long as the back end accepts them
+		 *
+		 * Must be called with the worker lock held.
+		 */
+		void _process()
+		{
+			while (_sink().packet_avail()
+			    && _p_in_fly < _sink().ack_slots_free()) {
+
+				/* account the request before it may get acknowledged */
+				_p_in_fly++;
+
+				if (!_forward(_sink().peek_packet())) {
+					_p_in_fly--;
+					return;
+				}
+
+				/* the request was forwarded or acknowledged */
+				_sink().get_packet();
+			}
+		}
+
+		void _handle_signal()
+		{
+			Genode::Lock::Guard guard(_worker._lock);
+			_process();
+		}
+
+	public:
+
+		Queue_component(Genode::Env &env, Queue_worker &worker,
+		                Partition &partition, Genode::size_t buf_size,
+		                bool writeable)
+		:
+			Queue_component_base(env.ram(), buf_size),
+			_worker(worker), _partition(partition), _writeable(writeable),
+			_tx(_ds, env.rm(), worker.ep().rpc_ep()),
+			_sink_ack(worker.ep(), *this, &Queue_component::_handle_signal),
+			_sink_submit(worker.ep(), *this, &Queue_component::_handle_signal)
+		{
+			_tx.sigh_ready_to_ack(_sink_ack);
+			_tx.sigh_packet_avail(_sink_submit);
+
+			_worker.insert(*this);
+		}
+
+		~Queue_component() { _worker.remove(*this); }
+
+		Queue_worker &worker() { return _worker; }
+
+		Genode::Capability<Session::Tx> cap() const { return _tx.cap(); }
+};
+
+
+void Block::Queue_worker::_handle_ack_avail()
+{
+	Genode::Lock::Guard guard(_lock);
+
+	Session::Tx::Source &backend = *_backend.source();
+
+	while (backend.ack_avail()) {
+
+		Packet_descriptor const reply = backend.get_acked_packet();
+
+		for (Request *r = _r_list.first(); r; r = r->next()) {
+
+			if (r->srv.offset() != reply.offset())
+				continue;
+
+			r->queue._complete(r->cli, reply);
+			_r_list.remove(r);
+			Genode::destroy(&_r_slab, r);
+			break;
+		}
+
+		/* replies of requests of closed sessions are just released */
+		backend.release_packet(reply);
+	}
+
+	for (Queue_component *q = _queues.first(); q; q = q->next())
+		q->_process();
+}
+
+
+void Block::Queue_worker::_handle_ready_to_submit()
+{
+	Genode::Lock::Guard guard(_lock);
+
+	for (Queue_component *q = _queues.first(); q; q = q->next())
+		q->_process();
+}
+
+
+void Block::Queue_worker::_handle_destruct()
+{
+	if (!_destruct_queue)
+		return;
+
+	_destruct_queue->destruct();
+	_destruct_queue = nullptr;
+	_destructed.unlock();
+}
+
+
+void Block::Queue_worker::destruct(Genode::Constructible<Queue_component> &queue)
+{
+	if (!queue.constructed())
+		return;
+
+	_destruct_queue = &queue;
+	Genode::Signal_transmitter(_destruct).submit();
+	_destructed.lock();
+}
+
+
+void Block::Queue_worker::insert(Queue_component &queue)
+{
+	Genode::Lock::Guard guard(_lock);
+	_queues.insert(&queue);
+}
+
+
+void Block::Queue_worker::remove(Queue_component &queue)
+{
+	Genode::Lock::Guard guard(_lock);
+
+	_queues.remove(&queue);
+
+	for (Request *r = _r_list.first(); r; ) {
+
+		Request *next = r->next();
+
+		if (&r->queue == &queue) {
+			_r_list.remove(r);
+			Genode::destroy(&_r_slab, r);
+		}
+		r = next;
+	}
+}
+
+#endif /* _PART_BLK__QUEUE_H_ */
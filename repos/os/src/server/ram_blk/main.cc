@@ -137,6 +137,30 @@ class Ram_blk : public Block::Driver
 		{
 			_io(block_number, block_count, const_cast<char *>(buffer), packet, false);
 		}
+
+		/*
+		 * The backing store is accessed by plain memory copies only, which
+		 * enables the concurrent processing of multiple queues.
+		 */
+		bool multi_queue() override { return true; }
+
+		void process(Block::Packet_descriptor::Opcode op,
+		             Block::sector_t                  block_number,
+		             size_t                           block_count,
+		             char                            *buffer) override
+		{
+			if (block_number + block_count > _block_count)
+				throw Io_error();
+
+			char * const ram  = (char *)_ram_addr + block_number * _block_size;
+			size_t const size = block_count * _block_size;
+
+			switch (op) {
+			case Block::Packet_descriptor::READ:  memcpy(buffer, ram, size); break;
+			case Block::Packet_descriptor::WRITE: memcpy(ram, buffer, size); break;
+			default: throw Io_error();
+			}
+		}
 };
 
 
@@ -202,7 +226,7 @@ struct Main
 
 	enum { WRITEABLE = true };
 
-	Block::Root root { env.ep(), heap, env.rm(), factory, WRITEABLE };
+	Block::Root root { env, heap, factory, WRITEABLE };
 
 	Main(Env &env) : env(env)
 	{
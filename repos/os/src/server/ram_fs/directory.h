@@ -22,35 +22,164 @@
 #include "file.h"
 #include "symlink.h"
 
-namespace Ram_fs { class Directory; }
+namespace Ram_fs {
+	class Directory;
+	class Lookup_cache;
+}
 
 
 class Ram_fs::Directory : public Node
 {
 	private:
 
-		List<Node> _entries { };
-		size_t     _num_entries = 0;
+		/*
+		 * Noncopyable
+		 */
+		Directory(Directory const &);
+		Directory &operator = (Directory const &);
+
+		/*
+		 * Small directories are searched linearly. Once a directory holds
+		 * more than 'HASH_THRESHOLD' entries, its entries are additionally
+		 * indexed by name. The index grows with the number of entries.
+		 */
+		enum { HASH_THRESHOLD = 32, MIN_BUCKETS = 64 };
+
+		Allocator  &_alloc;
+		List<Node>  _entries { };
+		size_t      _num_entries = 0;
+
+		Node      **_buckets     = nullptr;
+		size_t      _num_buckets = 0;
+
+		/* most recently read entry, speeds up sequential directory reads */
+		Node       *_cursor       = nullptr;
+		size_t      _cursor_index = 0;
+
+		/**
+		 * Counter of removed entries of all directories
+		 */
+		static unsigned long &_generation()
+		{
+			static unsigned long generation;
+			return generation;
+		}
+
+		static unsigned long _hash(char const *name, size_t len)
+		{
+			unsigned long h = 5381;
+			for (size_t i = 0; i < len; i++)
+				h = h*33 + (unsigned char)name[i];
+			return h;
+		}
+
+		static bool _matches(Node const &node, char const *name, size_t len) {
+			return strlen(node.name()) == len && strcmp(node.name(), name, len) == 0; }
+
+		Node *&_bucket(char const *name, size_t len) const {
+			return _buckets[_hash(name, len) % _num_buckets]; }
+
+		void _index(Node &node)
+		{
+			Node *&bucket = _bucket(node.name(), strlen(node.name()));
+			node._hash_next = bucket;
+			bucket = &node;
+		}
+
+		void _unindex(Node &node)
+		{
+			Node **p = &_bucket(node.name(), strlen(node.name()));
+			for (; *p; p = &(*p)->_hash_next)
+				if (*p == &node) {
+					*p = node._hash_next;
+					break;
+				}
+			node._hash_next = nullptr;
+		}
+
+		/**
+		 * Rebuild the name index with the given number of buckets
+		 *
+		 * If the index cannot be allocated, the directory keeps its current
+		 * index or falls back to the linear search.
+		 */
+		void _rehash(size_t num_buckets)
+		{
+			Node **buckets = nullptr;
+			size_t const size = num_buckets*sizeof(Node *);
+
+			try {
+				if (!_alloc.alloc(size, &buckets))
+					return;
+			}
+			catch (Out_of_ram)  { return; }
+			catch (Out_of_caps) { return; }
+
+			memset(buckets, 0, size);
+
+			if (_buckets)
+				_alloc.free(_buckets, _num_buckets*sizeof(Node *));
+
+			_buckets     = buckets;
+			_num_buckets = num_buckets;
+
+			for (Node *node = _entries.first(); node; node = node->next())
+				_index(*node);
+		}
+
+		Node *_find(char const *name, size_t len) const
+		{
+			if (_buckets) {
+				for (Node *node = _bucket(name, len); node; node = node->_hash_next)
+					if (_matches(*node, name, len))
+						return node;
+				return nullptr;
+			}
+
+			for (Node *node = _entries.first(); node; node = node->next())
+				if (_matches(*node, name, len))
+					return node;
+
+			return nullptr;
+		}
 
 		Node *_entry_unsynchronized(size_t index)
 		{
-			Node *node = _entries.first();
-			for (unsigned i = 0; i < index && node; node = node->next(), i++);
+			Node  *node = _entries.first();
+			size_t i    = 0;
+
+			/* continue from the most recently read entry if possible */
+			if (_cursor && _cursor_index <= index) {
+				node = _cursor;
+				i    = _cursor_index;
+			}
+
+			for (; i < index && node; node = node->next(), i++);
 			return node;
 		}
 
 	public:
 
-		Directory(char const *name) { Node::name(name); }
+		Directory(Allocator &alloc, char const *name) : _alloc(alloc) {
+			Node::name(name); }
 
-		bool has_sub_node_unsynchronized(char const *name) const override
+		~Directory()
 		{
-			Node const *sub_node = _entries.first();
-			for (; sub_node; sub_node = sub_node->next())
-				if (strcmp(sub_node->name(), name) == 0)
-					return true;
+			if (_buckets)
+				_alloc.free(_buckets, _num_buckets*sizeof(Node *));
+		}
 
-			return false;
+		/**
+		 * Return counter that is incremented whenever a node is removed
+		 * from any directory
+		 *
+		 * The counter allows for caching the result of path lookups.
+		 */
+		static unsigned long generation() { return _generation(); }
+
+		bool has_sub_node_unsynchronized(char const *name) const override
+		{
+			return _find(name, strlen(name)) != nullptr;
 		}
 
 		void adopt_unsynchronized(Node *node) override
@@ -60,14 +189,26 @@ class Ram_fs::Directory : public Node
 			 */
 			_entries.insert(node);
 			_num_entries++;
+			_cursor = nullptr;
+
+			if (_buckets)
+				_index(*node);
+
+			if (_num_entries > HASH_THRESHOLD && _num_entries > 2*_num_buckets)
+				_rehash(max((size_t)MIN_BUCKETS, 4*_num_buckets));
 
 			mark_as_updated();
 		}
 
 		void discard(Node *node) override
 		{
+			if (_buckets)
+				_unindex(*node);
+
 			_entries.remove(node);
 			_num_entries--;
+			_cursor = nullptr;
+			_generation()++;
 
 			mark_as_updated();
 		}
@@ -100,11 +241,7 @@ class Ram_fs::Directory : public Node
 			 */
 
 			/* try to find entry that matches the first path element */
-			Node *sub_node = _entries.first();
-			for (; sub_node; sub_node = sub_node->next())
-				if ((strlen(sub_node->name()) == i) &&
-					(strcmp(sub_node->name(), path, i) == 0))
-					break;
+			Node *sub_node = _find(path, i);
 
 			if (!sub_node)
 				throw File_system::Lookup_failed();
@@ -195,23 +332,31 @@ class Ram_fs::Directory : public Node
 				return 0;
 			}
 
+			/* return as many entries as fit into the buffer */
+			size_t const max_count = len / sizeof(Directory_entry);
+			size_t       count     = 0;
+
 			Node *node = _entry_unsynchronized(index);
 
-			/* index out of range */
-			if (!node)
-				return 0;
+			for (; node && count < max_count; count++) {
+
+				Directory_entry *e = (Directory_entry *)(dst) + count;
 
-			Directory_entry *e = (Directory_entry *)(dst);
+				e->inode = node->inode();
 
-			e->inode = node->inode();
+				if (dynamic_cast<File      *>(node)) e->type = Directory_entry::TYPE_FILE;
+				if (dynamic_cast<Directory *>(node)) e->type = Directory_entry::TYPE_DIRECTORY;
+				if (dynamic_cast<Symlink   *>(node)) e->type = Directory_entry::TYPE_SYMLINK;
 
-			if (dynamic_cast<File      *>(node)) e->type = Directory_entry::TYPE_FILE;
-			if (dynamic_cast<Directory *>(node)) e->type = Directory_entry::TYPE_DIRECTORY;
-			if (dynamic_cast<Symlink   *>(node)) e->type = Directory_entry::TYPE_SYMLINK;
+				strncpy(e->name, node->name(), sizeof(e->name));
 
-			strncpy(e->name, node->name(), sizeof(e->name));
+				_cursor       = node;
+				_cursor_index = index + count;
 
-			return sizeof(Directory_entry);
+				node = node->next();
+			}
+
+			return count*sizeof(Directory_entry);
 		}
 
 		size_t write(char const *, size_t, seek_off_t) override
@@ -230,4 +375,68 @@ class Ram_fs::Directory : public Node
 		}
 };
 
+
+/**
+ * Cache of path lookups shared by all sessions
+ *
+ * An entry is identified by the directory the lookup started at and the
+ * path relative to it. Entries are only valid as long as no node was removed
+ * from any directory since their creation. Hence, neither renamed nor
+ * destroyed nodes are ever returned.
+ */
+class Ram_fs::Lookup_cache
+{
+	private:
+
+		enum { ENTRIES = 64 };
+
+		struct Entry
+		{
+			Directory const *dir        = nullptr;
+			Node            *node       = nullptr;
+			unsigned long    generation = 0;
+			unsigned long    hash       = 0;
+			char             path[File_system::MAX_PATH_LEN] { };
+		};
+
+		Entry _entries[ENTRIES];
+
+		static unsigned long _hash(Directory const &dir, char const *path)
+		{
+			unsigned long h = (unsigned long)&dir;
+			for (; *path; path++)
+				h = h*33 + (unsigned char)*path;
+			return h;
+		}
+
+	public:
+
+		/**
+		 * Look up node via the cache
+		 *
+		 * \throw File_system::Lookup_failed
+		 */
+		Node *lookup(Directory &dir, char const *path)
+		{
+			unsigned long const hash = _hash(dir, path);
+			Entry &e = _entries[hash % ENTRIES];
+
+			if (e.node && e.dir == &dir && e.hash == hash
+			 && e.generation == Directory::generation()
+			 && strcmp(e.path, path, sizeof(e.path)) == 0)
+				return e.node;
+
+			Node *node = dir.lookup(path);
+
+			if (strlen(path) < sizeof(e.path)) {
+				e.dir        = &dir;
+				e.node       = node;
+				e.generation = Directory::generation();
+				e.hash       = hash;
+				strncpy(e.path, path, sizeof(e.path));
+			}
+			return node;
+		}
+};
+
 #endif /* _INCLUDE__RAM_FS__DIRECTORY_H_ */
@@ -50,6 +50,7 @@ class Ram_fs::Session_component : public File_system::Session_rpc_object
 		Genode::Ram_session              &_ram;
 		Genode::Allocator                &_alloc;
 		Directory                        &_root;
+		Lookup_cache                     &_lookup_cache;
 		Id_space<File_system::Node>       _open_node_registry { };
 		bool                              _writable;
 
@@ -194,13 +195,15 @@ class Ram_fs::Session_component : public File_system::Session_rpc_object
 		Session_component(size_t tx_buf_size, Genode::Entrypoint &ep,
 		                  Genode::Ram_session &ram, Genode::Region_map &rm,
 		                  Genode::Allocator &alloc,
-		                  Directory &root, bool writable)
+		                  Directory &root, Lookup_cache &lookup_cache,
+		                  bool writable)
 		:
 			Session_rpc_object(ram.alloc(tx_buf_size), rm, ep.rpc_ep()),
 			_ep(ep),
 			_ram(ram),
 			_alloc(alloc),
 			_root(root),
+			_lookup_cache(lookup_cache),
 			_writable(writable),
 			_process_packet_handler(_ep, *this, &Session_component::_process_packets)
 		{
@@ -349,13 +352,16 @@ class Ram_fs::Session_component : public File_system::Session_rpc_object
 					throw Node_already_exists();
 
 				try {
-					parent->adopt_unsynchronized(new (_alloc) Directory(name));
+					parent->adopt_unsynchronized(new (_alloc) Directory(_alloc, name));
 				} catch (Allocator::Out_of_memory) {
 					throw No_space();
 				}
 			}
 
-			Directory *dir = _root.lookup_dir(path_str);
+			Directory *dir =
+				dynamic_cast<Directory *>(_lookup_cache.lookup(_root, path_str));
+			if (!dir)
+				throw Lookup_failed();
 
 			Open_node *open_dir =
 				new (_alloc) Open_node(dir->weak_ptr(), _open_node_registry);
@@ -367,7 +373,7 @@ class Ram_fs::Session_component : public File_system::Session_rpc_object
 		{
 			_assert_valid_path(path.string());
 
-			Node *node = _root.lookup(path.string() + 1);
+			Node *node = _lookup_cache.lookup(_root, path.string() + 1);
 
 			Open_node *open_node =
 				new (_alloc) Open_node(node->weak_ptr(), _open_node_registry);
@@ -379,7 +385,7 @@ class Ram_fs::Session_component : public File_system::Session_rpc_object
 		{
 			_assert_valid_path(path.string());
 
-			Node *node = _root.lookup(path.string() + 1);
+			Node *node = _lookup_cache.lookup(_root, path.string() + 1);
 
 			Open_node *watcher = new (_alloc)
 				Open_node(node->weak_ptr(), _open_node_registry);
@@ -496,9 +502,15 @@ class Ram_fs::Session_component : public File_system::Session_rpc_object
 						throw Unavailable();
 
 					Node *node = from_dir->lookup(from_name.string());
-					node->name(to_name.string());
 
-					if (!(open_to_dir_node.node() == open_from_dir_node.node())) {
+					if (open_to_dir_node.node() == open_from_dir_node.node()) {
+
+						/* re-adopt the node to update the name index */
+						from_dir->discard(node);
+						node->name(to_name.string());
+						from_dir->adopt_unsynchronized(node);
+
+					} else {
 
 						Locked_ptr<Node> to_dir { open_to_dir_node.node() };
 
@@ -506,6 +518,7 @@ class Ram_fs::Session_component : public File_system::Session_rpc_object
 							throw Unavailable();
 
 						from_dir->discard(node);
+						node->name(to_name.string());
 						to_dir->adopt_unsynchronized(node);
 
 						/*
@@ -553,6 +566,7 @@ class Ram_fs::Root : public Root_component<Session_component>
 		Genode::Region_map    &_rm;
 		Genode::Xml_node const _config;
 		Directory             &_root_dir;
+		Lookup_cache          &_lookup_cache;
 
 	protected:
 
@@ -642,7 +656,7 @@ class Ram_fs::Root : public Root_component<Session_component>
 			}
 			return new (md_alloc())
 				Session_component(tx_buf_size, _ep, _ram, _rm, _alloc,
-				                  *session_root_dir, writeable);
+				                  *session_root_dir, _lookup_cache, writeable);
 		}
 
 	public:
@@ -654,14 +668,16 @@ class Ram_fs::Root : public Root_component<Session_component>
 		 * \param md_alloc  meta-data allocator
 		 * \param alloc     general-purpose allocator
 		 * \param root_dir  root-directory handle (anchor for fs)
+		 * \param cache     path-lookup cache shared by all sessions
 		 */
 		Root(Genode::Entrypoint &ep, Genode::Ram_session &ram,
 		     Genode::Region_map &rm, Genode::Xml_node config,
-		     Allocator &md_alloc, Allocator &alloc, Directory &root_dir)
+		     Allocator &md_alloc, Allocator &alloc, Directory &root_dir,
+		     Lookup_cache &cache)
 		:
 			Root_component<Session_component>(&ep.rpc_ep(), &md_alloc),
 			_ep(ep), _alloc(alloc), _ram(ram), _rm(rm), _config(config),
-			_root_dir(root_dir)
+			_root_dir(root_dir), _lookup_cache(cache)
 		{ }
 };
 
@@ -726,7 +742,7 @@ static void preload_content(Genode::Env            &env,
 		 */
 		if (sub_node.has_type("dir")) {
 
-			Ram_fs::Directory *sub_dir = new (&alloc) Ram_fs::Directory(name);
+			Ram_fs::Directory *sub_dir = new (&alloc) Ram_fs::Directory(alloc, name);
 
 			/* traverse into the new directory */
 			preload_content(env, alloc, sub_node, *sub_dir);
@@ -773,8 +789,6 @@ struct Ram_fs::Main
 {
 	Genode::Env &_env;
 
-	Directory _root_dir { "" };
-
 	Genode::Attached_rom_dataspace _config { _env, "config" };
 
 	/*
@@ -784,8 +798,12 @@ struct Ram_fs::Main
 
 	Genode::Heap _heap { _env.ram(), _env.rm() };
 
+	Directory _root_dir { _heap, "" };
+
+	Lookup_cache &_lookup_cache = *new (_heap) Lookup_cache();
+
 	Root _fs_root { _env.ep(), _env.ram(), _env.rm(), _config.xml(),
-	                _sliced_heap, _heap, _root_dir };
+	                _sliced_heap, _heap, _root_dir, _lookup_cache };
 
 	Main(Genode::Env &env) : _env(env)
 	{
@@ -26,6 +26,7 @@ namespace Ram_fs {
 	class Node;
 	class File;
 	class Symlink;
+	class Directory;
 }
 
 
@@ -44,11 +45,15 @@ class Ram_fs::Node : public  File_system::Node_base,
 
 		friend class List<Node>;
 		friend class Locked_ptr<Node>;
+		friend class Directory;
 
 		int                 _ref_count;
 		Name                _name;
 		unsigned long const _inode;
 
+		/* next node of the same bucket of the parent's name index */
+		Node               *_hash_next = nullptr;
+
 		/**
 		 * Generate unique inode number
 		 */
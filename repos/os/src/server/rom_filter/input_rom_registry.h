@@ -18,6 +18,7 @@
 #include <util/xml_node.h>
 #include <base/attached_rom_dataspace.h>
 #include <base/allocator.h>
+#include <util/reconstructible.h>
 
 namespace Rom_filter {
 
@@ -65,21 +66,44 @@ class Rom_filter::Input_rom_registry
 
 				Genode::Env &_env;
 
+				Genode::Allocator &_alloc;
+
 				Input_rom_name _name;
 
 				Input_rom_changed_fn &_input_rom_changed_fn;
 
 				Genode::Attached_rom_dataspace _rom_ds { _env, _name.string() };
 
+				/*
+				 * The ROM content is indexed once per update because each
+				 * evaluation of the output queries it many times.
+				 */
+				Genode::Constructible<Genode::Xml_node_index> _index { };
+
 				Xml_node _top_level { "<empty/>" };
 
+				void _update_top_level()
+				{
+					_top_level = Xml_node("<empty/>");
+					_index.destruct();
+
+					if (!_rom_ds.valid() || !_rom_ds.local_addr<void const>())
+						return;
+
+					_index.construct(_alloc, _rom_ds.local_addr<char const>(),
+					                 _rom_ds.size());
+
+					try { _top_level = _index->xml(); }
+					catch (Xml_node::Invalid_syntax) { }
+				}
+
 				void _handle_rom_changed()
 				{
 					_rom_ds.update();
 					if (!_rom_ds.valid())
 						return;
 
-					_top_level = _rom_ds.xml();
+					_update_top_level();
 
 					/* trigger re-evaluation of the inputs */
 					_input_rom_changed_fn.input_rom_changed();
@@ -195,14 +219,15 @@ class Rom_filter::Input_rom_registry
 				/**
 				 * Constructor
 				 */
-				Entry(Genode::Env &env, Input_rom_name const &name,
+				Entry(Genode::Env &env, Genode::Allocator &alloc,
+				      Input_rom_name const &name,
 				      Input_rom_changed_fn &input_rom_changed_fn)
 				:
-					_env(env), _name(name),
+					_env(env), _alloc(alloc), _name(name),
 					_input_rom_changed_fn(input_rom_changed_fn)
 				{
 					_rom_ds.sigh(_rom_changed_handler);
-					try { _top_level = _rom_ds.xml(); }
+					try { _update_top_level(); }
 					catch (...) {}
 				}
 
@@ -390,7 +415,7 @@ class Rom_filter::Input_rom_registry
 					return;
 
 				Entry *entry =
-					new (_alloc) Entry(_env, name, _input_rom_changed_fn);
+					new (_alloc) Entry(_env, _alloc, name, _input_rom_changed_fn);
 
 				_input_roms.insert(entry);
 			};
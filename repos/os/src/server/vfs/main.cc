@@ -674,6 +674,14 @@ class Vfs_server::Session_component : public File_system::Session_rpc_object,
 		}
 
 		void control(Node_handle, Control) override { }
+
+		Dataspace_capability dataspace(File_handle file_handle) override
+		{
+			Dataspace_capability ds;
+			_apply(file_handle, [&] (File &file) {
+				ds = file.dataspace(); });
+			return ds;
+		}
 };
 
 /**
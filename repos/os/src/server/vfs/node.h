@@ -20,6 +20,7 @@
 #include <vfs/file_system.h>
 #include <os/path.h>
 #include <base/id_space.h>
+#include <dataspace/client.h>
 
 /* Local includes */
 #include "assert.h"
@@ -425,6 +426,11 @@ class Vfs_server::File : public Io_node
 
 		char const *_leaf_path = nullptr; /* offset pointer to Node::_path */
 
+		Vfs::File_system &_vfs;
+
+		/* content exposed by the VFS plugin, obtained on demand */
+		Genode::Dataspace_capability _ds { };
+
 	public:
 
 		File(Node_space         &space,
@@ -435,7 +441,7 @@ class Vfs_server::File : public Io_node
 		     Mode                fs_mode,
 		     bool                create)
 		:
-			Io_node(space, file_path, fs_mode, node_io_handler)
+			Io_node(space, file_path, fs_mode, node_io_handler), _vfs(vfs)
 		{
 			unsigned vfs_mode =
 				(fs_mode-1) | (create ? Vfs::Directory_service::OPEN_MODE_CREATE : 0);
@@ -445,7 +451,37 @@ class Vfs_server::File : public Io_node
 			_handle->context = &context();
 		}
 
-		~File() { _handle->close(); }
+		~File()
+		{
+			if (_ds.valid())
+				_vfs.release(path(), _ds);
+
+			_handle->close();
+		}
+
+		/**
+		 * Return dataspace with the file content, or an invalid capability
+		 *
+		 * The dataspace is obtained at the first request and released when
+		 * the node gets closed. Plugins that would copy the file content
+		 * into the RAM of the server are not asked as the copy could not be
+		 * accounted to the session. Writeable dataspaces are never handed
+		 * out to the client.
+		 */
+		Genode::Dataspace_capability dataspace()
+		{
+			if (_ds.valid() || !_vfs.dataspace_shared(path()))
+				return _ds;
+
+			_ds = _vfs.dataspace(path());
+
+			if (_ds.valid() && Genode::Dataspace_client(_ds).writable()) {
+				_vfs.release(path(), _ds);
+				_ds = Genode::Dataspace_capability();
+			}
+
+			return _ds;
+		}
 
 		size_t read(char *dst, size_t len, seek_off_t seek_offset) override
 		{
@@ -0,0 +1,258 @@
+/*
+ * \brief  Test for the computation of the Internet Checksum
+ * \author Genode Labs
+ * \date   2018-03-27
+ *
+ * The test compares the optimized checksum computation against a plain
+ * implementation of RFC 1071, checks the incremental update of checksums
+ * (RFC 1624) against a full recomputation, and measures the throughput of
+ * both computations.
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/log.h>
+#include <timer_session/connection.h>
+#include <net/internet_checksum.h>
+#include <net/ipv4.h>
+#include <net/udp.h>
+#include <net/tcp.h>
+
+namespace Test {
+	struct Random;
+	struct Main;
+
+	using namespace Genode;
+	using namespace Net;
+}
+
+
+/**
+ * Xorshift pseudo-random number generator
+ */
+struct Test::Random
+{
+	uint32_t _state { 0x12345678 };
+
+	uint32_t next()
+	{
+		_state ^= _state << 13;
+		_state ^= _state >> 17;
+		_state ^= _state << 5;
+		return _state;
+	}
+
+	void fill(uint8_t *dst, size_t size)
+	{
+		for (size_t i = 0; i < size; i++)
+			dst[i] = next();
+	}
+};
+
+
+/**
+ * Straight-forward implementation of RFC 1071 used as reference
+ */
+static Genode::uint16_t reference_checksum(Genode::uint16_t const *addr,
+                                           Genode::size_t          size,
+                                           Genode::addr_t          sum = 0)
+{
+	for (; size > 1; size -= 2)
+		sum += *addr++;
+
+	if (size > 0)
+		sum += *(Genode::uint8_t const *)addr;
+
+	while (Genode::addr_t const sum_rsh = sum >> 16)
+		sum = (sum & 0xffff) + sum_rsh;
+
+	return ~sum;
+}
+
+
+struct Test::Main
+{
+	enum { BUF_SIZE = 64 * 1024 + 16 };
+
+	Env               &_env;
+	Timer::Connection  _timer { _env };
+	Random             _random { };
+	unsigned           _errors { 0 };
+
+	uint8_t _buf[BUF_SIZE] { };
+
+	template <typename... ARGS>
+	void _error(ARGS &&... args)
+	{
+		if (_errors++ < 10)
+			error(args...);
+	}
+
+	void _test_full()
+	{
+		_random.fill(_buf, BUF_SIZE);
+
+		/* all 16-bit aligned offsets and sizes up to several MTUs */
+		for (unsigned offset = 0; offset < 16; offset += 2) {
+			for (size_t size = 0; size < 4096; size++) {
+
+				uint16_t const *addr = (uint16_t const *)(_buf + offset);
+				addr_t   const  init = _random.next() & 0xffff;
+
+				uint16_t const expected = reference_checksum(addr, size, init);
+				uint16_t const got      = internet_checksum(addr, size, init);
+				if (got != expected)
+					_error("offset ", offset, " size ", size, ": checksum ",
+					       Hex(got), " expected ", Hex(expected));
+			}
+		}
+
+		/* worst case for the accumulators */
+		memset(_buf, 0xff, BUF_SIZE);
+		if (internet_checksum((uint16_t *)_buf, BUF_SIZE) !=
+		    reference_checksum((uint16_t *)_buf, BUF_SIZE))
+			_error("checksum of all-ones buffer differs");
+	}
+
+	/**
+	 * Rewrite addresses and ports of a random packet like a NAT does
+	 */
+	template <typename PROT>
+	void _rewrite(Ipv4_packet &ip, PROT &prot)
+	{
+		Ipv4_address const old_src = ip.src();
+		Ipv4_address const old_dst = ip.dst();
+		Port         const old_src_port = prot.src_port();
+		Port         const old_dst_port = prot.dst_port();
+
+		Ipv4_address new_src = ip.src();
+		Ipv4_address new_dst = ip.dst();
+		_random.fill(new_src.addr, sizeof(new_src.addr));
+		if (_random.next() & 1)
+			_random.fill(new_dst.addr, sizeof(new_dst.addr));
+
+		Port const new_src_port(_random.next());
+		Port const new_dst_port((_random.next() & 1) ? (uint16_t)_random.next()
+		                                             : old_dst_port.value);
+		ip.src(new_src);
+		ip.dst(new_dst);
+		prot.src_port(new_src_port);
+		prot.dst_port(new_dst_port);
+
+		Internet_checksum_diff ip_icd;
+		ip_icd.add_up_diff(old_src, new_src);
+		ip_icd.add_up_diff(old_dst, new_dst);
+		ip.update_checksum(ip_icd);
+
+		Internet_checksum_diff prot_icd;
+		prot_icd.add_up_diff(ip_icd);
+		prot_icd.add_up_diff(old_src_port, new_src_port);
+		prot_icd.add_up_diff(old_dst_port, new_dst_port);
+		prot.update_checksum(prot_icd);
+	}
+
+	void _test_incremental()
+	{
+		enum { ROUNDS = 10000, MAX_DATA_SIZE = 1460 };
+
+		for (unsigned i = 0; i < ROUNDS; i++) {
+
+			size_t const data_size = _random.next() % MAX_DATA_SIZE;
+			bool   const is_tcp    = i & 1;
+			size_t const prot_size = data_size + (is_tcp ? sizeof(Tcp_packet)
+			                                             : sizeof(Udp_packet));
+
+			_random.fill(_buf, sizeof(Ipv4_packet) + prot_size);
+			Ipv4_packet &ip = *(Ipv4_packet *)_buf;
+			ip.header_length(sizeof(Ipv4_packet) / 4);
+			ip.version(4);
+			ip.total_length(sizeof(Ipv4_packet) + prot_size);
+			ip.update_checksum();
+
+			if (is_tcp) {
+				Tcp_packet &tcp = ip.data<Tcp_packet>(prot_size);
+				tcp.update_checksum(ip.src(), ip.dst(), prot_size);
+				_rewrite(ip, tcp);
+				Ipv4_address src = ip.src();
+				Ipv4_address dst = ip.dst();
+				if (internet_checksum_pseudo_ip((uint16_t *)&tcp, prot_size,
+				                                host_to_big_endian((uint16_t)prot_size),
+				                                Ipv4_packet::Protocol::TCP, src, dst))
+					_error("round ", i, ": bad TCP checksum after rewrite");
+			} else {
+				Udp_packet &udp = ip.data<Udp_packet>(prot_size);
+				udp.length(prot_size);
+				udp.update_checksum(ip.src(), ip.dst());
+
+				/* a zero UDP checksum would be left untouched */
+				if (!udp.checksum())
+					continue;
+
+				_rewrite(ip, udp);
+				if (udp.checksum_error(ip.src(), ip.dst()))
+					_error("round ", i, ": bad UDP checksum after rewrite");
+			}
+			if (ip.checksum_error())
+				_error("round ", i, ": bad IPv4 checksum after rewrite");
+		}
+	}
+
+	template <typename FUNC>
+	void _measure(char const *name, size_t size, FUNC const &checksum)
+	{
+		enum { MIN_DURATION_MS = 500 };
+
+		unsigned long const start_ms = _timer.elapsed_ms();
+		unsigned long       bytes    = 0;
+		unsigned long       dummy    = 0;
+		while (_timer.elapsed_ms() - start_ms < MIN_DURATION_MS) {
+			for (unsigned i = 0; i < 1024; i++) {
+				dummy += checksum((uint16_t const *)_buf, size);
+				bytes += size;
+			}
+		}
+		unsigned long const ms = max(_timer.elapsed_ms() - start_ms, 1UL);
+		log(name, " checksum of ", size, " bytes: ",
+		    (bytes / ms) / 1024 * 1000 / 1024, " MiB/s (", Hex(dummy & 0xf), ")");
+	}
+
+	void _test_throughput()
+	{
+		_random.fill(_buf, BUF_SIZE);
+
+		size_t const sizes[] = { 20, 64, 1500, 64 * 1024 };
+		for (size_t size : sizes) {
+			_measure("reference", size, [] (uint16_t const *addr, size_t size) {
+				return reference_checksum(addr, size); });
+			_measure("optimized", size, [] (uint16_t const *addr, size_t size) {
+				return internet_checksum(addr, size); });
+		}
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- Internet checksum test ---");
+
+		_test_full();
+		_test_incremental();
+		if (_errors) {
+			error(_errors, " errors");
+			_env.parent().exit(-1);
+			return;
+		}
+		_test_throughput();
+
+		log("--- finished Internet checksum test ---");
+		_env.parent().exit(0);
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
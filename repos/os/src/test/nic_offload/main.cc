@@ -0,0 +1,304 @@
+/*
+ * \brief  Test for the software fallbacks of NIC-session offloads
+ * \author Genode Labs
+ * \date   2018-04-20
+ *
+ * The test completes partial TCP checksums as left by a sender with
+ * checksum offload and splits large TCP segments, including the resumption
+ * of an interrupted segmentation, and validates the resulting headers,
+ * checksums, and payload.
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/log.h>
+#include <net/ethernet.h>
+#include <net/internet_checksum.h>
+#include <net/ipv4.h>
+#include <net/tcp.h>
+#include <nic/offload.h>
+
+namespace Test {
+	struct Main;
+
+	using namespace Genode;
+	using namespace Net;
+}
+
+
+struct Test::Main
+{
+	enum {
+		IP_OFF       = sizeof(Ethernet_frame),
+		TCP_OFF      = IP_OFF + sizeof(Ipv4_packet),
+		HDR_LEN      = TCP_OFF + sizeof(Tcp_packet),
+		CSUM_OFFSET  = 16,
+		GSO_SIZE     = 1448,
+		PAYLOAD_SIZE = 5000,
+		BUF_SIZE     = HDR_LEN + PAYLOAD_SIZE,
+		ID           = 0x1234,
+		SEQ          = 1000,
+		FIN = 1 << 0, PSH = 1 << 3, ACK = 1 << 4, CWR = 1 << 7,
+	};
+
+	Env      &_env;
+	unsigned  _errors { 0 };
+
+	/* 32-bit aligned IP header */
+	uint8_t _frame[BUF_SIZE + 2] __attribute__((aligned(4))) { };
+	uint8_t _segment[HDR_LEN + GSO_SIZE] __attribute__((aligned(4))) { };
+
+	uint8_t     *_base() { return _frame + 2; }
+	Ipv4_packet &_ip()   { return *(Ipv4_packet *)(_base() + IP_OFF); }
+	Tcp_packet  &_tcp()  { return *(Tcp_packet  *)(_base() + TCP_OFF); }
+
+	template <typename... ARGS>
+	void _error(ARGS &&... args)
+	{
+		if (_errors++ < 10)
+			error(args...);
+	}
+
+	/**
+	 * Set up a TCP/IPv4 frame with 'payload' bytes of a known pattern
+	 */
+	void _init_frame(size_t payload, uint16_t tcp_flags)
+	{
+		memset(_frame, 0, sizeof(_frame));
+		for (size_t i = 0; i < payload; i++)
+			_base()[HDR_LEN + i] = (uint8_t)(i * 7 + 3);
+
+		Ipv4_packet &ip = _ip();
+		ip.header_length(sizeof(Ipv4_packet) / 4);
+		ip.version(4);
+		ip.time_to_live(64);
+		ip.protocol(Ipv4_packet::Protocol::TCP);
+		ip.total_length(HDR_LEN - IP_OFF + payload);
+		ip.identification(ID);
+		uint8_t src[] = { 10, 0, 0, 1 };
+		uint8_t dst[] = { 10, 0, 0, 2 };
+		ip.src(Ipv4_address(src));
+		ip.dst(Ipv4_address(dst));
+		ip.update_checksum();
+
+		Tcp_packet &tcp = _tcp();
+		tcp.src_port(Port(4711));
+		tcp.dst_port(Port(80));
+		tcp.seq_nr(SEQ);
+		tcp.flags(tcp_flags);
+	}
+
+	uint16_t _tcp_checksum_raw() {
+		return *(uint16_t *)(_base() + TCP_OFF + CSUM_OFFSET); }
+
+	void _test_complete_checksum(size_t payload)
+	{
+		_init_frame(payload, ACK);
+		size_t const size     = HDR_LEN + payload;
+		size_t const tcp_size = size - TCP_OFF;
+
+		Ipv4_address src = _ip().src();
+		Ipv4_address dst = _ip().dst();
+
+		_tcp().update_checksum(src, dst, tcp_size);
+		uint16_t const expected = _tcp_checksum_raw();
+
+		/* the sender leaves the sum of the pseudo header in the field */
+		uint16_t const pseudo = ~internet_checksum_pseudo_ip(
+			(uint16_t *)(_base() + TCP_OFF), 0,
+			host_to_big_endian((uint16_t)tcp_size),
+			Ipv4_packet::Protocol::TCP, src, dst);
+		*(uint16_t *)(_base() + TCP_OFF + CSUM_OFFSET) = pseudo;
+
+		::Nic::Offload_header header { ::Nic::Offload_header::NEEDS_CSUM,
+		                               ::Nic::Offload_header::GSO_NONE,
+		                               0, 0, TCP_OFF, CSUM_OFFSET, 0 };
+
+		if (!::Nic::complete_checksum(_base(), size, header))
+			_error("payload ", payload, ": checksum not completed");
+
+		if (_tcp_checksum_raw() != expected)
+			_error("payload ", payload, ": checksum ", Hex(_tcp_checksum_raw()),
+			       " expected ", Hex(expected));
+
+		if (header.flags != ::Nic::Offload_header::CSUM_VALID)
+			_error("payload ", payload, ": flags not updated");
+
+		/* a completed checksum is not touched again */
+		if (!::Nic::complete_checksum(_base(), size, header) ||
+		    _tcp_checksum_raw() != expected)
+			_error("payload ", payload, ": completed checksum changed");
+	}
+
+	void _test_malformed_checksum()
+	{
+		_init_frame(100, ACK);
+
+		::Nic::Offload_header odd { ::Nic::Offload_header::NEEDS_CSUM,
+		                            ::Nic::Offload_header::GSO_NONE,
+		                            0, 0, TCP_OFF + 1, CSUM_OFFSET, 0 };
+		if (::Nic::complete_checksum(_base(), HDR_LEN + 100, odd))
+			_error("odd checksum start accepted");
+
+		::Nic::Offload_header outside { ::Nic::Offload_header::NEEDS_CSUM,
+		                                ::Nic::Offload_header::GSO_NONE,
+		                                0, 0, HDR_LEN + 100, CSUM_OFFSET, 0 };
+		if (::Nic::complete_checksum(_base(), HDR_LEN + 100, outside))
+			_error("checksum field outside of the frame accepted");
+	}
+
+	/**
+	 * Validate segment 'i' of the frame set up by '_init_frame'
+	 *
+	 * \return  payload size of the segment
+	 */
+	size_t _check_segment(unsigned i, void *seg_base, size_t seg_size,
+	                      size_t payload, uint16_t flags)
+	{
+		uint8_t     *const seg = (uint8_t *)seg_base;
+		Ipv4_packet &ip  = *(Ipv4_packet *)(seg + IP_OFF);
+		Tcp_packet  &tcp = *(Tcp_packet  *)(seg + TCP_OFF);
+
+		size_t const off         = i * GSO_SIZE;
+		size_t const seg_payload = min(payload - off, (size_t)GSO_SIZE);
+		bool   const last        = off + seg_payload == payload;
+
+		if (seg_size != HDR_LEN + seg_payload) {
+			_error("segment ", i, ": size ", seg_size);
+			return 0;
+		}
+		if (ip.checksum_error())
+			_error("segment ", i, ": bad IP checksum");
+
+		if (ip.total_length() != seg_size - IP_OFF)
+			_error("segment ", i, ": IP total length ", ip.total_length());
+
+		if (ip.identification() != (uint16_t)(ID + i))
+			_error("segment ", i, ": IP identification ", ip.identification());
+
+		if (tcp.seq_nr() != SEQ + off)
+			_error("segment ", i, ": sequence number ", tcp.seq_nr());
+
+		Ipv4_address src = ip.src();
+		Ipv4_address dst = ip.dst();
+		size_t const tcp_size = seg_size - TCP_OFF;
+		if (internet_checksum_pseudo_ip((uint16_t *)&tcp, tcp_size,
+		                                host_to_big_endian((uint16_t)tcp_size),
+		                                Ipv4_packet::Protocol::TCP, src, dst))
+			_error("segment ", i, ": bad TCP checksum");
+
+		uint16_t const expected_flags = flags & ~(last ? 0 : FIN | PSH)
+		                                      & ~(i ? CWR : 0);
+		if (tcp.flags() != expected_flags)
+			_error("segment ", i, ": TCP flags ", Hex(tcp.flags()),
+			       " expected ", Hex(expected_flags));
+
+		if (memcmp(seg + HDR_LEN, _base() + HDR_LEN + off, seg_payload))
+			_error("segment ", i, ": payload differs");
+
+		return seg_payload;
+	}
+
+	void _test_segmentation(size_t payload)
+	{
+		uint16_t const flags = ACK | PSH | FIN | CWR;
+		_init_frame(payload, flags);
+
+		::Nic::Offload_header const header { 0, ::Nic::Offload_header::GSO_TCPV4,
+		                                     HDR_LEN, GSO_SIZE, 0, 0, 0 };
+
+		unsigned const expected_cnt = payload ? (payload + GSO_SIZE - 1) / GSO_SIZE : 1;
+
+		/* all segments */
+		unsigned cnt   = 0;
+		size_t   bytes = 0;
+		bool ok = ::Nic::for_each_segment(_base(), HDR_LEN + payload, header,
+		                                  _segment, sizeof(_segment),
+		                                  [&] (void *seg, size_t seg_size) {
+			bytes += _check_segment(cnt++, seg, seg_size, payload, flags); });
+
+		if (!ok || cnt != expected_cnt || bytes != payload)
+			_error("payload ", payload, ": ", cnt, " segments with ", bytes,
+			       " bytes");
+
+		/* resume the segmentation at a later segment */
+		unsigned const first = expected_cnt / 2;
+		cnt = first;
+		ok = ::Nic::for_each_segment(_base(), HDR_LEN + payload, header,
+		                             _segment, sizeof(_segment),
+		                             [&] (void *seg, size_t seg_size) {
+			_check_segment(cnt++, seg, seg_size, payload, flags); },
+		                             first);
+
+		if (!ok || cnt != expected_cnt)
+			_error("payload ", payload, ": resumed at ", first, " ended at ", cnt);
+	}
+
+	void _test_malformed_segmentation()
+	{
+		_init_frame(PAYLOAD_SIZE, ACK);
+
+		auto fn = [&] (void *, size_t) { _error("segment of malformed frame"); };
+
+		::Nic::Offload_header no_size { 0, ::Nic::Offload_header::GSO_TCPV4,
+		                                HDR_LEN, 0, 0, 0, 0 };
+		if (::Nic::for_each_segment(_base(), BUF_SIZE, no_size,
+		                            _segment, sizeof(_segment), fn))
+			_error("zero segment size accepted");
+
+		::Nic::Offload_header too_large { 0, ::Nic::Offload_header::GSO_TCPV4,
+		                                  HDR_LEN, GSO_SIZE + 1, 0, 0, 0 };
+		if (::Nic::for_each_segment(_base(), BUF_SIZE, too_large,
+		                            _segment, sizeof(_segment), fn))
+			_error("segment exceeding the buffer accepted");
+
+		::Nic::Offload_header short_hdr { 0, ::Nic::Offload_header::GSO_TCPV4,
+		                                  TCP_OFF, GSO_SIZE, 0, 0, 0 };
+		if (::Nic::for_each_segment(_base(), BUF_SIZE, short_hdr,
+		                            _segment, sizeof(_segment), fn))
+			_error("headers without TCP header accepted");
+
+		_ip().protocol(Ipv4_packet::Protocol::UDP);
+		::Nic::Offload_header const header { 0, ::Nic::Offload_header::GSO_TCPV4,
+		                                     HDR_LEN, GSO_SIZE, 0, 0, 0 };
+		if (::Nic::for_each_segment(_base(), BUF_SIZE, header,
+		                            _segment, sizeof(_segment), fn))
+			_error("segmentation of UDP accepted");
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- complete checksums ---");
+		for (size_t payload = 0; payload < 64; payload++)
+			_test_complete_checksum(payload);
+		_test_complete_checksum(GSO_SIZE);
+		_test_complete_checksum(PAYLOAD_SIZE);
+		_test_malformed_checksum();
+
+		log("--- split large segments ---");
+		_test_segmentation(0);
+		_test_segmentation(1);
+		_test_segmentation(GSO_SIZE);
+		_test_segmentation(GSO_SIZE + 1);
+		_test_segmentation(PAYLOAD_SIZE);
+		_test_malformed_segmentation();
+
+		if (_errors) {
+			error("test failed with ", _errors, " errors");
+			_env.parent().exit(-1);
+			return;
+		}
+		log("--- test finished ---");
+		_env.parent().exit(0);
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
@@ -0,0 +1,294 @@
+/*
+ * \brief  Throughput benchmark for the NIC router with many concurrent flows
+ * \author Genode Labs
+ * \date   2018-03-26
+ *
+ * The component connects to the router twice. Via the "src" session, it
+ * sends UDP packets of a configurable number of flows (distinct source
+ * ports) to an address behind the "dst" session, where the packets are
+ * counted. At the end, the packet rate of the router is reported.
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/log.h>
+#include <base/heap.h>
+#include <base/allocator_avl.h>
+#include <base/attached_rom_dataspace.h>
+#include <nic_session/connection.h>
+#include <nic/packet_allocator.h>
+#include <timer_session/connection.h>
+#include <net/ethernet.h>
+#include <net/arp.h>
+#include <net/ipv4.h>
+#include <net/udp.h>
+
+namespace Test {
+	struct Nic_client;
+	struct Main;
+
+	using namespace Genode;
+	using namespace Net;
+}
+
+
+struct Test::Nic_client
+{
+	Heap          &_heap;
+	Allocator_avl  _tx_block_alloc { &_heap };
+
+	enum { BUF_SIZE = Nic::Packet_allocator::DEFAULT_PACKET_SIZE * 128 };
+
+	Nic::Connection   _nic;
+	Mac_address const _mac { _nic.mac_address() };
+
+	Nic_client(Env &env, Heap &heap, char const *label)
+	:
+		_heap(heap), _nic(env, &_tx_block_alloc, BUF_SIZE, BUF_SIZE, label)
+	{ }
+
+	void sigh(Signal_context_capability sigh)
+	{
+		_nic.tx_channel()->sigh_ready_to_submit(sigh);
+		_nic.tx_channel()->sigh_ack_avail      (sigh);
+		_nic.rx_channel()->sigh_ready_to_ack   (sigh);
+		_nic.rx_channel()->sigh_packet_avail   (sigh);
+	}
+
+	void release_acked_packets()
+	{
+		while (_nic.tx()->ack_avail()) {
+			_nic.tx()->release_packet(_nic.tx()->get_acked_packet()); }
+	}
+
+	/**
+	 * Allocate, fill, and submit one packet
+	 *
+	 * \return  false if the packet could not be sent
+	 */
+	template <typename FUNC>
+	bool send(size_t size, FUNC const &write)
+	{
+		if (!_nic.tx()->ready_to_submit()) {
+			return false; }
+
+		try {
+			Packet_descriptor pkt = _nic.tx()->alloc_packet(size);
+			write(*(Ethernet_frame *)_nic.tx()->packet_content(pkt),
+			      size - sizeof(Ethernet_frame));
+			_nic.tx()->submit_packet(pkt);
+			return true;
+		}
+		catch (Nic::Session::Tx::Source::Packet_alloc_failed) {
+			return false; }
+	}
+
+	/**
+	 * Apply 'handle' to all pending received packets and acknowledge them
+	 */
+	template <typename FUNC>
+	void receive(FUNC const &handle)
+	{
+		while (_nic.rx()->packet_avail() && _nic.rx()->ready_to_ack()) {
+			Packet_descriptor const pkt = _nic.rx()->get_packet();
+			if (pkt.size() >= sizeof(Ethernet_frame)) {
+				try {
+					handle(*(Ethernet_frame *)_nic.rx()->packet_content(pkt),
+					       pkt.size() - sizeof(Ethernet_frame));
+				}
+				catch (Ethernet_frame::Bad_data_type) { }
+			}
+			_nic.rx()->acknowledge_packet(pkt);
+		}
+	}
+
+	void send_arp(Arp_packet::Opcode opcode,
+	              Mac_address const &dst_mac,
+	              Ipv4_address const &src_ip,
+	              Ipv4_address const &dst_ip)
+	{
+		send(Ethernet_frame::MIN_SIZE, [&] (Ethernet_frame &eth, size_t size) {
+			eth.dst(dst_mac);
+			eth.src(_mac);
+			eth.type(Ethernet_frame::Type::ARP);
+
+			Arp_packet &arp = eth.data<Arp_packet>(size);
+			arp.hardware_address_type(Arp_packet::ETHERNET);
+			arp.protocol_address_type(Arp_packet::IPV4);
+			arp.hardware_address_size(sizeof(Mac_address));
+			arp.protocol_address_size(sizeof(Ipv4_address));
+			arp.opcode(opcode);
+			arp.src_mac(_mac);
+			arp.src_ip(src_ip);
+			arp.dst_mac(opcode == Arp_packet::REQUEST ? Mac_address() : dst_mac);
+			arp.dst_ip(dst_ip);
+		});
+	}
+
+	Mac_address const &mac() const { return _mac; }
+};
+
+
+struct Test::Main
+{
+	enum { PAYLOAD_SIZE = 18, FIRST_PORT = 10000, DST_PORT = 7 };
+
+	Env                    &_env;
+	Heap                    _heap    { _env.ram(), _env.rm() };
+	Attached_rom_dataspace  _config  { _env, "config" };
+	Timer::Connection       _timer   { _env };
+
+	unsigned long const _flows   { max(_config.xml().attribute_value("flows", 1024UL), 1UL) };
+	unsigned long const _packets { _config.xml().attribute_value("packets", 100000UL) };
+
+	Ipv4_address const _src_ip     { Ipv4_packet::ip_from_string("10.0.1.2") };
+	Ipv4_address const _gateway_ip { Ipv4_packet::ip_from_string("10.0.1.1") };
+	Ipv4_address const _dst_ip     { Ipv4_packet::ip_from_string("10.0.2.2") };
+
+	Nic_client _src { _env, _heap, "src" };
+	Nic_client _dst { _env, _heap, "dst" };
+
+	Mac_address _gateway_mac { };
+	bool        _gateway_known { false };
+
+	unsigned long _sent     { 0 };
+	unsigned long _received { 0 };
+	unsigned long _last_received { 0 };
+	unsigned long _start_ms { 0 };
+
+	Signal_handler<Main> _src_handler   { _env.ep(), *this, &Main::_handle_src };
+	Signal_handler<Main> _dst_handler   { _env.ep(), *this, &Main::_handle_dst };
+	Signal_handler<Main> _timer_handler { _env.ep(), *this, &Main::_handle_timer };
+
+	bool _send_udp()
+	{
+		enum {
+			IP_SIZE  = sizeof(Ipv4_packet) + sizeof(Udp_packet) + PAYLOAD_SIZE,
+			PKT_SIZE = sizeof(Ethernet_frame) + IP_SIZE,
+		};
+		Port const src_port(FIRST_PORT + (_sent % _flows));
+
+		bool const sent = _src.send(PKT_SIZE, [&] (Ethernet_frame &eth, size_t size) {
+			eth.dst(_gateway_mac);
+			eth.src(_src.mac());
+			eth.type(Ethernet_frame::Type::IPV4);
+
+			Ipv4_packet &ip = eth.data<Ipv4_packet>(size);
+			ip.header_length(sizeof(Ipv4_packet) / 4);
+			ip.version(4);
+			ip.diff_service(0);
+			ip.ecn(0);
+			ip.total_length(IP_SIZE);
+			ip.identification(0);
+			ip.flags(0);
+			ip.fragment_offset(0);
+			ip.time_to_live(64);
+			ip.protocol(Ipv4_packet::Protocol::UDP);
+			ip.src(_src_ip);
+			ip.dst(_dst_ip);
+			ip.update_checksum();
+
+			Udp_packet &udp = ip.data<Udp_packet>(size - sizeof(Ipv4_packet));
+			udp.src_port(src_port);
+			udp.dst_port(Port(DST_PORT));
+			udp.length(sizeof(Udp_packet) + PAYLOAD_SIZE);
+			udp.update_checksum(_src_ip, _dst_ip);
+		});
+		if (sent) {
+			_sent++; }
+
+		return sent;
+	}
+
+	void _handle_src()
+	{
+		_src.release_acked_packets();
+		_src.receive([&] (Ethernet_frame &eth, size_t size) {
+
+			if (_gateway_known || eth.type() != Ethernet_frame::Type::ARP) {
+				return; }
+
+			Arp_packet const &arp = eth.data<Arp_packet>(size);
+			if (arp.opcode() != Arp_packet::REPLY || !(arp.src_ip() == _gateway_ip)) {
+				return; }
+
+			_gateway_mac   = arp.src_mac();
+			_gateway_known = true;
+			_start_ms      = _timer.elapsed_ms();
+			log("gateway ", _gateway_mac, ", sending ", _packets,
+			    " packets in ", _flows, " flows");
+		});
+		if (!_gateway_known) {
+			return; }
+
+		while (_sent < _packets && _send_udp()) { }
+	}
+
+	void _handle_dst()
+	{
+		_dst.release_acked_packets();
+		_dst.receive([&] (Ethernet_frame &eth, size_t size) {
+
+			if (eth.type() == Ethernet_frame::Type::IPV4) {
+				_received++;
+				return;
+			}
+			if (eth.type() != Ethernet_frame::Type::ARP) {
+				return; }
+
+			Arp_packet const &arp = eth.data<Arp_packet>(size);
+			if (arp.opcode() != Arp_packet::REQUEST || !(arp.dst_ip() == _dst_ip)) {
+				return; }
+
+			_dst.send_arp(Arp_packet::REPLY, arp.src_mac(), _dst_ip, arp.src_ip());
+		});
+		if (_received == _packets) {
+			_finish(); }
+	}
+
+	void _handle_timer()
+	{
+		if (!_gateway_known) {
+			_src.send_arp(Arp_packet::REQUEST, Ethernet_frame::broadcast(),
+			              _src_ip, _gateway_ip);
+			return;
+		}
+		/* keep the pipeline busy, give up if no packets arrive anymore */
+		_handle_src();
+		if (_received == _last_received && _sent == _packets) {
+			_finish(); }
+
+		_last_received = _received;
+	}
+
+	void _finish()
+	{
+		unsigned long const ms = max(_timer.elapsed_ms() - _start_ms, 1UL);
+		log("sent ", _sent, " received ", _received, " packets in ", ms, " ms "
+		    "(", (_received * 1000) / ms, " packets/s, ", _flows, " flows)");
+
+		_env.parent().exit(_received ? 0 : -1);
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- NIC router flood test ---");
+
+		_src.sigh(_src_handler);
+		_dst.sigh(_dst_handler);
+		_timer.sigh(_timer_handler);
+		_timer.trigger_periodic(1000*1000);
+
+		_handle_timer();
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
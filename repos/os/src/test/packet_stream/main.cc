@@ -0,0 +1,197 @@
+/*
+ * \brief  Packet-stream throughput and latency benchmark
+ * \author Genode Labs
+ * \date   2018-03-12
+ *
+ * The test connects a packet-stream source and sink that reside in the same
+ * component but are driven by different threads. It compares the default
+ * and the lock-free packet-stream policy as well as the single-packet and
+ * the batched interface.
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/heap.h>
+#include <base/thread.h>
+#include <base/allocator_avl.h>
+#include <base/attached_ram_dataspace.h>
+#include <os/packet_stream.h>
+#include <timer_session/connection.h>
+
+using namespace Genode;
+
+enum { QUEUE_SIZE = 1024, PACKET_SIZE = 64, MAX_BATCH = 64 };
+
+typedef Packet_stream_policy<Packet_descriptor, QUEUE_SIZE, QUEUE_SIZE, char>
+        Locked_policy;
+
+typedef Lock_free_packet_stream_policy<Packet_descriptor, QUEUE_SIZE,
+                                       QUEUE_SIZE, char>
+        Lock_free_policy;
+
+
+/**
+ * Thread that acknowledges all packets of the stream
+ */
+template <typename POLICY>
+struct Sink_thread : Thread
+{
+	Packet_stream_sink<POLICY> sink;
+
+	unsigned long const total;
+	unsigned      const batch;
+
+	Sink_thread(Env &env, Dataspace_capability ds, unsigned long total,
+	            unsigned batch)
+	:
+		Thread(env, "sink", 16*1024), sink(ds, env.rm()),
+		total(total), batch(batch)
+	{ }
+
+	void entry() override
+	{
+		Packet_descriptor packets[MAX_BATCH];
+
+		for (unsigned long done = 0; done < total; ) {
+
+			if (batch == 1) {
+				sink.acknowledge_packet(sink.get_packet());
+				done++;
+				continue;
+			}
+
+			unsigned const max = min((unsigned long)batch, total - done);
+			unsigned const n   = sink.get_packets(packets, max);
+
+			sink.acknowledge_packets(packets, n);
+			done += n;
+		}
+	}
+};
+
+
+template <typename POLICY>
+struct Benchmark
+{
+	typedef Packet_stream_source<POLICY> Source;
+
+	Env                    &env;
+	Timer::Connection      &timer;
+	Heap                    heap  { env.ram(), env.rm() };
+	Allocator_avl           alloc { &heap };
+	Attached_ram_dataspace  ds    { env.ram(), env.rm(), 1024*1024 };
+	Source                  source { ds.cap(), env.rm(), alloc };
+
+	unsigned const batch;
+
+	Sink_thread<POLICY> sink_thread;
+
+	Packet_descriptor packets[MAX_BATCH];
+	Packet_descriptor pool[QUEUE_SIZE];
+
+	Benchmark(Env &env, Timer::Connection &timer, char const *policy,
+	          unsigned long total, unsigned in_flight, unsigned batch)
+	:
+		env(env), timer(timer), batch(batch),
+		sink_thread(env, ds.cap(), total, batch)
+	{
+		Packet_stream_sink<POLICY> &sink = sink_thread.sink;
+
+		/* wire data-flow signals between source and sink */
+		source.register_sigh_packet_avail(sink.sigh_packet_avail());
+		source.register_sigh_ready_to_ack(sink.sigh_ready_to_ack());
+		sink.register_sigh_ready_to_submit(source.sigh_ready_to_submit());
+		sink.register_sigh_ack_avail(source.sigh_ack_avail());
+
+		/* all packets are recycled, so allocate them upfront */
+		for (unsigned i = 0; i < in_flight; i++)
+			pool[i] = source.alloc_packet(PACKET_SIZE);
+
+		unsigned long const start_us = timer.elapsed_us();
+
+		sink_thread.start();
+
+		unsigned long submitted = 0, acked = 0;
+
+		for (unsigned i = 0; i < in_flight && submitted < total; i++, submitted++)
+			source.submit_packet(pool[i]);
+
+		while (acked < total) {
+
+			unsigned n = 1;
+			if (batch == 1)
+				packets[0] = source.get_acked_packet();
+			else
+				n = source.get_acked_packets(packets, batch);
+
+			acked += n;
+
+			unsigned const resubmit = min((unsigned long)n, total - submitted);
+			if (!resubmit)
+				continue;
+
+			if (batch == 1)
+				source.submit_packet(packets[0]);
+			else
+				source.submit_packets(packets, resubmit);
+
+			submitted += resubmit;
+		}
+
+		sink_thread.join();
+
+		unsigned long const duration_us = max(timer.elapsed_us() - start_us, 1UL);
+
+		for (unsigned i = 0; i < in_flight; i++)
+			source.release_packet(pool[i]);
+
+		if (in_flight == 1)
+			log(policy, " batch=", batch, ": round trip ",
+			    (duration_us*1000)/total, " ns");
+		else
+			log(policy, " batch=", batch, " in-flight=", in_flight, ": ",
+			    (total*1000)/duration_us, " packets/ms");
+	}
+};
+
+
+struct Main
+{
+	enum { TOTAL = 1000*1000, ROUND_TRIPS = 100*1000 };
+
+	Env &env;
+
+	Timer::Connection timer { env };
+
+	template <typename POLICY>
+	void _run(char const *policy)
+	{
+		static unsigned const batches[] = { 1, 8, 32, MAX_BATCH };
+
+		for (unsigned i = 0; i < sizeof(batches)/sizeof(batches[0]); i++)
+			Benchmark<POLICY> benchmark(env, timer, policy, TOTAL,
+			                            QUEUE_SIZE - 1, batches[i]);
+
+		Benchmark<POLICY> latency(env, timer, policy, ROUND_TRIPS, 1, 1);
+	}
+
+	Main(Env &env) : env(env)
+	{
+		log("--- packet-stream benchmark ---");
+
+		_run<Locked_policy>("locked");
+		_run<Lock_free_policy>("lock-free");
+
+		log("--- packet-stream benchmark finished ---");
+	}
+};
+
+
+void Component::construct(Env &env) { static Main main(env); }
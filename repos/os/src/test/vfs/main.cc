@@ -0,0 +1,551 @@
+/*
+ * \brief  Test for VFS plugin features beyond the plain file operations
+ * \author Genode Labs
+ * \date   2018-04-20
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/attached_rom_dataspace.h>
+#include <base/component.h>
+#include <base/heap.h>
+#include <base/log.h>
+#include <util/xml_generator.h>
+#include <vfs/simple_env.h>
+
+using namespace Genode;
+
+
+struct Test_failed : Exception { };
+
+
+static void check(bool condition, char const *what)
+{
+	if (condition)
+		return;
+
+	error("check failed: ", what);
+	throw Test_failed();
+}
+
+
+struct Main
+{
+	Env &_env;
+
+	Heap _heap { _env.ram(), _env.rm() };
+
+	Attached_rom_dataspace _config { _env, "config" };
+
+	Vfs::Simple_env _vfs_env { _env, _heap, _config.xml().sub_node("vfs") };
+
+	Vfs::File_system &_root = _vfs_env.root_dir();
+
+	typedef Vfs::Directory_service::Open_result Open_result;
+	typedef Vfs::Io_batch                       Io_batch;
+	typedef Io_batch::Request                   Request;
+	typedef Io_batch::Vector                    Vector;
+
+	Vfs::Vfs_handle &_open(Vfs::File_system &root, char const *path)
+	{
+		using Vfs::Directory_service;
+
+		Vfs::Vfs_handle *handle = nullptr;
+
+		Open_result res = root.open(path, Directory_service::OPEN_MODE_RDWR
+		                                | Directory_service::OPEN_MODE_CREATE,
+		                            &handle, _heap);
+		if (res == Open_result::OPEN_ERR_EXISTS)
+			res = root.open(path, Directory_service::OPEN_MODE_RDWR,
+			                &handle, _heap);
+
+		check(res == Open_result::OPEN_OK, "open");
+		return *handle;
+	}
+
+	Vfs::Vfs_handle &_open(char const *path) { return _open(_root, path); }
+
+	/**
+	 * Read file at 'path' from offset 0 and compare it with 'expected'
+	 */
+	bool _content_equals(Vfs::File_system &root, char const *path,
+	                     char const *expected)
+	{
+		typedef Vfs::File_io_service::Read_result Read_result;
+
+		Vfs::Vfs_handle *handle = nullptr;
+		if (root.open(path, Vfs::Directory_service::OPEN_MODE_RDONLY,
+		              &handle, _heap) != Open_result::OPEN_OK)
+			return false;
+
+		char buf[64] { };
+		Vfs::file_size count = 0;
+
+		while (!handle->fs().queue_read(handle, sizeof(buf)))
+			_env.ep().wait_and_dispatch_one_io_signal();
+
+		Read_result res;
+		while ((res = handle->fs().complete_read(handle, buf, sizeof(buf), count))
+		       == Read_result::READ_QUEUED)
+			_env.ep().wait_and_dispatch_one_io_signal();
+
+		handle->close();
+
+		size_t const len = strlen(expected);
+		return res == Read_result::READ_OK && count == len
+		    && !memcmp(buf, expected, len);
+	}
+
+	void _write(Vfs::Vfs_handle &handle, char const *content)
+	{
+		Vfs::file_size count = 0;
+		check(handle.fs().write(&handle, content, strlen(content), count)
+		      == Vfs::File_io_service::WRITE_OK && count == strlen(content),
+		      "write");
+	}
+
+	void _write_at(Vfs::Vfs_handle &handle, Vfs::file_size offset,
+	               char const *content)
+	{
+		handle.seek(offset);
+		_write(handle, content);
+	}
+
+	/**
+	 * Read up to 'len' bytes at 'offset'
+	 *
+	 * \return number of bytes read
+	 */
+	Vfs::file_size _read_at(Vfs::Vfs_handle &handle, Vfs::file_size offset,
+	                        char *dst, Vfs::file_size len)
+	{
+		typedef Vfs::File_io_service::Read_result Read_result;
+
+		handle.seek(offset);
+
+		while (!handle.fs().queue_read(&handle, len))
+			_env.ep().wait_and_dispatch_one_io_signal();
+
+		Vfs::file_size count = 0;
+		Read_result res;
+		while ((res = handle.fs().complete_read(&handle, dst, len, count))
+		       == Read_result::READ_QUEUED)
+			_env.ep().wait_and_dispatch_one_io_signal();
+
+		check(res == Read_result::READ_OK, "read");
+		return count;
+	}
+
+	Vfs::file_size _size(char const *path)
+	{
+		Vfs::Directory_service::Stat st;
+		check(_root.stat(path, st) == Vfs::Directory_service::STAT_OK, "stat");
+		return st.size;
+	}
+
+	void _truncate(Vfs::Vfs_handle &handle, Vfs::file_size size)
+	{
+		check(handle.fs().ftruncate(&handle, size)
+		      == Vfs::File_io_service::FTRUNCATE_OK, "truncate");
+	}
+
+	/**
+	 * Return true if the 'len' bytes at 'offset' read as zeros
+	 */
+	bool _zeros_at(Vfs::Vfs_handle &handle, Vfs::file_size offset, size_t len)
+	{
+		char buf[64];
+		memset(buf, 0x55, sizeof(buf));
+
+		len = min(len, sizeof(buf));
+		if (_read_at(handle, offset, buf, len) != len)
+			return false;
+
+		for (size_t i = 0; i < len; i++)
+			if (buf[i])
+				return false;
+		return true;
+	}
+
+	/**
+	 * Return true if 'content' is found at 'offset'
+	 */
+	bool _content_at(Vfs::Vfs_handle &handle, Vfs::file_size offset,
+	                 char const *content)
+	{
+		char buf[64] { };
+		size_t const len = min(strlen(content), sizeof(buf));
+		return _read_at(handle, offset, buf, len) == len
+		    && !memcmp(buf, content, len);
+	}
+
+	/**
+	 * Submit all requests of 'batch' and wait for their completion
+	 */
+	void _execute(Io_batch &batch)
+	{
+		while (batch.submit())
+			_env.ep().wait_and_dispatch_one_io_signal();
+
+		while (!batch.complete())
+			_env.ep().wait_and_dispatch_one_io_signal();
+	}
+
+	static Request _request(Vfs::Vfs_handle &handle, Request::Opcode opcode,
+	                        Vfs::file_size offset, Vector const *vectors,
+	                        unsigned vector_count)
+	{
+		Request r;
+		r.handle       = &handle;
+		r.opcode       = opcode;
+		r.offset       = offset;
+		r.vectors      = vectors;
+		r.vector_count = vector_count;
+		return r;
+	}
+
+	/**
+	 * Write and read back vectored requests spanning the handles of two
+	 * different plugins within one batch each
+	 */
+	void _test_io_batch()
+	{
+		log("--- I/O batch ---");
+
+		Vfs::Vfs_handle &ram = _open("/ram/batch");
+		Vfs::Vfs_handle &fs  = _open("/fs/batch");
+
+		char hello[] = "hello, ", batched[] = "batched", world[] = "world";
+
+		Vector const head[] = { { hello,   7 }, { batched, 7 } };
+		Vector const tail[] = { { world,   5 } };
+
+		Request writes[] = {
+			_request(ram, Request::WRITE,   0, head, 2),
+			_request(ram, Request::WRITE, 100, tail, 1),
+			_request(fs,  Request::WRITE,   0, head, 2),
+			_request(fs,  Request::WRITE, 100, tail, 1) };
+
+		Io_batch write_batch(writes, 4, nullptr);
+		_execute(write_batch);
+
+		for (Request const &r : writes)
+			check(r.succeeded && r.count == r.size(), "batched write");
+
+		char ram_head[14], ram_tail[5], fs_head[14], fs_tail[5];
+
+		Vector const ram_head_v[] = { { ram_head, 3 }, { ram_head + 3, 11 } };
+		Vector const ram_tail_v[] = { { ram_tail, 5 } };
+		Vector const fs_head_v[]  = { { fs_head, 14 } };
+		Vector const fs_tail_v[]  = { { fs_tail,  5 } };
+
+		Request reads[] = {
+			_request(ram, Request::READ,   0, ram_head_v, 2),
+			_request(ram, Request::READ, 100, ram_tail_v, 1),
+			_request(fs,  Request::READ,   0, fs_head_v,  1),
+			_request(fs,  Request::READ, 100, fs_tail_v,  1) };
+
+		Io_batch read_batch(reads, 4, nullptr);
+		_execute(read_batch);
+
+		for (Request const &r : reads)
+			check(r.succeeded && r.count == r.size(), "batched read");
+
+		check(!memcmp(ram_head, "hello, batched", 14), "ram content at 0");
+		check(!memcmp(ram_tail, "world", 5),           "ram content at 100");
+		check(!memcmp(fs_head,  "hello, batched", 14), "fs content at 0");
+		check(!memcmp(fs_tail,  "world", 5),           "fs content at 100");
+
+		/* the seek offsets of the handles are not affected by batches */
+		check(ram.seek() == 0 && fs.seek() == 0, "seek offset");
+
+		ram.close();
+		fs.close();
+
+		log("I/O batch passed");
+	}
+
+	/**
+	 * Close a handle while a batched read is still in flight
+	 *
+	 * The request must be completed as failed by the close operation and
+	 * the packet of the request must be released once acknowledged. Since
+	 * the rounds consume much more than the packet buffer of the session,
+	 * a leaked packet would let the test stall.
+	 */
+	void _test_close_in_flight()
+	{
+		log("--- close with batched request in flight ---");
+
+		enum { ROUNDS = 64, SIZE = 16*1024 };
+
+		static char buf[SIZE];
+
+		for (unsigned i = 0; i < ROUNDS; i++) {
+
+			Vfs::Vfs_handle &fs = _open("/fs/batch");
+
+			Vector  const vector[] = { { buf, SIZE } };
+			Request       read[]   = { _request(fs, Request::READ, 0, vector, 1) };
+
+			Io_batch batch(read, 1, nullptr);
+			while (batch.submit())
+				_env.ep().wait_and_dispatch_one_io_signal();
+
+			bool const in_flight = !batch.complete();
+
+			fs.close();
+
+			check(batch.complete(), "completion on close");
+			check(!in_flight || !read[0].succeeded, "failed request on close");
+		}
+
+		log("close with batched request in flight passed");
+	}
+
+	/**
+	 * Resolve paths via the hashed '<dir>' index and the lookup cache of
+	 * 'Dir_file_system'
+	 *
+	 * The test uses a VFS of its own with more sibling directories than
+	 * buckets, a chain of unambiguous directories, which is subject to
+	 * caching, and several directories of the same name, which are not.
+	 */
+	void _test_dir_lookup()
+	{
+		log("--- directory index and lookup cache ---");
+
+		enum { DIRS = 40 };
+
+		typedef String<8> Name;
+
+		static char config[16*1024];
+
+		Xml_generator xml(config, sizeof(config), "vfs", [&] () {
+
+			for (unsigned i = 0; i < DIRS; i++) {
+				xml.node("dir", [&] () {
+					xml.attribute("name", Name("d", i));
+					xml.node("inline", [&] () {
+						xml.attribute("name", "id");
+						xml.append(Name("d", i).string());
+					});
+				});
+			}
+
+			xml.node("dir", [&] () {
+				xml.attribute("name", "a");
+				xml.node("dir", [&] () {
+					xml.attribute("name", "b");
+					xml.node("dir", [&] () {
+						xml.attribute("name", "c");
+						xml.node("ram");
+					});
+				});
+			});
+
+			auto merged_dir = [&] (char const *content) {
+				xml.node("dir", [&] () {
+					xml.attribute("name", "m");
+					xml.node("inline", [&] () {
+						xml.attribute("name", "x");
+						xml.append(content);
+					});
+				});
+			};
+
+			xml.node("dir", [&] () {
+				xml.attribute("name", "m");
+				xml.node("ram");
+			});
+			merged_dir("first");
+			merged_dir("second");
+
+			xml.node("inline", [&] () {
+				xml.attribute("name", "top");
+				xml.append("plain");
+			});
+		});
+
+		Vfs::Simple_env   vfs_env { _env, _heap, Xml_node(config) };
+		Vfs::File_system &root = vfs_env.root_dir();
+
+		/* repeated lookups are served by the cache */
+		for (unsigned round = 0; round < 2; round++) {
+
+			for (unsigned i = 0; i < DIRS; i++)
+				check(_content_equals(root, Name("/d", i, "/id").string(),
+				                      Name("d", i).string()), "hashed dir");
+
+			check(_content_equals(root, "/top", "plain"), "plain file system");
+			check(_content_equals(root, "/m/x", "first"), "merged dir order");
+		}
+
+		Vfs::Vfs_handle &deep = _open(root, "/a/b/c/file");
+		_write(deep, "deep");
+		deep.close();
+
+		Vfs::Directory_service::Stat st;
+		for (unsigned round = 0; round < 2; round++) {
+			check(_content_equals(root, "/a/b/c/file", "deep"), "cached dir");
+			check(root.stat("/a/b/c/file", st)
+			      == Vfs::Directory_service::STAT_OK && st.size == 4, "stat");
+			check(root.directory("/a/b/c") && root.num_dirent("/a/b/c") == 1,
+			      "cached dir listing");
+		}
+
+		check(root.unlink("/a/b/c/file") == Vfs::Directory_service::UNLINK_OK,
+		      "unlink");
+		check(root.stat("/a/b/c/file", st) != Vfs::Directory_service::STAT_OK,
+		      "stat of unlinked file");
+		check(root.num_dirent("/a/b/c") == 0, "listing of emptied dir");
+
+		/* files created in merged directories end up at the first one */
+		Vfs::Vfs_handle &merged = _open(root, "/m/file");
+		_write(merged, "merged");
+		merged.close();
+
+		check(_content_equals(root, "/m/file", "merged"), "merged dir file");
+		check(root.num_dirent("/m") == 3, "merged dir listing");
+
+		log("directory index and lookup cache passed");
+	}
+
+	/**
+	 * Sparse files, truncation and appending with the extent storage of
+	 * the ram plugin
+	 */
+	void _test_ram_extents()
+	{
+		log("--- ram extents ---");
+
+		enum { MB = 1024*1024 };
+
+		char const *path = "/extents/sparse";
+
+		Vfs::Vfs_handle &file = _open(path);
+
+		/* sparse writes, the holes in between are not backed by memory */
+		_write_at(file, 0,          "head");
+		_write_at(file, MB + 123,   "middle");
+		_write_at(file, 10*MB - 2,  "tail");
+
+		check(_size(path) == 10*MB + 2,          "size of sparse file");
+		check(_content_at(file, 0,         "head"),   "content at 0");
+		check(_content_at(file, MB + 123,  "middle"), "content at 1M");
+		check(_content_at(file, 10*MB - 2, "tail"),   "content at 10M");
+		check(_zeros_at(file, 4,        60), "hole after head");
+		check(_zeros_at(file, MB + 64,  59), "hole before middle");
+		check(_zeros_at(file, 5*MB,     64), "hole in the middle");
+
+		/* reads are clipped at the end of the file */
+		char buf[16];
+		check(_read_at(file, 10*MB - 2, buf, sizeof(buf)) == 4, "read at end");
+
+		/* shrink into an extent and beyond extents */
+		_truncate(file, MB + 126);
+		check(_size(path) == MB + 126,           "size after shrink");
+		check(_content_at(file, MB + 123, "mid"), "content after shrink");
+		check(_read_at(file, MB + 123, buf, sizeof(buf)) == 3, "read after shrink");
+
+		/* grow again, the dropped content must not reappear */
+		_truncate(file, 12*MB);
+		check(_size(path) == 12*MB,         "size after grow");
+		check(_content_at(file, 0, "head"), "content after grow");
+		check(_zeros_at(file, MB + 126,  64), "zeros after grow");
+		check(_zeros_at(file, 10*MB - 2, 64), "zeros at dropped tail");
+
+		/* shrink within the first block, then grow */
+		_truncate(file, 2);
+		_truncate(file, 64);
+		check(_content_at(file, 0, "he"), "content after partial shrink");
+		check(_zeros_at(file, 2, 62),     "zeros after partial shrink");
+
+		/* append at the end of the file, which includes the hole */
+		file.seek(~0ULL);
+		_write(file, "appended");
+		check(_size(path) == 72,                "size after append");
+		check(_content_at(file, 64, "appended"), "appended content");
+
+		file.close();
+
+		check(_root.unlink(path) == Vfs::Directory_service::UNLINK_OK, "unlink");
+
+		log("ram extents passed");
+	}
+
+	/**
+	 * Return number of entries of the directory opened as 'handle'
+	 */
+	unsigned _num_listed(Vfs::Vfs_handle &handle)
+	{
+		typedef Vfs::Directory_service::Dirent Dirent;
+
+		unsigned i = 0;
+		for (;; i++) {
+			Dirent dirent;
+			if (_read_at(handle, i*sizeof(Dirent), (char *)&dirent,
+			             sizeof(Dirent)) != sizeof(Dirent)
+			 || dirent.type == Vfs::Directory_service::DIRENT_TYPE_END)
+				return i;
+		}
+	}
+
+	/**
+	 * List a directory of the fs plugin with more entries than are
+	 * requested from the server at once
+	 */
+	void _test_fs_dir_listing()
+	{
+		log("--- fs directory listing ---");
+
+		enum { FILES = 40 };
+
+		typedef String<32> Path;
+
+		Vfs::Vfs_handle *dir = nullptr;
+		check(_root.opendir("/fs/list", true, &dir, _heap)
+		      == Vfs::Directory_service::OPENDIR_OK, "opendir");
+
+		for (unsigned i = 0; i < FILES; i++)
+			_open(Path("/fs/list/f", i).string()).close();
+
+		check(_num_listed(*dir) == FILES, "number of listed entries");
+
+		/* listing again from the start reflects modifications */
+		check(_root.unlink("/fs/list/f0") == Vfs::Directory_service::UNLINK_OK,
+		      "unlink");
+		check(_num_listed(*dir) == FILES - 1, "number of entries after unlink");
+
+		dir->close();
+
+		log("fs directory listing passed");
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		try {
+			_test_io_batch();
+			_test_close_in_flight();
+			_test_dir_lookup();
+			_test_ram_extents();
+			_test_fs_dir_listing();
+		}
+		catch (...) {
+			_env.parent().exit(-1);
+			return;
+		}
+
+		log("--- VFS test finished ---");
+		_env.parent().exit(0);
+	}
+};
+
+
+void Component::construct(Env &env) { static Main main(env); }
@@ -0,0 +1,3 @@
+TARGET = test-vfs
+SRC_CC = main.cc
+LIBS   = base vfs
@@ -0,0 +1,266 @@
+/*
+ * \brief  Test for generating and merging deltas of XML documents
+ * \author Genode Labs
+ * \date   2018-04-20
+ *
+ * Each test case generates the delta between two versions of a document
+ * and checks that merging the delta with the previous version reproduces
+ * the new version byte by byte.
+ */
+
+/*
+ * Copyright (C) 2018 Genode Labs GmbH
+ *
+ * This file is part of the Genode OS framework, which is distributed
+ * under the terms of the GNU Affero General Public License version 3.
+ */
+
+/* Genode includes */
+#include <base/component.h>
+#include <base/log.h>
+#include <os/xml_delta.h>
+
+namespace Test {
+	struct Document;
+	struct Main;
+
+	using namespace Genode;
+}
+
+
+/**
+ * Document with a top-level node per entry
+ */
+struct Test::Document
+{
+	enum { CAPACITY = 4096 };
+
+	char   buf[CAPACITY] { };
+	size_t len = 0;
+
+	void _append(char const *s)
+	{
+		size_t const n = strlen(s);
+		if (len + n >= CAPACITY)
+			throw Exception();
+
+		memcpy(buf + len, s, n);
+		len += n;
+	}
+
+	Document(char const * const entries[], unsigned count)
+	{
+		_append("<report version=\"1\">\n");
+		for (unsigned i = 0; i < count; i++) {
+			_append("\t");
+			_append(entries[i]);
+			_append("\n");
+		}
+		_append("</report>");
+	}
+};
+
+
+struct Test::Main
+{
+	enum { BUF_SIZE = 4096 };
+
+	Env      &_env;
+	unsigned  _errors { 0 };
+
+	char _delta[BUF_SIZE]  { };
+	char _merged[BUF_SIZE] { };
+
+	/* previous version used by all test cases */
+	char const * const _prev_entries[12] = {
+		"<device name=\"eth0\" state=\"up\" mac=\"02:02:02:02:02:00\"/>",
+		"<device name=\"eth1\" state=\"up\" mac=\"02:02:02:02:02:01\"/>",
+		"<device name=\"eth2\" state=\"down\" mac=\"02:02:02:02:02:02\"/>",
+		"<device name=\"wlan0\" state=\"up\" mac=\"02:02:02:02:02:03\">"
+		"<network ssid=\"home\" quality=\"72\"/></device>",
+		"<device name=\"usb0\" state=\"down\" mac=\"02:02:02:02:02:04\"/>",
+		"<partition number=\"1\" type=\"ext2\" length=\"1048576\"/>",
+		"<partition number=\"2\" type=\"fat32\" length=\"2097152\"/>",
+		"<partition number=\"3\" type=\"swap\" length=\"524288\"/>",
+		"<battery name=\"BAT0\" charge=\"87\" status=\"discharging\"/>",
+		"<battery name=\"BAT1\" charge=\"100\" status=\"full\"/>",
+		"<sensor name=\"cpu\" temperature=\"54\"/>",
+		"<sensor name=\"gpu\" temperature=\"61\"/>",
+	};
+
+	Document const _prev { _prev_entries, 12 };
+
+	template <typename... ARGS>
+	void _error(ARGS &&... args)
+	{
+		_errors++;
+		error(args...);
+	}
+
+	/**
+	 * Generate delta from '_prev' to 'curr' and merge it again
+	 *
+	 * \param expect_delta  whether the delta must be smaller than 'curr'
+	 */
+	void _round_trip(char const *name, Document const &curr, bool expect_delta)
+	{
+		size_t const delta_len =
+			Xml_delta::generate(_prev.buf, _prev.len, curr.buf, curr.len,
+			                    _delta, sizeof(_delta));
+
+		if (!delta_len) {
+			if (expect_delta)
+				_error(name, ": no delta generated");
+			return;
+		}
+
+		if (delta_len >= curr.len)
+			_error(name, ": delta of ", delta_len, " bytes not smaller than "
+			       "document of ", curr.len, " bytes");
+
+		/* the size of the delta and of the merged document is known upfront */
+		if (Xml_delta::generate(_prev.buf, _prev.len, curr.buf, curr.len,
+		                        nullptr, 0) != delta_len)
+			_error(name, ": size of delta differs without buffer");
+
+		try {
+			size_t const merged_len =
+				Xml_delta::merge(_prev.buf, _prev.len, _delta, delta_len,
+				                 _merged, sizeof(_merged));
+
+			if (Xml_delta::merge(_prev.buf, _prev.len, _delta, delta_len,
+			                     nullptr, 0) != merged_len)
+				_error(name, ": size of merged document differs without buffer");
+
+			if (merged_len != curr.len || memcmp(_merged, curr.buf, curr.len))
+				_error(name, ": merged document differs from new version:\n",
+				       Cstring(_merged, merged_len));
+		}
+		catch (Xml_delta::Invalid_delta) {
+			_error(name, ": generated delta is invalid"); }
+
+		log(name, ": delta ", delta_len, " of ", curr.len, " bytes");
+	}
+
+	void _test_unchanged()
+	{
+		_round_trip("unchanged", _prev, true);
+	}
+
+	void _test_attribute_change()
+	{
+		char const *e[12];
+		memcpy(e, _prev_entries, sizeof(e));
+
+		e[2]  = "<device name=\"eth2\" state=\"up\" mac=\"02:02:02:02:02:02\"/>";
+		e[8]  = "<battery name=\"BAT0\" charge=\"86\" status=\"discharging\"/>";
+		e[11] = "<sensor name=\"gpu\" temperature=\"62\"/>";
+		_round_trip("attribute change", Document(e, 12), true);
+
+		/* change within a sub node of a top-level node */
+		memcpy(e, _prev_entries, sizeof(e));
+		e[3] = "<device name=\"wlan0\" state=\"up\" mac=\"02:02:02:02:02:03\">"
+		       "<network ssid=\"home\" quality=\"68\"/></device>";
+		_round_trip("nested attribute change", Document(e, 12), true);
+	}
+
+	void _test_child_add()
+	{
+		char const *e[14];
+
+		/* add in the middle */
+		for (unsigned i = 0, j = 0; i < 13; i++)
+			e[i] = (i == 5) ? "<device name=\"tap0\" state=\"up\"/>"
+			                : _prev_entries[j++];
+		_round_trip("child added in the middle", Document(e, 13), true);
+
+		/* add at the front and at the end */
+		e[0] = "<device name=\"lo\" state=\"up\"/>";
+		for (unsigned i = 0; i < 12; i++)
+			e[i + 1] = _prev_entries[i];
+		e[13] = "<sensor name=\"disk\" temperature=\"38\"/>";
+		_round_trip("children added at both ends", Document(e, 14), true);
+	}
+
+	void _test_child_remove()
+	{
+		char const *e[12];
+
+		/* remove the first, a middle, and the last node */
+		unsigned n = 0;
+		for (unsigned i = 0; i < 12; i++)
+			if (i != 0 && i != 6 && i != 11)
+				e[n++] = _prev_entries[i];
+		_round_trip("children removed", Document(e, n), true);
+
+		/* remove more nodes than the lookahead covers */
+		n = 0;
+		for (unsigned i = 0; i < 12; i++)
+			if (i < 1 || i > 10)
+				e[n++] = _prev_entries[i];
+		_round_trip("run of children removed", Document(e, n), false);
+
+		/* reorder nodes, which resumes matching at an earlier node */
+		for (unsigned i = 0; i < 12; i++)
+			e[i] = _prev_entries[(i + 6) % 12];
+		_round_trip("children reordered", Document(e, 12), false);
+	}
+
+	void _test_no_delta()
+	{
+		char const * const e[2] = {
+			"<device name=\"eth0\" state=\"down\"/>",
+			"<device name=\"eth1\" state=\"down\"/>" };
+
+		Document const curr(e, 2);
+		if (Xml_delta::generate(_prev.buf, _prev.len, curr.buf, curr.len,
+		                        _delta, sizeof(_delta)))
+			_error("delta generated for completely changed document");
+
+		/* delta that does not fit into the destination buffer */
+		if (Xml_delta::generate(_prev.buf, _prev.len, _prev.buf, _prev.len,
+		                        _delta, 16))
+			_error("delta generated despite too small buffer");
+	}
+
+	void _test_invalid_delta()
+	{
+		char const * const invalid[] = {
+			"<report><delta:keep from=\"0\" count=\"0\"/></report>",
+			"<report><delta:keep from=\"11\" count=\"2\"/></report>",
+			"<report><delta:keep from=\"20\" count=\"1\"/></report>",
+			"<report><delta:keep" };
+
+		for (char const *delta : invalid) {
+			try {
+				Xml_delta::merge(_prev.buf, _prev.len, delta, strlen(delta),
+				                 _merged, sizeof(_merged));
+				_error("invalid delta accepted: ", delta);
+			}
+			catch (Xml_delta::Invalid_delta) { }
+		}
+	}
+
+	Main(Env &env) : _env(env)
+	{
+		log("--- XML delta test started ---");
+
+		_test_unchanged();
+		_test_attribute_change();
+		_test_child_add();
+		_test_child_remove();
+		_test_no_delta();
+		_test_invalid_delta();
+
+		if (_errors) {
+			error("test failed with ", _errors, " errors");
+			_env.parent().exit(-1);
+			return;
+		}
+		log("--- XML delta test finished ---");
+		_env.parent().exit(0);
+	}
+};
+
+
+void Component::construct(Genode::Env &env) { static Test::Main main(env); }
@@ -0,0 +1,3 @@
+TARGET = test-xml_delta
+SRC_CC = main.cc
+LIBS   = base
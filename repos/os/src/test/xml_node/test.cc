@@ -15,8 +15,11 @@
 /* Genode includes */
 #include <util/xml_node.h>
 #include <base/attached_ram_dataspace.h>
+#include <base/attached_rom_dataspace.h>
 #include <base/component.h>
+#include <base/heap.h>
 #include <base/log.h>
+#include <trace/timestamp.h>
 
 using namespace Genode;
 
@@ -317,6 +320,18 @@ static void log_xml_info(const char *xml_string)
 }
 
 
+static void log_indexed_xml_info(Allocator &alloc, const char *xml_string)
+{
+	Xml_node_index const index(alloc, xml_string, strlen(xml_string));
+	log("indexed nodes = ", index.num_nodes());
+	try {
+		log(Formatted_xml_node(index.xml()));
+	} catch (Xml_node::Invalid_syntax) {
+		log("string has invalid XML syntax\n");
+	}
+}
+
+
 template <size_t max_content_sz>
 static void test_decoded_content(Env        &env,
                                  unsigned    step,
@@ -371,6 +386,94 @@ static void test_decoded_content(Env        &env,
 }
 
 
+/**
+ * Sum up the RAM quanta of all start nodes with a route
+ */
+static unsigned long iterate_start_nodes(Xml_node config)
+{
+	unsigned long sum = 0;
+	config.for_each_sub_node("start", [&] (Xml_node start) {
+		if (start.has_sub_node("route"))
+			sum += start.sub_node("resource").attribute_value("quantum", 0UL); });
+	return sum;
+}
+
+
+/**
+ * Sum up the RAM quanta of all start nodes accessed by index
+ */
+static unsigned long access_start_nodes(Xml_node config)
+{
+	unsigned long sum = 0;
+	for (unsigned i = 0; i < config.num_sub_nodes(); i++)
+		sum += config.sub_node(i).sub_node(0U).attribute_value("quantum", 0UL);
+	return sum;
+}
+
+
+template <typename FN>
+static void measure(char const *what, unsigned long expected, FN const &fn)
+{
+	Trace::Timestamp const start  = Trace::timestamp();
+	unsigned long    const result = fn();
+	Trace::Timestamp const cycles = Trace::timestamp() - start;
+
+	log("  ", what, ": ", cycles/1000, "K cycles",
+	    result == expected ? "" : " (wrong result)");
+}
+
+
+/**
+ * Benchmark of queries on a large document with and without index
+ *
+ * The document resembles an init configuration with 'num' start nodes.
+ * The queries are those of a typical configuration update: the iteration
+ * over all start nodes with a look-up of sub nodes and attributes, and the
+ * access of each start node by position.
+ */
+static void benchmark_index(Env &env, Allocator &alloc, unsigned num)
+{
+	enum { MAX_START_LEN = 192 };
+	typedef String<MAX_START_LEN> Start;
+
+	Attached_ram_dataspace buf_ds(env.ram(), env.rm(), num*MAX_START_LEN + 64);
+	char * const buf = buf_ds.local_addr<char>();
+
+	size_t len = 0;
+	auto append = [&] (Start const &s) {
+		memcpy(buf + len, s.string(), s.length() - 1);
+		len += s.length() - 1;
+	};
+
+	append("<config>");
+	for (unsigned i = 0; i < num; i++)
+		append(Start("<start name=\"child_", i, "\" caps=\"100\">"
+		             "<resource name=\"RAM\" quantum=\"", i, "\"/>"
+		             "<route><any-service><parent/></any-service></route>"
+		             "</start>"));
+	append("</config>");
+
+	unsigned long const expected = (unsigned long)num*(num - 1)/2;
+
+	log("document of ", len, " bytes with ", num, " start nodes");
+
+	measure("plain iteration  ", expected, [&] () {
+		return iterate_start_nodes(Xml_node(buf, len)); });
+	measure("plain access     ", expected, [&] () {
+		return access_start_nodes(Xml_node(buf, len)); });
+
+	Trace::Timestamp const start = Trace::timestamp();
+	Xml_node_index const index(alloc, buf, len);
+	log("  index built in ", (Trace::timestamp() - start)/1000, "K cycles, ",
+	    index.num_nodes(), " nodes");
+
+	measure("indexed iteration", expected, [&] () {
+		return iterate_start_nodes(index.xml()); });
+	measure("indexed access   ", expected, [&] () {
+		return access_start_nodes(index.xml()); });
+}
+
+
 void Component::construct(Genode::Env &env)
 {
 	log("--- XML-token test ---");
@@ -416,6 +519,23 @@ void Component::construct(Genode::Env &env)
 	test_decoded_content<0   >(env, 5, xml_test_comments, 8, 119);
 	log("");
 
+	Heap heap(env.ram(), env.rm());
+
+	log("-- Test indexed XML nodes --");
+	log_indexed_xml_info(heap, xml_test_valid);
+	log_indexed_xml_info(heap, xml_test_truncated);
+	log_indexed_xml_info(heap, xml_test_attributes);
+	log_indexed_xml_info(heap, xml_test_text_between_nodes);
+	log_indexed_xml_info(heap, xml_test_comments);
+
 	log("--- End of XML-parser test ---");
+
+	Attached_rom_dataspace config(env, "config");
+	if (config.xml().attribute_value("benchmark", false)) {
+		log("--- XML-index benchmark ---");
+		benchmark_index(env, heap, 250);
+		benchmark_index(env, heap, 1000);
+	}
+
 	env.parent().exit(0);
 }